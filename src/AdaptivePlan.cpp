@@ -0,0 +1,222 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2026 Librett developers
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+#include <algorithm>
+#include <chrono>
+#include "AdaptivePlan.h"
+#include "GpuUtils.h"
+#include "kernel.h"
+#include "Wisdom.h"
+
+// Median of the times of a candidate
+static double median(std::vector<double> times) {
+  std::nth_element(times.begin(), times.begin() + times.size()/2, times.end());
+  return times[times.size()/2];
+}
+
+AdaptivePlan::AdaptivePlan(const std::vector<librettPlan_t*>& candidates_in, const int numExplore_in,
+  const std::string& wisdomKey_in) : numExplore(numExplore_in), wisdomKey(wisdomKey_in), numCollected(0),
+  done(false) {
+  for (librettPlan_t* plan : candidates_in) {
+    Candidate candidate;
+    candidate.plan.reset(plan);
+    candidate.numRun = 0;
+    candidate.eliminated = false;
+    candidates.push_back(candidate);
+  }
+#if !(SYCL || LIBRETT_USES_CPU)
+  startEvents.resize(numExplore);
+  endEvents.resize(numExplore);
+  for (int i=0;i < numExplore;i++) {
+  #if HIP
+    hipCheck(hipEventCreate(&startEvents[i]));
+    hipCheck(hipEventCreate(&endEvents[i]));
+  #else // CUDA
+    cudaCheck(cudaEventCreate(&startEvents[i]));
+    cudaCheck(cudaEventCreate(&endEvents[i]));
+  #endif
+  }
+#endif
+}
+
+AdaptivePlan::~AdaptivePlan() {
+#if HIP
+  for (size_t i=0;i < startEvents.size();i++) {
+    hipEventDestroy(startEvents[i]);
+    hipEventDestroy(endEvents[i]);
+  }
+#elif !(SYCL || LIBRETT_USES_CPU)
+  for (size_t i=0;i < startEvents.size();i++) {
+    cudaEventDestroy(startEvents[i]);
+    cudaEventDestroy(endEvents[i]);
+  }
+#endif
+}
+
+//
+// Reads back the times of the runs that have completed, in the order they were queued.
+// wait = true waits for all of them. Called with mutex held
+//
+void AdaptivePlan::collect(const bool wait) {
+#if !(SYCL || LIBRETT_USES_CPU)
+  while (numCollected < (int)runCandidate.size()) {
+    float ms;
+  #if HIP
+    if (wait) {
+      hipCheck(hipEventSynchronize(endEvents[numCollected]));
+    } else {
+      hipError_t err = hipEventQuery(endEvents[numCollected]);
+      if (err == hipErrorNotReady) break;
+      hipCheck(err);
+    }
+    hipCheck(hipEventElapsedTime(&ms, startEvents[numCollected], endEvents[numCollected]));
+  #else // CUDA
+    if (wait) {
+      cudaCheck(cudaEventSynchronize(endEvents[numCollected]));
+    } else {
+      cudaError_t err = cudaEventQuery(endEvents[numCollected]);
+      if (err == cudaErrorNotReady) break;
+      cudaCheck(err);
+    }
+    cudaCheck(cudaEventElapsedTime(&ms, startEvents[numCollected], endEvents[numCollected]));
+  #endif
+    candidates[runCandidate[numCollected]].times.push_back(ms*1.0e-3);
+    numCollected++;
+  }
+#else
+  // Host and SYCL runs are timed synchronously in execute()
+  (void)wait;
+#endif
+}
+
+//
+// Stops running the candidates that are clearly slower than the best one. A candidate
+// needs two runs, the first run of a plan may be slowed down by cold caches
+//
+void AdaptivePlan::eliminate() {
+  double bestTime = 1.0e40;
+  for (const Candidate& candidate : candidates) {
+    if (!candidate.times.empty()) bestTime = std::min(bestTime, median(candidate.times));
+  }
+  for (Candidate& candidate : candidates) {
+    if (candidate.eliminated || candidate.times.size() < 2) continue;
+    const double minTime = *std::min_element(candidate.times.begin(), candidate.times.end());
+    if (minTime > ELIMINATE_FACTOR*bestTime) candidate.eliminated = true;
+  }
+}
+
+//
+// Returns the candidate with the fewest runs, the better one of the model on ties
+//
+int AdaptivePlan::pick() {
+  int best = -1;
+  for (int i=0;i < (int)candidates.size();i++) {
+    if (candidates[i].eliminated) continue;
+    if (best == -1 || candidates[i].numRun < candidates[best].numRun) best = i;
+  }
+  return best;
+}
+
+//
+// Chooses the candidate with the lowest median time and frees the others
+//
+void AdaptivePlan::choose() {
+  collect(true);
+  int best = 0;
+  double bestTime = 1.0e40;
+  for (int i=0;i < (int)candidates.size();i++) {
+    if (candidates[i].times.empty()) continue;
+    const double time = median(candidates[i].times);
+    if (time < bestTime) {
+      best = i;
+      bestTime = time;
+    }
+  }
+  chosenPlan = candidates[best].plan;
+  // Candidates in use by executions of current() are freed when the executions return
+  for (Candidate& candidate : candidates) candidate.plan.reset();
+#if HIP
+  for (int i=0;i < numExplore;i++) {
+    hipCheck(hipEventDestroy(startEvents[i]));
+    hipCheck(hipEventDestroy(endEvents[i]));
+  }
+#elif !(SYCL || LIBRETT_USES_CPU)
+  for (int i=0;i < numExplore;i++) {
+    cudaCheck(cudaEventDestroy(startEvents[i]));
+    cudaCheck(cudaEventDestroy(endEvents[i]));
+  }
+#endif
+  startEvents.clear();
+  endEvents.clear();
+  wisdomRecord(wisdomKey, *chosenPlan);
+  done.store(true);
+}
+
+bool AdaptivePlan::execute(gpuStream_t stream, void* idata, void* odata, const double alpha, const double beta,
+  bool& chosen) {
+  chosen = false;
+  if (done.load()) return librettKernel(*chosenPlan, stream, idata, odata, alpha, beta);
+
+  // Exploring executions are serialized
+  std::lock_guard<std::mutex> lock(mutex);
+  if (done.load()) return librettKernel(*chosenPlan, stream, idata, odata, alpha, beta);
+  if ((int)runCandidate.size() == numExplore) {
+    choose();
+    chosen = true;
+    return librettKernel(*chosenPlan, stream, idata, odata, alpha, beta);
+  }
+
+  collect(false);
+  eliminate();
+  const int c = pick();
+  librettPlan_t& plan = *candidates[c].plan;
+  const int run = (int)runCandidate.size();
+#if SYCL || LIBRETT_USES_CPU
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  if (!librettKernel(plan, stream, idata, odata, alpha, beta)) return false;
+  #if SYCL
+  stream->wait_and_throw();
+  #endif
+  const double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  candidates[c].times.push_back(time);
+  numCollected = run + 1;
+#elif HIP
+  hipCheck(hipEventRecord(startEvents[run], stream));
+  if (!librettKernel(plan, stream, idata, odata, alpha, beta)) return false;
+  hipCheck(hipEventRecord(endEvents[run], stream));
+#else // CUDA
+  cudaCheck(cudaEventRecord(startEvents[run], stream));
+  if (!librettKernel(plan, stream, idata, odata, alpha, beta)) return false;
+  cudaCheck(cudaEventRecord(endEvents[run], stream));
+#endif
+  runCandidate.push_back(c);
+  candidates[c].numRun++;
+  return true;
+}
+
+std::shared_ptr<librettPlan_t> AdaptivePlan::current() {
+  if (done.load()) return chosenPlan;
+  std::lock_guard<std::mutex> lock(mutex);
+  if (done.load()) return chosenPlan;
+  return candidates[0].plan;
+}
@@ -0,0 +1,97 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2026 Librett developers
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+#ifndef LIBRETTADAPTIVEPLAN_H
+#define LIBRETTADAPTIVEPLAN_H
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "plan.h"
+
+//
+// Plan of librettPlanAdaptive(): a few activated candidates that are run in turn and timed
+// during the first numExplore executions. Candidates whose fastest run is ELIMINATE_FACTOR
+// times slower than the median of the best candidate are not run again. The execution
+// after the exploration chooses the candidate with the lowest median time, frees the others
+// and records the choice in wisdom under wisdomKey; from then on executions run the chosen
+// plan without locks.
+//
+// CUDA and HIP builds time the runs with events that are read back by later executions,
+// SYCL and CPU builds wait for each exploring run and time it on the host.
+//
+class AdaptivePlan {
+public:
+  static constexpr double ELIMINATE_FACTOR = 1.5;
+
+  // candidates are activated plans, the best of the model first. Takes ownership of them
+  AdaptivePlan(const std::vector<librettPlan_t*>& candidates, const int numExplore,
+    const std::string& wisdomKey);
+  ~AdaptivePlan();
+
+  // Transposes on stream. chosen is set to true by the execution that ends the exploration
+  bool execute(gpuStream_t stream, void* idata, void* odata, const double alpha, const double beta,
+    bool& chosen);
+
+  // Plan for executions that are not timed, the chosen plan or the best candidate of the
+  // model while exploring. The candidate is kept alive by the returned pointer
+  std::shared_ptr<librettPlan_t> current();
+
+private:
+#if SYCL || LIBRETT_USES_CPU
+  typedef int event_t;
+#elif HIP
+  typedef hipEvent_t event_t;
+#else // CUDA
+  typedef cudaEvent_t event_t;
+#endif
+
+  struct Candidate {
+    std::shared_ptr<librettPlan_t> plan;
+    // Timed runs queued and their times in seconds, once read back
+    int numRun;
+    std::vector<double> times;
+    bool eliminated;
+  };
+
+  const int numExplore;
+  const std::string wisdomKey;
+  std::mutex mutex;
+  std::vector<Candidate> candidates;
+  // Candidate and events of each timed run, runs up to numCollected have been read back
+  std::vector<int> runCandidate;
+  std::vector<event_t> startEvents;
+  std::vector<event_t> endEvents;
+  int numCollected;
+  std::shared_ptr<librettPlan_t> chosenPlan;
+  std::atomic<bool> done;
+
+  void collect(const bool wait);
+  void eliminate();
+  int pick();
+  void choose();
+};
+
+#endif // LIBRETTADAPTIVEPLAN_H
@@ -0,0 +1,686 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2026 Librett developers
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+//
+// Host implementation of the transpose kernels (kernel.h) for the CPU backend.
+// Each GPU thread block maps onto a task of the process-wide ThreadPool.
+// Output elements are written through the store stage of Store.h. The plain copy
+// (StoreCopy) moves elements as raw bytes, scaling stores use float, double and
+// librett_complex elements.
+//
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "GpuUtils.h"
+#include "CpuTile.h"
+#include "ThreadPool.h"
+#include "kernel.h"
+#include "Store.h"
+
+// Number of elements a Packed task moves at minimum
+const int PACKED_TASK_VOL = 4096;
+// Number of elements per row segment in a TiledCopy task
+const int TILEDCOPY_ROW_VOL = 4096;
+
+//
+// Runs func(task) for task = 0 ... n - 1 on the ThreadPool. Index64 plans can have more
+// than INT_MAX tasks, these are submitted in batches of at most INT_MAX tasks.
+//
+template <typename Index, typename Func>
+static void hostParallelFor(const long long int n, const Func& func) {
+  for (long long int t0=0;t0 < n;t0+=INT_MAX) {
+    const int nt = (int)std::min<long long int>(INT_MAX, n - t0);
+    ThreadPool::instance().parallelFor(nt, [&](int t) { func((Index)(t0 + t)); });
+  }
+}
+
+//
+// Returns input and output positions of posMbar.
+// Same sum as the warp reduction over gl_Mbar[] in the GPU kernels
+//
+template <typename Index>
+static inline void hostMbarPos(const Index posMbar, const int sizeMbar, const TensorConvInOutT<Index>* Mbar,
+  Index& posMbarIn, Index& posMbarOut) {
+  posMbarIn = 0;
+  posMbarOut = 0;
+  for (int i=0;i < sizeMbar;i++) {
+    posMbarIn  += ((posMbar/Mbar[i].c_in)  % Mbar[i].d_in) *Mbar[i].ct_in;
+    posMbarOut += ((posMbar/Mbar[i].c_out) % Mbar[i].d_out)*Mbar[i].ct_out;
+  }
+}
+
+//
+// Tensor of Mbar position posMbar: data, or entry i = 0 (input), 1 (output) of the
+// pointer table of a batch, see BatchArg in Types.h
+//
+template <typename T, typename Index>
+static inline T* hostBatchTensor(T* data, const BatchArg<Index>& batch, const Index posMbar, const int i) {
+  return (batch.ptr == nullptr) ? data : (T *)batch.ptr[i*batch.count + posMbar/batch.volMbar];
+}
+
+//
+// Computes pos[j] = sum_i ((j/c[i]) % d[i])*ct[i] for j = 0 ... vol - 1 by stepping
+// through the dimensions in increasing c order instead of dividing for every j
+//
+template <typename Index>
+static void hostPositions(const int vol, const int n, const Index* c, const Index* d, const Index* ct, Index* pos) {
+  std::vector<int> order(n);
+  for (int i=0;i < n;i++) order[i] = i;
+  std::sort(order.begin(), order.end(), [&](int a, int b) { return c[a] < c[b]; });
+  std::vector<Index> digit(n, 0);
+  Index p = 0;
+  for (int j=0;j < vol;j++) {
+    pos[j] = p;
+    for (int k=0;k < n;k++) {
+      int i = order[k];
+      p += ct[i];
+      if (++digit[i] < d[i]) break;
+      p -= digit[i]*ct[i];
+      digit[i] = 0;
+    }
+  }
+}
+
+//
+// Builds gather tables for the Packed methods:
+// dataOut[posMbarOut + posOut[j]] = dataIn[posMbarIn + posIn[j]], j = 0 ... volMmk - 1
+// This is the GPU shared memory round trip with the buffer index folded away.
+// Mmk positions are Index, Msh positions index the staging volume and are always int
+//
+template <typename Index>
+static void hostPackedTables(const int volMmk, const int sizeMmk,
+  const TensorConvInOutT<Index>* Mmk, const TensorConv* Msh,
+  std::vector<Index>& posIn, std::vector<Index>& posOut) {
+  std::vector<Index> c(sizeMmk), d(sizeMmk), ct(sizeMmk);
+  std::vector<int> csh(sizeMmk), dsh(sizeMmk), ctsh(sizeMmk);
+  std::vector<Index> posMmkIn(volMmk);
+  std::vector<int> posSh(volMmk);
+  posIn.resize(volMmk);
+  posOut.resize(volMmk);
+
+  for (int i=0;i < sizeMmk;i++) {
+    c[i] = Mmk[i].c_in;
+    d[i] = Mmk[i].d_in;
+    ct[i] = Mmk[i].ct_in;
+  }
+  hostPositions(volMmk, sizeMmk, c.data(), d.data(), ct.data(), posMmkIn.data());
+
+  for (int i=0;i < sizeMmk;i++) {
+    c[i] = Mmk[i].c_out;
+    d[i] = Mmk[i].d_out;
+    ct[i] = Mmk[i].ct_out;
+  }
+  hostPositions(volMmk, sizeMmk, c.data(), d.data(), ct.data(), posOut.data());
+
+  for (int i=0;i < sizeMmk;i++) {
+    csh[i] = Msh[i].c;
+    dsh[i] = Msh[i].d;
+    ctsh[i] = Msh[i].ct;
+  }
+  hostPositions(volMmk, sizeMmk, csh.data(), dsh.data(), ctsh.data(), posSh.data());
+
+  for (int j=0;j < volMmk;j++) {
+    posIn[j] = posMmkIn[posSh[j]];
+  }
+}
+
+//
+// Transpose when Mm and Mk don't overlap and contain only single rank
+//
+// Tasks are (tile, posMbar) pairs. A TILEDIM x TILEDIM tile of input rows stays in L1
+// while the output is written column by column, which is the role of the shared memory
+// tile on the GPU. The tile itself is moved by the SIMD micro-kernels of CpuTile.h.
+// Scaling stores transpose the tile into a buffer and apply the store row by row.
+//
+template <typename T, typename Index, typename Store>
+void hostTransposeTiled(const int numMm, const Index volMbar, const int sizeMbar,
+  const int2_t tiledVol, const Index cuDimMk, const Index cuDimMm,
+  const TensorConvInOutT<Index>* Mbar, const BatchArg<Index>& batch, const T* dataIn,
+  typename Store::OutType* dataOut, const Store store) {
+
+  const int numMk = (tiledVol.y - 1)/TILEDIM + 1;
+  const int numTile = numMm*numMk;
+  const TileTransposeFunc tileTranspose = tileTransposeFunc(sizeof(T), cpuIsa());
+  // Micro-kernels take int leading dimensions
+  const bool ldIsInt = (cuDimMk <= INT_MAX && cuDimMm <= INT_MAX);
+
+  hostParallelFor<Index>((long long int)numTile*volMbar, [&](Index task) {
+    const Index posMbar = task/numTile;
+    const int tile = (int)(task - posMbar*numTile);
+    const int bx = (tile % numMm)*TILEDIM;
+    const int by = (tile / numMm)*TILEDIM;
+    const int ex = std::min(bx + TILEDIM, tiledVol.x);
+    const int ey = std::min(by + TILEDIM, tiledVol.y);
+
+    Index posMajorIn, posMajorOut;
+    hostMbarPos(posMbar, sizeMbar, Mbar, posMajorIn, posMajorOut);
+
+    const T* in = hostBatchTensor(dataIn, batch, posMbar, 0) + posMajorIn + bx + by*cuDimMk;
+    typename Store::OutType* out = hostBatchTensor(dataOut, batch, posMbar, 1) + posMajorOut + by + bx*cuDimMm;
+    if (!ldIsInt) {
+      for (int x=0;x < ex - bx;x++) {
+        for (int y=0;y < ey - by;y++) {
+          store(out, x*cuDimMm + y, in[x + y*cuDimMk]);
+        }
+      }
+    } else if constexpr (Store::isCopy) {
+      tileTranspose(in, (int)cuDimMk, out, (int)cuDimMm, ex - bx, ey - by);
+    } else {
+      T buf[TILEDIM*TILEDIM];
+      tileTranspose(in, (int)cuDimMk, buf, TILEDIM, ex - bx, ey - by);
+      for (int x=0;x < ex - bx;x++) {
+        typename Store::OutType* outRow = out + x*cuDimMm;
+        const T* bufRow = buf + x*TILEDIM;
+        for (int y=0;y < ey - by;y++) {
+          store(outRow, y, bufRow[y]);
+        }
+      }
+    }
+  });
+}
+
+//
+// Transpose when the lead dimension is the same, e.g. (1, 2, 3) -> (1, 3, 2)
+//
+// Tasks are blocks of TILEDIM rows for one posMbar. Rows are contiguous in both
+// input and output and are moved with memcpy, or through the store for scaling stores.
+//
+template <typename T, typename Index, typename Store>
+void hostTransposeTiledCopy(const Index volMbar, const int sizeMbar,
+  const Index cuDimMk, const Index cuDimMm, const int2_t tiledVol,
+  const TensorConvInOutT<Index>* Mbar, const BatchArg<Index>& batch, const T* dataIn,
+  typename Store::OutType* dataOut, const Store store) {
+
+  const int numX = (tiledVol.x - 1)/TILEDCOPY_ROW_VOL + 1;
+  const int numY = (tiledVol.y - 1)/TILEDIM + 1;
+  const int numBlock = numX*numY;
+
+  hostParallelFor<Index>((long long int)numBlock*volMbar, [&](Index task) {
+    const Index posMbar = task/numBlock;
+    const int block = (int)(task - posMbar*numBlock);
+    const int bx = (block % numX)*TILEDCOPY_ROW_VOL;
+    const int by = (block / numX)*TILEDIM;
+    const int ex = std::min(bx + TILEDCOPY_ROW_VOL, tiledVol.x);
+    const int ey = std::min(by + TILEDIM, tiledVol.y);
+
+    Index posMajorIn, posMajorOut;
+    hostMbarPos(posMbar, sizeMbar, Mbar, posMajorIn, posMajorOut);
+
+    const T* in = hostBatchTensor(dataIn, batch, posMbar, 0);
+    typename Store::OutType* out = hostBatchTensor(dataOut, batch, posMbar, 1);
+    for (int y=by;y < ey;y++) {
+      typename Store::OutType* outRow = out + posMajorOut + bx + y*cuDimMm;
+      const T* inRow = in + posMajorIn + bx + y*cuDimMk;
+      if constexpr (Store::isCopy) {
+        memcpy(outRow, inRow, (ex - bx)*sizeof(T));
+      } else {
+        for (int x=0;x < ex - bx;x++) store(outRow, x, inRow[x]);
+      }
+    }
+  });
+}
+
+//
+// Packed transpose. Mmk is chosen to fit in cache (shmemAlloc() <= sharedMemPerBlock),
+// so the scattered side of the gather hits cache lines that stay resident.
+//
+// Tasks are (volMmk range, posMbar) pairs.
+//
+template <typename T, typename Index, typename Store>
+void hostTransposePacked(const int volMmk, const Index volMbar, const int sizeMbar,
+  const std::vector<Index>* posIn, const std::vector<Index>* posOut, const TensorConvInOutT<Index>* Mbar,
+  const BatchArg<Index>& batch, const T* dataIn, typename Store::OutType* dataOut, const Store store) {
+
+  const Index* pIn = posIn[0].data();
+  const Index* pOut = posOut[0].data();
+
+  const int numChunk = (volMmk - 1)/PACKED_TASK_VOL + 1;
+
+  hostParallelFor<Index>((long long int)numChunk*volMbar, [&](Index task) {
+    const Index posMbar = task/numChunk;
+    const int chunk = (int)(task - posMbar*numChunk);
+    const int j0 = chunk*PACKED_TASK_VOL;
+    const int j1 = std::min(j0 + PACKED_TASK_VOL, volMmk);
+
+    Index posMbarIn, posMbarOut;
+    hostMbarPos(posMbar, sizeMbar, Mbar, posMbarIn, posMbarOut);
+
+    const T* in = hostBatchTensor(dataIn, batch, posMbar, 0) + posMbarIn;
+    typename Store::OutType* out = hostBatchTensor(dataOut, batch, posMbar, 1) + posMbarOut;
+    for (int j=j0;j < j1;j++) {
+      store(out, pOut[j], in[pIn[j]]);
+    }
+  });
+}
+
+//
+// Packed method with a split rank
+//
+// Tasks are (split, posMbar) pairs. Splits with splitDim/numSplit + 1 elements
+// along the split rank use gather table set 1, see librettKernelActivate().
+//
+template <typename T, typename Index, typename Store>
+void hostTransposePackedSplit(const int numSplit,
+  const int splitDim, const int volMmkUnsplit, const Index volMbar,
+  const int sizeMbar, const Index cMmSplit, const Index cMkSplit,
+  const std::vector<Index>* posIn, const std::vector<Index>* posOut, const TensorConvInOutT<Index>* Mbar,
+  const BatchArg<Index>& batch, const T* dataIn, typename Store::OutType* dataOut, const Store store) {
+
+  const int volSplit0 = splitDim/numSplit;
+
+  hostParallelFor<Index>((long long int)numSplit*volMbar, [&](Index task) {
+    const Index posMbar = task/numSplit;
+    const int isplit = (int)(task - posMbar*numSplit);
+    const int p0 = (int)((long long int)isplit*splitDim/numSplit);
+    const int volSplit = (int)((long long int)(isplit + 1)*splitDim/numSplit - p0);
+    const int plusone = volSplit - volSplit0;
+    const int volMmkSplit = volSplit*volMmkUnsplit;
+    const Index* pIn = posIn[plusone].data();
+    const Index* pOut = posOut[plusone].data();
+
+    Index posMbarIn, posMbarOut;
+    hostMbarPos(posMbar, sizeMbar, Mbar, posMbarIn, posMbarOut);
+
+    const T* in = hostBatchTensor(dataIn, batch, posMbar, 0) + posMbarIn + p0*cMmSplit;
+    typename Store::OutType* out = hostBatchTensor(dataOut, batch, posMbar, 1) + posMbarOut + p0*cMkSplit;
+    for (int j=0;j < volMmkSplit;j++) {
+      store(out, pOut[j], in[pIn[j]]);
+    }
+  });
+}
+
+//
+// Copies n bytes, one contiguous slice per pool thread
+//
+static void hostMemcpy(void* dst, const void* src, const size_t n) {
+  ThreadPool& pool = ThreadPool::instance();
+  const size_t numSlice = pool.numThread();
+  const size_t slice = (((n + numSlice - 1)/numSlice + 63)/64)*64;
+  pool.parallelFor((int)numSlice, [&](int i) {
+    size_t i0 = std::min(n, i*slice);
+    size_t i1 = std::min(n, i0 + slice);
+    if (i1 > i0) memcpy((char *)dst + i0, (const char *)src + i0, i1 - i0);
+  });
+}
+
+//
+// Trivial method with a scaling or converting store, vol elements in PACKED_TASK_VOL chunks
+//
+template <typename T, typename Store>
+static void hostScale(const long long int vol, const T* dataIn, typename Store::OutType* dataOut,
+  const Store store) {
+  hostParallelFor<long long int>((vol - 1)/PACKED_TASK_VOL + 1, [&](long long int chunk) {
+    const long long int i0 = chunk*PACKED_TASK_VOL;
+    const long long int i1 = std::min<long long int>(i0 + PACKED_TASK_VOL, vol);
+    for (long long int i=i0;i < i1;i++) store(dataOut, i, dataIn[i]);
+  });
+}
+
+//
+// Sets shared memory bank configuration for all kernels. Nothing to do on the host.
+//
+void librettKernelSetSharedMemConfig() {
+}
+
+//
+// Host kernels have no register or shared memory limits, see librettKernelLaunchConfiguration()
+//
+void librettKernelResources(std::vector<KernelResource>&) {
+}
+
+//
+// Builds the gather tables of the Packed and PackedSplit host kernels once per plan.
+// Set 1 holds the PackedSplit splits with one more element along the split rank.
+//
+void librettKernelActivate(librettPlan_t& plan) {
+  const TensorSplit& ts = plan.tensorSplit;
+  if (ts.method != Packed && ts.method != PackedSplit) return;
+  if (!plan.hostPosIn[0].empty() || !plan.hostPosIn64[0].empty()) return;
+
+  const int volSplit0 = (ts.method == Packed) ? 0 : ts.splitDim/ts.numSplit;
+  const int volMmk0 = (ts.method == Packed) ? (int)ts.volMmk : volSplit0*ts.volMmkUnsplit;
+  const bool plusone = (ts.method == PackedSplit) && (ts.splitDim % ts.numSplit > 0);
+  const TensorConv* Msh = plan.hostMsh.data();
+  if (plan.index64) {
+    const TensorConvInOut64* Mmk = plan.hostMmk64.data();
+    hostPackedTables(volMmk0, ts.sizeMmk, Mmk, Msh, plan.hostPosIn64[0], plan.hostPosOut64[0]);
+    if (plusone) {
+      hostPackedTables((volSplit0 + 1)*ts.volMmkUnsplit, ts.sizeMmk, Mmk + ts.sizeMmk, Msh + ts.sizeMmk,
+        plan.hostPosIn64[1], plan.hostPosOut64[1]);
+    }
+  } else {
+    const TensorConvInOut* Mmk = plan.hostMmk.data();
+    hostPackedTables(volMmk0, ts.sizeMmk, Mmk, Msh, plan.hostPosIn[0], plan.hostPosOut[0]);
+    if (plusone) {
+      hostPackedTables((volSplit0 + 1)*ts.volMmkUnsplit, ts.sizeMmk, Mmk + ts.sizeMmk, Msh + ts.sizeMmk,
+        plan.hostPosIn[1], plan.hostPosOut[1]);
+    }
+  }
+}
+
+//
+// Sets up kernel launch configuration
+//
+// Returns the number of active blocks per SM that can be achieved on the Packed kernel
+// NOTE: Returns 0 when kernel execution is not possible
+//
+// On the host every block is a pool task, so numActiveBlock is always 1. numthread and
+// numRegStorage are kept at their GPU meaning because countCycles() uses them to
+// group accesses into warps.
+//
+int librettKernelLaunchConfiguration(const int sizeofType, const TensorSplit &ts,
+  const int, const gpuDeviceProp_t &prop, LaunchConfig &lc) {
+
+  lc.numthread_x = 1;
+  lc.numthread_y = 1;
+  lc.numthread_z = 1;
+  lc.numblock_x = 1;
+  lc.numblock_y = 1;
+  lc.numblock_z = 1;
+  lc.shmemsize = 0;
+  lc.numRegStorage = 0;
+
+  switch(ts.method) {
+    case Trivial:
+    break;
+
+    case Packed:
+    case PackedSplit:
+    {
+      // Size of the staging volume, this must stay resident in cache
+      lc.shmemsize = ts.shmemAlloc(sizeofType);
+      if (lc.shmemsize > gpuSharedMemPerBlock) return 0;
+
+      int volMmkTask = (ts.method == Packed) ? ts.volMmk :
+        (ts.splitDim/ts.numSplit + ((ts.splitDim % ts.numSplit) > 0))*ts.volMmkUnsplit;
+      lc.numthread_x = std::min(gpuMaxThreadsPerBlock, ((volMmkTask - 1)/gpuWarpSize + 1)*gpuWarpSize);
+      lc.numRegStorage = (volMmkTask - 1)/lc.numthread_x + 1;
+      if (ts.method == Packed) {
+        lc.numblock_x = std::max(1LL, ts.volMbar);
+      } else {
+        lc.numblock_x = ts.numSplit;
+        lc.numblock_y = std::max(1LL, ts.volMbar);
+      }
+    }
+    break;
+
+    case Tiled:
+    {
+      lc.numthread_x = TILEDIM;
+      lc.numthread_y = TILEROWS;
+      lc.numblock_x = ((ts.volMm - 1)/TILEDIM + 1)*((ts.volMk - 1)/TILEDIM + 1);
+      lc.numblock_z = std::max(1LL, ts.volMbar);
+    }
+    break;
+
+    case TiledCopy:
+    {
+      lc.numthread_x = TILEDIM;
+      lc.numthread_y = TILEROWS;
+      lc.numblock_x = ((ts.volMm - 1)/TILEDIM + 1)*((ts.volMkBar - 1)/TILEDIM + 1);
+      lc.numblock_z = std::max(1LL, ts.volMbar);
+    }
+    break;
+  }
+
+  return 1;
+}
+
+bool librettKernel(librettPlan_t &plan, gpuStream_t, void *dataIn, void *dataOut, const double alpha,
+  const double beta, const bool batched)
+{
+  // Batched execution appends the batch rank to Mbar, see librettPlan_t::setupBatch()
+  TensorSplit ts = plan.tensorSplit;
+  // Host memory is device memory here: the host descriptors are used directly, short
+  // descriptors have no device buffer, see librettPlan_t::activate()
+  const TensorConvInOut* Mbar = batched ? plan.hostMbarBatch.data() : plan.hostMbar.data();
+  const TensorConvInOut64* Mbar64 = batched ? plan.hostMbarBatch64.data() : plan.hostMbar64.data();
+  if (batched) {
+    ts.sizeMbar++;
+    ts.volMbar *= plan.batchCount;
+  }
+  // Batches of pointers, see librettPlan_t::setupBatchPointers()
+  BatchArg<int> batch = {nullptr, 0, 1};
+  BatchArg<long long int> batch64 = {nullptr, 0, 1};
+  if (batched && plan.batchPointers) {
+    batch = {plan.hostBatchData.data(), (int)plan.batchCount, (int)plan.tensorSplit.volMbar};
+    batch64 = {plan.hostBatchData.data(), plan.batchCount, plan.tensorSplit.volMbar};
+  }
+
+  // Store stage, see Store.h. Elements of 1 and 2 bytes are only copied
+  const int mode = (plan.typeIn != -1) ? StoreModeConvert :
+    ((plan.sizeofType < 4) ? StoreModeCopy : storeMode(alpha, beta));
+
+  // Calls CALL0(TYPE, STORE) with the element type and store of the mode
+  #define CALLS(COPYTYPE, TYPE) \
+    if (mode == StoreModeCopy) { CALL0(COPYTYPE, StoreCopy<COPYTYPE>); } \
+    else if (mode == StoreModeScale) { CALL0(TYPE, StoreScale<TYPE>); } \
+    else { CALL0(TYPE, StoreAxpby<TYPE>); }
+
+  // Converting plans: calls CALL0(TYPE, STORE) with the input element type and the
+  // converting store
+  #define CONVERT \
+    if (plan.typeIn == LIBRETT_FLOAT64) { CALL0(double, StoreConvert<float>); } \
+    if (plan.typeIn == LIBRETT_FLOAT16) { CALL0(Half, StoreConvert<float>); } \
+    if (plan.typeIn == LIBRETT_BFLOAT16) { CALL0(BFloat16, StoreConvert<float>); } \
+    if (plan.typeIn == LIBRETT_FLOAT32) { \
+      if (plan.typeOut == LIBRETT_FLOAT64) { CALL0(float, StoreConvert<double>); } \
+      if (plan.typeOut == LIBRETT_FLOAT16) { CALL0(float, StoreConvert<Half>); } \
+      if (plan.typeOut == LIBRETT_BFLOAT16) { CALL0(float, StoreConvert<BFloat16>); } \
+    }
+
+  switch(ts.method) {
+    case Trivial:
+    {
+      if (mode == StoreModeCopy) {
+        hostMemcpy(dataOut, dataIn, (size_t)ts.volMmk*ts.volMbar*plan.sizeofType);
+      } else {
+        #define CALL0(TYPE, STORE) \
+          hostScale<TYPE>(ts.volMmk*ts.volMbar, (TYPE *)dataIn, (STORE::OutType *)dataOut, STORE(alpha, beta));
+        if (mode == StoreModeConvert) {
+          CONVERT
+        } else {
+          if (plan.sizeofType == 4) { CALLS(float, float); }
+          if (plan.sizeofType == 8) { CALLS(double, double); }
+          if (plan.sizeofType == 16) { CALLS(librett_complex, librett_complex); }
+        }
+        #undef CALL0
+      }
+    }
+    break;
+
+    case Packed:
+    {
+      #define CALL0(TYPE, STORE) \
+        if (plan.index64) { \
+          hostTransposePacked<TYPE, long long int>((int)ts.volMmk, ts.volMbar, ts.sizeMbar, \
+            plan.hostPosIn64, plan.hostPosOut64, Mbar64, batch64, (TYPE *)dataIn, (STORE::OutType *)dataOut, STORE(alpha, beta)); \
+        } else { \
+          hostTransposePacked<TYPE, int>((int)ts.volMmk, (int)ts.volMbar, ts.sizeMbar, \
+            plan.hostPosIn, plan.hostPosOut, Mbar, batch, (TYPE *)dataIn, (STORE::OutType *)dataOut, STORE(alpha, beta)); \
+        }
+      if (mode == StoreModeConvert) {
+        CONVERT
+      } else {
+        if (plan.sizeofType == 1) { CALL0(uint8_t, StoreCopy<uint8_t>); }
+        if (plan.sizeofType == 2) { CALL0(uint16_t, StoreCopy<uint16_t>); }
+        if (plan.sizeofType == 4) { CALLS(uint32_t, float); }
+        if (plan.sizeofType == 8) { CALLS(uint64_t, double); }
+        if (plan.sizeofType == 16) { CALLS(Bytes16, librett_complex); }
+      }
+      #undef CALL0
+    }
+    break;
+
+    case PackedSplit:
+    {
+      #define CALL0(TYPE, STORE) \
+        if (plan.index64) { \
+          hostTransposePackedSplit<TYPE, long long int>(ts.numSplit, ts.splitDim, ts.volMmkUnsplit, ts.volMbar, \
+            ts.sizeMbar, plan.cuDimMm, plan.cuDimMk, \
+            plan.hostPosIn64, plan.hostPosOut64, Mbar64, batch64, (TYPE *)dataIn, (STORE::OutType *)dataOut, STORE(alpha, beta)); \
+        } else { \
+          hostTransposePackedSplit<TYPE, int>(ts.numSplit, ts.splitDim, ts.volMmkUnsplit, (int)ts.volMbar, \
+            ts.sizeMbar, (int)plan.cuDimMm, (int)plan.cuDimMk, \
+            plan.hostPosIn, plan.hostPosOut, Mbar, batch, (TYPE *)dataIn, (STORE::OutType *)dataOut, STORE(alpha, beta)); \
+        }
+      if (mode == StoreModeConvert) {
+        CONVERT
+      } else {
+        if (plan.sizeofType == 1) { CALL0(uint8_t, StoreCopy<uint8_t>); }
+        if (plan.sizeofType == 2) { CALL0(uint16_t, StoreCopy<uint16_t>); }
+        if (plan.sizeofType == 4) { CALLS(uint32_t, float); }
+        if (plan.sizeofType == 8) { CALLS(uint64_t, double); }
+        if (plan.sizeofType == 16) { CALLS(Bytes16, librett_complex); }
+      }
+      #undef CALL0
+    }
+    break;
+
+    case Tiled:
+    {
+      #define CALL0(TYPE, STORE) \
+        if (plan.index64) { \
+          hostTransposeTiled<TYPE, long long int>(((ts.volMm - 1)/TILEDIM + 1), ts.volMbar, ts.sizeMbar, \
+            plan.tiledVol, plan.cuDimMk, plan.cuDimMm, Mbar64, batch64, (TYPE *)dataIn, (STORE::OutType *)dataOut, \
+            STORE(alpha, beta)); \
+        } else { \
+          hostTransposeTiled<TYPE, int>(((ts.volMm - 1)/TILEDIM + 1), (int)ts.volMbar, ts.sizeMbar, \
+            plan.tiledVol, (int)plan.cuDimMk, (int)plan.cuDimMm, Mbar, batch, (TYPE *)dataIn, (STORE::OutType *)dataOut, \
+            STORE(alpha, beta)); \
+        }
+      if (mode == StoreModeConvert) {
+        CONVERT
+      } else {
+        if (plan.sizeofType == 1) { CALL0(uint8_t, StoreCopy<uint8_t>); }
+        if (plan.sizeofType == 2) { CALL0(uint16_t, StoreCopy<uint16_t>); }
+        if (plan.sizeofType == 4) { CALLS(uint32_t, float); }
+        if (plan.sizeofType == 8) { CALLS(uint64_t, double); }
+        if (plan.sizeofType == 16) { CALLS(Bytes16, librett_complex); }
+      }
+      #undef CALL0
+    }
+    break;
+
+    case TiledCopy:
+    {
+      #define CALL0(TYPE, STORE) \
+        if (plan.index64) { \
+          hostTransposeTiledCopy<TYPE, long long int>(ts.volMbar, ts.sizeMbar, plan.cuDimMk, plan.cuDimMm, \
+            plan.tiledVol, Mbar64, batch64, (TYPE *)dataIn, (STORE::OutType *)dataOut, STORE(alpha, beta)); \
+        } else { \
+          hostTransposeTiledCopy<TYPE, int>((int)ts.volMbar, ts.sizeMbar, (int)plan.cuDimMk, (int)plan.cuDimMm, \
+            plan.tiledVol, Mbar, batch, (TYPE *)dataIn, (STORE::OutType *)dataOut, STORE(alpha, beta)); \
+        }
+      if (mode == StoreModeConvert) {
+        CONVERT
+      } else {
+        if (plan.sizeofType == 1) { CALL0(uint8_t, StoreCopy<uint8_t>); }
+        if (plan.sizeofType == 2) { CALL0(uint16_t, StoreCopy<uint16_t>); }
+        if (plan.sizeofType == 4) { CALLS(uint32_t, float); }
+        if (plan.sizeofType == 8) { CALLS(uint64_t, double); }
+        if (plan.sizeofType == 16) { CALLS(Bytes16, librett_complex); }
+      }
+      #undef CALL0
+    }
+    break;
+
+    default:
+    return false;
+  }
+  #undef CONVERT
+  #undef CALLS
+
+  return true;
+}
+
+//
+// Grouped transpose of tensors with different shapes and permutations, each in the Tiled
+// or TiledCopy form of librettPlan_t::setupGrouped(). Tasks are the work units of all
+// tensors numbered one tensor after another, so one parallel loop of the ThreadPool
+// balances small and large tensors. Elements are only copied and are moved as bytes.
+//
+bool librettKernelGrouped(const int count, librettPlan_t* const* plans, void* const* dataIn,
+  void* const* dataOut, const gpuDeviceProp_t&)
+{
+  const size_t sizeofType = plans[0]->sizeofType;
+  const TileTransposeFunc tileTranspose = tileTransposeFunc(sizeofType, cpuIsa());
+
+  // Work units per posMbar: TILEDIM x TILEDIM tiles, or blocks of TILEDIM rows of
+  // TILEDCOPY_ROW_VOL elements for the TiledCopy form
+  std::vector<long long int> workStart(count + 1, 0);
+  std::vector<int> numX(count);
+  std::vector<int> numUnit(count);
+  for (int i=0;i < count;i++) {
+    const librettPlan_t& plan = *plans[i];
+    const int rowVol = (plan.groupedMethod == TiledCopy) ? TILEDCOPY_ROW_VOL : TILEDIM;
+    numX[i] = (plan.groupedVolX - 1)/rowVol + 1;
+    numUnit[i] = numX[i]*((plan.groupedVolY - 1)/TILEDIM + 1);
+    workStart[i + 1] = workStart[i] + numUnit[i]*plan.groupedVolMbar;
+  }
+
+  hostParallelFor<long long int>(workStart[count], [&](long long int work) {
+    const int i = (int)(std::upper_bound(workStart.begin(), workStart.end(), work) - workStart.begin()) - 1;
+    const librettPlan_t& plan = *plans[i];
+    const long long int unit = work - workStart[i];
+    const long long int posMbar = unit/numUnit[i];
+    const int block = (int)(unit - posMbar*numUnit[i]);
+    const long long int cuDimMk = plan.groupedCuDimMk;
+    const long long int cuDimMm = plan.groupedCuDimMm;
+
+    long long int posMajorIn, posMajorOut;
+    hostMbarPos(posMbar, (int)plan.hostMbarGrouped.size(), plan.hostMbarGrouped.data(), posMajorIn, posMajorOut);
+    const char* in = (const char *)dataIn[i] + posMajorIn*sizeofType;
+    char* out = (char *)dataOut[i] + posMajorOut*sizeofType;
+
+    if (plan.groupedMethod == TiledCopy) {
+      const int bx = (block % numX[i])*TILEDCOPY_ROW_VOL;
+      const int by = (block / numX[i])*TILEDIM;
+      const int ex = std::min(bx + TILEDCOPY_ROW_VOL, plan.groupedVolX);
+      const int ey = std::min(by + TILEDIM, plan.groupedVolY);
+      for (int y=by;y < ey;y++) {
+        memcpy(out + (bx + y*cuDimMm)*sizeofType, in + (bx + y*cuDimMk)*sizeofType, (ex - bx)*sizeofType);
+      }
+    } else {
+      const int bx = (block % numX[i])*TILEDIM;
+      const int by = (block / numX[i])*TILEDIM;
+      const int ex = std::min(bx + TILEDIM, plan.groupedVolX);
+      const int ey = std::min(by + TILEDIM, plan.groupedVolY);
+      in += (bx + by*cuDimMk)*sizeofType;
+      out += (by + bx*cuDimMm)*sizeofType;
+      if (cuDimMk <= INT_MAX && cuDimMm <= INT_MAX) {
+        tileTranspose(in, (int)cuDimMk, out, (int)cuDimMm, ex - bx, ey - by);
+      } else {
+        for (int x=0;x < ex - bx;x++) {
+          for (int y=0;y < ey - by;y++) {
+            memcpy(out + (x*cuDimMm + y)*sizeofType, in + (x + y*cuDimMk)*sizeofType, sizeofType);
+          }
+        }
+      }
+    }
+  });
+
+  return true;
+}
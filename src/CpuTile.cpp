@@ -0,0 +1,443 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2026 Librett developers
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "CpuTile.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+  #define TILE_X86 1
+  #include <immintrin.h>
+#endif
+
+//
+// Reference loop, used for element sizes and hosts without a vector version
+//
+template <typename T>
+static void tileScalar(const void* vin, const int ldIn, void* vout, const int ldOut,
+  const int nx, const int ny) {
+  const T* in = (const T *)vin;
+  T* out = (T *)vout;
+  for (int x=0;x < nx;x++) {
+    T* outx = out + (size_t)x*ldOut;
+    for (int y=0;y < ny;y++) {
+      outx[y] = in[x + (size_t)y*ldIn];
+    }
+  }
+}
+
+#if TILE_X86
+
+//
+// Edge of a block that does not fill a whole micro tile
+//
+template <typename T>
+static inline void tileEdge(const T* p, const int ldIn, T* q, const int ldOut, const int mx, const int my) {
+  for (int x=0;x < mx;x++) {
+    for (int y=0;y < my;y++) {
+      q[y + (size_t)x*ldOut] = p[x + (size_t)y*ldIn];
+    }
+  }
+}
+
+//
+// AVX2, 1 byte elements, 8x8 micro tiles of 64-bit rows
+//
+__attribute__((target("avx2")))
+static void tileAVX2_1(const void* vin, const int ldIn, void* vout, const int ldOut,
+  const int nx, const int ny) {
+  const uint8_t* in = (const uint8_t *)vin;
+  uint8_t* out = (uint8_t *)vout;
+  for (int x0=0;x0 < nx;x0 += 8) {
+    const int mx = std::min(8, nx - x0);
+    for (int y0=0;y0 < ny;y0 += 8) {
+      const int my = std::min(8, ny - y0);
+      const uint8_t* p = in + x0 + (size_t)y0*ldIn;
+      uint8_t* q = out + y0 + (size_t)x0*ldOut;
+      if (mx < 8 || my < 8) {
+        tileEdge(p, ldIn, q, ldOut, mx, my);
+        continue;
+      }
+      __m128i r[8];
+      for (int i=0;i < 8;i++) r[i] = _mm_loadl_epi64((const __m128i *)(p + (size_t)i*ldIn));
+      __m128i t0 = _mm_unpacklo_epi8(r[0], r[1]);
+      __m128i t1 = _mm_unpacklo_epi8(r[2], r[3]);
+      __m128i t2 = _mm_unpacklo_epi8(r[4], r[5]);
+      __m128i t3 = _mm_unpacklo_epi8(r[6], r[7]);
+      __m128i s0 = _mm_unpacklo_epi16(t0, t1);
+      __m128i s1 = _mm_unpackhi_epi16(t0, t1);
+      __m128i s2 = _mm_unpacklo_epi16(t2, t3);
+      __m128i s3 = _mm_unpackhi_epi16(t2, t3);
+      // Output rows 2k and 2k + 1 in the low and high halves
+      __m128i u[4];
+      u[0] = _mm_unpacklo_epi32(s0, s2);
+      u[1] = _mm_unpackhi_epi32(s0, s2);
+      u[2] = _mm_unpacklo_epi32(s1, s3);
+      u[3] = _mm_unpackhi_epi32(s1, s3);
+      for (int k=0;k < 4;k++) {
+        _mm_storel_epi64((__m128i *)(q + (size_t)(2*k)*ldOut), u[k]);
+        _mm_storel_epi64((__m128i *)(q + (size_t)(2*k + 1)*ldOut), _mm_unpackhi_epi64(u[k], u[k]));
+      }
+    }
+  }
+}
+
+//
+// AVX2, 2 byte elements, 8x8 micro tiles of 128-bit rows
+//
+__attribute__((target("avx2")))
+static void tileAVX2_2(const void* vin, const int ldIn, void* vout, const int ldOut,
+  const int nx, const int ny) {
+  const uint16_t* in = (const uint16_t *)vin;
+  uint16_t* out = (uint16_t *)vout;
+  for (int x0=0;x0 < nx;x0 += 8) {
+    const int mx = std::min(8, nx - x0);
+    for (int y0=0;y0 < ny;y0 += 8) {
+      const int my = std::min(8, ny - y0);
+      const uint16_t* p = in + x0 + (size_t)y0*ldIn;
+      uint16_t* q = out + y0 + (size_t)x0*ldOut;
+      if (mx < 8 || my < 8) {
+        tileEdge(p, ldIn, q, ldOut, mx, my);
+        continue;
+      }
+      __m128i r[8];
+      for (int i=0;i < 8;i++) r[i] = _mm_loadu_si128((const __m128i *)(p + (size_t)i*ldIn));
+      __m128i t0 = _mm_unpacklo_epi16(r[0], r[1]);
+      __m128i t1 = _mm_unpackhi_epi16(r[0], r[1]);
+      __m128i t2 = _mm_unpacklo_epi16(r[2], r[3]);
+      __m128i t3 = _mm_unpackhi_epi16(r[2], r[3]);
+      __m128i t4 = _mm_unpacklo_epi16(r[4], r[5]);
+      __m128i t5 = _mm_unpackhi_epi16(r[4], r[5]);
+      __m128i t6 = _mm_unpacklo_epi16(r[6], r[7]);
+      __m128i t7 = _mm_unpackhi_epi16(r[6], r[7]);
+      __m128i s0 = _mm_unpacklo_epi32(t0, t2);
+      __m128i s1 = _mm_unpackhi_epi32(t0, t2);
+      __m128i s2 = _mm_unpacklo_epi32(t1, t3);
+      __m128i s3 = _mm_unpackhi_epi32(t1, t3);
+      __m128i s4 = _mm_unpacklo_epi32(t4, t6);
+      __m128i s5 = _mm_unpackhi_epi32(t4, t6);
+      __m128i s6 = _mm_unpacklo_epi32(t5, t7);
+      __m128i s7 = _mm_unpackhi_epi32(t5, t7);
+      r[0] = _mm_unpacklo_epi64(s0, s4);
+      r[1] = _mm_unpackhi_epi64(s0, s4);
+      r[2] = _mm_unpacklo_epi64(s1, s5);
+      r[3] = _mm_unpackhi_epi64(s1, s5);
+      r[4] = _mm_unpacklo_epi64(s2, s6);
+      r[5] = _mm_unpackhi_epi64(s2, s6);
+      r[6] = _mm_unpacklo_epi64(s3, s7);
+      r[7] = _mm_unpackhi_epi64(s3, s7);
+      for (int j=0;j < 8;j++) _mm_storeu_si128((__m128i *)(q + (size_t)j*ldOut), r[j]);
+    }
+  }
+}
+
+//
+// AVX2, 4 byte elements, 8x8 micro tiles
+//
+__attribute__((target("avx2")))
+static inline void transpose8x8ps(__m256 r[8]) {
+  __m256 t0 = _mm256_unpacklo_ps(r[0], r[1]);
+  __m256 t1 = _mm256_unpackhi_ps(r[0], r[1]);
+  __m256 t2 = _mm256_unpacklo_ps(r[2], r[3]);
+  __m256 t3 = _mm256_unpackhi_ps(r[2], r[3]);
+  __m256 t4 = _mm256_unpacklo_ps(r[4], r[5]);
+  __m256 t5 = _mm256_unpackhi_ps(r[4], r[5]);
+  __m256 t6 = _mm256_unpacklo_ps(r[6], r[7]);
+  __m256 t7 = _mm256_unpackhi_ps(r[6], r[7]);
+  __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+  r[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+  r[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+  r[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+  r[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+  r[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+  r[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+  r[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+  r[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+}
+
+// First n of the 8 lanes set
+__attribute__((target("avx2")))
+static inline __m256i laneMask8(const int n) {
+  return _mm256_cmpgt_epi32(_mm256_set1_epi32(n), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+__attribute__((target("avx2")))
+static void tileAVX2_4(const void* vin, const int ldIn, void* vout, const int ldOut,
+  const int nx, const int ny) {
+  const float* in = (const float *)vin;
+  float* out = (float *)vout;
+  for (int x0=0;x0 < nx;x0 += 8) {
+    const int mx = std::min(8, nx - x0);
+    for (int y0=0;y0 < ny;y0 += 8) {
+      const int my = std::min(8, ny - y0);
+      const float* p = in + x0 + (size_t)y0*ldIn;
+      float* q = out + y0 + (size_t)x0*ldOut;
+      __m256 r[8];
+      if (mx == 8 && my == 8) {
+        for (int i=0;i < 8;i++) r[i] = _mm256_loadu_ps(p + (size_t)i*ldIn);
+        transpose8x8ps(r);
+        for (int j=0;j < 8;j++) _mm256_storeu_ps(q + (size_t)j*ldOut, r[j]);
+      } else {
+        const __m256i mask = laneMask8(mx);
+        for (int i=0;i < 8;i++) r[i] = (i < my) ? _mm256_maskload_ps(p + (size_t)i*ldIn, mask) : _mm256_setzero_ps();
+        transpose8x8ps(r);
+        const __m256i maskOut = laneMask8(my);
+        for (int j=0;j < mx;j++) _mm256_maskstore_ps(q + (size_t)j*ldOut, maskOut, r[j]);
+      }
+    }
+  }
+}
+
+//
+// AVX2, 8 byte elements, 4x4 micro tiles
+//
+__attribute__((target("avx2")))
+static inline void transpose4x4pd(__m256d r[4]) {
+  __m256d t0 = _mm256_unpacklo_pd(r[0], r[1]);
+  __m256d t1 = _mm256_unpackhi_pd(r[0], r[1]);
+  __m256d t2 = _mm256_unpacklo_pd(r[2], r[3]);
+  __m256d t3 = _mm256_unpackhi_pd(r[2], r[3]);
+  r[0] = _mm256_permute2f128_pd(t0, t2, 0x20);
+  r[1] = _mm256_permute2f128_pd(t1, t3, 0x20);
+  r[2] = _mm256_permute2f128_pd(t0, t2, 0x31);
+  r[3] = _mm256_permute2f128_pd(t1, t3, 0x31);
+}
+
+// First n of the 4 lanes set
+__attribute__((target("avx2")))
+static inline __m256i laneMask4(const int n) {
+  return _mm256_cmpgt_epi64(_mm256_set1_epi64x(n), _mm256_setr_epi64x(0, 1, 2, 3));
+}
+
+__attribute__((target("avx2")))
+static void tileAVX2_8(const void* vin, const int ldIn, void* vout, const int ldOut,
+  const int nx, const int ny) {
+  const double* in = (const double *)vin;
+  double* out = (double *)vout;
+  for (int x0=0;x0 < nx;x0 += 4) {
+    const int mx = std::min(4, nx - x0);
+    for (int y0=0;y0 < ny;y0 += 4) {
+      const int my = std::min(4, ny - y0);
+      const double* p = in + x0 + (size_t)y0*ldIn;
+      double* q = out + y0 + (size_t)x0*ldOut;
+      __m256d r[4];
+      if (mx == 4 && my == 4) {
+        for (int i=0;i < 4;i++) r[i] = _mm256_loadu_pd(p + (size_t)i*ldIn);
+        transpose4x4pd(r);
+        for (int j=0;j < 4;j++) _mm256_storeu_pd(q + (size_t)j*ldOut, r[j]);
+      } else {
+        const __m256i mask = laneMask4(mx);
+        for (int i=0;i < 4;i++) r[i] = (i < my) ? _mm256_maskload_pd(p + (size_t)i*ldIn, mask) : _mm256_setzero_pd();
+        transpose4x4pd(r);
+        const __m256i maskOut = laneMask4(my);
+        for (int j=0;j < mx;j++) _mm256_maskstore_pd(q + (size_t)j*ldOut, maskOut, r[j]);
+      }
+    }
+  }
+}
+
+//
+// AVX-512, 8 byte elements, 8x8 micro tiles
+//
+__attribute__((target("avx512f")))
+static inline void transpose8x8pd(__m512d r[8]) {
+  const __m512i idxLo2 = _mm512_setr_epi64(0, 1, 8, 9, 4, 5, 12, 13);
+  const __m512i idxHi2 = _mm512_setr_epi64(2, 3, 10, 11, 6, 7, 14, 15);
+  const __m512i idxLo4 = _mm512_setr_epi64(0, 1, 2, 3, 8, 9, 10, 11);
+  const __m512i idxHi4 = _mm512_setr_epi64(4, 5, 6, 7, 12, 13, 14, 15);
+  __m512d t0 = _mm512_unpacklo_pd(r[0], r[1]);
+  __m512d t1 = _mm512_unpackhi_pd(r[0], r[1]);
+  __m512d t2 = _mm512_unpacklo_pd(r[2], r[3]);
+  __m512d t3 = _mm512_unpackhi_pd(r[2], r[3]);
+  __m512d t4 = _mm512_unpacklo_pd(r[4], r[5]);
+  __m512d t5 = _mm512_unpackhi_pd(r[4], r[5]);
+  __m512d t6 = _mm512_unpacklo_pd(r[6], r[7]);
+  __m512d t7 = _mm512_unpackhi_pd(r[6], r[7]);
+  __m512d s0 = _mm512_permutex2var_pd(t0, idxLo2, t2);
+  __m512d s1 = _mm512_permutex2var_pd(t1, idxLo2, t3);
+  __m512d s2 = _mm512_permutex2var_pd(t0, idxHi2, t2);
+  __m512d s3 = _mm512_permutex2var_pd(t1, idxHi2, t3);
+  __m512d s4 = _mm512_permutex2var_pd(t4, idxLo2, t6);
+  __m512d s5 = _mm512_permutex2var_pd(t5, idxLo2, t7);
+  __m512d s6 = _mm512_permutex2var_pd(t4, idxHi2, t6);
+  __m512d s7 = _mm512_permutex2var_pd(t5, idxHi2, t7);
+  r[0] = _mm512_permutex2var_pd(s0, idxLo4, s4);
+  r[1] = _mm512_permutex2var_pd(s1, idxLo4, s5);
+  r[2] = _mm512_permutex2var_pd(s2, idxLo4, s6);
+  r[3] = _mm512_permutex2var_pd(s3, idxLo4, s7);
+  r[4] = _mm512_permutex2var_pd(s0, idxHi4, s4);
+  r[5] = _mm512_permutex2var_pd(s1, idxHi4, s5);
+  r[6] = _mm512_permutex2var_pd(s2, idxHi4, s6);
+  r[7] = _mm512_permutex2var_pd(s3, idxHi4, s7);
+}
+
+__attribute__((target("avx512f")))
+static void tileAVX512_8(const void* vin, const int ldIn, void* vout, const int ldOut,
+  const int nx, const int ny) {
+  const double* in = (const double *)vin;
+  double* out = (double *)vout;
+  for (int x0=0;x0 < nx;x0 += 8) {
+    const int mx = std::min(8, nx - x0);
+    for (int y0=0;y0 < ny;y0 += 8) {
+      const int my = std::min(8, ny - y0);
+      const double* p = in + x0 + (size_t)y0*ldIn;
+      double* q = out + y0 + (size_t)x0*ldOut;
+      __m512d r[8];
+      if (mx == 8 && my == 8) {
+        for (int i=0;i < 8;i++) r[i] = _mm512_loadu_pd(p + (size_t)i*ldIn);
+        transpose8x8pd(r);
+        for (int j=0;j < 8;j++) _mm512_storeu_pd(q + (size_t)j*ldOut, r[j]);
+      } else {
+        const __mmask8 mask = (__mmask8)((1u << mx) - 1);
+        for (int i=0;i < 8;i++) r[i] = (i < my) ? _mm512_maskz_loadu_pd(mask, p + (size_t)i*ldIn) : _mm512_setzero_pd();
+        transpose8x8pd(r);
+        const __mmask8 maskOut = (__mmask8)((1u << my) - 1);
+        for (int j=0;j < mx;j++) _mm512_mask_storeu_pd(q + (size_t)j*ldOut, maskOut, r[j]);
+      }
+    }
+  }
+}
+
+//
+// AVX-512, 16 byte elements, 4x4 micro tiles of 128-bit lanes
+//
+__attribute__((target("avx512f")))
+static inline void transpose4x4x2pd(__m512d r[4]) {
+  __m512d t0 = _mm512_shuffle_f64x2(r[0], r[1], _MM_SHUFFLE(2, 0, 2, 0));
+  __m512d t1 = _mm512_shuffle_f64x2(r[0], r[1], _MM_SHUFFLE(3, 1, 3, 1));
+  __m512d t2 = _mm512_shuffle_f64x2(r[2], r[3], _MM_SHUFFLE(2, 0, 2, 0));
+  __m512d t3 = _mm512_shuffle_f64x2(r[2], r[3], _MM_SHUFFLE(3, 1, 3, 1));
+  r[0] = _mm512_shuffle_f64x2(t0, t2, _MM_SHUFFLE(2, 0, 2, 0));
+  r[1] = _mm512_shuffle_f64x2(t1, t3, _MM_SHUFFLE(2, 0, 2, 0));
+  r[2] = _mm512_shuffle_f64x2(t0, t2, _MM_SHUFFLE(3, 1, 3, 1));
+  r[3] = _mm512_shuffle_f64x2(t1, t3, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+__attribute__((target("avx512f")))
+static void tileAVX512_16(const void* vin, const int ldIn, void* vout, const int ldOut,
+  const int nx, const int ny) {
+  const double* in = (const double *)vin;
+  double* out = (double *)vout;
+  for (int x0=0;x0 < nx;x0 += 4) {
+    const int mx = std::min(4, nx - x0);
+    for (int y0=0;y0 < ny;y0 += 4) {
+      const int my = std::min(4, ny - y0);
+      const double* p = in + 2*(x0 + (size_t)y0*ldIn);
+      double* q = out + 2*(y0 + (size_t)x0*ldOut);
+      __m512d r[4];
+      if (mx == 4 && my == 4) {
+        for (int i=0;i < 4;i++) r[i] = _mm512_loadu_pd(p + 2*(size_t)i*ldIn);
+        transpose4x4x2pd(r);
+        for (int j=0;j < 4;j++) _mm512_storeu_pd(q + 2*(size_t)j*ldOut, r[j]);
+      } else {
+        // Two mask bits per element
+        const __mmask8 mask = (__mmask8)((1u << 2*mx) - 1);
+        for (int i=0;i < 4;i++) r[i] = (i < my) ? _mm512_maskz_loadu_pd(mask, p + 2*(size_t)i*ldIn) : _mm512_setzero_pd();
+        transpose4x4x2pd(r);
+        const __mmask8 maskOut = (__mmask8)((1u << 2*my) - 1);
+        for (int j=0;j < mx;j++) _mm512_mask_storeu_pd(q + 2*(size_t)j*ldOut, maskOut, r[j]);
+      }
+    }
+  }
+}
+
+#endif // TILE_X86
+
+CpuIsa cpuIsa() {
+  static const CpuIsa isa = []() {
+    CpuIsa best = IsaScalar;
+#if TILE_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) best = IsaAVX2;
+    if (best == IsaAVX2 && __builtin_cpu_supports("avx512f")) best = IsaAVX512;
+#endif
+    const char* env = std::getenv("LIBRETT_CPU_ISA");
+    if (env != nullptr) {
+      CpuIsa cap = best;
+      if (strcmp(env, "scalar") == 0) {
+        cap = IsaScalar;
+      } else if (strcmp(env, "avx2") == 0) {
+        cap = IsaAVX2;
+      } else if (strcmp(env, "avx512") != 0) {
+        printf("LIBRETT_CPU_ISA must be scalar, avx2 or avx512\n");
+      }
+      best = std::min(best, cap);
+    }
+    return best;
+  }();
+  return isa;
+}
+
+const char* cpuIsaName(const CpuIsa isa) {
+  switch(isa) {
+    case IsaAVX2: return "AVX2";
+    case IsaAVX512: return "AVX-512";
+    default: return "scalar";
+  }
+}
+
+TileTransposeFunc tileTransposeFunc(const int sizeofType, const CpuIsa isa) {
+  switch(sizeofType) {
+    case 1:
+#if TILE_X86
+    if (isa >= IsaAVX2) return tileAVX2_1;
+#endif
+    return tileScalar<uint8_t>;
+
+    case 2:
+#if TILE_X86
+    if (isa >= IsaAVX2) return tileAVX2_2;
+#endif
+    return tileScalar<uint16_t>;
+
+    case 4:
+#if TILE_X86
+    if (isa >= IsaAVX2) return tileAVX2_4;
+#endif
+    return tileScalar<uint32_t>;
+
+    case 8:
+#if TILE_X86
+    if (isa >= IsaAVX512) return tileAVX512_8;
+    if (isa >= IsaAVX2) return tileAVX2_8;
+#endif
+    return tileScalar<uint64_t>;
+
+    // A 16 byte element fills a 128-bit lane, on AVX2 the loop already moves whole lanes
+    case 16:
+#if TILE_X86
+    if (isa >= IsaAVX512) return tileAVX512_16;
+#endif
+    return tileScalar<Bytes16>;
+  }
+  return nullptr;
+}
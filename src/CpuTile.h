@@ -0,0 +1,61 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2026 Librett developers
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+#ifndef LIBRETTCPUTILE_H
+#define LIBRETTCPUTILE_H
+
+//
+// Host tile engine for the Tiled method. Transposes 2D blocks of 1, 2, 4, 8 or 16 byte
+// elements through register-blocked micro tiles: 8x8 (1, 2 and 4 bytes) and 4x4 (8 bytes)
+// on AVX2, 8x8 (8 bytes) and 4x4 (16 bytes) on AVX-512. Micro tiles are visited output row
+// by output row, and those on the block edge use masked loads and stores (scalar copies
+// for 1 and 2 byte elements).
+// The instruction set is detected at run time.
+//
+
+#include <cstdint>
+
+// Element types are moved bitwise, no arithmetic is performed on them
+struct Bytes16 {
+  uint64_t lo, hi;
+};
+
+enum CpuIsa {IsaScalar = 0, IsaAVX2 = 1, IsaAVX512 = 2};
+
+//
+// Transposes an nx x ny block:
+// out[x*ldOut + y] = in[x + y*ldIn] for 0 <= x < nx, 0 <= y < ny
+//
+typedef void (*TileTransposeFunc)(const void* in, const int ldIn, void* out, const int ldOut,
+  const int nx, const int ny);
+
+// Best instruction set supported by the host, LIBRETT_CPU_ISA=scalar|avx2|avx512 lowers it
+CpuIsa cpuIsa();
+
+const char* cpuIsaName(const CpuIsa isa);
+
+// Tile transpose for elements of sizeofType bytes using at most the given instruction set.
+// Returns nullptr for unsupported element sizes
+TileTransposeFunc tileTransposeFunc(const int sizeofType, const CpuIsa isa);
+
+#endif // LIBRETTCPUTILE_H
@@ -0,0 +1,242 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2026 Librett developers
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+#include <algorithm>
+#include <cstdlib>
+#include "DescriptorArena.h"
+#include "GpuMem.hpp"
+
+//
+// Makes deviceID the current device for the lifetime of the object: chunks and events
+// belong to the device of the arena, whichever device the caller has set
+//
+struct CurrentDevice {
+#if HIP
+  int prevDevice;
+  CurrentDevice(const int deviceID) {
+    hipCheck(hipGetDevice(&prevDevice));
+    if (prevDevice != deviceID) hipCheck(hipSetDevice(deviceID));
+  }
+  ~CurrentDevice() { hipSetDevice(prevDevice); }
+#elif SYCL || LIBRETT_USES_CPU
+  CurrentDevice(const int) {}
+#else // CUDA
+  int prevDevice;
+  CurrentDevice(const int deviceID) {
+    cudaCheck(cudaGetDevice(&prevDevice));
+    if (prevDevice != deviceID) cudaCheck(cudaSetDevice(deviceID));
+  }
+  ~CurrentDevice() { cudaSetDevice(prevDevice); }
+#endif
+};
+
+DescriptorArena::DescriptorArena(const int deviceID_in) : deviceID(deviceID_in) {
+  for (int i=0;i < NUM_CLASS;i++) {
+    sizeClass[i].chunkPos = nullptr;
+    sizeClass[i].chunkLeft = 0;
+  }
+  stats.reserved = 0;
+  stats.inUse = 0;
+  stats.peak = 0;
+}
+
+DescriptorArena::event_t DescriptorArena::recordEvent(gpuStream_t stream) {
+#if SYCL
+  return stream->ext_oneapi_submit_barrier();
+#elif LIBRETT_USES_CPU
+  // Work on the host streams has completed when the call that queued it returns
+  (void)stream;
+  return 0;
+#else
+  event_t event;
+  if (events.empty()) {
+  #if HIP
+    hipCheck(hipEventCreateWithFlags(&event, hipEventDisableTiming));
+  #else // CUDA
+    cudaCheck(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+  #endif
+  } else {
+    event = events.back();
+    events.pop_back();
+  }
+  #if HIP
+  hipCheck(hipEventRecord(event, stream));
+  #else // CUDA
+  cudaCheck(cudaEventRecord(event, stream));
+  #endif
+  return event;
+#endif
+}
+
+bool DescriptorArena::eventDone(event_t& event) {
+#if SYCL
+  return (event.get_info<sycl::info::event::command_execution_status>() ==
+    sycl::info::event_command_status::complete);
+#elif HIP
+  hipError_t err = hipEventQuery(event);
+  if (err == hipErrorNotReady) return false;
+  hipCheck(err);
+  return true;
+#elif LIBRETT_USES_CPU
+  (void)event;
+  return true;
+#else // CUDA
+  cudaError_t err = cudaEventQuery(event);
+  if (err == cudaErrorNotReady) return false;
+  cudaCheck(err);
+  return true;
+#endif
+}
+
+void DescriptorArena::releaseEvent(event_t& event) {
+#if !(SYCL || LIBRETT_USES_CPU)
+  events.push_back(event);
+#else
+  (void)event;
+#endif
+}
+
+void DescriptorArena::reclaim(SizeClass& sc) {
+  for (auto it=sc.freed.begin();it != sc.freed.end();) {
+    std::deque<Freed>& freed = it->second;
+    // Events of one stream complete in order
+    while (!freed.empty() && eventDone(freed.front().event)) {
+      sc.ready.push_back(freed.front().p);
+      releaseEvent(freed.front().event);
+      freed.pop_front();
+    }
+    // Drop streams without blocks, the stream may have been destroyed
+    if (freed.empty()) {
+      it = sc.freed.erase(it);
+    } else {
+      it++;
+    }
+  }
+}
+
+void* DescriptorArena::allocate(const size_t size, gpuStream_t stream) {
+  int cls = 0;
+  while (cls < NUM_CLASS && (MIN_BLOCK << cls) < size) cls++;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  CurrentDevice device(deviceID);
+
+  char* p = nullptr;
+  size_t blockSize = size;
+  if (cls == NUM_CLASS) {
+    allocate_device<char>(&p, size, stream);
+    blocks[p] = std::make_pair(-1, size);
+    stats.reserved += size;
+  } else {
+    SizeClass& sc = sizeClass[cls];
+    blockSize = MIN_BLOCK << cls;
+    // Blocks freed on this stream are safe to reuse in stream order
+    auto it = sc.freed.find(stream);
+    if (it != sc.freed.end() && !it->second.empty()) {
+      p = it->second.back().p;
+      releaseEvent(it->second.back().event);
+      it->second.pop_back();
+    } else {
+      if (sc.ready.empty()) reclaim(sc);
+      if (!sc.ready.empty()) {
+        p = sc.ready.back();
+        sc.ready.pop_back();
+      }
+    }
+    if (p == nullptr) {
+      if (sc.chunkLeft < blockSize) {
+        allocate_device<char>(&sc.chunkPos, CHUNK_SIZE, stream);
+        chunks.push_back(sc.chunkPos);
+        sc.chunkLeft = CHUNK_SIZE;
+        stats.reserved += CHUNK_SIZE;
+      }
+      p = sc.chunkPos;
+      sc.chunkPos += blockSize;
+      sc.chunkLeft -= blockSize;
+    }
+    blocks[p] = std::make_pair(cls, blockSize);
+  }
+
+  stats.inUse += blockSize;
+  stats.peak = std::max(stats.peak, stats.inUse);
+  return p;
+}
+
+void DescriptorArena::deallocate(void* p, gpuStream_t stream) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = blocks.find(p);
+  if (it == blocks.end()) {
+    printf("DescriptorArena::deallocate, pointer not allocated by the arena\n");
+    exit(1);
+  }
+  const int cls = it->second.first;
+  const size_t blockSize = it->second.second;
+  blocks.erase(it);
+  stats.inUse -= blockSize;
+
+  CurrentDevice device(deviceID);
+  if (cls == -1) {
+    char* pc = (char *)p;
+    deallocate_device<char>(&pc, stream);
+    stats.reserved -= blockSize;
+  } else {
+    Freed freed;
+    freed.p = (char *)p;
+    freed.event = recordEvent(stream);
+    sizeClass[cls].freed[stream].push_back(freed);
+  }
+}
+
+DescriptorArena::Stats DescriptorArena::getStats() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return stats;
+}
+
+// Arenas of all devices. Allocated once and never deleted: plans may be destroyed after
+// static destructors have run, and the device runtime may have shut down at exit
+static std::unordered_map<int, DescriptorArena*>& arenas = *new std::unordered_map<int, DescriptorArena*>();
+static std::mutex arenasMutex;
+
+DescriptorArena& DescriptorArena::instance(const int deviceID) {
+  std::lock_guard<std::mutex> lock(arenasMutex);
+  auto it = arenas.find(deviceID);
+  if (it != arenas.end()) return *it->second;
+  DescriptorArena* arena = new DescriptorArena(deviceID);
+  arenas[deviceID] = arena;
+  return *arena;
+}
+
+DescriptorArena::Stats DescriptorArena::getTotalStats() {
+  Stats total;
+  total.reserved = 0;
+  total.inUse = 0;
+  total.peak = 0;
+  std::lock_guard<std::mutex> lock(arenasMutex);
+  for (auto it=arenas.begin();it != arenas.end();it++) {
+    Stats stats = it->second->getStats();
+    total.reserved += stats.reserved;
+    total.inUse += stats.inUse;
+    total.peak += stats.peak;
+  }
+  return total;
+}
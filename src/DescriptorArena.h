@@ -0,0 +1,137 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2026 Librett developers
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+#ifndef LIBRETTDESCRIPTORARENA_H
+#define LIBRETTDESCRIPTORARENA_H
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "GpuUtils.h"
+
+//
+// Device memory for plan descriptors, one arena per device.
+// Blocks of MIN_BLOCK << k bytes, k = 0 ... NUM_CLASS - 1, are carved from CHUNK_SIZE byte
+// device allocations and kept on per size class free lists; chunks are never returned
+// while the process runs. Freeing a block does not synchronize the device: the block is
+// reused at once on the stream it was freed on, and on other streams once the work queued
+// on that stream before the free has completed. Larger requests are allocated directly.
+//
+class DescriptorArena {
+public:
+  static const size_t MIN_BLOCK = 128;
+  static const int NUM_CLASS = 10;
+  static const size_t CHUNK_SIZE = 1 << 20;
+
+  struct Stats {
+    // Bytes of device memory held by the arena
+    size_t reserved;
+    // Bytes in blocks handed out, rounded up to the block size
+    size_t inUse;
+    // Largest inUse so far
+    size_t peak;
+  };
+
+  // Returns size bytes of device memory for use on stream. Blocks start at multiples of
+  // MIN_BLOCK bytes from the start of a chunk
+  void* allocate(const size_t size, gpuStream_t stream);
+
+  // Returns a block of allocate(), the last use of which was queued on stream
+  void deallocate(void* p, gpuStream_t stream);
+
+  Stats getStats();
+
+  // Arena of device deviceID
+  static DescriptorArena& instance(const int deviceID);
+
+  // Statistics summed over the arenas of all devices
+  static Stats getTotalStats();
+
+private:
+#if SYCL
+  typedef sycl::event event_t;
+#elif HIP
+  typedef hipEvent_t event_t;
+#elif LIBRETT_USES_CPU
+  typedef int event_t;
+#else // CUDA
+  typedef cudaEvent_t event_t;
+#endif
+
+  // Block and the event recorded on its stream when it was freed
+  struct Freed {
+    char* p;
+    event_t event;
+  };
+
+  struct SizeClass {
+    // Blocks without pending work
+    std::vector<char*> ready;
+    // Blocks freed on each stream, oldest first
+    std::unordered_map<gpuStream_t, std::deque<Freed> > freed;
+    // Unused part of the newest chunk of this size class
+    char* chunkPos;
+    size_t chunkLeft;
+  };
+
+  const int deviceID;
+  std::mutex mutex;
+  SizeClass sizeClass[NUM_CLASS];
+  std::vector<char*> chunks;
+  // Blocks in use: size class, -1 for direct allocations, and size in bytes
+  std::unordered_map<void*, std::pair<int, size_t> > blocks;
+  // Events that are free for recording
+  std::vector<event_t> events;
+  Stats stats;
+
+  DescriptorArena(const int deviceID);
+
+  event_t recordEvent(gpuStream_t stream);
+  bool eventDone(event_t& event);
+  void releaseEvent(event_t& event);
+  // Moves the blocks of all streams whose free has completed to sc.ready
+  void reclaim(SizeClass& sc);
+};
+
+//
+// Allocate len elements of descriptor storage on device deviceID
+//
+template <class T>
+void allocate_descriptor(T **pp, const size_t len, const int deviceID, gpuStream_t gpuStream) {
+  *pp = (T *)DescriptorArena::instance(deviceID).allocate(sizeof(T)*len, gpuStream);
+}
+
+//
+// Deallocate descriptor storage, the last use of which was queued on gpuStream
+//
+template <class T>
+void deallocate_descriptor(T **pp, const int deviceID, gpuStream_t gpuStream) {
+  if (*pp != nullptr) {
+    DescriptorArena::instance(deviceID).deallocate(*pp, gpuStream);
+    *pp = nullptr;
+  }
+}
+
+#endif // LIBRETTDESCRIPTORARENA_H
@@ -0,0 +1,350 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2026 Librett developers
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include "DeviceProfile.h"
+#include "Wisdom.h"
+
+const char* DEVICE_PROFILE_HEADER = "librett-device-profile 1";
+
+// Profiles of deviceProfileLoad(), deviceID -1 is the first one, and of the devices of
+// deviceProfileFor(). Neither container moves its elements, deviceProfileGet() and
+// deviceProfileFor() return pointers into them
+static std::deque<DeviceProfile> loadedProfiles;
+static std::map<std::string, int> loadedPaths;
+static std::map<int, DeviceProfile> deviceProfiles;
+static std::mutex profilesMutex;
+
+DeviceProfile::DeviceProfile() : backend(deviceProfileBackend()), major(0), minor(0), warpSize(0),
+  multiProcessorCount(0), maxThreadsPerBlock(0), maxThreadsPerMultiProcessor(0),
+  maxBlocksPerMultiProcessor(0), sharedMemPerBlock(0), sharedMemPerMultiprocessor(0),
+  reservedSharedMemPerBlock(0), sharedMemAllocUnit(1), regsPerBlock(0), regsPerMultiprocessor(0),
+  regAllocUnit(1), regAllocPartitions(1), clockRate(0), memoryClockRate(0), memoryBusWidth(0),
+  ECCEnabled(0), l1CacheSize(0), l2CacheSize(0), l3CacheSize(0), cacheLineSize(0) {}
+
+//
+// Calls f(key, field) on the numeric properties of profile, in file order
+//
+template <typename P, typename F>
+static void visitProperties(P& p, F f) {
+  f("major", p.major);
+  f("minor", p.minor);
+  f("warpSize", p.warpSize);
+  f("multiProcessorCount", p.multiProcessorCount);
+  f("maxThreadsPerBlock", p.maxThreadsPerBlock);
+  f("maxThreadsPerMultiProcessor", p.maxThreadsPerMultiProcessor);
+  f("maxBlocksPerMultiProcessor", p.maxBlocksPerMultiProcessor);
+  f("sharedMemPerBlock", p.sharedMemPerBlock);
+  f("sharedMemPerMultiprocessor", p.sharedMemPerMultiprocessor);
+  f("reservedSharedMemPerBlock", p.reservedSharedMemPerBlock);
+  f("sharedMemAllocUnit", p.sharedMemAllocUnit);
+  f("regsPerBlock", p.regsPerBlock);
+  f("regsPerMultiprocessor", p.regsPerMultiprocessor);
+  f("regAllocUnit", p.regAllocUnit);
+  f("regAllocPartitions", p.regAllocPartitions);
+  f("clockRate", p.clockRate);
+  f("memoryClockRate", p.memoryClockRate);
+  f("memoryBusWidth", p.memoryBusWidth);
+  f("ECCEnabled", p.ECCEnabled);
+  f("l1CacheSize", p.l1CacheSize);
+  f("l2CacheSize", p.l2CacheSize);
+  f("l3CacheSize", p.l3CacheSize);
+  f("cacheLineSize", p.cacheLineSize);
+}
+
+const char* deviceProfileBackend() {
+#if SYCL
+  return "sycl";
+#elif HIP
+  return "hip";
+#elif LIBRETT_USES_CPU
+  return "host";
+#else // CUDA
+  return "cuda";
+#endif
+}
+
+DeviceProfile deviceProfileOf(const gpuDeviceProp_t& prop) {
+  DeviceProfile profile;
+  profile.name = deviceName(prop);
+  profile.major = gpuMajor;
+  profile.warpSize = gpuWarpSize;
+  profile.multiProcessorCount = gpuMultiProcessorCount;
+  profile.maxThreadsPerBlock = gpuMaxThreadsPerBlock;
+  profile.sharedMemPerBlock = gpuSharedMemPerBlock;
+#if SYCL
+  // Clock in MHz. Work-group limits of the Xe cores, local memory has no granularity
+  profile.clockRate = prop.get_max_clock_frequency()*1000;
+  profile.maxThreadsPerMultiProcessor = 2048;
+  profile.maxBlocksPerMultiProcessor = 32;
+  profile.sharedMemPerMultiprocessor = profile.sharedMemPerBlock;
+#elif LIBRETT_USES_CPU
+  // Limits of a GPU with 2048 threads and 32 blocks per SM, as run by the SIMT pool
+  profile.clockRate = prop.clockRate;
+  profile.maxThreadsPerMultiProcessor = 2048;
+  profile.maxBlocksPerMultiProcessor = 32;
+  profile.sharedMemPerMultiprocessor = profile.sharedMemPerBlock;
+  profile.l1CacheSize = prop.l1CacheSize;
+  profile.l2CacheSize = prop.l2CacheSize;
+  profile.l3CacheSize = prop.l3CacheSize;
+  profile.cacheLineSize = prop.cacheLineSize;
+#else // CUDA and HIP
+  profile.minor = prop.minor;
+  profile.maxThreadsPerMultiProcessor = prop.maxThreadsPerMultiProcessor;
+  profile.regsPerBlock = prop.regsPerBlock;
+#if HIP
+  // ROCm before 6 has neither sharedMemPerMultiprocessor nor regsPerMultiprocessor
+  profile.sharedMemPerMultiprocessor = prop.maxSharedMemoryPerMultiProcessor;
+  #if HIP_VERSION_MAJOR >= 6
+  profile.regsPerMultiprocessor = prop.regsPerMultiprocessor;
+  #else
+  profile.regsPerMultiprocessor = prop.regsPerBlock;
+  #endif
+#else // CUDA
+  profile.sharedMemPerMultiprocessor = prop.sharedMemPerMultiprocessor;
+  profile.regsPerMultiprocessor = prop.regsPerMultiprocessor;
+#endif
+  profile.clockRate = prop.clockRate;
+  profile.memoryClockRate = prop.memoryClockRate;
+  profile.memoryBusWidth = prop.memoryBusWidth;
+  profile.ECCEnabled = prop.ECCEnabled;
+#if HIP
+  // Wavefronts take VGPRs in blocks of 8 per lane from one of the 4 SIMDs of a CU,
+  // LDS is allocated in 512 byte blocks
+  profile.maxBlocksPerMultiProcessor = 32;
+  profile.sharedMemAllocUnit = 512;
+  profile.regAllocUnit = 8*64;
+  profile.regAllocPartitions = 4;
+#else // CUDA
+  // Warps take registers in blocks of 256 from one of the sub-partitions of an SM, GP100
+  // has two of them. Shared memory is allocated in 256 byte blocks before Ampere
+  profile.maxBlocksPerMultiProcessor = prop.maxBlocksPerMultiProcessor;
+  profile.reservedSharedMemPerBlock = prop.reservedSharedMemPerBlock;
+  profile.sharedMemAllocUnit = (prop.major >= 8) ? 128 : 256;
+  profile.regAllocUnit = 256;
+  profile.regAllocPartitions = (prop.major == 6 && prop.minor == 0) ? 2 : 4;
+#endif
+#endif
+  return profile;
+}
+
+void deviceProfileProp(const DeviceProfile& profile, gpuDeviceProp_t& prop) {
+#if SYCL
+  prop.set_major_version(profile.major);
+  prop.set_max_clock_frequency(profile.clockRate/1000);
+  prop.set_max_compute_units(profile.multiProcessorCount);
+  prop.set_max_work_group_size(profile.maxThreadsPerBlock);
+  prop.set_min_sub_group_size(profile.warpSize);
+  prop.set_local_mem_size(profile.sharedMemPerBlock);
+#elif LIBRETT_USES_CPU
+  prop = gpuDeviceProp_t();
+  prop.warpSize = profile.warpSize;
+  prop.maxThreadsPerBlock = profile.maxThreadsPerBlock;
+  prop.multiProcessorCount = profile.multiProcessorCount;
+  prop.clockRate = profile.clockRate;
+  prop.major = profile.major;
+  prop.sharedMemPerBlock = profile.sharedMemPerBlock;
+  prop.l1CacheSize = profile.l1CacheSize;
+  prop.l2CacheSize = profile.l2CacheSize;
+  prop.l3CacheSize = profile.l3CacheSize;
+  prop.cacheLineSize = profile.cacheLineSize;
+#else // CUDA and HIP
+  prop = gpuDeviceProp_t();
+  strncpy(prop.name, profile.name.c_str(), sizeof(prop.name) - 1);
+  prop.major = profile.major;
+  prop.minor = profile.minor;
+  prop.warpSize = profile.warpSize;
+  prop.multiProcessorCount = profile.multiProcessorCount;
+  prop.maxThreadsPerBlock = profile.maxThreadsPerBlock;
+  prop.maxThreadsPerMultiProcessor = profile.maxThreadsPerMultiProcessor;
+  prop.sharedMemPerBlock = profile.sharedMemPerBlock;
+  prop.regsPerBlock = profile.regsPerBlock;
+#if HIP
+  prop.maxSharedMemoryPerMultiProcessor = profile.sharedMemPerMultiprocessor;
+  #if HIP_VERSION_MAJOR >= 6
+  prop.regsPerMultiprocessor = profile.regsPerMultiprocessor;
+  #endif
+#else // CUDA
+  prop.sharedMemPerMultiprocessor = profile.sharedMemPerMultiprocessor;
+  prop.regsPerMultiprocessor = profile.regsPerMultiprocessor;
+#endif
+  prop.clockRate = profile.clockRate;
+  prop.memoryClockRate = profile.memoryClockRate;
+  prop.memoryBusWidth = profile.memoryBusWidth;
+  prop.ECCEnabled = profile.ECCEnabled;
+#if LIBRETT_USES_CUDA
+  prop.maxBlocksPerMultiProcessor = profile.maxBlocksPerMultiProcessor;
+  prop.reservedSharedMemPerBlock = profile.reservedSharedMemPerBlock;
+#endif
+#endif
+}
+
+bool deviceProfileWrite(const char* path, const DeviceProfile& profile) {
+  std::ofstream file(path);
+  if (!file) return false;
+  file << DEVICE_PROFILE_HEADER << "\n";
+  file << "backend " << profile.backend << "\n";
+  file << "name " << profile.name << "\n";
+  visitProperties(profile, [&](const char* key, const auto& value) {
+    file << key << " " << value << "\n";
+  });
+  for (const KernelResource& res : profile.kernels) {
+    file << "kernel " << res.method << " " << res.sizeofType << " " << res.numRegStorage << " "
+      << res.numRegs << " " << res.sharedSizeBytes << " " << res.maxThreadsPerBlock << "\n";
+  }
+  return (bool)file;
+}
+
+bool deviceProfileRead(const char* path, DeviceProfile& profile) {
+  std::ifstream file(path);
+  if (!file) return false;
+  std::string line;
+  if (!std::getline(file, line) || line != DEVICE_PROFILE_HEADER) return false;
+  profile = DeviceProfile();
+  profile.backend.clear();
+  while (std::getline(file, line)) {
+    if (line.empty()) continue;
+    std::istringstream str(line);
+    std::string key;
+    str >> key;
+    if (key == "backend") {
+      str >> profile.backend;
+    } else if (key == "name") {
+      std::getline(str >> std::ws, profile.name);
+    } else if (key == "kernel") {
+      KernelResource res;
+      str >> res.method >> res.sizeofType >> res.numRegStorage >> res.numRegs >> res.sharedSizeBytes
+        >> res.maxThreadsPerBlock;
+      profile.kernels.push_back(res);
+    } else {
+      // Keys of later versions are skipped
+      visitProperties(profile, [&](const char* name, auto& value) {
+        if (key == name) str >> value;
+      });
+    }
+    if (!str) return false;
+  }
+  return (!profile.backend.empty() && !profile.name.empty() && profile.warpSize > 0 &&
+    profile.multiProcessorCount > 0 && profile.maxThreadsPerBlock > 0);
+}
+
+bool deviceProfileLoad(const char* path, int& deviceID) {
+  std::lock_guard<std::mutex> lock(profilesMutex);
+  auto it = loadedPaths.find(path);
+  if (it != loadedPaths.end()) {
+    deviceID = it->second;
+    return true;
+  }
+  DeviceProfile profile;
+  if (!deviceProfileRead(path, profile)) return false;
+  loadedProfiles.push_back(profile);
+  deviceID = -(int)loadedProfiles.size();
+  loadedPaths.insert({path, deviceID});
+  return true;
+}
+
+const DeviceProfile* deviceProfileGet(const int deviceID) {
+  std::lock_guard<std::mutex> lock(profilesMutex);
+  const int i = -deviceID - 1;
+  if (i < 0 || i >= (int)loadedProfiles.size()) return nullptr;
+  return &loadedProfiles[i];
+}
+
+const DeviceProfile* deviceProfileFor(const int deviceID, const gpuDeviceProp_t& prop) {
+  if (deviceID < 0) return deviceProfileGet(deviceID);
+  std::lock_guard<std::mutex> lock(profilesMutex);
+  auto it = deviceProfiles.find(deviceID);
+  if (it == deviceProfiles.end()) it = deviceProfiles.insert({deviceID, deviceProfileOf(prop)}).first;
+  return &it->second;
+}
+
+bool deviceProfileKernel(const int deviceID, const int method, const int sizeofType,
+  const int numRegStorage, KernelResource& res) {
+  std::lock_guard<std::mutex> lock(profilesMutex);
+  const DeviceProfile* profile = nullptr;
+  if (deviceID < 0) {
+    const int i = -deviceID - 1;
+    if (i < (int)loadedProfiles.size()) profile = &loadedProfiles[i];
+  } else {
+    auto it = deviceProfiles.find(deviceID);
+    if (it != deviceProfiles.end()) profile = &it->second;
+  }
+  if (profile == nullptr) return false;
+  for (const KernelResource& kernel : profile->kernels) {
+    if (kernel.method == method && kernel.sizeofType == sizeofType && kernel.numRegStorage == numRegStorage) {
+      res = kernel;
+      return true;
+    }
+  }
+  return false;
+}
+
+void deviceProfileAddKernel(const int deviceID, const KernelResource& res) {
+  std::lock_guard<std::mutex> lock(profilesMutex);
+  auto it = deviceProfiles.find(deviceID);
+  if (it != deviceProfiles.end()) it->second.kernels.push_back(res);
+}
+
+static long long int roundUp(const long long int val, const long long int unit) {
+  return ((val + unit - 1)/unit)*unit;
+}
+
+int occupancyActiveBlocks(const DeviceProfile& profile, const KernelResource& res,
+  const int numthread, const size_t dynamicSharedMem) {
+
+  const int maxThreadsPerBlock = (res.maxThreadsPerBlock > 0) ?
+    std::min(profile.maxThreadsPerBlock, res.maxThreadsPerBlock) : profile.maxThreadsPerBlock;
+  if (numthread <= 0 || numthread > maxThreadsPerBlock) return 0;
+  const int numWarp = (numthread - 1)/profile.warpSize + 1;
+
+  // Threads and blocks
+  int numBlock = (profile.maxThreadsPerMultiProcessor/profile.warpSize)/numWarp;
+  if (profile.maxBlocksPerMultiProcessor > 0) numBlock = std::min(numBlock, profile.maxBlocksPerMultiProcessor);
+
+  // Registers, allocated per warp
+  if (res.numRegs > 0 && profile.regsPerMultiprocessor > 0) {
+    const long long int regsPerWarp = roundUp((long long int)res.numRegs*profile.warpSize,
+      std::max(1, profile.regAllocUnit));
+    if (profile.regsPerBlock > 0 && regsPerWarp*numWarp > profile.regsPerBlock) return 0;
+    const int numPartition = std::max(1, profile.regAllocPartitions);
+    const long long int warpsPerPartition = (profile.regsPerMultiprocessor/numPartition)/regsPerWarp;
+    numBlock = (int)std::min<long long int>(numBlock, (warpsPerPartition*numPartition)/numWarp);
+  }
+
+  // Shared memory, allocated per block
+  const long long int sharedMem = roundUp((long long int)(res.sharedSizeBytes + dynamicSharedMem +
+    profile.reservedSharedMemPerBlock), std::max(1, profile.sharedMemAllocUnit));
+  if (res.sharedSizeBytes + dynamicSharedMem > profile.sharedMemPerBlock) return 0;
+  if (sharedMem > 0 && profile.sharedMemPerMultiprocessor > 0) {
+    numBlock = (int)std::min<long long int>(numBlock, profile.sharedMemPerMultiprocessor/sharedMem);
+  }
+
+  return std::max(0, numBlock);
+}
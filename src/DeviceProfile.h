@@ -0,0 +1,151 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2026 Librett developers
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+#ifndef LIBRETTDEVICEPROFILE_H
+#define LIBRETTDEVICEPROFILE_H
+
+#include <string>
+#include <vector>
+#include "uniapi.h"
+
+//
+// Device profiles: the properties of a device that planning depends on. getNumActiveBlock()
+// computes occupancy from the profile of the device with occupancyActiveBlocks() instead of
+// asking the runtime. Profiles are also written to a file on a node with the device and
+// read back where there is none, see librettPlanOffline(). Plans of a profile file have a
+// negative deviceID.
+//
+// The profile file is text, a header line and one "key value" line per property:
+// backend name major minor warpSize multiProcessorCount maxThreadsPerBlock
+// maxThreadsPerMultiProcessor maxBlocksPerMultiProcessor sharedMemPerBlock
+// sharedMemPerMultiprocessor reservedSharedMemPerBlock sharedMemAllocUnit regsPerBlock
+// regsPerMultiprocessor regAllocUnit regAllocPartitions clockRate memoryClockRate
+// memoryBusWidth ECCEnabled l1CacheSize l2CacheSize l3CacheSize cacheLineSize
+// followed by one line per kernel:
+// kernel method sizeofType numRegStorage numRegs sharedSizeBytes maxThreadsPerBlock
+//
+
+// Resources of a kernel instance, numRegStorage is 0 for the Tiled kernels
+struct KernelResource {
+  int method;
+  int sizeofType;
+  int numRegStorage;
+  // Registers per thread, 0 if unknown
+  int numRegs;
+  // Static shared memory in bytes
+  size_t sharedSizeBytes;
+  int maxThreadsPerBlock;
+};
+
+struct DeviceProfile {
+  // Backend of the build that wrote the profile: cuda, hip, sycl or host
+  std::string backend;
+  std::string name;
+  int major;
+  int minor;
+  int warpSize;
+  int multiProcessorCount;
+  int maxThreadsPerBlock;
+  int maxThreadsPerMultiProcessor;
+  int maxBlocksPerMultiProcessor;
+  // Shared memory in bytes. Allocations are rounded up to sharedMemAllocUnit and include
+  // reservedSharedMemPerBlock
+  size_t sharedMemPerBlock;
+  size_t sharedMemPerMultiprocessor;
+  size_t reservedSharedMemPerBlock;
+  int sharedMemAllocUnit;
+  // Registers. Warps allocate numRegs*warpSize registers rounded up to regAllocUnit from one
+  // of regAllocPartitions equal parts of the register file. regsPerMultiprocessor = 0
+  // leaves registers out of the occupancy
+  int regsPerBlock;
+  int regsPerMultiprocessor;
+  int regAllocUnit;
+  int regAllocPartitions;
+  // Clocks in kHz, bus width in bits
+  int clockRate;
+  int memoryClockRate;
+  int memoryBusWidth;
+  int ECCEnabled;
+  // Caches of host devices, bytes
+  size_t l1CacheSize;
+  size_t l2CacheSize;
+  size_t l3CacheSize;
+  int cacheLineSize;
+  std::vector<KernelResource> kernels;
+
+  DeviceProfile();
+};
+
+// Backend of this build
+const char* deviceProfileBackend();
+
+// Profile of the device of prop, without kernels. Limits that prop does not have take
+// the values of the architecture
+DeviceProfile deviceProfileOf(const gpuDeviceProp_t& prop);
+
+// Properties of a device with profile, the planning fields are set and the rest is zero
+void deviceProfileProp(const DeviceProfile& profile, gpuDeviceProp_t& prop);
+
+// Writes profile to path. Returns false if the file cannot be written
+bool deviceProfileWrite(const char* path, const DeviceProfile& profile);
+
+// Reads a file of deviceProfileWrite(). Returns false if the file cannot be read or is not
+// a profile file
+bool deviceProfileRead(const char* path, DeviceProfile& profile);
+
+//
+// Loads the profile of path and returns its deviceID, which is negative. A path that has
+// been loaded before returns the same deviceID without reading the file again. Returns
+// false if the file cannot be read
+//
+bool deviceProfileLoad(const char* path, int& deviceID);
+
+// Profile of a deviceID of deviceProfileLoad(), nullptr for other deviceIDs
+const DeviceProfile* deviceProfileGet(const int deviceID);
+
+//
+// Profile of deviceID: the profile of deviceProfileLoad() for negative deviceIDs, or the
+// profile of device deviceID with properties prop, made by deviceProfileOf() on first use.
+// Returns nullptr for unknown negative deviceIDs. The kernels of the profile may grow,
+// read them with deviceProfileKernel()
+//
+const DeviceProfile* deviceProfileFor(const int deviceID, const gpuDeviceProp_t& prop);
+
+// Resources of a kernel instance in the profile of deviceID. Returns false if the profile
+// does not have them
+bool deviceProfileKernel(const int deviceID, const int method, const int sizeofType,
+  const int numRegStorage, KernelResource& res);
+
+// Adds the resources of a kernel instance to the profile of a device of deviceProfileFor()
+void deviceProfileAddKernel(const int deviceID, const KernelResource& res);
+
+//
+// Maximum number of active blocks per multiprocessor of a kernel with resources res,
+// launched with numthread threads and dynamicSharedMem bytes of dynamic shared memory.
+// The smallest of the thread, block, register and shared memory limits of profile, 0 if
+// the block does not fit
+//
+int occupancyActiveBlocks(const DeviceProfile& profile, const KernelResource& res,
+  const int numthread, const size_t dynamicSharedMem);
+
+#endif // LIBRETTDEVICEPROFILE_H
@@ -25,6 +25,7 @@ SOFTWARE.
 #ifndef LIBRETTMEM_HPP
 #define LIBRETTMEM_HPP
 
+#include <stdlib.h>
 #include "GpuUtils.h"
 
 #ifdef LIBRETT_HAS_UMPIRE
@@ -48,6 +49,13 @@ void allocate_device(T **pp, const size_t len, gpuStream_t gpuStream) {
 #else  // LIBRETT_HAS_UMPIRE
   #if SYCL
   *((void **)pp) = (void *)sycl::malloc_device( sizeof(T)*len, *gpuStream);
+  #elif LIBRETT_USES_CPU
+    #ifdef NO_ALIGNED_ALLOC
+    *((void **)pp) = malloc(sizeof(T)*len);
+    #else
+    // aligned_alloc() needs the size to be a multiple of the alignment
+    *((void **)pp) = aligned_alloc(64, ((sizeof(T)*len - 1)/64 + 1)*64);
+    #endif
   #elif HIP
   hipCheck(hipMalloc((void **)pp, sizeof(T)*len));
   #else // CUDA
@@ -71,6 +79,8 @@ void deallocate_device(T **pp, gpuStream_t gpuStream) {
   if (*pp != NULL) {
     #if SYCL
       sycl::free( (void *)(*pp), *gpuStream );
+    #elif LIBRETT_USES_CPU
+      free((void *)(*pp));
     #elif HIP
       hipCheck(hipFree((void *)(*pp)));
     #else // CUDA
@@ -31,13 +31,36 @@ SOFTWARE.
 #endif
 
 #include "uniapi.h"
+#if LIBRETT_USES_CPU
+  #include <cstring>
+  #include <algorithm>
+  #include "ThreadPool.h"
+#endif
 
 const int numthread = 64;
 
+#if LIBRETT_USES_CPU
+//
+// Copies n bytes in parallel, one contiguous slice per pool thread
+//
+static void hostParallelCopy(const size_t n, const void *data_in, void *data_out) {
+  ThreadPool& pool = ThreadPool::instance();
+  const size_t numSlice = pool.numThread();
+  // Slices are whole cache lines
+  const size_t slice = (((n + numSlice - 1)/numSlice + 63)/64)*64;
+  pool.parallelFor((int)numSlice, [&](int i) {
+    size_t i0 = std::min(n, i*slice);
+    size_t i1 = std::min(n, i0 + slice);
+    if (i1 > i0) memcpy((char *)data_out + i0, (const char *)data_in + i0, i1 - i0);
+  });
+}
+#endif
+
 // -----------------------------------------------------------------------------------
 //
 // Copy using scalar loads and stores
 //
+#ifndef LIBRETT_USES_CPU
 template <typename T>
 #if SYCL
 void scalarCopyKernel(const int n, const T* data_in, T* data_out, sycl::nd_item<3> item)
@@ -49,6 +72,7 @@ __global__ void scalarCopyKernel(const int n, const T* data_in, T* data_out)
     data_out[i] = data_in[i];
   }
 }
+#endif // LIBRETT_USES_CPU
 
 template <typename T>
 void scalarCopy(const int n, const T *data_in, T *data_out, gpuStream_t& stream) {
@@ -64,6 +88,10 @@ void scalarCopy(const int n, const T *data_in, T *data_out, gpuStream_t& stream)
                        [=](sycl::nd_item<3> item) {
                          scalarCopyKernel<T>(n, data_in, data_out, item);
                        });
+#elif LIBRETT_USES_CPU
+  for (int i = 0; i < n; i++) {
+    data_out[i] = data_in[i];
+  }
 #elif HIP
   hipLaunchKernelGGL(HIP_KERNEL_NAME(scalarCopyKernel<T>), dim3(numblock), dim3(numthread),
      0, stream, n, data_in, data_out);
@@ -81,6 +109,7 @@ void scalarCopy(const int n, const T *data_in, T *data_out, gpuStream_t& stream)
 //
 // Copy using vectorized loads and stores
 //
+#ifndef LIBRETT_USES_CPU
 template <typename T>
 #if SYCL
 void vectorCopyKernel(const int n, T* data_in, T* data_out, sycl::nd_item<3> item)
@@ -103,6 +132,7 @@ __global__ void vectorCopyKernel(const int n, T* data_in, T* data_out)
     data_out[i] = data_in[i];
   }
 }
+#endif // LIBRETT_USES_CPU
 
 template <typename T>
 void vectorCopy(const int n, T *data_in, T *data_out, gpuStream_t& stream) {
@@ -120,6 +150,8 @@ void vectorCopy(const int n, T *data_in, T *data_out, gpuStream_t& stream) {
                        [=](sycl::nd_item<3> item) {
                          vectorCopyKernel<T>(n, data_in, data_out, item);
                        });
+#elif LIBRETT_USES_CPU
+  hostParallelCopy((size_t)n*sizeof(T), data_in, data_out);
 #elif HIP
   hipLaunchKernelGGL(HIP_KERNEL_NAME(vectorCopyKernel<T>), dim3(numblock), dim3(numthread),
      shmemsize, stream, n, data_in, data_out);
@@ -137,6 +169,7 @@ void vectorCopy(const int n, T *data_in, T *data_out, gpuStream_t& stream) {
 //
 // Copy using vectorized loads and stores
 //
+#ifndef LIBRETT_USES_CPU
 template <int numElem>
 #if SYCL
 void memcpyFloatKernel(const int n, float4_t *data_in, float4_t *data_out, sycl::nd_item<3> item)
@@ -176,6 +209,7 @@ __global__ void memcpyFloatLoopKernel(const int n, float4_t *data_in, float4_t *
     }
   }
 }
+#endif // LIBRETT_USES_CPU
 
 #define NUM_ELEM 2
 void memcpyFloat(const int n, float *data_in, float *data_out, gpuStream_t& stream) {
@@ -189,6 +223,8 @@ void memcpyFloat(const int n, float *data_in, float *data_out, gpuStream_t& stre
                        [=](sycl::nd_item<3> item) {
                          memcpyFloatKernel<NUM_ELEM>( n/4, (float4_t *)data_in, (float4_t *)data_out, item);
                        });
+#elif LIBRETT_USES_CPU
+  hostParallelCopy((size_t)n*sizeof(float), data_in, data_out);
 #elif HIP
   hipLaunchKernelGGL(HIP_KERNEL_NAME(memcpyFloatKernel<NUM_ELEM>), dim3(numblock), dim3(numthread),
      shmemsize, stream , n/4, (float4_t *)data_in, (float4_t *)data_out);
@@ -29,6 +29,7 @@ SOFTWARE.
 #include <cstring> // memcpy
 #include "GpuModel.h"
 #include "GpuModelKernel.h"
+#include "ModelProfile.h"
 #ifdef ENABLE_NVTOOLS
 #include "GpuUtils.h"
 #endif
@@ -225,6 +226,27 @@ void computePos(const int vol0, const int vol1,
   }
 }
 
+//
+// Compute memory element positions of 64-bit descriptors, reduced with modelPos()
+//
+void computePos(const long long int vol0, const long long int vol1,
+  const TensorConvInOut64* conv, const int numConv,
+  int* posIn, int* posOut) {
+
+  long long int nvol = vol1 - vol0;
+  for (long long int i=0;i <= nvol;i++) {
+    long long int posInVal = 0;
+    long long int posOutVal = 0;
+    long long int j = i + vol0;
+    for (int k=0;k < numConv;k++) {
+      posInVal  += ((j / conv[k].c_in) % conv[k].d_in) * conv[k].ct_in;
+      posOutVal += ((j / conv[k].c_out) % conv[k].d_out) * conv[k].ct_out;
+    }
+    posIn[i] = modelPos(posInVal);
+    posOut[i] = modelPos(posOutVal);
+  }
+}
+
 //
 // Compute memory element positions
 // Starts from zero
@@ -320,8 +342,8 @@ void computePosRef(int vol0, int vol1,
 void countPackedGlTransactions(const int warpSize, const int accWidth, const int cacheWidth,
   const int numthread, const int posMbarIn, const int posMbarOut, const int volMmk,
   std::vector<int>& posMmkIn, std::vector<int>& posMmkOut,
-  int& gld_tran, int& gst_tran, int& gld_req, int& gst_req,
-  int& cl_full_l2, int& cl_part_l2, int& cl_full_l1, int& cl_part_l1) {
+  long long int& gld_tran, long long int& gst_tran, long long int& gld_req, long long int& gst_req,
+  long long int& cl_full_l2, long long int& cl_part_l2, long long int& cl_full_l1, long long int& cl_part_l1) {
 
   std::vector<int> readSeg(warpSize);
   std::vector<int> writeSeg(warpSize);
@@ -396,8 +418,8 @@ void countPackedGlTransactions0(const int warpSize, const int accWidth, const in
   const int numthread,
   const int numPos, const int posMbarIn[INT_VECTOR_LEN], const int posMbarOut[INT_VECTOR_LEN],
   const int volMmk,  const int* __restrict__ posMmkIn, const int* __restrict__ posMmkOut,
-  int& gld_tran, int& gst_tran, int& gld_req, int& gst_req,
-  int& cl_full_l2, int& cl_part_l2, int& cl_full_l1, int& cl_part_l1) {
+  long long int& gld_tran, long long int& gst_tran, long long int& gld_req, long long int& gst_req,
+  long long int& cl_full_l2, long long int& cl_part_l2, long long int& cl_full_l1, long long int& cl_part_l1) {
 
 #ifdef NO_ALIGNED_ALLOC
   int_vector* writeSegVolMmk = (int_vector *)aligned_malloc(volMmk*sizeof(int_vector), sizeof(int_vector));
@@ -474,9 +496,9 @@ void countPackedGlTransactions0(const int warpSize, const int accWidth, const in
 //
 // Count numnber of shared memory transactions for Packed -method
 //
-void countPackedShTransactions0(const int warpSize, const int bankWidth, const int numthread,
+void countPackedShTransactions0(const int warpSize, const int bankWidth, const int wordShift, const int numthread,
   const int volMmk, const TensorConv* msh, const int numMsh,
-  int& sld_tran, int& sst_tran, int& sld_req, int& sst_req) {
+  long long int& sld_tran, long long int& sst_tran, long long int& sld_req, long long int& sst_req) {
 
   int p[32];
   int d[32];
@@ -501,13 +523,18 @@ void countPackedShTransactions0(const int warpSize, const int bankWidth, const i
   for (int j00=0;j00 < volMmk;j00+=numthread) {
     int n0 = std::min(volMmk, j00 + numthread);
     for (int j0=j00;j0 < n0;j0+=warpSize) {
-      // Number of accesses for each bank
+      // Number of accesses for each bank, lanes reading the same word share the access
       std::vector<int> numAccess(warpSize, 0);
+      std::vector<int> lastWord(warpSize, -1);
       int maxNumAccess = 0;
       int n = std::min(warpSize, volMmk - j0);
       for (int j1=0;j1 < n;j1++) {
-        int bank = pos & bankWidthMask;
-        maxNumAccess = std::max(maxNumAccess, ++numAccess[bank]);
+        int word = pos >> wordShift;
+        int bank = word & bankWidthMask;
+        if (word != lastWord[bank]) {
+          lastWord[bank] = word;
+          maxNumAccess = std::max(maxNumAccess, ++numAccess[bank]);
+        }
         // Advance position
         int ii = 0;
         while (++p[ii] == d[ii]) {
@@ -528,17 +555,18 @@ void countPackedShTransactions0(const int warpSize, const int bankWidth, const i
 // Count numnber of shared memory transactions for Packed -method
 // *** Slow reference version
 //
-void countPackedShTransactionsRef(const int warpSize, const int bankWidth, const int numthread,
+void countPackedShTransactionsRef(const int warpSize, const int bankWidth, const int wordShift, const int numthread,
   const int volMmk, const TensorConv* msh, const int numMsh,
-  int& sld_tran, int& sst_tran, int& sld_req, int& sst_req) {
+  long long int& sld_tran, long long int& sst_tran, long long int& sld_req, long long int& sst_req) {
 
   const int bankWidthMask = bankWidth - 1;
 
   for (int j00=0;j00 < volMmk;j00+=numthread) {
     int n0 = std::min(volMmk, j00 + numthread);
     for (int j0=j00;j0 < n0;j0+=warpSize) {
-      // Number of accesses for each bank
+      // Number of accesses for each bank, lanes reading the same word share the access
       std::vector<int> numAccess(warpSize, 0);
+      std::vector<int> lastWord(warpSize, -1);
       int maxNumAccess = 0;
       int n = std::min(warpSize, volMmk - j0);
       for (int j1=0;j1 < n;j1++) {
@@ -547,8 +575,12 @@ void countPackedShTransactionsRef(const int warpSize, const int bankWidth, const
         for (int k=0;k < numMsh;k++) {
           pos += ((j / msh[k].c) % msh[k].d) * msh[k].ct;
         }
-        int bank = pos & bankWidthMask;
-        maxNumAccess = std::max(maxNumAccess, ++numAccess[bank]);
+        int word = pos >> wordShift;
+        int bank = word & bankWidthMask;
+        if (word != lastWord[bank]) {
+          lastWord[bank] = word;
+          maxNumAccess = std::max(maxNumAccess, ++numAccess[bank]);
+        }
       }
       sld_tran += maxNumAccess;
       sst_tran++;
@@ -561,13 +593,15 @@ void countPackedShTransactionsRef(const int warpSize, const int bankWidth, const
 //
 // Count number of global memory transactions for Tiled method
 //
+template <typename Conv>
 void countTiledGlTransactions(const bool isCopy,
-  const int numPosMbarSample, const int volMm, const int volMk, const int volMbar,
+  const int numPosMbarSample, const int volMm, const int volMk, const long long int volMbar,
   const int cIn, const int cOut, const int accWidth, const int cacheWidth,
-  std::vector<TensorConvInOut>& hostMbar, const int sizeMbar,
-  int& num_iter, float& mlp, int& gld_tran, int& gst_tran, int& gld_req, int& gst_req, int& cl_full, int& cl_part) {
+  const std::vector<Conv>& hostMbar, const int sizeMbar,
+  long long int& num_iter, float& mlp, long long int& gld_tran, long long int& gst_tran,
+  long long int& gld_req, long long int& gst_req, long long int& cl_full, long long int& cl_part) {
 
-  int ntile = ((volMm - 1)/TILEDIM + 1)*((volMk - 1)/TILEDIM + 1);
+  long long int ntile = (long long int)((volMm - 1)/TILEDIM + 1)*((volMk - 1)/TILEDIM + 1);
   num_iter = volMbar*ntile;
 
   gld_tran = 0;
@@ -579,7 +613,7 @@ void countTiledGlTransactions(const bool isCopy,
 
   // Random number generator
   std::default_random_engine generator;
-  std::uniform_int_distribution<int> distribution(0, volMbar - 1);
+  std::uniform_int_distribution<long long int> distribution(0, volMbar - 1);
 
   // Number of elements inside the horizontally clipped tiles
   int h = volMm % TILEDIM;
@@ -587,31 +621,31 @@ void countTiledGlTransactions(const bool isCopy,
   int v = volMk % TILEDIM;
 
   // Number of full tiles
-  int ntile_full = (volMm/TILEDIM)*(volMk/TILEDIM);
+  long long int ntile_full = (long long int)(volMm/TILEDIM)*(volMk/TILEDIM);
   // Number of tiles that are clipped in horizontal direction
-  int ntile_horz = (h > 0)*(volMk/TILEDIM);
+  long long int ntile_horz = (h > 0)*(volMk/TILEDIM);
   // Number of tiles that are clipped in vertical direction
-  int ntile_vert = (v > 0)*(volMm/TILEDIM);
+  long long int ntile_vert = (v > 0)*(volMm/TILEDIM);
   // Number of corner tiles (0 or 1)
-  int ntile_corn = (h > 0)*(v > 0);
+  long long int ntile_corn = (h > 0)*(v > 0);
 
   if (isCopy) {
     // Total number of memory level parallelism
-    int mlp_tot = (TILEDIM/TILEROWS)*(ntile_full + ntile_horz) + ((v - 1)/TILEROWS + 1)*(ntile_vert + ntile_corn);
+    long long int mlp_tot = (TILEDIM/TILEROWS)*(ntile_full + ntile_horz) + ((v - 1)/TILEROWS + 1)*(ntile_vert + ntile_corn);
     // Average memory level parallelism per tile
     mlp = (float)mlp_tot/(float)ntile;
   } else {
     // Total number of memory level parallelism
-    int mlp_tot = (TILEDIM/TILEROWS)*(2*ntile_full + ntile_horz + ntile_vert) +
+    long long int mlp_tot = (TILEDIM/TILEROWS)*(2*ntile_full + ntile_horz + ntile_vert) +
     ((v - 1)/TILEROWS + 1)*(ntile_vert + ntile_corn) + ((h - 1)/TILEROWS + 1)*(ntile_horz + ntile_corn);
     // Average memory level parallelism per tile
     mlp = (float)mlp_tot/(float)(2*ntile);
   }
 
-  int num_iposMbar = (numPosMbarSample == 0) ? volMbar : numPosMbarSample;
+  int num_iposMbar = (numPosMbarSample == 0) ? (int)volMbar : numPosMbarSample;
 
   for (int iposMbar=0;iposMbar < num_iposMbar;iposMbar++) {
-    int posMbar = (numPosMbarSample == 0) ? iposMbar : distribution(generator);
+    long long int posMbar = (numPosMbarSample == 0) ? iposMbar : distribution(generator);
 
     int posMbarIn;
     int posMbarOut;
@@ -761,76 +795,111 @@ void countTiledGlTransactions(const bool isCopy,
   }
 }
 
-struct GpuModelProp {
-  double base_dep_delay;
-  double base_mem_latency;
-  double sh_mem_latency;
-  double iter_cycles;
-  double fac;
-
-  GpuModelProp(int major) {
-    #if CUDA
-    if (major <= 3) {
-      // Kepler
-      base_dep_delay = 14.0;
-      base_mem_latency = 358.0;
-      sh_mem_latency = 11.0;
-      iter_cycles = 50.0;
-      fac = 2.0;
-    } else if (major <= 5) {
-      // Maxwell
-      base_dep_delay = 2.5;
-      base_mem_latency = 385.0;
-      sh_mem_latency = 1.0;
-      iter_cycles = 220.0;
-      fac = 2.0;
-    } else {
-      // Pascal and above
-      base_dep_delay = 2.8;
-      base_mem_latency = 485.0;
-      sh_mem_latency = 1.0;
-      iter_cycles = 260.0;
-      fac = 2.0;
-    }
-    #endif
+template void countTiledGlTransactions<TensorConvInOut>(const bool isCopy,
+  const int numPosMbarSample, const int volMm, const int volMk, const long long int volMbar,
+  const int cIn, const int cOut, const int accWidth, const int cacheWidth,
+  const std::vector<TensorConvInOut>& hostMbar, const int sizeMbar,
+  long long int& num_iter, float& mlp, long long int& gld_tran, long long int& gst_tran,
+  long long int& gld_req, long long int& gst_req, long long int& cl_full, long long int& cl_part);
+
+template void countTiledGlTransactions<TensorConvInOut64>(const bool isCopy,
+  const int numPosMbarSample, const int volMm, const int volMk, const long long int volMbar,
+  const int cIn, const int cOut, const int accWidth, const int cacheWidth,
+  const std::vector<TensorConvInOut64>& hostMbar, const int sizeMbar,
+  long long int& num_iter, float& mlp, long long int& gld_tran, long long int& gst_tran,
+  long long int& gld_req, long long int& gst_req, long long int& cl_full, long long int& cl_part);
+
+GpuModelProp::GpuModelProp(int major) {
+  if (major <= 3) {
+    // Kepler
+    base_dep_delay = 14.0;
+    base_mem_latency = 358.0;
+    sh_mem_latency = 11.0;
+    iter_cycles = 50.0;
+    fac = 2.0;
+  } else if (major <= 5) {
+    // Maxwell
+    base_dep_delay = 2.5;
+    base_mem_latency = 385.0;
+    sh_mem_latency = 1.0;
+    iter_cycles = 220.0;
+    fac = 2.0;
+  } else {
+    // Pascal and above
+    base_dep_delay = 2.8;
+    base_mem_latency = 485.0;
+    sh_mem_latency = 1.0;
+    iter_cycles = 260.0;
+    fac = 2.0;
   }
+  mem_BW = 0.0;
+}
 
-};
+GpuModelDevice gpuModelDevice(const gpuDeviceProp_t &prop, const GpuModelProp &gpuModelProp) {
+  GpuModelDevice device;
+  device.numSM = gpuMultiProcessorCount;
+  // GPU clock in GHz (convert from MHz to GHz)
+  device.freq = (double)gpuClockRate/1.0e3;
+  device.warpSize = gpuWarpSize;
+  device.mem_BW = gpuModelProp.mem_BW;
+#if HIP || LIBRETT_USES_CUDA
+  if (device.mem_BW == 0.0) {
+    // Memory bandwidth in GB/s
+    device.mem_BW = (double)(prop.memoryClockRate*2*(prop.memoryBusWidth/8))/1.0e6;
+    if (prop.ECCEnabled) device.mem_BW *= (1.0 - 0.125);
+  }
+#endif
+  return device;
+}
 
-void prepmodel5(const gpuDeviceProp_t &prop, GpuModelProp &gpuModelProp,
-  int nthread, int numActiveBlock, float mlp,
-  int gld_req, int gst_req, int gld_tran, int gst_tran,
-  int sld_req, int sst_req, int sld_tran, int sst_tran,
-  int cl_full, int cl_part,
+GpuModelProp gpuModelPropOf(const gpuDeviceProp_t &prop) {
+  GpuModelProp gpuModelProp(gpuMajor);
+  modelProfileFind(prop, gpuModelProp);
+  return gpuModelProp;
+}
+
+GpuModelCounters gpuModelCounters(const librettPlan_t& plan) {
+  GpuModelCounters counters;
+  const int method = plan.tensorSplit.method;
+  counters.method = method;
+  counters.nthread = plan.launchConfig.numthread_x*plan.launchConfig.numthread_y*plan.launchConfig.numthread_z;
+  counters.numActiveBlock = plan.numActiveBlock;
+  // Packed kernels have numRegStorage loads in flight per thread
+  counters.mlp = (method == Packed || method == PackedSplit) ? (float)plan.launchConfig.numRegStorage : plan.mlp;
+  counters.gld_req = plan.gld_req;
+  counters.gst_req = plan.gst_req;
+  counters.gld_tran = plan.gld_tran;
+  counters.gst_tran = plan.gst_tran;
+  counters.sld_req = plan.sld_req;
+  counters.sst_req = plan.sst_req;
+  counters.sld_tran = plan.sld_tran;
+  counters.sst_tran = plan.sst_tran;
+  counters.num_iter = plan.num_iter;
+  counters.cl_full = plan.cl_full_l2;
+  counters.cl_part = plan.cl_part_l2;
+  return counters;
+}
+
+static void prepmodel5(const GpuModelProp &gpuModelProp, const GpuModelDevice &device,
+  const GpuModelCounters &counters,
   double &delta_ll, double &mem_cycles, double &sh_mem_cycles, double &MWP) {
 
-  double active_SM = gpuMultiProcessorCount;
-  // GPU clock in GHz (convert from MHz to GHz)
-  double freq = (double)gpuClockRate/1.0e3;
-  int warpSize = gpuWarpSize;
-
-#if SYCL
-  // Memory bandwidth in GB/s
-  //double mem_BW = (double)(prop.memoryClockRate*2*(prop.memoryBusWidth/8))/1.0e6;
-  //if (prop.ECCEnabled) mem_BW *= (1.0 - 0.125);
-  double mem_BW = 0.0;
-#else // CUDA or SYCL
-  // Memory bandwidth in GB/s
-  double mem_BW = (double)(prop.memoryClockRate*2*(prop.memoryBusWidth/8))/1.0e6;
-  if (prop.ECCEnabled) mem_BW *= (1.0 - 0.125);
-  #if HIP
-    return;  // Dmitry Lyakh
-  #endif
-#endif
+  double active_SM = device.numSM;
+  double freq = device.freq;
+  int warpSize = device.warpSize;
+  double mem_BW = device.mem_BW;
+  const double mlp = counters.mlp;
 
-  int active_warps_per_SM = nthread*numActiveBlock/warpSize;
+  int active_warps_per_SM = counters.nthread*counters.numActiveBlock/warpSize;
 
   // avg. number of memory transactions per memory request
   // double num_trans_per_request = ((double)gld_tran + (double)gst_tran*(1.0 + part_cl)) / (double)(gld_req + gst_req);
   // double num_trans_per_request = ((double)gld_tran + (double)gst_tran + (double)cl_part) / (double)(gld_req + gst_req);
-  double cl = (double)cl_part/(double)(cl_full + cl_part);
-  double num_trans_per_request = ((double)gld_tran + ((double)gst_tran)*(1.0 + cl)) / (double)(gld_req + gst_req);
-  double shnum_trans_per_request = (double)(sld_tran + sst_tran) / (double)(sld_req + sst_req);
+  double cl = (double)counters.cl_part/(double)std::max(1LL, counters.cl_full + counters.cl_part);
+  double num_trans_per_request = ((double)counters.gld_tran + ((double)counters.gst_tran)*(1.0 + cl)) /
+    (double)std::max(1LL, counters.gld_req + counters.gst_req);
+  double shnum_trans_per_request = (double)(counters.sld_tran + counters.sst_tran) /
+    (double)std::max(1LL, counters.sld_req + counters.sst_req);
 
   double mem_l = gpuModelProp.base_mem_latency + (num_trans_per_request - 1.0) * gpuModelProp.base_dep_delay;
 
@@ -848,57 +917,108 @@ void prepmodel5(const gpuDeviceProp_t &prop, GpuModelProp &gpuModelProp,
 
   delta_ll = gpuModelProp.base_dep_delay;
   double BW_per_warp = freq*bytes_per_request/mem_l;
-  double MWP_peak_BW = mem_BW/(BW_per_warp*active_SM);
+  // Without a bandwidth the warps in flight are limited by occupancy only
+  double MWP_peak_BW = (mem_BW > 0.0) ? mem_BW/(BW_per_warp*active_SM) : (double)active_warps_per_SM;
   MWP = mem_l / dep_delay;
   MWP = std::min(MWP*mlp, std::min(MWP_peak_BW, (double)active_warps_per_SM));
 }
 
-double cyclesPacked(const bool isSplit, const size_t sizeofType, const gpuDeviceProp_t &prop,
-  int nthread, int numActiveBlock, float mlp,
-  int gld_req, int gst_req, int gld_tran, int gst_tran,
-  int sld_req, int sst_req, int sld_tran, int sst_tran, int num_iter, int cl_full, int cl_part) {
+double gpuModelCycles(const GpuModelProp &gpuModelProp, const GpuModelDevice &device,
+  const GpuModelCounters &counters) {
 
-  int warpSize = gpuWarpSize;           // AMD change
-  int warps_per_block = nthread/warpSize; // AMD change
-
-  GpuModelProp gpuModelProp(gpuMajor);
+  int warps_per_block = counters.nthread/device.warpSize;   // AMD change
 
   double delta_ll, mem_cycles, sh_mem_cycles, MWP;
-  prepmodel5(prop, gpuModelProp, nthread, numActiveBlock, mlp,
-    gld_req, gst_req, gld_tran, gst_tran,
-    sld_req, sst_req, sld_tran, sst_tran, cl_full, cl_part,
-    delta_ll, mem_cycles, sh_mem_cycles, MWP);
+  prepmodel5(gpuModelProp, device, counters, delta_ll, mem_cycles, sh_mem_cycles, MWP);
   double ldst_cycles = mem_cycles*warps_per_block/MWP;
   double sync_cycles = 0.0;//2.0*delta_ll*(warps_per_block - 1.0);
-  double cycles = (ldst_cycles + sh_mem_cycles + sync_cycles + gpuModelProp.iter_cycles)*num_iter;
+  if (counters.method == TiledCopy) {
+    sh_mem_cycles = 0.0;
+    sync_cycles = 0.0;
+  }
+  double cycles = (ldst_cycles + sh_mem_cycles + sync_cycles + gpuModelProp.iter_cycles)*counters.num_iter;
 
   return cycles;
 }
 
+double cyclesPacked(const bool isSplit, const size_t sizeofType, const gpuDeviceProp_t &prop,
+  int nthread, int numActiveBlock, float mlp,
+  long long int gld_req, long long int gst_req, long long int gld_tran, long long int gst_tran,
+  long long int sld_req, long long int sst_req, long long int sld_tran, long long int sst_tran,
+  long long int num_iter, long long int cl_full, long long int cl_part) {
+
+  GpuModelProp gpuModelProp = gpuModelPropOf(prop);
+  GpuModelCounters counters = {isSplit ? PackedSplit : Packed, nthread, numActiveBlock, mlp,
+    gld_req, gst_req, gld_tran, gst_tran, sld_req, sst_req, sld_tran, sst_tran,
+    num_iter, cl_full, cl_part};
+  return gpuModelCycles(gpuModelProp, gpuModelDevice(prop, gpuModelProp), counters);
+}
+
 double cyclesTiled(const bool isCopy, const size_t sizeofType, const gpuDeviceProp_t &prop,
   int nthread, int numActiveBlock, float mlp,
-  int gld_req, int gst_req, int gld_tran, int gst_tran,
-  int sld_req, int sst_req, int sld_tran, int sst_tran, int num_iter, int cl_full, int cl_part) {
+  long long int gld_req, long long int gst_req, long long int gld_tran, long long int gst_tran,
+  long long int sld_req, long long int sst_req, long long int sld_tran, long long int sst_tran,
+  long long int num_iter, long long int cl_full, long long int cl_part) {
+
+  GpuModelProp gpuModelProp = gpuModelPropOf(prop);
+  GpuModelCounters counters = {isCopy ? TiledCopy : Tiled, nthread, numActiveBlock, mlp,
+    gld_req, gst_req, gld_tran, gst_tran, sld_req, sst_req, sld_tran, sst_tran,
+    num_iter, cl_full, cl_part};
+  return gpuModelCycles(gpuModelProp, gpuModelDevice(prop, gpuModelProp), counters);
+}
 
-  int warpSize = gpuWarpSize;           // AMD change
-  int warps_per_block = nthread/warpSize; // AMD change
+//
+// Host cost model (CPU backend)
+//
+struct HostModelProp {
+  // Sustained bytes per cycle one core streams from memory
+  double core_bytes_per_cycle;
+  // Sustained bytes per cycle of the whole socket
+  double max_bytes_per_cycle;
+  // Fixed cost of one task (Mbar position, split or tile)
+  double iter_cycles;
+  // Cost per element moved: Tiled, TiledCopy, Packed
+  double elem_cycles_tiled;
+  double elem_cycles_copy;
+  double elem_cycles_packed;
+
+  HostModelProp() {
+    core_bytes_per_cycle = 8.0;
+    max_bytes_per_cycle = 32.0;
+    iter_cycles = 200.0;
+    elem_cycles_tiled = 0.5;
+    elem_cycles_copy = 0.125;
+    elem_cycles_packed = 1.0;
+  }
+};
 
-  GpuModelProp gpuModelProp(gpuMajor);
+//
+// Returns cycles for a host kernel.
+// Transaction counts are in cache lines (accWidth = cacheWidth = line size) over the sampled
+// part of the tensor, sampleScale converts them to the whole tensor. Partially written lines
+// are read before they are written.
+//
+double cyclesHost(const int method, const size_t sizeofType, const gpuDeviceProp_t &prop,
+  const double sampleScale, const double vol, long long int num_iter,
+  long long int gld_tran, long long int gst_tran, long long int cl_full, long long int cl_part) {
 
-  double delta_ll, mem_cycles, sh_mem_cycles, MWP;
-  prepmodel5(prop, gpuModelProp, nthread, numActiveBlock, mlp,
-    gld_req, gst_req, gld_tran, gst_tran,
-    sld_req, sst_req, sld_tran, sst_tran, cl_full, cl_part,
-    delta_ll, mem_cycles, sh_mem_cycles, MWP);
-  double ldst_cycles = mem_cycles*warps_per_block/MWP;
-  double sync_cycles = 0.0;//2.0*delta_ll*(warps_per_block - 1.0);
-  if (isCopy) {
-    sh_mem_cycles = 0.0;
-    sync_cycles = 0.0;
-  }
-  double cycles = (ldst_cycles + sh_mem_cycles + sync_cycles + gpuModelProp.iter_cycles)*num_iter;
+  HostModelProp hostModelProp;
 
-  return cycles;
+  double numThread = (double)gpuMultiProcessorCount;
+
+  double cl = (double)cl_part/(double)std::max(1LL, cl_full + cl_part);
+  double lines = sampleScale*((double)gld_tran + ((double)gst_tran)*(1.0 + cl));
+  double bytes = lines*(double)prop.cacheLineSize;
+  double bytes_per_cycle = std::min(numThread*hostModelProp.core_bytes_per_cycle,
+    hostModelProp.max_bytes_per_cycle);
+  double mem_cycles = bytes/bytes_per_cycle;
+
+  double elem_cycles = hostModelProp.elem_cycles_packed;
+  if (method == Tiled) elem_cycles = hostModelProp.elem_cycles_tiled;
+  if (method == TiledCopy) elem_cycles = hostModelProp.elem_cycles_copy;
+  double cpu_cycles = ((double)num_iter*hostModelProp.iter_cycles + vol*elem_cycles)/numThread;
+
+  return mem_cycles + cpu_cycles;
 }
 
 bool check_results(const int tran, const int cl_full, const int cl_part, const int* results) {
@@ -1226,19 +1346,19 @@ const int shTestData[138][3] =
         i++;
       }
 
-      int sld_tran_ref = 0, sst_tran_ref = 0, sld_req_ref = 0, sst_req_ref = 0;
-      countPackedShTransactionsRef(warpSize, warpSize, numthread, volMmk, msh.data(), numMsh,
+      long long int sld_tran_ref = 0, sst_tran_ref = 0, sld_req_ref = 0, sst_req_ref = 0;
+      countPackedShTransactionsRef(warpSize, warpSize, 0, numthread, volMmk, msh.data(), numMsh,
         sld_tran_ref, sst_tran_ref, sld_req_ref, sst_req_ref);
 
-      int sld_tran = 0, sst_tran = 0, sld_req = 0, sst_req = 0;
-      countPackedShTransactions0(warpSize, warpSize, numthread, volMmk, msh.data(), numMsh,
+      long long int sld_tran = 0, sst_tran = 0, sld_req = 0, sst_req = 0;
+      countPackedShTransactions0(warpSize, warpSize, 0, numthread, volMmk, msh.data(), numMsh,
         sld_tran, sst_tran, sld_req, sst_req);
 
       if (sld_tran != sld_tran_ref || sst_tran != sst_tran_ref ||
         sld_req != sld_req_ref || sst_req != sst_req_ref) {
         printf("Error in countPackedShTransactions. Test %d\n", testInd);
-        printf("Ref: %d %d %d %d\n", sld_tran_ref, sst_tran_ref, sld_req_ref, sst_req_ref);
-        printf("Vec: %d %d %d %d\n", sld_tran, sst_tran, sld_req, sst_req);
+        printf("Ref: %lld %lld %lld %lld\n", sld_tran_ref, sst_tran_ref, sld_req_ref, sst_req_ref);
+        printf("Vec: %lld %lld %lld %lld\n", sld_tran, sst_tran, sld_req, sst_req);
         return false;
       }
 
@@ -1378,6 +1498,8 @@ const int shTestData[138][3] =
                                 sycl::property_list{sycl::property::queue::in_order{}});
     #elif HIP
     hipCheck(hipStreamCreate(&gpustream));
+    #elif LIBRETT_USES_CPU
+    gpustream = nullptr;
     #elif CUDA
     cudaCheck(cudaStreamCreate(&gpustream));    
     #endif
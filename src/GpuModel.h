@@ -39,6 +39,21 @@ void computePos0(const int vol,
   const TensorConvInOut* conv, const int numConv,
   int* posIn, int* posOut);
 
+//
+// Positions of index64 plans are reduced modulo MODEL_POS_WRAP before they enter the int
+// counters below. The wrap is a multiple of every transaction and cache line width,
+// so the reduced positions have the same alignment as the full ones.
+//
+const long long int MODEL_POS_WRAP = (1LL << 24);
+
+inline int modelPos(const long long int pos) {
+  return (int)(pos & (MODEL_POS_WRAP - 1));
+}
+
+void computePos(const long long int vol0, const long long int vol1,
+  const TensorConvInOut64* conv, const int numConv,
+  int* posIn, int* posOut);
+
 void computePosRef(int vol0, int vol1,
   std::vector<TensorConvInOut>::iterator it0, std::vector<TensorConvInOut>::iterator it1,
   std::vector<int>& posIn, std::vector<int>& posOut);
@@ -46,43 +61,114 @@ void computePosRef(int vol0, int vol1,
 void countPackedGlTransactions(const int warpSize, const int accWidth, const int cacheWidth,
   const int numthread, const int posMbarIn, const int posMbarOut, const int volMmk,
   std::vector<int>& posMmkIn, std::vector<int>& posMmkOut,
-  int& gld_tran, int& gst_tran, int& gld_req, int& gst_req,
-  int& cl_full_l2, int& cl_part_l2, int& cl_full_l1, int& cl_part_l1);
+  long long int& gld_tran, long long int& gst_tran, long long int& gld_req, long long int& gst_req,
+  long long int& cl_full_l2, long long int& cl_part_l2, long long int& cl_full_l1, long long int& cl_part_l1);
 
 void countPackedGlTransactions0(const int warpSize, const int accWidth, const int cacheWidth,
   const int numthread,
   const int numPos, const int posMbarIn[INT_VECTOR_LEN], const int posMbarOut[INT_VECTOR_LEN],
   const int volMmk,  const int* __restrict__ posMmkIn, const int* __restrict__ posMmkOut,
-  int& gld_tran, int& gst_tran, int& gld_req, int& gst_req,
-  int& cl_full_l2, int& cl_part_l2, int& cl_full_l1, int& cl_part_l1);
-
-void countPackedShTransactions(const int warpSize, const int bankWidth, const int numthread,
+  long long int& gld_tran, long long int& gst_tran, long long int& gld_req, long long int& gst_req,
+  long long int& cl_full_l2, long long int& cl_part_l2, long long int& cl_full_l1, long long int& cl_part_l1);
+
+//
+// Shared memory banks are 4 bytes wide. Positions are shifted right by wordShift to get the
+// bank word, see shWordShift(). Lanes that read the same word do not conflict
+//
+inline int shWordShift(const size_t sizeofType) {
+  return (sizeofType == 1) ? 2 : ((sizeofType == 2) ? 1 : 0);
+}
+
+void countPackedShTransactions(const int warpSize, const int bankWidth, const int wordShift, const int numthread,
   const int volMmk, const TensorConv* msh, const int numMsh,
-  int& sld_tran, int& sst_tran, int& sld_req, int& sst_req);
+  long long int& sld_tran, long long int& sst_tran, long long int& sld_req, long long int& sst_req);
 
-void countPackedShTransactions0(const int warpSize, const int bankWidth, const int numthread,
+void countPackedShTransactions0(const int warpSize, const int bankWidth, const int wordShift, const int numthread,
   const int volMmk, const TensorConv* msh, const int numMsh,
-  int& sld_tran, int& sst_tran, int& sld_req, int& sst_req);
+  long long int& sld_tran, long long int& sst_tran, long long int& sld_req, long long int& sst_req);
 
-void countPackedShTransactionsRef(const int warpSize, const int bankWidth, const int numthread,
+void countPackedShTransactionsRef(const int warpSize, const int bankWidth, const int wordShift, const int numthread,
   const int volMmk, const TensorConv* msh, const int numMsh,
-  int& sld_tran, int& sst_tran, int& sld_req, int& sst_req);
+  long long int& sld_tran, long long int& sst_tran, long long int& sld_req, long long int& sst_req);
 
+// Conv is TensorConvInOut or TensorConvInOut64
+template <typename Conv>
 void countTiledGlTransactions(const bool leadVolSame,
-  const int numPosMbarSample, const int volMm, const int volMk, const int volMbar,
+  const int numPosMbarSample, const int volMm, const int volMk, const long long int volMbar,
   const int cIn, const int cOut, const int accWidth, const int cacheWidth,
-  std::vector<TensorConvInOut>& hostMbar, const int sizeMbar,
-  int& num_iter, float& mlp, int& gld_tran, int& gst_tran, int& gld_req, int& gst_req, int& cl_full, int& cl_part);
+  const std::vector<Conv>& hostMbar, const int sizeMbar,
+  long long int& num_iter, float& mlp, long long int& gld_tran, long long int& gst_tran,
+  long long int& gld_req, long long int& gst_req, long long int& cl_full, long long int& cl_part);
+
+//
+// Parameters of the GPU performance model. GpuModelProp(major) holds the defaults of the
+// architecture, profiles of librettCalibrateModel() replace them per device, see
+// ModelProfile.h
+//
+struct GpuModelProp {
+  double base_dep_delay;
+  double base_mem_latency;
+  double sh_mem_latency;
+  double iter_cycles;
+  double fac;
+  // Memory bandwidth in GB/s, 0 takes the bandwidth of the device properties
+  double mem_BW;
+
+  GpuModelProp(int major);
+};
+
+//
+// Device constants of the model: number of SMs, clock in GHz, warp size and memory
+// bandwidth in GB/s. mem_BW = 0 leaves the bandwidth out of the model
+//
+struct GpuModelDevice {
+  double numSM;
+  double freq;
+  int warpSize;
+  double mem_BW;
+};
+
+// Device constants of prop, with the bandwidth of gpuModelProp if it has one
+GpuModelDevice gpuModelDevice(const gpuDeviceProp_t &prop, const GpuModelProp &gpuModelProp);
+
+// Model parameters of the device of prop: its profile, or the defaults of its architecture
+GpuModelProp gpuModelPropOf(const gpuDeviceProp_t &prop);
+
+//
+// Counters of a Packed, PackedSplit, Tiled or TiledCopy kernel, the input of the model
+//
+struct GpuModelCounters {
+  int method;
+  int nthread;
+  int numActiveBlock;
+  float mlp;
+  long long int gld_req, gst_req, gld_tran, gst_tran;
+  long long int sld_req, sst_req, sld_tran, sst_tran;
+  long long int num_iter, cl_full, cl_part;
+};
+
+// Counters of a plan after librettPlan_t::countCycles()
+GpuModelCounters gpuModelCounters(const librettPlan_t& plan);
+
+// Model cycles of a kernel, summed over the SMs
+double gpuModelCycles(const GpuModelProp &gpuModelProp, const GpuModelDevice &device,
+  const GpuModelCounters &counters);
 
 double cyclesPacked(const bool isSplit, const size_t sizeofType, const gpuDeviceProp_t &prop,
   int nthread, int numActiveBlock, float mlp,
-  int gld_req, int gst_req, int gld_tran, int gst_tran,
-  int sld_req, int sst_req, int sld_tran, int sst_tran, int num_iter, int cl_full, int cl_part);
+  long long int gld_req, long long int gst_req, long long int gld_tran, long long int gst_tran,
+  long long int sld_req, long long int sst_req, long long int sld_tran, long long int sst_tran,
+  long long int num_iter, long long int cl_full, long long int cl_part);
 
 double cyclesTiled(const bool isCopy, const size_t sizeofType, const gpuDeviceProp_t &prop,
   int nthread, int numActiveBlock, float mlp,
-  int gld_req, int gst_req, int gld_tran, int gst_tran,
-  int sld_req, int sst_req, int sld_tran, int sst_tran, int num_iter, int cl_full, int cl_part);
+  long long int gld_req, long long int gst_req, long long int gld_tran, long long int gst_tran,
+  long long int sld_req, long long int sst_req, long long int sld_tran, long long int sst_tran,
+  long long int num_iter, long long int cl_full, long long int cl_part);
+
+double cyclesHost(const int method, const size_t sizeofType, const gpuDeviceProp_t &prop,
+  const double sampleScale, const double vol, long long int num_iter,
+  long long int gld_tran, long long int gst_tran, long long int cl_full, long long int cl_part);
 
 bool testCounters(const int warpSize, const int accWidth, const int cacheWidth);
 
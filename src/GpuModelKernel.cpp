@@ -29,6 +29,7 @@ All rights reserved.
 #include "GpuMem.hpp"
 #include "GpuModelKernel.h"
 #include <iostream>
+#include <vector>
 #include "uniapi.h"
 
 #define RESTRICT //__restrict__
@@ -38,6 +39,58 @@ All rights reserved.
 #  pragma clang diagnostic ignored "-Wpass-failed"
 #endif
 
+#if LIBRETT_USES_CPU && !LIBRETT_CPU_SIMT
+//
+// Host version of runCountersKernel. Each group of warpSize positions is one warp,
+// lanes follow the same rules as the warp-wide countGlTransactions() and countCacheLines()
+//
+void runCountersHost(const int warpSize, const int* posData, const int numPosData,
+  const int accWidth, const int cacheWidth, int* tranData, int* cl_fullData, int* cl_partData)
+{
+  std::vector<int> seg(warpSize + 1);
+  std::vector<int> full(warpSize);
+  for (int j=0; j < numPosData/warpSize; j++) {
+    const int* pos = posData + j*warpSize;
+
+    // Active lanes are 0 ... n - 1
+    int n = warpSize;
+    for (int lane=0; lane < warpSize; lane++) {
+      if (pos[lane] == -1) {
+        n = lane;
+        break;
+      }
+    }
+
+    int tran = (n > 0);
+    for (int lane=1; lane < n; lane++) {
+      tran += (pos[lane]/accWidth != pos[lane - 1]/accWidth);
+    }
+
+    // Lane is at the beginning of a full cache line, if seg matches seg cacheWidth - 1 away
+    int cl_full = 0;
+    for (int lane=0; lane < warpSize; lane++) full[lane] = 0;
+    for (int lane=0; lane + cacheWidth - 1 < n; lane++) {
+      if (pos[lane]/cacheWidth == pos[lane + cacheWidth - 1]/cacheWidth) {
+        cl_full++;
+        for (int k=0; k < cacheWidth && lane + k < warpSize; k++) full[lane + k] = 1;
+      }
+    }
+
+    int cl_part = 0;
+    for (int lane=0; lane < warpSize; lane++) seg[lane] = (lane < n) ? pos[lane]/cacheWidth : -1;
+    seg[warpSize] = -1;
+    for (int lane=0; lane < warpSize; lane++) {
+      cl_part += (!full[lane] && seg[lane] != seg[lane + 1]);
+    }
+
+    tranData[j] = tran;
+    cl_fullData[j] = cl_full;
+    cl_partData[j] = cl_part;
+  }
+}
+
+#else // SYCL, HIP, CUDA
+
 //
 // Global memory access statistics
 //
@@ -493,6 +546,8 @@ countPacked(const int volMmk, const int volMbar,
   auto shSegOut = (int *)dpct_local;
 #elif HIP
   HIP_DYNAMIC_SHARED( int, shSegOut)
+#elif LIBRETT_USES_CPU
+  int* shSegOut = (int *)Librett::simt::dynamicShared();
 #else // CUDA
   extern __shared__ int shSegOut[];
 #endif
@@ -668,6 +723,8 @@ countPackedSplit( const int splitDim, const int volMmkUnsplit, const int volMbar
   auto shSegOut = (int *)dpct_local;
 #elif HIP
   HIP_DYNAMIC_SHARED( int, shSegOut)
+#elif LIBRETT_USES_CPU
+  int* shSegOut = (int *)Librett::simt::dynamicShared();
 #else // CUDA
   extern __shared__ int shSegOut[];
 #endif
@@ -943,6 +1000,7 @@ countTiledCopy(const int numMm, const int volMbar, const int sizeMbar,
   writeMemStat(warpLane, memStat, glMemStat);
 #endif
 }
+#endif // LIBRETT_USES_CPU && !LIBRETT_CPU_SIMT
 
 //######################################################################################
 //######################################################################################
@@ -982,6 +1040,19 @@ void runCounters(const int warpSize, const int *hostPosData, const int numPosDat
   copy_DtoH<int>(dev_cl_part, host_cl_part, numWarp, gpustream);
 
   gpustream->wait();
+#elif LIBRETT_USES_CPU && !LIBRETT_CPU_SIMT
+  runCountersHost(warpSize, devPosData, numPosData, accWidth, cacheWidth, dev_tran, dev_cl_full, dev_cl_part);
+
+  copy_DtoH<int>(dev_tran,    host_tran,    numWarp, gpustream);
+  copy_DtoH<int>(dev_cl_full, host_cl_full, numWarp, gpustream);
+  copy_DtoH<int>(dev_cl_part, host_cl_part, numWarp, gpustream);
+#elif LIBRETT_USES_CPU
+  Librett::simt::launch(nblock, nthread, 0, runCountersKernel, (const int *)devPosData, numPosData,
+    accWidth, cacheWidth, dev_tran, dev_cl_full, dev_cl_part);
+
+  copy_DtoH<int>(dev_tran,    host_tran,    numWarp, gpustream);
+  copy_DtoH<int>(dev_cl_full, host_cl_full, numWarp, gpustream);
+  copy_DtoH<int>(dev_cl_part, host_cl_part, numWarp, gpustream);
 #elif HIP
   hipLaunchKernelGGL(runCountersKernel, dim3(nblock), dim3(nthread ), 0, gpustream, devPosData, numPosData,
     accWidth, cacheWidth, dev_tran, dev_cl_full, dev_cl_part);
@@ -1009,10 +1080,56 @@ void runCounters(const int warpSize, const int *hostPosData, const int numPosDat
   deallocate_device<int>(&devPosData, gpustream);
 }
 
+#if !(LIBRETT_USES_CPU && !LIBRETT_CPU_SIMT)
+//
+// The counter kernels read Mbar and Mmk from device memory. Short descriptors are passed
+// to the transpose kernels by value and have no device buffer, see librettPlan_t::activate(),
+// they are uploaded for the lifetime of this object
+//
+struct CounterDescriptors {
+  librettPlan_t& plan;
+  TensorConvInOut* Mbar;
+  TensorConvInOut* Mmk;
+
+  CounterDescriptors(librettPlan_t& plan_in) : plan(plan_in), Mbar(nullptr), Mmk(nullptr) {
+    if (plan.Mbar == nullptr && !plan.hostMbar.empty()) {
+      allocate_device<TensorConvInOut>(&Mbar, plan.hostMbar.size(), plan.stream);
+      copy_HtoD_sync<TensorConvInOut>(plan.hostMbar.data(), Mbar, plan.hostMbar.size(), plan.stream);
+      plan.Mbar = Mbar;
+    }
+    if (plan.Mmk == nullptr && !plan.hostMmk.empty()) {
+      allocate_device<TensorConvInOut>(&Mmk, plan.hostMmk.size(), plan.stream);
+      copy_HtoD_sync<TensorConvInOut>(plan.hostMmk.data(), Mmk, plan.hostMmk.size(), plan.stream);
+      plan.Mmk = Mmk;
+    }
+  }
+
+  ~CounterDescriptors() {
+    if (Mbar != nullptr) {
+      plan.Mbar = nullptr;
+      deallocate_device<TensorConvInOut>(&Mbar, plan.stream);
+    }
+    if (Mmk != nullptr) {
+      plan.Mmk = nullptr;
+      deallocate_device<TensorConvInOut>(&Mmk, plan.stream);
+    }
+  }
+};
+#endif
+
 bool librettGpuModelKernel(librettPlan_t &plan, const int accWidth, const int cacheWidth,
   int &gld_tran, int &gst_tran, int &gld_req, int &gst_req,
   int &cl_full_l2, int &cl_part_l2, int &cl_full_l1, int &cl_part_l1)
 {
+#if LIBRETT_USES_CPU && !LIBRETT_CPU_SIMT
+  // Counter kernels are device-only; the host model works from countCycles() estimates
+  return false;
+#else
+
+  // Counter kernels use int positions
+  if (plan.index64) return false;
+
+  CounterDescriptors descriptors(plan);
 
   LaunchConfig& lc = plan.launchConfig;
   TensorSplit& ts = plan.tensorSplit;
@@ -1054,6 +1171,11 @@ bool librettGpuModelKernel(librettPlan_t &plan, const int accWidth, const int ca
                             item, dpct_local_acc_ct1.get_pointer());       \
         });                                                                    \
   });
+#elif LIBRETT_USES_CPU
+  #define CALL0(NREG)                                                                       \
+    Librett::simt::launch(lc.numblock, lc.numthread, ts.volMmk*sizeof(int), countPacked<NREG>, \
+      ts.volMmk, ts.volMbar, ts.sizeMmk, ts.sizeMbar,                                       \
+      plan.Mmk, plan.Mbar, accWidth, cacheWidth, devMemStat)
 #else // CUDA or HIP
   #define CALL0(NREG)                                                                       \
     countPacked<NREG> <<< lc.numblock, lc.numthread, ts.volMmk*sizeof(int), plan.stream >>> \
@@ -1109,6 +1231,11 @@ bool librettGpuModelKernel(librettPlan_t &plan, const int accWidth, const int ca
               dpct_local_acc_ct1.get_pointer());                               \
         });                                                                    \
   });
+#elif LIBRETT_USES_CPU
+  #define CALL0(NREG)                                                                              \
+    Librett::simt::launch(lc.numblock, lc.numthread, volMmkSplit*sizeof(int), countPackedSplit<NREG>, \
+      ts.splitDim, ts.volMmkUnsplit, ts.volMbar, ts.sizeMmk, ts.sizeMbar,                          \
+        plan.cuDimMm, plan.cuDimMk, plan.Mmk, plan.Mbar, accWidth, cacheWidth, devMemStat)
 #else // CUDA or HIP
   #define CALL0(NREG)                                                                              \
     countPackedSplit<NREG> <<< lc.numblock, lc.numthread, volMmkSplit*sizeof(int), plan.stream >>> \
@@ -1150,6 +1277,10 @@ bool librettGpuModelKernel(librettPlan_t &plan, const int accWidth, const int ca
       hipLaunchKernelGGL(countTiled, dim3(lc.numblock), dim3(lc.numthread), 0, plan.stream ,
 	((ts.volMm - 1)/TILEDIM + 1), ts.volMbar, ts.sizeMbar, plan.tiledVol, plan.cuDimMk, plan.cuDimMm,
         plan.Mbar, accWidth, cacheWidth, devMemStat);
+#elif LIBRETT_USES_CPU
+      Librett::simt::launch(lc.numblock, lc.numthread, 0, countTiled,
+        ((ts.volMm - 1)/TILEDIM + 1), ts.volMbar, ts.sizeMbar, plan.tiledVol, plan.cuDimMk,
+        plan.cuDimMm, plan.Mbar, accWidth, cacheWidth, devMemStat);
 #else // CUDA
       countTiled <<< lc.numblock, lc.numthread, 0, plan.stream >>>
         (((ts.volMm - 1)/TILEDIM + 1), ts.volMbar, ts.sizeMbar, plan.tiledVol, plan.cuDimMk,
@@ -1181,6 +1312,10 @@ bool librettGpuModelKernel(librettPlan_t &plan, const int accWidth, const int ca
       hipLaunchKernelGGL(countTiledCopy, dim3(lc.numblock), dim3(lc.numthread), 0, plan.stream ,
 	((ts.volMm - 1)/TILEDIM + 1), ts.volMbar, ts.sizeMbar, plan.cuDimMk, plan.cuDimMm, plan.tiledVol,
         plan.Mbar, accWidth, cacheWidth, devMemStat);
+#elif LIBRETT_USES_CPU
+      Librett::simt::launch(lc.numblock, lc.numthread, 0, countTiledCopy,
+        ((ts.volMm - 1)/TILEDIM + 1), ts.volMbar, ts.sizeMbar, plan.cuDimMk, plan.cuDimMm,
+        plan.tiledVol, plan.Mbar, accWidth, cacheWidth, devMemStat);
 #else // CUDA
       countTiledCopy <<< lc.numblock, lc.numthread, 0, plan.stream >>>
         (((ts.volMm - 1)/TILEDIM + 1), ts.volMbar, ts.sizeMbar, plan.cuDimMk, plan.cuDimMm,
@@ -1204,6 +1339,7 @@ bool librettGpuModelKernel(librettPlan_t &plan, const int accWidth, const int ca
   plan.stream->wait_and_throw();
 #elif HIP
   hipCheck(hipDeviceSynchronize());
+#elif LIBRETT_USES_CPU
 #else // CUDA
   cudaCheck(cudaDeviceSynchronize());
 #endif
@@ -1220,4 +1356,5 @@ bool librettGpuModelKernel(librettPlan_t &plan, const int accWidth, const int ca
   // l1_tran    = hostMemStat.l1_tran;
 
   return true;
+#endif // LIBRETT_USES_CPU && !LIBRETT_CPU_SIMT
 }
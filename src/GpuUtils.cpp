@@ -24,6 +24,7 @@ SOFTWARE.
 *******************************************************************************/
 
 #include <stdio.h>
+#include <string.h>
 
 #ifdef ENABLE_NVTOOLS
   #include <nvToolsExtCuda.h>
@@ -38,6 +39,8 @@ void set_device_array_async_T(void *data, int value, const size_t ndata,
 {
   #if SYCL
     stream->memset(data, value, sizeofT * ndata);
+  #elif LIBRETT_USES_CPU
+    memset(data, value, sizeofT*ndata);
   #elif HIP
     hipCheck(hipMemsetAsync(data, value, sizeofT*ndata, stream));
   #else // CUDA
@@ -50,6 +53,8 @@ void set_device_array_sync_T(void *data, int value, const size_t ndata,
 {
   #if SYCL
     stream->memset(data, value, sizeofT * ndata).wait();
+  #elif LIBRETT_USES_CPU
+    memset(data, value, sizeofT*ndata);
   #elif HIP
     hipCheck(hipMemset(data, value, sizeofT*ndata));
   #else // CUDA
@@ -66,6 +71,8 @@ void copy_HtoD_async_T(const void *h_array, void *d_array, size_t array_len,
 {
   #if SYCL
     stream->memcpy(d_array, h_array, sizeofT * array_len);
+  #elif LIBRETT_USES_CPU
+    memcpy(d_array, h_array, sizeofT*array_len);
   #elif HIP
     hipCheck(hipMemcpyAsync(d_array, h_array, sizeofT*array_len, hipMemcpyDefault, stream));
   #else // CUDA
@@ -78,6 +85,8 @@ void copy_HtoD_sync_T(const void *h_array, void *d_array, size_t array_len,
 {
   #if SYCL
     stream->memcpy(d_array, h_array, sizeofT * array_len).wait();
+  #elif LIBRETT_USES_CPU
+    memcpy(d_array, h_array, sizeofT*array_len);
   #elif HIP
     hipCheck(hipMemcpy(d_array, h_array, sizeofT*array_len, hipMemcpyDefault));
   #else // CUDA
@@ -94,6 +103,8 @@ void copy_DtoH_async_T(const void *d_array, void *h_array, const size_t array_le
 {
   #if SYCL
     stream->memcpy(h_array, d_array, sizeofT * array_len);
+  #elif LIBRETT_USES_CPU
+    memcpy(h_array, d_array, sizeofT*array_len);
   #elif HIP
     hipCheck(hipMemcpyAsync(h_array, d_array, sizeofT*array_len, hipMemcpyDefault, stream));
   #else // CUDA
@@ -106,6 +117,8 @@ void copy_DtoH_sync_T(const void *d_array, void *h_array, const size_t array_len
 {
   #if SYCL
     stream->memcpy(h_array, d_array, sizeofT * array_len).wait();
+  #elif LIBRETT_USES_CPU
+    memcpy(h_array, d_array, sizeofT*array_len);
   #elif HIP
     hipCheck(hipMemcpy(h_array, d_array, sizeofT*array_len, hipMemcpyDefault));
   #else
@@ -143,7 +156,7 @@ void gpuRangeStop() {
 #endif
 
 void DeviceReset() {
-  #if SYCL
+  #if SYCL || LIBRETT_USES_CPU
   // does nothing
   #elif HIP
     hipCheck(hipSetDevice(0));
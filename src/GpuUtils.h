@@ -35,6 +35,8 @@ static int warp_size = 64;  // AMD change
 //
 #ifdef SYCL
   #define cudaCheck(stmt) do { int err = stmt; } while (0)
+#elif LIBRETT_USES_CPU
+  #define cudaCheck(stmt) do { stmt; } while (0)
 #elif HIP
   #define hipCheck(stmt) do {                                                       \
     hipError_t err = stmt;                                                          \
@@ -0,0 +1,142 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2026 Librett developers
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+#include "CpuTile.h"
+#include "InPlace.h"
+#include "ThreadPool.h"
+
+// Pass 1 scratch memory is at most the larger of this and 1/16 of the tensor
+const size_t INPLACE_SCRATCH_BYTES = 4*1024*1024;
+// Longest run of the new leading rank that pass 1 gathers
+const int INPLACE_MAX_RUN = 64;
+// Largest run when the leading rank stays in place
+const size_t INPLACE_MAX_RUN_BYTES = 64*1024;
+
+// Largest divisor of n that is at most maxDiv
+static int largestDivisor(const int n, const int maxDiv) {
+  for (int t=std::min(n, maxDiv);t > 1;t--) {
+    if (n % t == 0) return t;
+  }
+  return 1;
+}
+
+bool inPlaceTranspose(const int rank, const int* dim, const int* permutation, const size_t sizeofType,
+  void* data) {
+
+  if (rank <= 1) return true;
+
+  size_t vol = 1;
+  for (int i=0;i < rank;i++) vol *= dim[i];
+
+  // Input rank that becomes the leading output rank, and volume of the input ranks before it
+  const int lead = permutation[0];
+  size_t volBefore = 1;
+  for (int i=0;i < lead;i++) volBefore *= dim[i];
+
+  // Split dim[lead] = t*q with t the faster part. Runs of t elements move as a unit in pass 2
+  const size_t scratchBytes = std::max(INPLACE_SCRATCH_BYTES, vol*sizeofType/16);
+  int t;
+  if (lead == 0) {
+    t = largestDivisor(dim[0], (int)std::max<size_t>(1, INPLACE_MAX_RUN_BYTES/sizeofType));
+  } else {
+    const size_t maxRun = scratchBytes/(volBefore*sizeofType);
+    t = largestDivisor(dim[lead], (int)std::min<size_t>(INPLACE_MAX_RUN, maxRun));
+  }
+
+  char* base = (char *)data;
+
+  //
+  // Pass 1: every block [volBefore][t] becomes [t][volBefore]
+  //
+  if (volBefore > 1 && t > 1) {
+    TileTransposeFunc tileTranspose = tileTransposeFunc(sizeofType, cpuIsa());
+    if (tileTranspose == nullptr) return false;
+
+    const size_t blockBytes = volBefore*t*sizeofType;
+    const size_t numBlock = vol/(volBefore*t);
+    ThreadPool& pool = ThreadPool::instance();
+    const int numTask = (int)std::min({(size_t)pool.numThread(), numBlock, scratchBytes/blockBytes});
+    std::vector<char> scratch(numTask*blockBytes);
+
+    pool.parallelFor(numTask, [&](int task) {
+      char* buf = scratch.data() + task*blockBytes;
+      for (size_t b=task;b < numBlock;b += numTask) {
+        char* block = base + b*blockBytes;
+        memcpy(buf, block, blockBytes);
+        tileTranspose(buf, (int)volBefore, block, t, (int)volBefore, t);
+      }
+    });
+  }
+
+  //
+  // Pass 2: cycle following on runs. Run position is the input position with dim[lead]
+  // replaced by q, its destination is the output position with the same replacement
+  //
+  std::vector<size_t> runDim(dim, dim + rank);
+  runDim[lead] /= t;
+  std::vector<size_t> outStride(rank);
+  size_t stride = 1;
+  for (int i=0;i < rank;i++) {
+    outStride[permutation[i]] = stride;
+    stride *= runDim[permutation[i]];
+  }
+
+  auto destination = [&](size_t pos) {
+    size_t dst = 0;
+    for (int i=0;i < rank;i++) {
+      const size_t c = pos % runDim[i];
+      pos /= runDim[i];
+      dst += c*outStride[i];
+    }
+    return dst;
+  };
+
+  const size_t runBytes = t*sizeofType;
+  const size_t numRun = vol/t;
+  std::vector<uint64_t> moved((numRun + 63)/64, 0);
+  std::vector<char> carry(runBytes);
+  std::vector<char> swap(runBytes);
+
+  for (size_t start=0;start < numRun;start++) {
+    if ((moved[start >> 6] >> (start & 63)) & 1) continue;
+    moved[start >> 6] |= 1ull << (start & 63);
+    size_t dst = destination(start);
+    if (dst == start) continue;
+    // carry holds the run that belongs to dst
+    memcpy(carry.data(), base + start*runBytes, runBytes);
+    while (dst != start) {
+      memcpy(swap.data(), base + dst*runBytes, runBytes);
+      memcpy(base + dst*runBytes, carry.data(), runBytes);
+      carry.swap(swap);
+      moved[dst >> 6] |= 1ull << (dst & 63);
+      dst = destination(dst);
+    }
+    memcpy(base + start*runBytes, carry.data(), runBytes);
+  }
+
+  return true;
+}
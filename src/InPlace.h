@@ -0,0 +1,49 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2026 Librett developers
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+#ifndef LIBRETTINPLACE_H
+#define LIBRETTINPLACE_H
+
+#include <cstddef>
+
+//
+// In-place transpose of a tensor in host memory.
+//
+// The permutation is split into two passes:
+// 1. Each contiguous block of input rows up to the new leading rank is transposed through
+//    a scratch buffer, so that runs of t elements of the new leading rank become contiguous.
+// 2. The runs are moved to their final position by following the cycles of the remaining
+//    permutation. Every run is read and written once, a bit map marks the runs already moved.
+//
+// Extra memory is one bit per run, two runs and a pass 1 scratch buffer of at most
+// 4 MB or 1/16 of the tensor, whichever is larger. Pass 2 is serial and its accesses are scattered,
+// so the bandwidth is a fraction of the out-of-place kernels.
+//
+// dim[rank] and permutation[rank] as in librettPlan(); ranks should be reduced with
+// reduceRanks() beforehand, which makes the runs longer. sizeofType must be supported
+// by tileTransposeFunc().
+//
+bool inPlaceTranspose(const int rank, const int* dim, const int* permutation, const size_t sizeofType,
+  void* data);
+
+#endif // LIBRETTINPLACE_H
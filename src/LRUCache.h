@@ -43,7 +43,7 @@ private:
   };
 
   // Size of the cache
-  const size_t capacity;
+  size_t capacity;
 
   // Value that is returned when the key is not found
   const value_type null_value;
@@ -80,11 +80,8 @@ public:
       touch(it);
     } else {
       // key not found
-      if (cache.size() == capacity) {
-        key_type oldest_key = keys.back();
-        keys.pop_back();
-        cache.erase( cache.find(oldest_key) );
-      }
+      if (capacity == 0) return;
+      if (cache.size() == capacity) evict(capacity - 1);
       keys.push_front(key);
       ValueIterator vi;
       vi.value = value;
@@ -94,8 +91,42 @@ public:
     }
   }
 
+  // Sets the size of the cache, the oldest entries are dropped when it shrinks
+  void setCapacity(const size_t capacity_in) {
+    std::lock_guard<std::mutex> lock(cache_lock);
+    capacity = capacity_in;
+    evict(capacity);
+  }
+
+  void erase(key_type key) {
+    std::lock_guard<std::mutex> lock(cache_lock);
+    auto it = cache.find(key);
+    if (it == cache.end()) return;
+    keys.erase(it->second.it);
+    cache.erase(it);
+  }
+
+  size_t size() {
+    std::lock_guard<std::mutex> lock(cache_lock);
+    return cache.size();
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> lock(cache_lock);
+    evict(0);
+  }
+
 private:
 
+  // Drops the oldest entries until there are at most n left
+  void evict(const size_t n) {
+    while (cache.size() > n) {
+      key_type oldest_key = keys.back();
+      keys.pop_back();
+      cache.erase( cache.find(oldest_key) );
+    }
+  }
+
   void touch(typename unordered_map<key_type, ValueIterator>::iterator it) {
     keys.erase(it->second.it);
     keys.push_front(it->first);
@@ -0,0 +1,294 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2026 Librett developers
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include "ModelProfile.h"
+#include "Wisdom.h"
+
+const char* PROFILE_HEADER = "librett-model-profile 1";
+const char* SAMPLES_HEADER = "librett-model-samples 1";
+
+// Profiles keyed by device name, ordered so that exported files are stable
+static std::map<std::string, GpuModelProp> profiles;
+static std::mutex profilesMutex;
+
+bool modelProfileFind(const gpuDeviceProp_t& prop, GpuModelProp& gpuModelProp) {
+  std::lock_guard<std::mutex> lock(profilesMutex);
+  if (profiles.empty()) return false;
+  auto it = profiles.find(deviceName(prop));
+  if (it == profiles.end()) return false;
+  gpuModelProp = it->second;
+  return true;
+}
+
+void modelProfileRecord(const std::string& name, const GpuModelProp& gpuModelProp) {
+  std::lock_guard<std::mutex> lock(profilesMutex);
+  profiles.erase(name);
+  profiles.emplace(name, gpuModelProp);
+}
+
+bool modelProfileExport(const char* path) {
+  std::ofstream file(path);
+  if (!file) return false;
+  file << PROFILE_HEADER << "\n" << std::setprecision(9);
+  std::lock_guard<std::mutex> lock(profilesMutex);
+  for (auto it=profiles.begin();it != profiles.end();it++) {
+    const GpuModelProp& p = it->second;
+    file << p.base_dep_delay << " " << p.base_mem_latency << " " << p.sh_mem_latency << " " << p.iter_cycles
+      << " " << p.fac << " " << p.mem_BW << " " << it->first << "\n";
+  }
+  return (bool)file;
+}
+
+bool modelProfileImport(const char* path) {
+  std::ifstream file(path);
+  if (!file) return false;
+  std::string line;
+  if (!std::getline(file, line) || line != PROFILE_HEADER) return false;
+  std::map<std::string, GpuModelProp> entries;
+  while (std::getline(file, line)) {
+    if (line.empty()) continue;
+    std::istringstream str(line);
+    GpuModelProp p(0);
+    str >> p.base_dep_delay >> p.base_mem_latency >> p.sh_mem_latency >> p.iter_cycles >> p.fac >> p.mem_BW;
+    if (!str) return false;
+    std::string name;
+    std::getline(str >> std::ws, name);
+    if (name.empty()) return false;
+    entries.erase(name);
+    entries.emplace(name, p);
+  }
+  std::lock_guard<std::mutex> lock(profilesMutex);
+  for (auto it=entries.begin();it != entries.end();it++) {
+    profiles.erase(it->first);
+    profiles.emplace(it->first, it->second);
+  }
+  return true;
+}
+
+bool modelSamplesWrite(const char* path, const std::string& name, const int major,
+  const GpuModelDevice& device, const std::vector<GpuModelSample>& samples) {
+  std::ofstream file(path);
+  if (!file) return false;
+  file << SAMPLES_HEADER << "\n" << name << "\n" << std::setprecision(9);
+  file << major << " " << device.numSM << " " << device.freq << " " << device.warpSize << " "
+    << device.mem_BW << "\n";
+  for (const GpuModelSample& s : samples) {
+    const GpuModelCounters& c = s.counters;
+    file << c.method << " " << c.nthread << " " << c.numActiveBlock << " " << c.mlp << " "
+      << c.gld_req << " " << c.gst_req << " " << c.gld_tran << " " << c.gst_tran << " "
+      << c.sld_req << " " << c.sst_req << " " << c.sld_tran << " " << c.sst_tran << " "
+      << c.num_iter << " " << c.cl_full << " " << c.cl_part << " " << s.seconds << "\n";
+  }
+  return (bool)file;
+}
+
+bool modelSamplesRead(const char* path, std::string& name, int& major, GpuModelDevice& device,
+  std::vector<GpuModelSample>& samples) {
+  std::ifstream file(path);
+  if (!file) return false;
+  std::string line;
+  if (!std::getline(file, line) || line != SAMPLES_HEADER) return false;
+  if (!std::getline(file, name) || name.empty()) return false;
+  if (!std::getline(file, line)) return false;
+  std::istringstream deviceStr(line);
+  deviceStr >> major >> device.numSM >> device.freq >> device.warpSize >> device.mem_BW;
+  if (!deviceStr || device.numSM <= 0.0 || device.freq <= 0.0 || device.warpSize <= 0) return false;
+  samples.clear();
+  while (std::getline(file, line)) {
+    if (line.empty()) continue;
+    std::istringstream str(line);
+    GpuModelSample s;
+    GpuModelCounters& c = s.counters;
+    str >> c.method >> c.nthread >> c.numActiveBlock >> c.mlp >> c.gld_req >> c.gst_req >> c.gld_tran
+      >> c.gst_tran >> c.sld_req >> c.sst_req >> c.sld_tran >> c.sst_tran >> c.num_iter >> c.cl_full
+      >> c.cl_part >> s.seconds;
+    if (!str) return false;
+    samples.push_back(s);
+  }
+  return true;
+}
+
+// Fitted parameters and the weight that pulls them toward their starting values. The
+// pull keeps parameters that the samples do not constrain, e.g. sh_mem_latency without
+// shared memory kernels, at their defaults
+const int NUM_FIT_PARAM = 5;
+const double FIT_PRIOR_WEIGHT = 1.0e-3;
+
+// Parameters are fitted as logarithms, so that they stay positive
+static void getFitParams(const GpuModelProp& p, double* x) {
+  x[0] = std::log(p.base_dep_delay);
+  x[1] = std::log(p.base_mem_latency);
+  x[2] = std::log(p.sh_mem_latency);
+  x[3] = std::log(p.iter_cycles);
+  x[4] = std::log(p.fac);
+}
+
+static void setFitParams(const double* x, GpuModelProp& p) {
+  p.base_dep_delay = std::exp(x[0]);
+  p.base_mem_latency = std::exp(x[1]);
+  p.sh_mem_latency = std::exp(x[2]);
+  p.iter_cycles = std::exp(x[3]);
+  p.fac = std::exp(x[4]);
+}
+
+//
+// Residuals at parameters x: log of model over measured cycles of each sample, then the
+// pull toward x0. Returns false if the model cannot be evaluated
+//
+static bool fitResiduals(const GpuModelDevice& device, const std::vector<GpuModelSample>& samples,
+  const double* x, const double* x0, GpuModelProp& p, std::vector<double>& r) {
+  setFitParams(x, p);
+  const double cyclesPerSecond = device.freq*1.0e9*device.numSM;
+  for (size_t i=0;i < samples.size();i++) {
+    const double cycles = gpuModelCycles(p, device, samples[i].counters);
+    if (!std::isfinite(cycles) || cycles <= 0.0) return false;
+    r[i] = std::log(cycles/(samples[i].seconds*cyclesPerSecond));
+  }
+  for (int j=0;j < NUM_FIT_PARAM;j++) r[samples.size() + j] = FIT_PRIOR_WEIGHT*(x[j] - x0[j]);
+  return true;
+}
+
+static double sumSquares(const std::vector<double>& r) {
+  double sum = 0.0;
+  for (double v : r) sum += v*v;
+  return sum;
+}
+
+//
+// Solves a*d = b by Gaussian elimination with partial pivoting, a and b are overwritten.
+// Returns false if a is singular
+//
+static bool solveFit(double a[NUM_FIT_PARAM][NUM_FIT_PARAM], double* b, double* d) {
+  const int n = NUM_FIT_PARAM;
+  for (int k=0;k < n;k++) {
+    int pivot = k;
+    for (int i=k + 1;i < n;i++) {
+      if (std::fabs(a[i][k]) > std::fabs(a[pivot][k])) pivot = i;
+    }
+    if (!(std::fabs(a[pivot][k]) > 0.0)) return false;
+    for (int j=0;j < n;j++) std::swap(a[k][j], a[pivot][j]);
+    std::swap(b[k], b[pivot]);
+    for (int i=k + 1;i < n;i++) {
+      const double f = a[i][k]/a[k][k];
+      for (int j=k;j < n;j++) a[i][j] -= f*a[k][j];
+      b[i] -= f*b[k];
+    }
+  }
+  for (int i=n - 1;i >= 0;i--) {
+    double sum = b[i];
+    for (int j=i + 1;j < n;j++) sum -= a[i][j]*d[j];
+    d[i] = sum/a[i][i];
+  }
+  return true;
+}
+
+//
+// Levenberg-Marquardt iterations with a forward difference Jacobian. The model is a
+// minimum of several terms, so it is only piecewise smooth; steps that do not lower the
+// cost raise the damping until one does or the damping runs out
+//
+bool modelFit(const GpuModelDevice& device, const std::vector<GpuModelSample>& samples_in,
+  GpuModelProp& gpuModelProp) {
+
+  // Samples the model cannot evaluate, e.g. kernels without active warps, are left out
+  std::vector<GpuModelSample> samples;
+  for (const GpuModelSample& s : samples_in) {
+    const int method = s.counters.method;
+    if (!(s.seconds > 0.0) ||
+      (method != Packed && method != PackedSplit && method != Tiled && method != TiledCopy)) continue;
+    const double cycles = gpuModelCycles(gpuModelProp, device, s.counters);
+    if (std::isfinite(cycles) && cycles > 0.0) samples.push_back(s);
+  }
+  if ((int)samples.size() < MODEL_FIT_MIN_SAMPLE) return false;
+
+  const int m = (int)samples.size() + NUM_FIT_PARAM;
+  GpuModelProp p = gpuModelProp;
+  double x0[NUM_FIT_PARAM];
+  double x[NUM_FIT_PARAM];
+  getFitParams(gpuModelProp, x0);
+  getFitParams(gpuModelProp, x);
+  std::vector<double> r(m);
+  std::vector<double> rTry(m);
+  std::vector<double> jac(m*NUM_FIT_PARAM);
+  if (!fitResiduals(device, samples, x, x0, p, r)) return false;
+  double cost = sumSquares(r);
+
+  const double h = 1.0e-5;
+  double lambda = 1.0e-3;
+  for (int iter=0;iter < 200;iter++) {
+    for (int j=0;j < NUM_FIT_PARAM;j++) {
+      double xh[NUM_FIT_PARAM];
+      for (int k=0;k < NUM_FIT_PARAM;k++) xh[k] = x[k];
+      xh[j] += h;
+      const bool ok = fitResiduals(device, samples, xh, x0, p, rTry);
+      for (int i=0;i < m;i++) jac[i*NUM_FIT_PARAM + j] = ok ? (rTry[i] - r[i])/h : 0.0;
+    }
+    double jtj[NUM_FIT_PARAM][NUM_FIT_PARAM];
+    double jtr[NUM_FIT_PARAM];
+    for (int j=0;j < NUM_FIT_PARAM;j++) {
+      jtr[j] = 0.0;
+      for (int i=0;i < m;i++) jtr[j] += jac[i*NUM_FIT_PARAM + j]*r[i];
+      for (int k=0;k < NUM_FIT_PARAM;k++) {
+        jtj[j][k] = 0.0;
+        for (int i=0;i < m;i++) jtj[j][k] += jac[i*NUM_FIT_PARAM + j]*jac[i*NUM_FIT_PARAM + k];
+      }
+    }
+
+    bool improved = false;
+    double xTry[NUM_FIT_PARAM];
+    while (!improved && lambda < 1.0e10) {
+      double a[NUM_FIT_PARAM][NUM_FIT_PARAM];
+      double b[NUM_FIT_PARAM];
+      double d[NUM_FIT_PARAM];
+      for (int j=0;j < NUM_FIT_PARAM;j++) {
+        for (int k=0;k < NUM_FIT_PARAM;k++) a[j][k] = jtj[j][k];
+        a[j][j] += lambda*jtj[j][j] + 1.0e-12;
+        b[j] = -jtr[j];
+      }
+      if (solveFit(a, b, d)) {
+        for (int j=0;j < NUM_FIT_PARAM;j++) xTry[j] = x[j] + d[j];
+        improved = fitResiduals(device, samples, xTry, x0, p, rTry) && sumSquares(rTry) < cost;
+      }
+      if (!improved) lambda *= 10.0;
+    }
+    if (!improved) break;
+
+    const double costTry = sumSquares(rTry);
+    const bool converged = (cost - costTry < 1.0e-12*(1.0 + cost));
+    for (int j=0;j < NUM_FIT_PARAM;j++) x[j] = xTry[j];
+    r.swap(rTry);
+    cost = costTry;
+    lambda = std::max(lambda*0.1, 1.0e-12);
+    if (converged) break;
+  }
+
+  setFitParams(x, gpuModelProp);
+  return true;
+}
@@ -0,0 +1,85 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2026 Librett developers
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+#ifndef LIBRETTMODELPROFILE_H
+#define LIBRETTMODELPROFILE_H
+
+#include <string>
+#include <vector>
+#include "GpuModel.h"
+
+//
+// Model profiles: the GpuModelProp parameters fitted for a device by librettCalibrateModel()
+// or librettFitModel(), kept per device name like wisdom. countCycles() uses the profile
+// of the device instead of the defaults of its architecture.
+//
+// The profile file is text, one device per line:
+// base_dep_delay base_mem_latency sh_mem_latency iter_cycles fac mem_BW deviceName
+//
+// The sample file holds recorded timings. After the header come the device name on a line
+// of its own, the line
+// major numSM freq warpSize mem_BW
+// and one line per timed kernel:
+// method nthread numActiveBlock mlp gld_req gst_req gld_tran gst_tran sld_req sst_req
+// sld_tran sst_tran num_iter cl_full cl_part seconds
+//
+
+// Timed run of a kernel
+struct GpuModelSample {
+  GpuModelCounters counters;
+  double seconds;
+};
+
+// Profile of the device of prop. Returns false if the device has none
+bool modelProfileFind(const gpuDeviceProp_t& prop, GpuModelProp& gpuModelProp);
+
+// Stores the profile of the device called name, replacing an older one
+void modelProfileRecord(const std::string& name, const GpuModelProp& gpuModelProp);
+
+// Writes all profiles to path. Returns false if the file cannot be written
+bool modelProfileExport(const char* path);
+
+// Adds the profiles of path, replacing profiles of the same device. Returns false if the
+// file cannot be read or is not a profile file
+bool modelProfileImport(const char* path);
+
+// Writes samples of the device called name. Returns false if the file cannot be written
+bool modelSamplesWrite(const char* path, const std::string& name, const int major,
+  const GpuModelDevice& device, const std::vector<GpuModelSample>& samples);
+
+// Reads a file of modelSamplesWrite(). Returns false if the file cannot be read or is not
+// a sample file
+bool modelSamplesRead(const char* path, std::string& name, int& major, GpuModelDevice& device,
+  std::vector<GpuModelSample>& samples);
+
+//
+// Fits base_dep_delay, base_mem_latency, sh_mem_latency, iter_cycles and fac to the
+// samples by least squares on the logarithm of the cycles, starting from the values in
+// gpuModelProp. mem_BW is not fitted, it is measured directly. Samples on which the model
+// cannot be evaluated are left out. Returns false if fewer than MODEL_FIT_MIN_SAMPLE remain
+//
+const int MODEL_FIT_MIN_SAMPLE = 8;
+bool modelFit(const GpuModelDevice& device, const std::vector<GpuModelSample>& samples,
+  GpuModelProp& gpuModelProp);
+
+#endif // LIBRETTMODELPROFILE_H
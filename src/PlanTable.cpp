@@ -0,0 +1,124 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2026 Librett developers
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+#include <thread>
+#include "PlanTable.h"
+
+const librettHandle SLOT_MASK = (1u << PlanTable::SLOT_BITS) - 1;
+
+PlanTable::PlanTable() : numSlot(0) {
+  for (int i=0;i < NUM_SEGMENT;i++) segments[i] = nullptr;
+}
+
+PlanTable::~PlanTable() {
+  for (int i=0;i < NUM_SEGMENT;i++) delete [] segments[i].load();
+}
+
+PlanTable::Slot* PlanTable::getSlot(const librettHandle handle) {
+  const int slot = (int)(handle & SLOT_MASK);
+  Slot* segment = segments[slot >> SEGMENT_BITS].load();
+  if (segment == nullptr) return nullptr;
+  return &segment[slot & (SEGMENT_SIZE - 1)];
+}
+
+//
+// Takes a free slot, or adds a slot at the end of the table. Called with mutex held
+//
+bool PlanTable::newSlot(int& slot) {
+  if (!freeSlots.empty()) {
+    slot = freeSlots.front();
+    freeSlots.pop_front();
+    return true;
+  }
+  if (numSlot == NUM_SEGMENT*SEGMENT_SIZE) return false;
+  if (numSlot % SEGMENT_SIZE == 0) {
+    Slot* segment = new Slot[SEGMENT_SIZE];
+    for (int i=0;i < SEGMENT_SIZE;i++) {
+      segment[i].handle = (librettHandle)(numSlot + i);
+      segment[i].plan = nullptr;
+      segment[i].readers = 0;
+      segment[i].inUse = false;
+    }
+    segments[numSlot >> SEGMENT_BITS].store(segment);
+  }
+  slot = numSlot++;
+  return true;
+}
+
+bool PlanTable::insert(librettPlan_t* plan, librettHandle& handle) {
+  if (!reserve(handle)) return false;
+  publish(handle, plan);
+  return true;
+}
+
+bool PlanTable::reserve(librettHandle& handle) {
+  std::lock_guard<std::mutex> lock(mutex);
+  int slot;
+  if (!newSlot(slot)) return false;
+  Slot* s = getSlot((librettHandle)slot);
+  s->inUse = true;
+  handle = s->handle;
+  return true;
+}
+
+void PlanTable::publish(const librettHandle handle, librettPlan_t* plan) {
+  getSlot(handle)->plan.store(plan);
+}
+
+librettPlan_t* PlanTable::remove(const librettHandle handle) {
+  Slot* slot;
+  librettPlan_t* plan;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    slot = getSlot(handle);
+    if (slot == nullptr || !slot->inUse || slot->handle != handle) return nullptr;
+    // Next generation of the slot, find() of handle fails from here on
+    slot->handle.store(handle + SLOT_MASK + 1);
+    plan = slot->plan.exchange(nullptr);
+  }
+  // Wait for the calls that found the plan before it was removed
+  while (slot->readers.load() != 0) std::this_thread::yield();
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    slot->inUse = false;
+    freeSlots.push_back((int)(handle & SLOT_MASK));
+  }
+  return plan;
+}
+
+PlanTable::Ref PlanTable::find(const librettHandle handle) {
+  Ref ref;
+  Slot* slot = getSlot(handle);
+  if (slot == nullptr) return ref;
+  // The reader count is raised before the plan is read, remove() sees either the count
+  // or the plan gone
+  slot->readers++;
+  librettPlan_t* plan = slot->plan.load();
+  if (plan == nullptr || slot->handle.load() != handle) {
+    slot->readers--;
+    return ref;
+  }
+  ref.slot = slot;
+  ref.plan = plan;
+  return ref;
+}
@@ -0,0 +1,129 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2026 Librett developers
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+#ifndef LIBRETTPLANTABLE_H
+#define LIBRETTPLANTABLE_H
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include "librett.h"
+
+class librettPlan_t;
+
+//
+// Table of the plans behind librettHandles. A handle holds a slot index in its low
+// SLOT_BITS bits and the generation of the slot in the rest; the generation changes each
+// time the slot is freed, so that handles of destroyed plans do not find the plan that
+// reuses the slot. Slots are kept in segments that are never moved or freed, so find() is
+// a few atomic operations without locks. Creating and removing plans take a mutex.
+//
+class PlanTable {
+private:
+  struct Slot {
+    // Handle of the slot. Free slots hold the next handle they will be given out as
+    std::atomic<librettHandle> handle;
+    // Plan of the handle, nullptr while the handle is reserved or the slot is free
+    std::atomic<librettPlan_t*> plan;
+    // Number of find() references to the slot
+    std::atomic<int> readers;
+    // Slot has been given out by reserve(), guarded by mutex
+    bool inUse;
+  };
+
+public:
+  static const int SLOT_BITS = 22;
+  static const int SEGMENT_BITS = 12;
+  static const int SEGMENT_SIZE = 1 << SEGMENT_BITS;
+  static const int NUM_SEGMENT = 1 << (SLOT_BITS - SEGMENT_BITS);
+
+  //
+  // Reference to the plan of a handle. remove() waits for the references to a plan to be
+  // released before it returns the plan
+  //
+  class Ref {
+  public:
+    Ref() : slot(nullptr), plan(nullptr) {}
+    Ref(Ref&& ref) : slot(ref.slot), plan(ref.plan) { ref.slot = nullptr; ref.plan = nullptr; }
+    Ref& operator=(Ref&& ref) {
+      if (this != &ref) {
+        release();
+        slot = ref.slot;
+        plan = ref.plan;
+        ref.slot = nullptr;
+        ref.plan = nullptr;
+      }
+      return *this;
+    }
+    Ref(const Ref&) = delete;
+    Ref& operator=(const Ref&) = delete;
+    ~Ref() { release(); }
+
+    explicit operator bool() const { return (plan != nullptr); }
+    librettPlan_t& operator*() const { return *plan; }
+    librettPlan_t* operator->() const { return plan; }
+    librettPlan_t* get() const { return plan; }
+
+  private:
+    friend class PlanTable;
+    Slot* slot;
+    librettPlan_t* plan;
+    void release() {
+      if (slot != nullptr) slot->readers--;
+      slot = nullptr;
+      plan = nullptr;
+    }
+  };
+
+  PlanTable();
+  ~PlanTable();
+
+  // Stores plan under a new handle. Returns false if all slots are in use
+  bool insert(librettPlan_t* plan, librettHandle& handle);
+
+  // Returns a new handle without a plan. Returns false if all slots are in use
+  bool reserve(librettHandle& handle);
+
+  // Stores plan under a handle of reserve()
+  void publish(const librettHandle handle, librettPlan_t* plan);
+
+  // Frees the handle and returns its plan, nullptr for unknown handles and handles
+  // without a plan. Waits until the references of find() to the plan have been released
+  librettPlan_t* remove(const librettHandle handle);
+
+  // Reference to the plan of handle, empty for unknown and reserved handles
+  Ref find(const librettHandle handle);
+
+private:
+  std::atomic<Slot*> segments[NUM_SEGMENT];
+  // Number of slots given out so far, including the free ones
+  int numSlot;
+  // Free slots, freed first are reused first to delay the reuse of generations
+  std::deque<int> freeSlots;
+  std::mutex mutex;
+
+  Slot* getSlot(const librettHandle handle);
+  bool newSlot(int& slot);
+};
+
+#endif // LIBRETTPLANTABLE_H
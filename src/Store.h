@@ -0,0 +1,231 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2016 Antti-Pekka Hynninen
+Copyright (c) 2016 Oak Ridge National Laboratory (UT-Batelle)
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+#ifndef LIBRETTSTORE_H
+#define LIBRETTSTORE_H
+
+#include <cstdint>
+#include <cstring>
+#include "uniapi.h"
+#include "librett.h"
+
+//
+// Store stage of the transpose kernels. Every output element is written through
+// store(dataOut, pos, val), the store type is a template parameter of the kernel:
+//
+// StoreCopy    : dataOut[pos] = val
+// StoreScale   : dataOut[pos] = alpha*val
+// StoreAxpby   : dataOut[pos] = alpha*val + beta*dataOut[pos]
+// StoreConvert : dataOut[pos] = val converted to the output element type
+//
+// Only StoreAxpby reads dataOut. alpha and beta are real, complex elements are scaled
+// component-wise. Scaling is defined for float, double and librett_complex elements.
+// Store::OutType is the type of the dataOut elements.
+//
+
+__gpu_inline__ static float scaleElem(const float a, const float x) { return a*x; }
+__gpu_inline__ static double scaleElem(const double a, const double x) { return a*x; }
+__gpu_inline__ static librett_complex scaleElem(const double a, const librett_complex x) {
+#if HIP
+  return make_hipDoubleComplex(a*x.x, a*x.y);
+#elif LIBRETT_USES_CUDA
+  return make_cuDoubleComplex(a*x.x, a*x.y);
+#else
+  return a*x;
+#endif
+}
+
+__gpu_inline__ static float axpbyElem(const float a, const float x, const float b, const float y) {
+  return a*x + b*y;
+}
+__gpu_inline__ static double axpbyElem(const double a, const double x, const double b, const double y) {
+  return a*x + b*y;
+}
+__gpu_inline__ static librett_complex axpbyElem(const double a, const librett_complex x,
+  const double b, const librett_complex y) {
+#if HIP
+  return make_hipDoubleComplex(a*x.x + b*y.x, a*x.y + b*y.y);
+#elif LIBRETT_USES_CUDA
+  return make_cuDoubleComplex(a*x.x + b*y.x, a*x.y + b*y.y);
+#else
+  return a*x + b*y;
+#endif
+}
+
+// Type of alpha and beta for element type T
+template <typename T> struct StoreScalar { typedef T type; };
+template <> struct StoreScalar<librett_complex> { typedef double type; };
+
+template <typename T>
+struct StoreCopy {
+  typedef T OutType;
+  static const bool isCopy = true;
+  StoreCopy(const double, const double) {}
+  template <typename Index>
+  __gpu_inline__ void operator()(T* dataOut, const Index pos, const T val) const {
+    gpu_stGlobal(dataOut[pos], val);
+  }
+};
+
+template <typename T>
+struct StoreScale {
+  typedef T OutType;
+  static const bool isCopy = false;
+  typename StoreScalar<T>::type alpha;
+  StoreScale(const double alpha_in, const double) : alpha(alpha_in) {}
+  template <typename Index>
+  __gpu_inline__ void operator()(T* dataOut, const Index pos, const T val) const {
+    gpu_stGlobal(dataOut[pos], scaleElem(alpha, val));
+  }
+};
+
+template <typename T>
+struct StoreAxpby {
+  typedef T OutType;
+  static const bool isCopy = false;
+  typename StoreScalar<T>::type alpha;
+  typename StoreScalar<T>::type beta;
+  StoreAxpby(const double alpha_in, const double beta_in) : alpha(alpha_in), beta(beta_in) {}
+  template <typename Index>
+  __gpu_inline__ void operator()(T* dataOut, const Index pos, const T val) const {
+    gpu_stGlobal(dataOut[pos], axpbyElem(alpha, val, beta, gpu_ldGlobal(dataOut[pos])));
+  }
+};
+
+//
+// Element conversion for converting plans. Half and BFloat16 hold the bits of IEEE binary16
+// and bfloat16 numbers. Conversions go through float, narrowing rounds to nearest even
+//
+struct Half {
+  uint16_t bits;
+};
+
+struct BFloat16 {
+  uint16_t bits;
+};
+
+__gpu_inline__ static float toFloat(const float x) { return x; }
+__gpu_inline__ static float toFloat(const double x) { return (float)x; }
+__gpu_inline__ static float toFloat(const BFloat16 x) {
+  uint32_t u = (uint32_t)x.bits << 16;
+  float f;
+  memcpy(&f, &u, 4);
+  return f;
+}
+__gpu_inline__ static float toFloat(const Half x) {
+  uint32_t sign = (uint32_t)(x.bits & 0x8000) << 16;
+  uint32_t e = (x.bits >> 10) & 0x1f;
+  uint32_t m = x.bits & 0x3ff;
+  uint32_t u;
+  if (e == 0x1f) {
+    // Inf and NaN
+    u = sign | 0x7f800000 | (m << 13);
+  } else if (e != 0) {
+    u = sign | ((e + 112) << 23) | (m << 13);
+  } else if (m == 0) {
+    u = sign;
+  } else {
+    // Subnormal, normalize
+    e = 113;
+    while ((m & 0x400) == 0) {
+      m <<= 1;
+      e--;
+    }
+    u = sign | (e << 23) | ((m & 0x3ff) << 13);
+  }
+  float f;
+  memcpy(&f, &u, 4);
+  return f;
+}
+
+template <typename T> __gpu_inline__ T fromFloat(const float x);
+template <> __gpu_inline__ float fromFloat<float>(const float x) { return x; }
+template <> __gpu_inline__ double fromFloat<double>(const float x) { return (double)x; }
+template <> __gpu_inline__ BFloat16 fromFloat<BFloat16>(const float x) {
+  uint32_t u;
+  memcpy(&u, &x, 4);
+  BFloat16 r;
+  if ((u & 0x7fffffff) > 0x7f800000) {
+    // Quiet NaN
+    r.bits = (uint16_t)((u >> 16) | 0x40);
+  } else {
+    r.bits = (uint16_t)((u + 0x7fff + ((u >> 16) & 1)) >> 16);
+  }
+  return r;
+}
+template <> __gpu_inline__ Half fromFloat<Half>(const float x) {
+  uint32_t u;
+  memcpy(&u, &x, 4);
+  uint32_t sign = (u >> 16) & 0x8000;
+  uint32_t a = u & 0x7fffffff;
+  uint32_t r;
+  if (a >= 0x7f800000) {
+    // Inf and NaN
+    r = (a > 0x7f800000) ? 0x7e00 : 0x7c00;
+  } else if (a >= 0x477ff000) {
+    // Rounds above the largest half, 65504
+    r = 0x7c00;
+  } else if (a >= 0x38800000) {
+    // Normal half, rebias the exponent. A carry out of the mantissa is still correct
+    r = (a >> 13) - (112 << 10);
+    uint32_t rem = a & 0x1fff;
+    if (rem > 0x1000 || (rem == 0x1000 && (r & 1))) r++;
+  } else if (a >= 0x33000000) {
+    // Subnormal half
+    uint32_t m = (a & 0x7fffff) | 0x800000;
+    uint32_t shift = 126 - (a >> 23);
+    r = m >> shift;
+    uint32_t rem = m & ((1u << shift) - 1);
+    uint32_t halfway = 1u << (shift - 1);
+    if (rem > halfway || (rem == halfway && (r & 1))) r++;
+  } else {
+    r = 0;
+  }
+  Half h;
+  h.bits = (uint16_t)(sign | r);
+  return h;
+}
+
+template <typename TOut>
+struct StoreConvert {
+  typedef TOut OutType;
+  static const bool isCopy = false;
+  StoreConvert(const double, const double) {}
+  template <typename Index, typename TIn>
+  __gpu_inline__ void operator()(TOut* dataOut, const Index pos, const TIn val) const {
+    gpu_stGlobal(dataOut[pos], fromFloat<TOut>(toFloat(val)));
+  }
+};
+
+// Store modes selected by librettKernel()
+enum {StoreModeCopy, StoreModeScale, StoreModeAxpby, StoreModeConvert};
+
+// Returns the store mode for alpha and beta, beta = 0 never reads dataOut
+inline int storeMode(const double alpha, const double beta) {
+  if (beta != 0.0) return StoreModeAxpby;
+  if (alpha != 1.0) return StoreModeScale;
+  return StoreModeCopy;
+}
+
+#endif // LIBRETTSTORE_H
@@ -28,6 +28,85 @@ SOFTWARE.
 //
 #include "TensorTester.h"
 
+#if LIBRETT_USES_CPU
+#include <algorithm>
+#include <vector>
+#include "ThreadPool.h"
+
+//
+// Host versions of the check kernels
+//
+void setTensorCheckPatternKernel(unsigned int* data, unsigned int ndata)
+{
+  for (unsigned int i = 0; i < ndata; i++) {
+    data[i] = i;
+  }
+}
+
+//
+// Each task checks a contiguous range of positions. Ranks are visited in increasing c
+// (calcTensorConv() builds them as a mixed radix), so the reference value is stepped
+// along runs of the fastest rank instead of being recomputed for every element.
+//
+template<typename T>
+void checkTransposeKernel(T* data, unsigned int ndata, int rank, TensorConv* glTensorConv,
+  TensorError_t* glError, int* glFail)
+{
+  std::vector<TensorConv> conv(glTensorConv, glTensorConv + rank);
+  std::sort(conv.begin(), conv.end(), [](const TensorConv& a, const TensorConv& b) { return a.c < b.c; });
+
+  const unsigned int chunk = 65536;
+  const int numChunk = (int)((ndata + chunk - 1)/chunk);
+  std::vector<TensorError_t> error(numChunk);
+  std::vector<int> fail(numChunk, 0);
+
+  ThreadPool::instance().parallelFor(numChunk, [&](int ichunk) {
+    unsigned int i = ichunk*chunk;
+    unsigned int i1 = std::min(ndata, i + chunk);
+    std::vector<int> q(rank);
+    int refBase = 0;
+    for (int j=0; j < rank; j++) {
+      q[j] = (i/conv[j].c) % conv[j].d;
+      if (j > 0) refBase += q[j]*conv[j].ct;
+    }
+
+    while (i < i1) {
+      unsigned int n = std::min((unsigned int)(conv[0].d - q[0]), i1 - i);
+      int refVal = refBase + q[0]*conv[0].ct;
+      for (unsigned int k = 0; k < n; k++, refVal += conv[0].ct) {
+        int dataVal = (data[i + k] & 0xffffffff)/(sizeof(T)/4);
+        if (refVal != dataVal) {
+          error[ichunk].pos = i + k;
+          error[ichunk].refVal = refVal;
+          error[ichunk].dataVal = dataVal;
+          fail[ichunk] = 1;
+          return;
+        }
+      }
+      i += n;
+
+      q[0] = 0;
+      for (int j=1; j < rank; j++) {
+        refBase += conv[j].ct;
+        if (++q[j] < conv[j].d) break;
+        refBase -= conv[j].d*conv[j].ct;
+        q[j] = 0;
+      }
+    }
+  });
+
+  // First error has the minimum position
+  for (int ichunk=0; ichunk < numChunk; ichunk++) {
+    if (fail[ichunk]) {
+      glError[0] = error[ichunk];
+      *glFail = 1;
+      return;
+    }
+  }
+}
+
+#else // SYCL, HIP, CUDA
+
 #if SYCL
 void setTensorCheckPatternKernel(unsigned int* data, unsigned int ndata, sycl::nd_item<3>& item)
 #else
@@ -130,6 +209,7 @@ __global__ void checkTransposeKernel(T* data, unsigned int ndata, int rank, Tens
   }
 
 }
+#endif // LIBRETT_USES_CPU
 
 // ################################################################################
 // ################################################################################
@@ -173,6 +253,8 @@ void TensorTester::setTensorCheckPattern(unsigned int* data, unsigned int ndata)
                        setTensorCheckPatternKernel(data, ndata, item);
                      });
   });
+#elif LIBRETT_USES_CPU
+  setTensorCheckPatternKernel(data, ndata);
 #elif HIP
   int numblock = min(65535, (ndata - 1)/numthread + 1 );
   hipLaunchKernelGGL(setTensorCheckPatternKernel, dim3(numblock), dim3(numthread ), 0, this->tt_gpustream, data, ndata);
@@ -265,6 +347,11 @@ bool TensorTester::checkTranspose(int rank, int *dim, int *permutation, T *data)
   int h_fail;
   copy_DtoH<int>(d_fail, &h_fail, 1, this->tt_gpustream);
   this->tt_gpustream->wait_and_throw();
+#elif LIBRETT_USES_CPU
+  checkTransposeKernel(data, ndata, rank, d_tensorConv, d_error, d_fail);
+
+  int h_fail;
+  copy_DtoH<int>(d_fail, &h_fail, 1, this->tt_gpustream);
 #elif HIP
   hipLaunchKernelGGL(checkTransposeKernel, dim3(numblock), dim3(numthread), shmemsize,
 		     this->tt_gpustream, data, ndata, rank, d_tensorConv, d_error, d_fail);
@@ -0,0 +1,117 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2026 Librett developers
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+#include <algorithm>
+#include <cstdlib>
+#include "ThreadPool.h"
+
+// True on the worker threads of any pool
+static thread_local bool inWorker = false;
+
+ThreadPool::ThreadPool(const int numThread) : jobFunc(nullptr), jobSize(0), jobChunk(1),
+  jobNext(0), jobActive(0), jobGeneration(0), shutdown(false) {
+  for (int i=1;i < numThread;i++) {
+    workers.emplace_back(&ThreadPool::workerLoop, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(jobMutex);
+    shutdown = true;
+  }
+  jobCond.notify_all();
+  for (auto& worker : workers) worker.join();
+}
+
+//
+// Grabs chunks of the current job until there are none left
+//
+void ThreadPool::runJob() {
+  for (;;) {
+    int i0 = jobNext.fetch_add(jobChunk, std::memory_order_relaxed);
+    if (i0 >= jobSize) break;
+    int i1 = std::min(jobSize, i0 + jobChunk);
+    for (int i=i0;i < i1;i++) (*jobFunc)(i);
+  }
+}
+
+void ThreadPool::workerLoop() {
+  inWorker = true;
+  unsigned long long int seenGeneration = 0;
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(jobMutex);
+      jobCond.wait(lock, [&] { return shutdown || jobGeneration != seenGeneration; });
+      if (shutdown) return;
+      seenGeneration = jobGeneration;
+    }
+    runJob();
+    {
+      std::lock_guard<std::mutex> lock(jobMutex);
+      if (--jobActive == 0) doneCond.notify_one();
+    }
+  }
+}
+
+void ThreadPool::parallelFor(const int n, const std::function<void(int)>& func) {
+  if (n <= 0) return;
+  if (workers.empty() || n == 1 || inWorker) {
+    for (int i=0;i < n;i++) func(i);
+    return;
+  }
+
+  std::lock_guard<std::mutex> submitLock(submitMutex);
+  {
+    std::lock_guard<std::mutex> lock(jobMutex);
+    jobFunc = &func;
+    jobSize = n;
+    // Few chunks per thread keeps the load balanced without contending on jobNext
+    jobChunk = std::max(1, n/(8*numThread()));
+    jobNext.store(0, std::memory_order_relaxed);
+    jobActive = (int)workers.size();
+    jobGeneration++;
+  }
+  jobCond.notify_all();
+
+  runJob();
+
+  std::unique_lock<std::mutex> lock(jobMutex);
+  doneCond.wait(lock, [&] { return jobActive == 0; });
+  jobFunc = nullptr;
+}
+
+int ThreadPool::defaultNumThread() {
+  const char* env = std::getenv("LIBRETT_NUM_THREADS");
+  if (env != nullptr) {
+    int n = std::atoi(env);
+    if (n > 0) return n;
+  }
+  unsigned int n = std::thread::hardware_concurrency();
+  return (n > 0) ? (int)n : 1;
+}
+
+ThreadPool& ThreadPool::instance() {
+  static ThreadPool pool(defaultNumThread());
+  return pool;
+}
@@ -0,0 +1,83 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2026 Librett developers
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+#ifndef LIBRETTTHREADPOOL_H
+#define LIBRETTTHREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//
+// Fixed size pool of worker threads that executes parallel loops.
+// The calling thread takes part in the loop, so a pool of size one runs serially
+// without any synchronization. Loops submitted from different threads are serialized,
+// loops submitted from inside a worker run serially on that worker.
+//
+class ThreadPool {
+private:
+  std::vector<std::thread> workers;
+
+  // Serializes calls to parallelFor()
+  std::mutex submitMutex;
+
+  // Protects the job state below
+  std::mutex jobMutex;
+  std::condition_variable jobCond;
+  std::condition_variable doneCond;
+
+  // Current job
+  const std::function<void(int)>* jobFunc;
+  int jobSize;
+  int jobChunk;
+  std::atomic<int> jobNext;
+  // Number of workers that have not finished the current job
+  int jobActive;
+  // Incremented for every new job, workers wait for a change
+  unsigned long long int jobGeneration;
+  bool shutdown;
+
+  void workerLoop();
+  void runJob();
+
+public:
+  ThreadPool(const int numThread);
+  ~ThreadPool();
+
+  // Number of threads, including the calling thread
+  int numThread() const { return (int)workers.size() + 1; }
+
+  // Calls func(i) for i = 0 ... n - 1 and returns after all calls have finished
+  void parallelFor(const int n, const std::function<void(int)>& func);
+
+  // Number of threads used by default: LIBRETT_NUM_THREADS or the hardware concurrency
+  static int defaultNumThread();
+
+  // Process-wide pool with defaultNumThread() threads
+  static ThreadPool& instance();
+};
+
+#endif // LIBRETTTHREADPOOL_H
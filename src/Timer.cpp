@@ -95,6 +95,8 @@ void Timer::stop()
     #if SYCL
       // Synchronize Device
       dpct::get_current_device().queues_wait_and_throw();
+    #elif LIBRETT_USES_CPU
+      // Host kernels complete before returning
     #elif HIP
       hipCheck(hipDeviceSynchronize());
     #else // CUDA
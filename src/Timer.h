@@ -34,7 +34,10 @@ SOFTWARE.
 // -------------------------------------------------
 // By default uses GPU event timer. Comment out
 // this line if you want to use the wallclock 
+// (CPU builds have no events and always use the wallclock)
+#ifndef LIBRETT_USES_CPU
 #define GPU_EVENT_TIMER
+#endif
 // -------------------------------------------------
 #ifdef GPU_EVENT_TIMER
   #if SYCL
@@ -27,19 +27,62 @@ SOFTWARE.
 
 #define MAX_REG_STORAGE 8
 
-struct TensorConv {
-  int c;
-  int d;
-  int ct;
+//
+// Tensor conversion descriptors. Index is int for tensors with at most INT_MAX elements
+// and long long int for larger ones, see librettPlan_t::index64
+//
+template <typename Index>
+struct TensorConvT {
+  Index c;
+  Index d;
+  Index ct;
 };
 
-struct TensorConvInOut {
-  int c_in;
-  int d_in;
-  int ct_in;
-  int c_out;
-  int d_out;
-  int ct_out;
+template <typename Index>
+struct TensorConvInOutT {
+  Index c_in;
+  Index d_in;
+  Index ct_in;
+  Index c_out;
+  Index d_out;
+  Index ct_out;
+};
+
+typedef TensorConvT<int> TensorConv;
+typedef TensorConvInOutT<int> TensorConvInOut;
+typedef TensorConvInOutT<long long int> TensorConvInOut64;
+
+//
+// Descriptors as kernel arguments. Descriptors of at most N entries are passed by value
+// in inl and gl is nullptr, longer ones are read from the device buffer gl.
+// Mbar has at most DESC_INLINE entries inline, Mmk and Msh (2*sizeMmk entries for
+// PackedSplit) twice as many, which keeps the kernel parameters below 4 KB
+//
+#define DESC_INLINE 16
+
+template <typename Conv, int N>
+struct DescArg {
+  const Conv* gl;
+  Conv inl[N];
+};
+
+template <typename Index>
+using MbarArg = DescArg<TensorConvInOutT<Index>, DESC_INLINE>;
+template <typename Index>
+using MmkArg = DescArg<TensorConvInOutT<Index>, 2*DESC_INLINE>;
+typedef DescArg<TensorConv, 2*DESC_INLINE> MshArg;
+
+//
+// Batch of tensors at arbitrary addresses as a kernel argument, see
+// librettPlan_t::setupBatchPointers(). The batch rank is the slowest Mbar rank with zero
+// strides, tensor b = posMbar/volMbar is at ptr[b] (input) and ptr[count + b] (output).
+// ptr is nullptr for single tensors and evenly spaced batches
+//
+template <typename Index>
+struct BatchArg {
+  void* const* ptr;
+  Index count;
+  Index volMbar;
 };
 
 #endif // LIBRETTTYPES_H
@@ -0,0 +1,180 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2026 Librett developers
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include "Wisdom.h"
+
+const char* WISDOM_HEADER = "librett-wisdom 1";
+
+struct WisdomEntry {
+  int method;
+  int sizeMm;
+  int sizeMk;
+  int numSplit;
+  int splitRank;
+  size_t numthread[3];
+  size_t numblock[3];
+  size_t shmemsize;
+  int numRegStorage;
+};
+
+// Entries keyed by wisdomKey(), ordered so that exported files are stable
+static std::map<std::string, WisdomEntry> wisdom;
+static std::mutex wisdomMutex;
+
+std::string deviceName(const gpuDeviceProp_t& prop) {
+  std::ostringstream name;
+#if SYCL
+  name << "sycl cu " << prop.get_max_compute_units() << " wg " << prop.get_max_work_group_size()
+    << " lmem " << prop.get_local_mem_size();
+#elif LIBRETT_USES_CPU
+  name << "host threads " << prop.multiProcessorCount << " l1 " << prop.l1CacheSize
+    << " l2 " << prop.l2CacheSize << " l3 " << prop.l3CacheSize;
+#else // CUDA and HIP
+  name << prop.name;
+#endif
+  std::string str = name.str();
+  const size_t first = str.find_first_not_of(" \t\r\n");
+  if (first == std::string::npos) return "unknown";
+  return str.substr(first, str.find_last_not_of(" \t\r\n") - first + 1);
+}
+
+static WisdomEntry makeEntry(const librettPlan_t& plan) {
+  WisdomEntry entry;
+  entry.method = plan.tensorSplit.method;
+  entry.sizeMm = plan.tensorSplit.sizeMm;
+  entry.sizeMk = plan.tensorSplit.sizeMk;
+  entry.numSplit = plan.tensorSplit.numSplit;
+  entry.splitRank = plan.tensorSplit.splitRank;
+  entry.numthread[0] = plan.launchConfig.numthread_x;
+  entry.numthread[1] = plan.launchConfig.numthread_y;
+  entry.numthread[2] = plan.launchConfig.numthread_z;
+  entry.numblock[0] = plan.launchConfig.numblock_x;
+  entry.numblock[1] = plan.launchConfig.numblock_y;
+  entry.numblock[2] = plan.launchConfig.numblock_z;
+  entry.shmemsize = plan.launchConfig.shmemsize;
+  entry.numRegStorage = plan.launchConfig.numRegStorage;
+  return entry;
+}
+
+static bool operator==(const WisdomEntry& lhs, const WisdomEntry& rhs) {
+  return lhs.method == rhs.method && lhs.sizeMm == rhs.sizeMm && lhs.sizeMk == rhs.sizeMk &&
+    lhs.numSplit == rhs.numSplit && lhs.splitRank == rhs.splitRank &&
+    lhs.numthread[0] == rhs.numthread[0] && lhs.numthread[1] == rhs.numthread[1] &&
+    lhs.numthread[2] == rhs.numthread[2] && lhs.numblock[0] == rhs.numblock[0] &&
+    lhs.numblock[1] == rhs.numblock[1] && lhs.numblock[2] == rhs.numblock[2] &&
+    lhs.shmemsize == rhs.shmemsize && lhs.numRegStorage == rhs.numRegStorage;
+}
+
+// Key is the tensor part, a newline and the device name
+static std::string tensorKey(const int rank, const int* dim, const int* permutation, const size_t sizeofType) {
+  std::ostringstream key;
+  key << rank << " " << sizeofType;
+  for (int i=0;i < rank;i++) key << " " << dim[i];
+  for (int i=0;i < rank;i++) key << " " << permutation[i];
+  return key.str();
+}
+
+std::string wisdomKey(const gpuDeviceProp_t& prop, const std::vector<int>& redDim,
+  const std::vector<int>& redPermutation, const size_t sizeofType) {
+  return tensorKey(redDim.size(), redDim.data(), redPermutation.data(), sizeofType) + "\n" + deviceName(prop);
+}
+
+void wisdomRecord(const std::string& key, const librettPlan_t& plan) {
+  std::lock_guard<std::mutex> lock(wisdomMutex);
+  wisdom[key] = makeEntry(plan);
+}
+
+std::list<librettPlan_t>::iterator wisdomFind(const std::string& key, std::list<librettPlan_t>& plans) {
+  WisdomEntry entry;
+  {
+    std::lock_guard<std::mutex> lock(wisdomMutex);
+    auto it = wisdom.find(key);
+    if (it == wisdom.end()) return plans.end();
+    entry = it->second;
+  }
+  for (auto it=plans.begin();it != plans.end();it++) {
+    if (makeEntry(*it) == entry) return it;
+  }
+  return plans.end();
+}
+
+bool wisdomExport(const char* path) {
+  std::ofstream file(path);
+  if (!file) return false;
+  file << WISDOM_HEADER << "\n";
+  std::lock_guard<std::mutex> lock(wisdomMutex);
+  for (auto it=wisdom.begin();it != wisdom.end();it++) {
+    const size_t pos = it->first.find('\n');
+    const WisdomEntry& e = it->second;
+    file << it->first.substr(0, pos) << " " << e.method << " " << e.sizeMm << " " << e.sizeMk << " "
+      << e.numSplit << " " << e.splitRank << " " << e.numthread[0] << " " << e.numthread[1] << " "
+      << e.numthread[2] << " " << e.numblock[0] << " " << e.numblock[1] << " " << e.numblock[2] << " "
+      << e.shmemsize << " " << e.numRegStorage << " " << it->first.substr(pos + 1) << "\n";
+  }
+  return (bool)file;
+}
+
+bool wisdomImport(const char* path) {
+  std::ifstream file(path);
+  if (!file) return false;
+  std::string line;
+  if (!std::getline(file, line) || line != WISDOM_HEADER) return false;
+  std::map<std::string, WisdomEntry> entries;
+  while (std::getline(file, line)) {
+    if (line.empty()) continue;
+    std::istringstream str(line);
+    int rank;
+    size_t sizeofType;
+    if (!(str >> rank >> sizeofType) || rank < 1 || rank > 64) return false;
+    std::vector<int> dim(rank);
+    std::vector<int> permutation(rank);
+    for (int i=0;i < rank;i++) str >> dim[i];
+    for (int i=0;i < rank;i++) str >> permutation[i];
+    WisdomEntry e;
+    str >> e.method >> e.sizeMm >> e.sizeMk >> e.numSplit >> e.splitRank >> e.numthread[0] >> e.numthread[1]
+      >> e.numthread[2] >> e.numblock[0] >> e.numblock[1] >> e.numblock[2] >> e.shmemsize >> e.numRegStorage;
+    if (!str) return false;
+    std::string name;
+    std::getline(str >> std::ws, name);
+    if (name.empty()) return false;
+    // reduceRanks() needs a valid tensor. Files of older versions have entries on the
+    // ranks before reduceRanks()
+    std::vector<bool> seen(rank, false);
+    for (int i=0;i < rank;i++) {
+      if (dim[i] < 1 || permutation[i] < 0 || permutation[i] >= rank || seen[permutation[i]]) return false;
+      seen[permutation[i]] = true;
+    }
+    std::vector<int> redDim;
+    std::vector<int> redPermutation;
+    reduceRanks(rank, dim.data(), permutation.data(), redDim, redPermutation);
+    entries[tensorKey(redDim.size(), redDim.data(), redPermutation.data(), sizeofType) + "\n" + name] = e;
+  }
+  std::lock_guard<std::mutex> lock(wisdomMutex);
+  for (auto it=entries.begin();it != entries.end();it++) wisdom[it->first] = it->second;
+  return true;
+}
@@ -0,0 +1,66 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2026 Librett developers
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+#ifndef LIBRETTWISDOM_H
+#define LIBRETTWISDOM_H
+
+#include <list>
+#include <string>
+#include <vector>
+#include "plan.h"
+
+//
+// Wisdom: the plans chosen by librettPlanMeasure() and librettPlanOffline(), kept per
+// device name, reduced dimensions and permutation, and element size. An entry stores the TensorSplit
+// and LaunchConfig of the chosen plan. Later plans of the same tensor take the candidate
+// of createPlans() that matches the entry instead of running the performance model.
+// Entries that no longer match a candidate, e.g. after a library update, are ignored.
+//
+// The wisdom file is text, one entry per line:
+// rank sizeofType redDim[rank] redPermutation[rank] method sizeMm sizeMk numSplit splitRank
+// numthread[3] numblock[3] shmemsize numRegStorage deviceName
+//
+
+// Returns the name of the device. Backends without a name use the properties that
+// the plans depend on
+std::string deviceName(const gpuDeviceProp_t& prop);
+
+// Returns the key of a tensor on the device. The key is on the ranks of reduceRanks(), as
+// the key of the plan cache, so tensors that share a cached plan share the entry
+std::string wisdomKey(const gpuDeviceProp_t& prop, const std::vector<int>& redDim,
+  const std::vector<int>& redPermutation, const size_t sizeofType);
+
+// Stores the choice of plan under key, replacing an older entry
+void wisdomRecord(const std::string& key, const librettPlan_t& plan);
+
+// Returns the plan that matches the entry of key, or plans.end() if there is none
+std::list<librettPlan_t>::iterator wisdomFind(const std::string& key, std::list<librettPlan_t>& plans);
+
+// Writes all entries to path. Returns false if the file cannot be written
+bool wisdomExport(const char* path);
+
+// Adds the entries of path, replacing entries with the same key. Returns false if the
+// file cannot be read or is not a wisdom file
+bool wisdomImport(const char* path);
+
+#endif // LIBRETTWISDOM_H
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <unistd.h>
+#include "ThreadPool.h"
+
+namespace Librett {
+
+  // Host stand-ins for the CUDA vector types used by the launch configuration
+  struct dim3 {
+    unsigned int x, y, z;
+    dim3(unsigned int x_ = 1, unsigned int y_ = 1, unsigned int z_ = 1) : x(x_), y(y_), z(z_) {}
+  };
+
+  struct int2 {
+    int x, y;
+  };
+
+  struct int4 {
+    int x, y, z, w;
+  };
+
+  struct float4 {
+    float x, y, z, w;
+  };
+
+  // Host execution is synchronous; a stream is an opaque tag that is never dereferenced
+  using cpuStream_t = void*;
+
+  //
+  // Host device properties. Field names follow cudaDeviceProp so that the
+  // gpu* property macros in uniapi.h resolve the same way on every backend.
+  // One "multiprocessor" is one hardware thread of the pool that runs the kernels.
+  //
+  struct cpuDeviceProp {
+    int warpSize;
+    int maxThreadsPerBlock;
+    int multiProcessorCount;
+    // Clock rate in kHz
+    int clockRate;
+    int major;
+    // Per-block staging buffer limit, bytes
+    size_t sharedMemPerBlock;
+    // Cache hierarchy, bytes
+    size_t l1CacheSize;
+    size_t l2CacheSize;
+    size_t l3CacheSize;
+    int cacheLineSize;
+  };
+
+/// Util function to get number of host devices (always one)
+  static inline void cpuGetDeviceCount(int* count) {
+    *count = 1;
+  }
+
+/// Util function to get the host properties
+  static inline void cpuGetDeviceProperties(cpuDeviceProp* prop) {
+    long val;
+
+    // Plans model a 32-wide warp, the memory counters assume it
+    prop->warpSize = 32;
+    prop->maxThreadsPerBlock = 1024;
+
+    prop->multiProcessorCount = ThreadPool::instance().numThread();
+
+    // Nominal 2 GHz; only used to convert cycles into seconds
+    prop->clockRate = 2000000;
+    prop->major = 1;
+
+    prop->cacheLineSize = 64;
+    prop->l1CacheSize = 32*1024;
+    prop->l2CacheSize = 1024*1024;
+    prop->l3CacheSize = 0;
+#ifdef _SC_LEVEL1_DCACHE_LINESIZE
+    if ((val = sysconf(_SC_LEVEL1_DCACHE_LINESIZE)) > 0) prop->cacheLineSize = (int)val;
+    if ((val = sysconf(_SC_LEVEL1_DCACHE_SIZE)) > 0) prop->l1CacheSize = (size_t)val;
+    if ((val = sysconf(_SC_LEVEL2_CACHE_SIZE)) > 0) prop->l2CacheSize = (size_t)val;
+    if ((val = sysconf(_SC_LEVEL3_CACHE_SIZE)) > 0) prop->l3CacheSize = (size_t)val;
+#endif
+    (void)val;
+
+    // Packed staging buffer must stay resident in L2 together with the streamed lines
+    prop->sharedMemPerBlock = prop->l2CacheSize/2;
+  }
+
+} // namespace Librett
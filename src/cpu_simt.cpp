@@ -0,0 +1,417 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2026 Librett developers
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "cpu_simt.hpp"
+
+#if defined(__x86_64__) && defined(__linux__)
+  #define SIMT_ASM_SWITCH 1
+#else
+  #include <ucontext.h>
+#endif
+
+namespace Librett {
+namespace simt {
+
+thread_local Current current;
+
+// Stack of one device thread. Kernels only keep a few registers worth of locals
+const size_t FIBER_STACK_SIZE = 128*1024;
+
+//
+// Execution context of a fiber. On x86-64 Linux a context is just the saved stack pointer
+// and switching saves the callee-saved registers, swapcontext() would also make a system
+// call to save the signal mask on every warp operation.
+//
+#if SIMT_ASM_SWITCH
+struct Context {
+  void* sp;
+};
+
+// Saves the callee-saved registers on the current stack, stores the stack pointer in
+// *saveSp and continues on the stack newSp
+extern "C" void librettSimtSwitch(void** saveSp, void* newSp);
+asm(R"(
+  .text
+  .p2align 4
+  .type librettSimtSwitch, @function
+librettSimtSwitch:
+  pushq %rbp
+  pushq %rbx
+  pushq %r12
+  pushq %r13
+  pushq %r14
+  pushq %r15
+  movq %rsp, (%rdi)
+  movq %rsi, %rsp
+  popq %r15
+  popq %r14
+  popq %r13
+  popq %r12
+  popq %rbx
+  popq %rbp
+  ret
+  .size librettSimtSwitch, .-librettSimtSwitch
+)");
+
+static inline void switchContext(Context& from, Context& to) {
+  librettSimtSwitch(&from.sp, to.sp);
+}
+
+// Starts entry() on the given stack the first time the context is switched to.
+// entry() must never return
+static void makeContext(Context& c, char* stack, const size_t size, void (*entry)(), Context* link) {
+  void** top = (void **)(((uintptr_t)(stack + size)) & ~(uintptr_t)15);
+  // Fake return address of entry(), keeps the stack aligned as after a call
+  *(--top) = nullptr;
+  *(--top) = (void *)entry;
+  // rbp, rbx, r12 - r15
+  for (int i=0;i < 6;i++) *(--top) = nullptr;
+  c.sp = top;
+}
+#else
+struct Context {
+  ucontext_t uc;
+};
+
+static inline void switchContext(Context& from, Context& to) {
+  swapcontext(&from.uc, &to.uc);
+}
+
+static void makeContext(Context& c, char* stack, const size_t size, void (*entry)(), Context* link) {
+  getcontext(&c.uc);
+  c.uc.uc_stack.ss_sp = stack;
+  c.uc.uc_stack.ss_size = size;
+  c.uc.uc_link = &link->uc;
+  makecontext(&c.uc, entry, 0);
+}
+#endif
+
+enum FiberState {Ready, Running, WaitWarp, WaitBlock, Done};
+
+enum WarpOp {Shuffle, Ballot};
+
+struct Fiber {
+  Context ctx;
+  std::unique_ptr<char[]> stack;
+  dim3 threadIdx;
+  int warp;
+  int lane;
+  FiberState state;
+  unsigned int waitGen;
+};
+
+struct Warp {
+  // Number of completed warp operations
+  unsigned int gen;
+  int arrived;
+  int numLive;
+  unsigned int liveMask;
+  // Exchange slots and the lanes that took part, double buffered on the parity of gen:
+  // operation gen + 2 cannot start before every lane has read the result of operation gen
+  uint64_t slot[2][warpSize];
+  unsigned int activeMask[2];
+};
+
+//
+// Runs the blocks assigned to one OS thread
+//
+struct Scheduler {
+  Context ctx;
+  std::vector<Fiber> fibers;
+  std::vector<Warp> warps;
+  Fiber* running;
+  const std::function<void()>* body;
+
+  // Block-wide barrier
+  unsigned int blockGen;
+  int blockArrived;
+  int blockNumLive;
+
+  std::unique_ptr<char[]> sharedArena;
+  size_t sharedArenaSize;
+
+  Stats stats;
+
+  Scheduler() : running(nullptr), body(nullptr), blockGen(0), blockArrived(0), blockNumLive(0),
+    sharedArenaSize(0) {
+    memset(&stats, 0, sizeof(stats));
+  }
+
+  void runBlock(const dim3 blockIdx);
+  void yield(Fiber& f);
+  void completeWarp(Warp& w, const WarpOp op);
+  void completeBlock();
+  bool runnable(const Fiber& f) const;
+};
+
+static thread_local std::unique_ptr<Scheduler> scheduler;
+
+static std::mutex statsMutex;
+static Stats globalStats = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+static void addStats(Stats& dst, const Stats& src) {
+  dst.launches    += src.launches;
+  dst.blocks      += src.blocks;
+  dst.threads     += src.threads;
+  dst.syncthreads += src.syncthreads;
+  dst.shuffles    += src.shuffles;
+  dst.ballots     += src.ballots;
+  dst.atomics     += src.atomics;
+  dst.globalLoads  += src.globalLoads;
+  dst.globalStores += src.globalStores;
+  dst.sharedLoads  += src.sharedLoads;
+  dst.sharedStores += src.sharedStores;
+}
+
+Stats getStats() {
+  std::lock_guard<std::mutex> lock(statsMutex);
+  return globalStats;
+}
+
+void resetStats() {
+  std::lock_guard<std::mutex> lock(statsMutex);
+  memset(&globalStats, 0, sizeof(globalStats));
+}
+
+void Scheduler::yield(Fiber& f) {
+  switchContext(f.ctx, ctx);
+}
+
+void Scheduler::completeWarp(Warp& w, const WarpOp op) {
+  w.activeMask[w.gen & 1] = w.liveMask;
+  w.gen++;
+  w.arrived = 0;
+  if (op == Shuffle) {
+    stats.shuffles++;
+  } else {
+    stats.ballots++;
+  }
+}
+
+void Scheduler::completeBlock() {
+  blockGen++;
+  blockArrived = 0;
+  stats.syncthreads++;
+}
+
+bool Scheduler::runnable(const Fiber& f) const {
+  switch(f.state) {
+    case Ready:
+    return true;
+    case WaitWarp:
+    return (warps[f.warp].gen != f.waitGen);
+    case WaitBlock:
+    return (blockGen != f.waitGen);
+    default:
+    return false;
+  }
+}
+
+//
+// Stores v for the calling lane and waits for the other lanes of the warp.
+// Returns the parity of the completed operation
+//
+static int exchange(const uint64_t v, const WarpOp op, Warp*& wp) {
+  Scheduler& s = *scheduler;
+  Fiber& f = *s.running;
+  Warp& w = s.warps[f.warp];
+  const unsigned int gen = w.gen;
+  w.slot[gen & 1][f.lane] = v;
+  if (++w.arrived == w.numLive) {
+    s.completeWarp(w, op);
+  } else {
+    f.state = WaitWarp;
+    f.waitGen = gen;
+    s.yield(f);
+  }
+  wp = &w;
+  return gen & 1;
+}
+
+const uint64_t* warpExchange(const uint64_t v) {
+  Warp* w;
+  const int parity = exchange(v, Shuffle, w);
+  return w->slot[parity];
+}
+
+unsigned int ballot(const int pred) {
+  Warp* w;
+  const int parity = exchange(pred != 0, Ballot, w);
+  unsigned int res = 0;
+  for (int i=0;i < warpSize;i++) res |= (unsigned int)(w->slot[parity][i] != 0) << i;
+  return res & w->activeMask[parity];
+}
+
+void syncthreads() {
+  Scheduler& s = *scheduler;
+  Fiber& f = *s.running;
+  const unsigned int gen = s.blockGen;
+  if (++s.blockArrived == s.blockNumLive) {
+    s.completeBlock();
+  } else {
+    f.state = WaitBlock;
+    f.waitGen = gen;
+    s.yield(f);
+  }
+}
+
+void countAtomic() {
+  scheduler->stats.atomics++;
+}
+
+//
+// Entry point of every fiber. Exited threads no longer take part in warp operations
+// and barriers, the last one to exit may complete an operation the others wait on.
+// Their exchange slots are left alone, the remaining lanes may still be reading them.
+//
+static void fiberMain() {
+  Scheduler& s = *scheduler;
+  (*s.body)();
+
+  Fiber& f = *s.running;
+  f.state = Done;
+  Warp& w = s.warps[f.warp];
+  w.liveMask &= ~(1u << f.lane);
+  w.numLive--;
+  if (w.arrived > 0 && w.arrived == w.numLive) s.completeWarp(w, Shuffle);
+  s.blockNumLive--;
+  if (s.blockArrived > 0 && s.blockArrived == s.blockNumLive) s.completeBlock();
+#if SIMT_ASM_SWITCH
+  // Never resumed again, the next block re-initializes the context
+  switchContext(f.ctx, s.ctx);
+#endif
+  // Returning resumes the scheduler through uc_link
+}
+
+void Scheduler::runBlock(const dim3 blockIdx) {
+  current.blockIdx = blockIdx;
+  const dim3 blockDim = current.blockDim;
+  const int numThread = blockDim.x*blockDim.y*blockDim.z;
+  const int numWarp = (numThread + warpSize - 1)/warpSize;
+
+  if ((int)fibers.size() < numThread) {
+    size_t n = fibers.size();
+    fibers.resize(numThread);
+    for (;n < fibers.size();n++) fibers[n].stack.reset(new char[FIBER_STACK_SIZE]);
+  }
+
+  warps.resize(numWarp);
+  for (int i=0;i < numWarp;i++) {
+    warps[i].gen = 0;
+    warps[i].arrived = 0;
+    warps[i].numLive = std::min(warpSize, numThread - i*warpSize);
+    warps[i].liveMask = (warps[i].numLive == warpSize) ? 0xffffffff : (1u << warps[i].numLive) - 1;
+    memset(warps[i].slot, 0, sizeof(warps[i].slot));
+  }
+  blockGen = 0;
+  blockArrived = 0;
+  blockNumLive = numThread;
+
+  for (int i=0;i < numThread;i++) {
+    Fiber& f = fibers[i];
+    f.threadIdx = dim3(i % blockDim.x, (i / blockDim.x) % blockDim.y, i / (blockDim.x*blockDim.y));
+    f.warp = i / warpSize;
+    f.lane = i % warpSize;
+    f.state = Ready;
+    makeContext(f.ctx, f.stack.get(), FIBER_STACK_SIZE, fiberMain, &ctx);
+  }
+
+  // Run one warp at a time until all of its lanes have exited or wait at syncthreads()
+  while (blockNumLive > 0) {
+    bool progress = false;
+    for (int w=0;w < numWarp;w++) {
+      const int i0 = w*warpSize;
+      const int i1 = std::min(numThread, i0 + warpSize);
+      bool resumed;
+      do {
+        resumed = false;
+        for (int i=i0;i < i1;i++) {
+          Fiber& f = fibers[i];
+          if (!runnable(f)) continue;
+          f.state = Running;
+          running = &f;
+          current.threadIdx = f.threadIdx;
+          switchContext(ctx, f.ctx);
+          resumed = true;
+        }
+        progress |= resumed;
+      } while (resumed);
+    }
+    if (!progress) {
+      printf("simt: deadlock in block (%u, %u, %u), warp operation or syncthreads() in divergent code\n",
+        blockIdx.x, blockIdx.y, blockIdx.z);
+      exit(1);
+    }
+  }
+  running = nullptr;
+
+  stats.blocks++;
+  stats.threads += numThread;
+}
+
+void launchBlocks(const dim3 numblock, const dim3 numthread, const size_t shmemsize,
+  const std::function<void()>& body) {
+
+  const int numThread = numthread.x*numthread.y*numthread.z;
+  if (numThread > 1024) {
+    printf("simt: block of %d threads exceeds the limit of 1024\n", numThread);
+    exit(1);
+  }
+  const int numBlock = numblock.x*numblock.y*numblock.z;
+
+  Stats launchStats;
+  memset(&launchStats, 0, sizeof(launchStats));
+  launchStats.launches = 1;
+  std::mutex launchMutex;
+
+  ThreadPool::instance().parallelFor(numBlock, [&](int b) {
+    if (scheduler == nullptr) scheduler.reset(new Scheduler());
+    Scheduler& s = *scheduler;
+    if (s.sharedArenaSize < shmemsize) {
+      s.sharedArena.reset(new char[shmemsize]);
+      s.sharedArenaSize = shmemsize;
+    }
+    current.blockDim = numthread;
+    current.gridDim = numblock;
+    current.dynamicShared = s.sharedArena.get();
+    current.stats = &s.stats;
+    s.body = &body;
+    memset(&s.stats, 0, sizeof(s.stats));
+    s.runBlock(dim3(b % numblock.x, (b / numblock.x) % numblock.y, b / (numblock.x*numblock.y)));
+    s.body = nullptr;
+    std::lock_guard<std::mutex> lock(launchMutex);
+    addStats(launchStats, s.stats);
+  });
+
+  std::lock_guard<std::mutex> lock(statsMutex);
+  addStats(globalStats, launchStats);
+}
+
+} // namespace simt
+} // namespace Librett
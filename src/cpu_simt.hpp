@@ -0,0 +1,175 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include "cpu_device.hpp"
+
+//
+// SIMT emulation of the device execution model on host threads.
+//
+// Every block of a launch is a pool task. Inside a block each device thread is a fiber,
+// fibers of one warp run in lockstep between warp-wide operations (shuffle, ballot) and
+// all warps meet at syncthreads(). Static __shared__ variables are thread_local, i.e.
+// private to the OS thread that runs the block, and dynamic shared memory is a per-thread
+// arena of lc.shmemsize bytes. This lets the device kernels in kernel.cpp and
+// GpuModelKernel.cpp run unchanged on machines without a GPU.
+//
+namespace Librett {
+namespace simt {
+
+  constexpr int warpSize = 32;
+
+  //
+  // Execution counters, summed over all launches since the last resetStats().
+  // Warp-wide operations and barriers are counted once per warp and per block,
+  // like the warp-level instruction counts reported by a GPU profiler. Memory
+  // accesses are counted per thread, through the gpu_ld and gpu_st accessors of uniapi.h.
+  //
+  struct Stats {
+    unsigned long long int launches;
+    unsigned long long int blocks;
+    unsigned long long int threads;
+    unsigned long long int syncthreads;
+    unsigned long long int shuffles;
+    unsigned long long int ballots;
+    unsigned long long int atomics;
+    unsigned long long int globalLoads;
+    unsigned long long int globalStores;
+    unsigned long long int sharedLoads;
+    unsigned long long int sharedStores;
+  };
+
+  // Thread and block indices of the fiber that is currently running on this OS thread,
+  // and the counters of its block
+  struct Current {
+    dim3 threadIdx;
+    dim3 blockIdx;
+    dim3 blockDim;
+    dim3 gridDim;
+    char* dynamicShared;
+    Stats* stats;
+  };
+  extern thread_local Current current;
+
+  Stats getStats();
+  void resetStats();
+
+  // Stores v for the calling lane, waits for the other lanes of the warp and
+  // returns the values of all lanes
+  const uint64_t* warpExchange(const uint64_t v);
+
+  // Bit mask of the lanes that have pred != 0
+  unsigned int ballot(const int pred);
+
+  // Block-wide barrier
+  void syncthreads();
+
+  void countAtomic();
+
+  // Linear thread index within the block divided into warps
+  inline int laneId() {
+    return (current.threadIdx.x + (current.threadIdx.y + current.threadIdx.z*current.blockDim.y)*current.blockDim.x) & (warpSize - 1);
+  }
+
+  inline char* dynamicShared() {
+    return current.dynamicShared;
+  }
+
+  enum MemAccess {GlobalLoad, GlobalStore, SharedLoad, SharedStore};
+
+  template <MemAccess access> inline void countAccess() {
+    Stats& stats = *current.stats;
+    switch(access) {
+      case GlobalLoad:  stats.globalLoads++;  break;
+      case GlobalStore: stats.globalStores++; break;
+      case SharedLoad:  stats.sharedLoads++;  break;
+      case SharedStore: stats.sharedStores++; break;
+    }
+  }
+
+  // Memory accessors of the kernels, see gpu_ldGlobal() and friends in uniapi.h
+  template <MemAccess access, typename T> inline const T& load(const T& x) {
+    countAccess<access>();
+    return x;
+  }
+
+  template <MemAccess access, typename T, typename V> inline void store(T& x, const V& v) {
+    countAccess<access>();
+    x = v;
+  }
+
+  template <typename T> inline T shuffle(const T var, const int srcLane) {
+    static_assert(sizeof(T) <= sizeof(uint64_t), "shuffle supports types of at most 8 bytes");
+    uint64_t v = 0;
+    memcpy(&v, &var, sizeof(T));
+    const uint64_t* lanes = warpExchange(v);
+    T res;
+    memcpy(&res, &lanes[srcLane], sizeof(T));
+    return res;
+  }
+
+  // Runs body() on every thread of every block. Returns when all blocks have finished
+  void launchBlocks(const dim3 numblock, const dim3 numthread, const size_t shmemsize,
+    const std::function<void()>& body);
+
+  //
+  // Host counterpart of kernel<<< numblock, numthread, shmemsize >>>(args...)
+  //
+  template <typename... Params, typename... Args>
+  void launch(const dim3 numblock, const dim3 numthread, const size_t shmemsize,
+    void (*kernel)(Params...), Args&&... args) {
+    std::tuple<typename std::decay<Params>::type...> params(std::forward<Args>(args)...);
+    launchBlocks(numblock, numthread, shmemsize, [&]() { std::apply(kernel, params); });
+  }
+
+} // namespace simt
+} // namespace Librett
+
+// Device intrinsics. Only full-warp masks are supported, which is all the kernels use.
+
+using Librett::simt::warpSize;
+
+template <typename T> inline T __shfl_sync(const unsigned int mask, const T var, const int srcLane,
+  const int width=warpSize) {
+  const int lane = Librett::simt::laneId();
+  return Librett::simt::shuffle(var, (lane & ~(width - 1)) + (srcLane & (width - 1)));
+}
+
+template <typename T> inline T __shfl_xor_sync(const unsigned int mask, const T var, const int laneMask,
+  const int width=warpSize) {
+  const int lane = Librett::simt::laneId();
+  const int src = lane ^ laneMask;
+  return Librett::simt::shuffle(var, ((src ^ lane) < width) ? src : lane);
+}
+
+template <typename T> inline T __shfl_down_sync(const unsigned int mask, const T var, const unsigned int delta,
+  const int width=warpSize) {
+  const int lane = Librett::simt::laneId();
+  const int src = lane + (int)delta;
+  return Librett::simt::shuffle(var, ((src & ~(width - 1)) == (lane & ~(width - 1))) ? src : lane);
+}
+
+inline unsigned int __ballot_sync(const unsigned int mask, const int pred) {
+  return Librett::simt::ballot(pred) & mask;
+}
+
+inline int __any_sync(const unsigned int mask, const int pred) {
+  return (Librett::simt::ballot(pred) & mask) != 0;
+}
+
+inline int __popc(const unsigned int x) {
+  return __builtin_popcount(x);
+}
+
+inline int __ffs(const int x) {
+  return __builtin_ffs(x);
+}
+
+inline int atomicAdd(int* address, const int val) {
+  Librett::simt::countAtomic();
+  return __atomic_fetch_add(address, val, __ATOMIC_RELAXED);
+}
@@ -27,9 +27,16 @@ All rights reserved.
 *******************************************************************************/
 
 #include "GpuUtils.h"
+#include "GpuMem.hpp"
 #include "LRUCache.h"
 #include "kernel.h"
+#include "Store.h"
+#include <algorithm>
+#include <climits>
+#include <cstdint>
 #include <iostream>
+#include <map>
+#include <vector>
 #include "unistd.h"
 
 #define RESTRICT __restrict__
@@ -39,16 +46,100 @@ All rights reserved.
 #  pragma clang diagnostic ignored "-Wpass-failed"
 #endif
 
+//
+// All kernels are templated on Index, the type of global memory positions:
+// int, or long long int for plans with librettPlan_t::index64 set, and on Store,
+// the store stage of Store.h that writes the output elements.
+//
+
+//
+// Entry i of a descriptor passed as a kernel argument, see DescArg in Types.h
+//
+template <typename Conv, int N>
+__gpu_inline__ Conv loadDesc(const DescArg<Conv, N>& arg, const int i) {
+  return (arg.gl != nullptr) ? gpu_ldGlobal(arg.gl[i]) : arg.inl[i];
+}
+
+//
+// Tensor of Mbar position posMbar: data, or entry i = 0 (input), 1 (output) of the
+// pointer table of a batch, see BatchArg in Types.h
+//
+template <typename T, typename Index>
+__gpu_inline__ T* batchTensor(T* data, const BatchArg<Index>& batch, const Index posMbar, const int i) {
+  return (batch.ptr == nullptr) ? data : (T *)gpu_ldGlobal(batch.ptr[i*batch.count + posMbar/batch.volMbar]);
+}
+
+//
+// Elements of 1 and 2 bytes are moved as packed 4 byte words (char4, short2) along runs
+// that are contiguous in global memory and start at a word boundary. librettKernel()
+// checks the alignment of the launch and passes wordIn / wordOut to the kernels
+//
+template <typename T>
+constexpr int wordVol() {
+  return (sizeof(T) < 4) ? (int)(4/sizeof(T)) : 1;
+}
+
+template <typename T>
+struct alignas(sizeof(T)*wordVol<T>()) PackedWord {
+  T e[wordVol<T>()];
+};
+
+//
+// Copies the n <= wordVol<T>() elements at data[pos] to sh[0], sh[shStride], ...
+// A whole word is a single global access
+//
+template <typename T, typename Index>
+__gpu_inline__ void loadWord(const T* RESTRICT data, const Index pos, const int n, T* sh, const int shStride) {
+  if (n == wordVol<T>()) {
+    const PackedWord<T> word = gpu_ldGlobal(*(const PackedWord<T> *)(data + pos));
+#pragma unroll
+    for (int k=0; k < wordVol<T>(); k++) gpu_stShared(sh[k*shStride], word.e[k]);
+  } else {
+    for (int k=0; k < n; k++) gpu_stShared(sh[k*shStride], gpu_ldGlobal(data[pos + k]));
+  }
+}
+
+//
+// Copies sh[0], sh[shStride], ... to the n <= wordVol<T>() elements at data[pos]
+//
+template <typename T, typename Index>
+__gpu_inline__ void storeWord(T* RESTRICT data, const Index pos, const int n, const T* sh, const int shStride) {
+  if (n == wordVol<T>()) {
+    PackedWord<T> word;
+#pragma unroll
+    for (int k=0; k < wordVol<T>(); k++) word.e[k] = gpu_ldShared(sh[k*shStride]);
+    gpu_stGlobal(*(PackedWord<T> *)(data + pos), word);
+  } else {
+    for (int k=0; k < n; k++) gpu_stGlobal(data[pos + k], gpu_ldShared(sh[k*shStride]));
+  }
+}
+
+//
+// Mmk or Msh descriptor that counts words of V elements instead of elements. lead is the
+// contiguous rank of the words, the position of a word is that of its first element
+//
+template <typename Int>
+__gpu_inline__ void wordConv(const int V, const bool lead, Int& c, Int& d, Int& ct) {
+  if (lead) {
+    d /= V;
+    ct *= V;
+  } else {
+    c /= V;
+  }
+}
+
 //
 // Transpose when Mm and Mk don't overlap and contain only single rank
 //
 //  dim3 numthread(TILEDIM, TILEROWS, 1);
 //  dim3 numblock( ((plan.volMm-1)/TILEDIM+1)*((plan.volMk-1)/TILEDIM+1), 1, plan.volMbar);
 //
-template <typename T>
-__global__ void transposeTiled(const int numMm, const int volMbar, const int sizeMbar,
-  const int2_t tiledVol, const int cuDimMk, const int cuDimMm,
-  const TensorConvInOut* RESTRICT glMbar, const T* RESTRICT dataIn, T* RESTRICT dataOut
+template <typename T, typename Index, typename Store = StoreCopy<T>>
+__global__ void transposeTiled(const int numMm, const Index volMbar, const int sizeMbar,
+  const int2_t tiledVol, const Index cuDimMk, const Index cuDimMm,
+  const MbarArg<Index> glMbar, const BatchArg<Index> batch, const bool wordIn, const bool wordOut,
+  const T* RESTRICT dataIn,
+  typename Store::OutType* RESTRICT dataOut, const Store store
 #if SYCL
   , sycl::nd_item<3>& item
 #endif
@@ -58,24 +149,24 @@ __global__ void transposeTiled(const int numMm, const int volMbar, const int siz
 #if SYCL
   sycl::group wrk_grp = item.get_group();
   sycl::sub_group sg = item.get_sub_group();
-  using tile_t = T[TILEDIM][TILEDIM+1];
+  using tile_t = T[TILEDIM][TILEDIM+tilePad(sizeof(T))];
   tile_t& shTile = *sycl::ext::oneapi::group_local_memory_for_overwrite<tile_t>(wrk_grp);
   const int warpSize = sg.get_local_range().get(0);
 #elif HIP
   __shared__ T shTile[TILEDIM][TILEDIM];
 #else // CUDA
-  __shared__ T shTile[TILEDIM][TILEDIM+1];
+  __shared__ T shTile[TILEDIM][TILEDIM+tilePad(sizeof(T))];
 #endif
 
   const int warpLane = threadIdx_x & (warpSize - 1);
 
-  TensorConvInOut Mbar;
+  TensorConvInOutT<Index> Mbar;
   Mbar.c_in = 1;
   Mbar.d_in = 1;
   Mbar.c_out = 1;
   Mbar.d_out = 1;
   if (warpLane < sizeMbar) {
-    Mbar = glMbar[warpLane];
+    Mbar = loadDesc(glMbar, warpLane);
   }
 
   const int bx = (blockIdx_x % numMm)*TILEDIM;
@@ -102,34 +193,53 @@ __global__ void transposeTiled(const int numMm, const int volMbar, const int siz
   const unsigned int one = 1;
 #endif
 
-  const int posMinorIn = xin + yin*cuDimMk;
-  const int posMinorOut = yout + xout*cuDimMm;
-  const int posInAdd = TILEROWS*cuDimMk;
-  const int posOutAdd = TILEROWS*cuDimMm;
+  const Index posMinorIn = xin + yin*cuDimMk;
+  const Index posMinorOut = yout + xout*cuDimMm;
+  const Index posInAdd = TILEROWS*cuDimMk;
+  const Index posOutAdd = TILEROWS*cuDimMm;
+
+  // Packed words: the block reads TILEROWS*V rows of the tile at a time, each thread one
+  // word of a row. Writes run the same way along the output rows, the tile columns
+  constexpr int V = wordVol<T>();
+  const bool wordRead = (V > 1) && wordIn;
+  const bool wordWrite = (V > 1) && Store::isCopy && wordOut;
+  const int wordThread = threadIdx_x + threadIdx_y*TILEDIM;
+  const int wordPos = (wordThread % (TILEDIM/V))*V;
+  const int wordRow = wordThread / (TILEDIM/V);
+  const int shRow = (int)(sizeof(shTile[0])/sizeof(T));
+#if SYCL
+  const int volX = tiledVol.x();
+  const int volY = tiledVol.y();
+#else
+  const int volX = tiledVol.x;
+  const int volY = tiledVol.y;
+#endif
 
-  for (int posMbar=blockIdx_z; posMbar < volMbar; posMbar += gridDim_z)
+  for (Index posMbar=blockIdx_z; posMbar < volMbar; posMbar += gridDim_z)
   {
+    const T* RESTRICT in = batchTensor(dataIn, batch, posMbar, 0);
+    typename Store::OutType* RESTRICT out = batchTensor(dataOut, batch, posMbar, 1);
     // Compute global memory positions
-    int posMajorIn = ((posMbar/Mbar.c_in) % Mbar.d_in)*Mbar.ct_in;
-    int posMajorOut = ((posMbar/Mbar.c_out) % Mbar.d_out)*Mbar.ct_out;
+    Index posMajorIn = ((posMbar/Mbar.c_in) % Mbar.d_in)*Mbar.ct_in;
+    Index posMajorOut = ((posMbar/Mbar.c_out) % Mbar.d_out)*Mbar.ct_out;
 #if SYCL
-    posMajorIn  = sycl::reduce_over_group(sg, posMajorIn,  sycl::plus<int>());
-    posMajorOut = sycl::reduce_over_group(sg, posMajorOut, sycl::plus<int>());
+    posMajorIn  = sycl::reduce_over_group(sg, posMajorIn,  sycl::plus<Index>());
+    posMajorOut = sycl::reduce_over_group(sg, posMajorOut, sycl::plus<Index>());
 #else // FOR CUDA, HIP only
     #pragma unroll
     for (int i=warpSize/2; i >= 1; i/=2) {  // AMD change
       #if HIP
         posMajorIn += __shfl_xor(posMajorIn,i);
         posMajorOut += __shfl_xor(posMajorOut,i);
-      #elif CUDA
+      #else // CUDA
         posMajorIn += __shfl_xor_sync(0xffffffff,posMajorIn,i);
         posMajorOut += __shfl_xor_sync(0xffffffff,posMajorOut,i);
       #endif
     }
 #endif // SYCL
 
-    int posIn = posMajorIn + posMinorIn;
-    int posOut = posMajorOut + posMinorOut;
+    Index posIn = posMajorIn + posMinorIn;
+    Index posOut = posMajorOut + posMinorOut;
 
     // Read from global memory
     #if SYCL
@@ -139,14 +249,23 @@ __global__ void transposeTiled(const int numMm, const int volMbar, const int siz
     #endif
 
     // Read data into shared memory tile
+    if (wordRead) {
+      for (int y=wordRow; y < TILEDIM; y += TILEROWS*V) {
+        if (by + y < volY && bx + wordPos < volX) {
+          loadWord(in, posMajorIn + bx + wordPos + (by + y)*cuDimMk, min(V, volX - bx - wordPos),
+            &shTile[y][wordPos], 1);
+        }
+      }
+    } else {
 #pragma unroll
-    for (int j=0; j < TILEDIM; j += TILEROWS) {
-      // int pos = posIn + j*cuDimMk;
-      // if (xin < readVol.x && yin + j < readVol.y) {
-      if ((maskIny & (one << j)) != 0) {   // AMD change
-        shTile[threadIdx_y + j][threadIdx_x] = dataIn[posIn];
+      for (int j=0; j < TILEDIM; j += TILEROWS) {
+        // int pos = posIn + j*cuDimMk;
+        // if (xin < readVol.x && yin + j < readVol.y) {
+        if ((maskIny & (one << j)) != 0) {   // AMD change
+          gpu_stShared(shTile[threadIdx_y + j][threadIdx_x], gpu_ldGlobal(in[posIn]));
+        }
+        posIn += posInAdd;
       }
-      posIn += posInAdd;
     }
 
     // Write to global memory
@@ -156,14 +275,23 @@ __global__ void transposeTiled(const int numMm, const int volMbar, const int siz
     syncthreads();
     #endif
 
+    if (wordWrite) {
+      for (int x=wordRow; x < TILEDIM; x += TILEROWS*V) {
+        if (bx + x < volX && by + wordPos < volY) {
+          storeWord((T *)out, posMajorOut + by + wordPos + (bx + x)*cuDimMm, min(V, volY - by - wordPos),
+            &shTile[wordPos][x], shRow);
+        }
+      }
+    } else {
 #pragma unroll
-    for (int j=0; j < TILEDIM; j += TILEROWS) {
-      // int pos = posOut + j*cuDimMm;
-      // if (xout + j < readVol.x && yout < readVol.y) {
-      if ((maskOutx & (one << j)) != 0 ) {   // AMD change
-        dataOut[posOut] = shTile[threadIdx_x][threadIdx_y + j];
+      for (int j=0; j < TILEDIM; j += TILEROWS) {
+        // int pos = posOut + j*cuDimMm;
+        // if (xout + j < readVol.x && yout < readVol.y) {
+        if ((maskOutx & (one << j)) != 0 ) {   // AMD change
+          store(out, posOut, gpu_ldShared(shTile[threadIdx_x][threadIdx_y + j]));
+        }
+        posOut += posOutAdd;
       }
-      posOut += posOutAdd;
     }
 
   }
@@ -173,14 +301,15 @@ __global__ void transposeTiled(const int numMm, const int volMbar, const int siz
 //
 // Packed transpose. Thread block loads plan.volMmk number of elements
 //
-template <typename T, int numRegStorage>
+template <typename T, int numRegStorage, typename Index, typename Store = StoreCopy<T>>
 __global__ void transposePacked(
-  const int volMmk, const int volMbar,
+  const int volMmk, const Index volMbar,
   const int sizeMmk, const int sizeMbar,
-  const TensorConvInOut* RESTRICT gl_Mmk,
-  const TensorConvInOut* RESTRICT gl_Mbar,
-  const TensorConv* RESTRICT gl_Msh,
-  const T* RESTRICT dataIn, T* RESTRICT dataOut
+  const MmkArg<Index> gl_Mmk,
+  const MbarArg<Index> gl_Mbar,
+  const MshArg gl_Msh,
+  const BatchArg<Index> batch, const bool wordIn, const bool wordOut,
+  const T* RESTRICT dataIn, typename Store::OutType* RESTRICT dataOut, const Store store
   #if SYCL
   , sycl::nd_item<3> item, uint8_t *dpct_local
   #endif
@@ -194,6 +323,8 @@ __global__ void transposePacked(
   const int warpSize = sg.get_local_range().get(0);
 #elif HIP
   HIP_DYNAMIC_SHARED( char, shBuffer_char)
+#elif LIBRETT_USES_CPU
+  char* shBuffer_char = Librett::simt::dynamicShared();
 #else // CUDA
   extern __shared__ char shBuffer_char[];
 #endif
@@ -201,25 +332,48 @@ __global__ void transposePacked(
 
   const int warpLane = threadIdx_x & (warpSize - 1);
 
-  TensorConvInOut Mmk;
+  TensorConvInOutT<Index> Mmk;
   Mmk.c_in = 1;
   Mmk.d_in = 1;
   Mmk.c_out = 1;
   Mmk.d_out = 1;
   if (warpLane < sizeMmk) {
-    Mmk = gl_Mmk[warpLane];
+    Mmk = loadDesc(gl_Mmk, warpLane);
   }
   TensorConv Msh;
   Msh.c = 1;
   Msh.d = 1;
   if (warpLane < sizeMmk) {
-    Msh = gl_Msh[warpLane];
+    Msh = loadDesc(gl_Msh, warpLane);
+  }
+
+  // Packed words: positions are precomputed for words of V elements instead of elements,
+  // see wordConv(). shStride is the shared memory distance of consecutive output elements
+  constexpr int V = wordVol<T>();
+  const bool wordRead = (V > 1) && wordIn;
+  const bool wordWrite = (V > 1) && Store::isCopy && wordOut;
+  int shStride = 1;
+  if (V > 1) {
+#if SYCL
+    shStride = sg.shuffle(Msh.ct, 0);
+#elif HIP
+    shStride = __shfl(Msh.ct, 0);
+#else // CUDA
+    shStride = __shfl_sync(0xffffffff, Msh.ct, 0);
+#endif
+  }
+  if (warpLane < sizeMmk) {
+    if (wordRead) wordConv(V, warpLane == 0, Mmk.c_in, Mmk.d_in, Mmk.ct_in);
+    if (wordWrite) {
+      wordConv(V, warpLane == 0, Mmk.c_out, Mmk.d_out, Mmk.ct_out);
+      wordConv(V, warpLane == 0, Msh.c, Msh.d, Msh.ct);
+    }
   }
 
   // Pre-compute tensor positions in Mmk
   // 3*numRegStorage registers
-  int posMmkIn[numRegStorage];
-  int posMmkOut[numRegStorage];
+  Index posMmkIn[numRegStorage];
+  Index posMmkOut[numRegStorage];
   int posSh[numRegStorage];
 #pragma unroll
   for (int j=0; j < numRegStorage; j++) {
@@ -251,30 +405,32 @@ __global__ void transposePacked(
   }
 
   // 6 registers
-  TensorConvInOut Mbar;
+  TensorConvInOutT<Index> Mbar;
   Mbar.c_in = 1;
   Mbar.d_in = 1;
   Mbar.c_out = 1;
   Mbar.d_out = 1;
   if (warpLane < sizeMbar) {
-    Mbar = gl_Mbar[warpLane];
+    Mbar = loadDesc(gl_Mbar, warpLane);
   }
 
-  for (int posMbar=blockIdx_x; posMbar < volMbar; posMbar += gridDim_x)
+  for (Index posMbar=blockIdx_x; posMbar < volMbar; posMbar += gridDim_x)
   {
+    const T* RESTRICT in = batchTensor(dataIn, batch, posMbar, 0);
+    typename Store::OutType* RESTRICT out = batchTensor(dataOut, batch, posMbar, 1);
 
-    int posMbarOut = ((posMbar/Mbar.c_out) % Mbar.d_out)*Mbar.ct_out;
-    int posMbarIn  = ((posMbar/Mbar.c_in)  % Mbar.d_in) *Mbar.ct_in;
+    Index posMbarOut = ((posMbar/Mbar.c_out) % Mbar.d_out)*Mbar.ct_out;
+    Index posMbarIn  = ((posMbar/Mbar.c_in)  % Mbar.d_in) *Mbar.ct_in;
 #if SYCL
-    posMbarOut = sycl::reduce_over_group(sg, posMbarOut, sycl::plus<int>());
-    posMbarIn  = sycl::reduce_over_group(sg, posMbarIn,  sycl::plus<int>());
+    posMbarOut = sycl::reduce_over_group(sg, posMbarOut, sycl::plus<Index>());
+    posMbarIn  = sycl::reduce_over_group(sg, posMbarIn,  sycl::plus<Index>());
 #else // for CUDA, HIP only
     #pragma unroll
     for (int i=warpSize/2; i >= 1; i/=2) {   // AMD change
       #if HIP
 	posMbarOut += __shfl_xor(posMbarOut,i);
 	posMbarIn  += __shfl_xor(posMbarIn,i);
-      #elif CUDA
+      #else // CUDA
         posMbarOut += __shfl_xor_sync(0xffffffff,posMbarOut,i);
         posMbarIn  += __shfl_xor_sync(0xffffffff,posMbarIn,i);
       #endif
@@ -288,11 +444,19 @@ __global__ void transposePacked(
     #endif
 
     // Read from global memory
+    if (wordRead) {
 #pragma unroll
-    for (int j=0; j < numRegStorage; j++) {
-      int posMmk = threadIdx_x + j*blockDim_x;
-      int posIn = posMbarIn + posMmkIn[j];
-      if (posMmk < volMmk) shBuffer[posMmk] = dataIn[posIn];
+      for (int j=0; j < numRegStorage; j++) {
+        int posWord = threadIdx_x + j*blockDim_x;
+        if (posWord < volMmk/V) loadWord(in, posMbarIn + posMmkIn[j], V, &shBuffer[posWord*V], 1);
+      }
+    } else {
+#pragma unroll
+      for (int j=0; j < numRegStorage; j++) {
+        int posMmk = threadIdx_x + j*blockDim_x;
+        Index posIn = posMbarIn + posMmkIn[j];
+        if (posMmk < volMmk) gpu_stShared(shBuffer[posMmk], gpu_ldGlobal(in[posIn]));
+      }
     }
 
     #if SYCL
@@ -302,11 +466,19 @@ __global__ void transposePacked(
     #endif
 
     // Write to global memory
+    if (wordWrite) {
 #pragma unroll
-    for (int j=0; j < numRegStorage; j++) {
-      int posMmk = threadIdx_x + j*blockDim_x;
-      int posOut = posMbarOut + posMmkOut[j];
-      if (posMmk < volMmk) dataOut[posOut] = shBuffer[posSh[j]];
+      for (int j=0; j < numRegStorage; j++) {
+        int posWord = threadIdx_x + j*blockDim_x;
+        if (posWord < volMmk/V) storeWord((T *)out, posMbarOut + posMmkOut[j], V, &shBuffer[posSh[j]], shStride);
+      }
+    } else {
+#pragma unroll
+      for (int j=0; j < numRegStorage; j++) {
+        int posMmk = threadIdx_x + j*blockDim_x;
+        Index posOut = posMbarOut + posMmkOut[j];
+        if (posMmk < volMmk) store(out, posOut, gpu_ldShared(shBuffer[posSh[j]]));
+      }
     }
 
   }
@@ -319,15 +491,16 @@ __global__ void transposePacked(
 // dim nthread(((volMmkWithSplit - 1)/(gpuWarpSize*lc.numRegStorage) + 1)*gpuWarpSize, 1, 1)
 // dim nblock(ts.numSplit, min(256, max(1, ts.volMbar)), 1)
 //
-template <typename T, int numRegStorage>
+template <typename T, int numRegStorage, typename Index, typename Store = StoreCopy<T>>
 __global__ void transposePackedSplit(
-  const int splitDim, const int volMmkUnsplit, const int volMbar,
+  const int splitDim, const int volMmkUnsplit, const Index volMbar,
   const int sizeMmk, const int sizeMbar,
-  const int cMmSplit, const int cMkSplit,
-  const TensorConvInOut* RESTRICT glMmk,
-  const TensorConvInOut* RESTRICT glMbar,
-  const TensorConv* RESTRICT glMsh,
-  const T* RESTRICT dataIn, T* RESTRICT dataOut
+  const Index cMmSplit, const Index cMkSplit,
+  const MmkArg<Index> glMmk,
+  const MbarArg<Index> glMbar,
+  const MshArg glMsh,
+  const BatchArg<Index> batch, const bool wordIn, const bool wordOut,
+  const T* RESTRICT dataIn, typename Store::OutType* RESTRICT dataOut, const Store store
   #if SYCL
   , sycl::nd_item<3>& item, uint8_t *dpct_local
   #endif
@@ -341,6 +514,8 @@ __global__ void transposePackedSplit(
   const int warpSize = sg.get_local_range().get(0);
 #elif HIP
   HIP_DYNAMIC_SHARED( char, shBuffer_char)
+#elif LIBRETT_USES_CPU
+  char* shBuffer_char = Librett::simt::dynamicShared();
 #else // CUDA
   extern __shared__ char shBuffer_char[];
 #endif
@@ -349,23 +524,47 @@ __global__ void transposePackedSplit(
   const int warpLane = threadIdx_x & (warpSize - 1);
 
   // const int plusone = (blockIdx.x < (splitDim % gridDim.x));
-  const int p0 = blockIdx_x*splitDim/gridDim_x;
-  const int volSplit = (blockIdx_x + 1)*splitDim/gridDim_x - p0;
+  // blockIdx_x*splitDim can exceed INT_MAX in the 64-bit kernels
+  const Index p0 = (Index)blockIdx_x*splitDim/gridDim_x;
+  const int volSplit = (int)(((Index)blockIdx_x + 1)*splitDim/gridDim_x - p0);
   const int plusone = volSplit - splitDim/gridDim_x;
 
-  TensorConvInOut Mmk;
+  TensorConvInOutT<Index> Mmk;
   Mmk.c_in = 1;
   Mmk.d_in = 1;
   Mmk.c_out = 1;
   Mmk.d_out = 1;
   if (warpLane < sizeMmk) {
-    Mmk = glMmk[warpLane + plusone*sizeMmk];
+    Mmk = loadDesc(glMmk, warpLane + plusone*sizeMmk);
   }
   TensorConv Msh;
   Msh.c = 1;
   Msh.d = 1;
   if (warpLane < sizeMmk) {
-    Msh = glMsh[warpLane + plusone*sizeMmk];
+    Msh = loadDesc(glMsh, warpLane + plusone*sizeMmk);
+  }
+
+  // Packed words: positions are precomputed for words of V elements instead of elements,
+  // see wordConv(). shStride is the shared memory distance of consecutive output elements
+  constexpr int V = wordVol<T>();
+  const bool wordRead = (V > 1) && wordIn;
+  const bool wordWrite = (V > 1) && Store::isCopy && wordOut;
+  int shStride = 1;
+  if (V > 1) {
+#if SYCL
+    shStride = sg.shuffle(Msh.ct, 0);
+#elif HIP
+    shStride = __shfl(Msh.ct, 0);
+#else // CUDA
+    shStride = __shfl_sync(0xffffffff, Msh.ct, 0);
+#endif
+  }
+  if (warpLane < sizeMmk) {
+    if (wordRead) wordConv(V, warpLane == 0, Mmk.c_in, Mmk.d_in, Mmk.ct_in);
+    if (wordWrite) {
+      wordConv(V, warpLane == 0, Mmk.c_out, Mmk.d_out, Mmk.ct_out);
+      wordConv(V, warpLane == 0, Msh.c, Msh.d, Msh.ct);
+    }
   }
 
   // gridDim.x = number of splits
@@ -374,15 +573,15 @@ __global__ void transposePackedSplit(
   // const int volSplit = (splitDim/gridDim.x) + plusone;
   // Start position in this split
   // const int p0 = (splitDim/gridDim.x)*blockIdx.x + min(blockIdx.x, (splitDim % gridDim.x));
-  const int posMmkIn0  = p0*cMmSplit;
-  const int posMmkOut0 = p0*cMkSplit;
+  const Index posMmkIn0  = p0*cMmSplit;
+  const Index posMmkOut0 = p0*cMkSplit;
   // Volume of split Mmk
   const int volMmkSplit = volSplit*volMmkUnsplit;
 
   // Pre-compute tensor positions in Mmk
   // 3*numRegStorage registers
-  int posMmkIn[numRegStorage];
-  int posMmkOut[numRegStorage];
+  Index posMmkIn[numRegStorage];
+  Index posMmkOut[numRegStorage];
   int posSh[numRegStorage];
 #pragma unroll
   for (int j=0; j < numRegStorage; j++) {
@@ -413,33 +612,35 @@ __global__ void transposePackedSplit(
     }
   }
 
-  TensorConvInOut Mbar;
+  TensorConvInOutT<Index> Mbar;
   Mbar.c_in = 1;
   Mbar.d_in = 1;
   Mbar.c_out = 1;
   Mbar.d_out = 1;
   if (warpLane < sizeMbar) {
-    Mbar = glMbar[warpLane];
+    Mbar = loadDesc(glMbar, warpLane);
   }
 
-  const int posMbar0 = blockIdx_y*volMbar/gridDim_y;
-  const int posMbar1 = (blockIdx_y + 1)*volMbar/gridDim_y;
-  for (int posMbar=posMbar0; posMbar < posMbar1; posMbar++)
+  const Index posMbar0 = blockIdx_y*volMbar/gridDim_y;
+  const Index posMbar1 = (blockIdx_y + 1)*volMbar/gridDim_y;
+  for (Index posMbar=posMbar0; posMbar < posMbar1; posMbar++)
   // for (int posMbar=blockIdx.y;posMbar < volMbar;posMbar+=gridDim.y)
   {
+    const T* RESTRICT in = batchTensor(dataIn, batch, posMbar, 0);
+    typename Store::OutType* RESTRICT out = batchTensor(dataOut, batch, posMbar, 1);
 
-    int posMbarOut = ((posMbar/Mbar.c_out) % Mbar.d_out)*Mbar.ct_out;
-    int posMbarIn = ((posMbar/Mbar.c_in) % Mbar.d_in)*Mbar.ct_in;
+    Index posMbarOut = ((posMbar/Mbar.c_out) % Mbar.d_out)*Mbar.ct_out;
+    Index posMbarIn = ((posMbar/Mbar.c_in) % Mbar.d_in)*Mbar.ct_in;
 #if SYCL
-    posMbarOut = sycl::reduce_over_group(sg, posMbarOut, sycl::plus<int>());
-    posMbarIn  = sycl::reduce_over_group(sg, posMbarIn,  sycl::plus<int>());
+    posMbarOut = sycl::reduce_over_group(sg, posMbarOut, sycl::plus<Index>());
+    posMbarIn  = sycl::reduce_over_group(sg, posMbarIn,  sycl::plus<Index>());
 #else // HIP, CUDA only
     #pragma unroll
     for (int i=warpSize/2; i >= 1; i/=2) {   // AMD change
       #if HIP
         posMbarOut += __shfl_xor(posMbarOut,i);
         posMbarIn += __shfl_xor(posMbarIn,i);
-      #elif CUDA
+      #else // CUDA
         posMbarOut += __shfl_xor_sync(0xffffffff,posMbarOut,i);
         posMbarIn += __shfl_xor_sync(0xffffffff,posMbarIn,i);
       #endif
@@ -453,11 +654,19 @@ __global__ void transposePackedSplit(
     syncthreads();
     #endif
 
+    if (wordRead) {
 #pragma unroll
-    for (int j=0; j < numRegStorage; j++) {
-      int posMmk = threadIdx_x + j*blockDim_x;
-      int posIn = posMbarIn + posMmkIn[j];
-      if (posMmk < volMmkSplit) shBuffer[posMmk] = dataIn[posIn];
+      for (int j=0; j < numRegStorage; j++) {
+        int posWord = threadIdx_x + j*blockDim_x;
+        if (posWord < volMmkSplit/V) loadWord(in, posMbarIn + posMmkIn[j], V, &shBuffer[posWord*V], 1);
+      }
+    } else {
+#pragma unroll
+      for (int j=0; j < numRegStorage; j++) {
+        int posMmk = threadIdx_x + j*blockDim_x;
+        Index posIn = posMbarIn + posMmkIn[j];
+        if (posMmk < volMmkSplit) gpu_stShared(shBuffer[posMmk], gpu_ldGlobal(in[posIn]));
+      }
     }
 
     // Write to global memory
@@ -467,11 +676,21 @@ __global__ void transposePackedSplit(
     syncthreads();
     #endif
 
+    if (wordWrite) {
 #pragma unroll
-    for (int j=0; j < numRegStorage; j++) {
-      int posMmk = threadIdx_x + j*blockDim_x;
-      int posOut = posMbarOut + posMmkOut[j];
-      if (posMmk < volMmkSplit) dataOut[posOut] = shBuffer[posSh[j]];
+      for (int j=0; j < numRegStorage; j++) {
+        int posWord = threadIdx_x + j*blockDim_x;
+        if (posWord < volMmkSplit/V) {
+          storeWord((T *)out, posMbarOut + posMmkOut[j], V, &shBuffer[posSh[j]], shStride);
+        }
+      }
+    } else {
+#pragma unroll
+      for (int j=0; j < numRegStorage; j++) {
+        int posMmk = threadIdx_x + j*blockDim_x;
+        Index posOut = posMbarOut + posMmkOut[j];
+        if (posMmk < volMmkSplit) store(out, posOut, gpu_ldShared(shBuffer[posSh[j]]));
+      }
     }
 
   }
@@ -485,13 +704,14 @@ __global__ void transposePackedSplit(
 //  dim3 numthread(TILEDIM, TILEROWS, 1);
 //  dim3 numblock( ((plan.volMm-1)/TILEDIM+1)*((plan.volMkBar-1)/TILEDIM+1), 1, plan.volMbar);
 //
-template <typename T>
+template <typename T, typename Index, typename Store = StoreCopy<T>>
 __global__ void transposeTiledCopy(
-  const int numMm, const int volMbar, const int sizeMbar,
-  const int cuDimMk, const int cuDimMm,
+  const int numMm, const Index volMbar, const int sizeMbar,
+  const Index cuDimMk, const Index cuDimMm,
   const int2_t tiledVol,
-  const TensorConvInOut* RESTRICT gl_Mbar,
-  const T* RESTRICT dataIn, T* RESTRICT dataOut
+  const MbarArg<Index> gl_Mbar,
+  const BatchArg<Index> batch,
+  const T* RESTRICT dataIn, typename Store::OutType* RESTRICT dataOut, const Store store
   #if SYCL
   , sycl::nd_item<3>& item
   #endif
@@ -502,13 +722,13 @@ __global__ void transposeTiledCopy(
   const int warpSize = sg.get_local_range().get(0);
 #endif
   const int warpLane = threadIdx_x & (warpSize - 1);
-  TensorConvInOut Mbar;
+  TensorConvInOutT<Index> Mbar;
   Mbar.c_in = 1;
   Mbar.d_in = 1;
   Mbar.c_out = 1;
   Mbar.d_out = 1;
   if (warpLane < sizeMbar) {
-    Mbar = gl_Mbar[warpLane];
+    Mbar = loadDesc(gl_Mbar, warpLane);
   }
 
   const int bx = (blockIdx_x % numMm)*TILEDIM;
@@ -528,34 +748,36 @@ __global__ void transposeTiledCopy(
   const unsigned int one = 1;
 #endif
 
-  const int posMinorIn = x + y*cuDimMk;
-  const int posMinorOut = x + y*cuDimMm;
-  const int posInAdd = TILEROWS*cuDimMk;
-  const int posOutAdd = TILEROWS*cuDimMm;
+  const Index posMinorIn = x + y*cuDimMk;
+  const Index posMinorOut = x + y*cuDimMm;
+  const Index posInAdd = TILEROWS*cuDimMk;
+  const Index posOutAdd = TILEROWS*cuDimMm;
 
-  for (int posMbar=blockIdx_z; posMbar < volMbar; posMbar += gridDim_z)
+  for (Index posMbar=blockIdx_z; posMbar < volMbar; posMbar += gridDim_z)
   {
+    const T* RESTRICT in = batchTensor(dataIn, batch, posMbar, 0);
+    typename Store::OutType* RESTRICT out = batchTensor(dataOut, batch, posMbar, 1);
 
     // Compute global memory positions
-    int posMajorIn = ((posMbar/Mbar.c_in) % Mbar.d_in)*Mbar.ct_in;
-    int posMajorOut = ((posMbar/Mbar.c_out) % Mbar.d_out)*Mbar.ct_out;
+    Index posMajorIn = ((posMbar/Mbar.c_in) % Mbar.d_in)*Mbar.ct_in;
+    Index posMajorOut = ((posMbar/Mbar.c_out) % Mbar.d_out)*Mbar.ct_out;
 #if SYCL
-    posMajorIn  = sycl::reduce_over_group(sg, posMajorIn,  sycl::plus<int>());
-    posMajorOut = sycl::reduce_over_group(sg, posMajorOut, sycl::plus<int>());
+    posMajorIn  = sycl::reduce_over_group(sg, posMajorIn,  sycl::plus<Index>());
+    posMajorOut = sycl::reduce_over_group(sg, posMajorOut, sycl::plus<Index>());
 #else // for CUDA, HIP only
     #pragma unroll
     for (int i=warpSize/2; i >= 1; i/=2) {   // AMD change
       #if HIP
         posMajorIn += __shfl_xor(posMajorIn,i);
         posMajorOut += __shfl_xor(posMajorOut,i);
-      #elif CUDA
+      #else // CUDA
         posMajorIn  += __shfl_xor_sync(0xffffffff,posMajorIn,i);
         posMajorOut += __shfl_xor_sync(0xffffffff,posMajorOut,i);
       #endif
     }
 #endif // SYCL
-    int posIn = posMajorIn + posMinorIn;
-    int posOut = posMajorOut + posMinorOut;
+    Index posIn = posMajorIn + posMinorIn;
+    Index posOut = posMajorOut + posMinorOut;
 
     // Variables where values are stored
     T val[TILEDIM/TILEROWS];
@@ -565,7 +787,7 @@ __global__ void transposeTiledCopy(
     for (int j=0; j < TILEDIM; j += TILEROWS) {
       // if ((x < tiledVol.x) && (y + j < tiledVol.y)) {
       if ((mask & (one << j)) != 0) {   // AMD change
-        val[j/TILEROWS] = dataIn[posIn];
+        val[j/TILEROWS] = gpu_ldGlobal(in[posIn]);
       }
       posIn += posInAdd;
     }
@@ -575,7 +797,7 @@ __global__ void transposeTiledCopy(
     for (int j=0; j < TILEDIM; j += TILEROWS) {
       // if ((x < tiledVol.x) && (y + j < tiledVol.y)) {
       if ((mask & (one << j)) != 0) {   // AMD change
-        dataOut[posOut] = val[j/TILEROWS];
+        store(out, posOut, val[j/TILEROWS]);
       }
       posOut += posOutAdd;
     }
@@ -674,6 +896,164 @@ __global__ void transposeTiledCopy(
 }
 #endif
 
+//
+// Trivial method with a scaling store stage. The plain copy is a memcpy
+//
+//  dim3 numthread(TRIVIAL_NUMTHREAD, 1, 1);
+//  dim3 numblock(min(TRIVIAL_MAXBLOCK, (vol - 1)/TRIVIAL_NUMTHREAD + 1), 1, 1);
+//
+const int TRIVIAL_NUMTHREAD = 256;
+const int TRIVIAL_MAXBLOCK = 4096;
+
+template <typename T, typename Index, typename Store>
+__global__ void transposeTrivial(const Index vol, const T* RESTRICT dataIn,
+  typename Store::OutType* RESTRICT dataOut, const Store store
+  #if SYCL
+  , sycl::nd_item<3>& item
+  #endif
+  )
+{
+  const Index stride = (Index)gridDim_x*blockDim_x;
+  for (Index pos=(Index)blockIdx_x*blockDim_x + threadIdx_x; pos < vol; pos += stride) {
+    store(dataOut, pos, gpu_ldGlobal(dataIn[pos]));
+  }
+}
+
+//
+// Tensor of a grouped launch in Tiled (copy = 0) or TiledCopy (copy = 1) form, see
+// librettPlan_t::setupGrouped(). Work units are (tile, posMbar) pairs numbered over all
+// tensors of the launch, the tensor owns units workStart ... workStart + numTile*volMbar - 1.
+// Its Mbar descriptors are at offsetMbar in the Mbar part of the descriptor table.
+//
+template <typename Index>
+struct GroupedTask {
+  const void* dataIn;
+  void* dataOut;
+  Index volMbar;
+  Index cuDimMk;
+  Index cuDimMm;
+  int workStart;
+  int numMm;
+  int numTile;
+  int volX;
+  int volY;
+  int sizeMbar;
+  int offsetMbar;
+  int copy;
+};
+
+// Number of work units a thread block takes from the queue at a time
+const int GROUPED_CHUNK = 4;
+
+//
+// Grouped transpose of numTask tensors with different shapes and permutations.
+// Persistent thread blocks take GROUPED_CHUNK work units at a time from the queue
+// counter until all numWork units are done. *queue must be zero at launch.
+//
+//  dim3 numthread(TILEDIM, TILEROWS, 1);
+//  dim3 numblock(min(prop.multiProcessorCount*8, (numWork - 1)/GROUPED_CHUNK + 1), 1, 1);
+//
+template <typename T, typename Index>
+__global__ void transposeGrouped(const int numTask, const int numWork,
+  const GroupedTask<Index>* RESTRICT glTask, const TensorConvInOutT<Index>* RESTRICT glMbar,
+  int* RESTRICT queue
+#if SYCL
+  , sycl::nd_item<3>& item
+#endif
+  )
+{
+  // Shared memory
+#if SYCL
+  sycl::group wrk_grp = item.get_group();
+  using tile_t = T[TILEDIM][TILEDIM+tilePad(sizeof(T))];
+  tile_t& shTile = *sycl::ext::oneapi::group_local_memory_for_overwrite<tile_t>(wrk_grp);
+  int& shWork = *sycl::ext::oneapi::group_local_memory_for_overwrite<int>(wrk_grp);
+  #define GROUPED_SYNC() sycl::group_barrier(wrk_grp)
+#elif HIP
+  __shared__ T shTile[TILEDIM][TILEDIM];
+  __shared__ int shWork;
+  #define GROUPED_SYNC() syncthreads()
+#else // CUDA
+  __shared__ T shTile[TILEDIM][TILEDIM+tilePad(sizeof(T))];
+  __shared__ int shWork;
+  #define GROUPED_SYNC() syncthreads()
+#endif
+
+  while (true) {
+    if (threadIdx_x == 0 && threadIdx_y == 0) gpu_stShared(shWork, gpu_atomicAdd(queue[0], GROUPED_CHUNK));
+    GROUPED_SYNC();
+    const int work0 = gpu_ldShared(shWork);
+    GROUPED_SYNC();
+    if (work0 >= numWork) break;
+    const int work1 = min(work0 + GROUPED_CHUNK, numWork);
+
+    // Tensor of the first work unit, the units of a chunk are consecutive
+    int iTask = 0;
+    for (int n=numTask;n > 1;) {
+      const int half = n/2;
+      if (gpu_ldGlobal(glTask[iTask + half].workStart) <= work0) iTask += half;
+      n -= half;
+    }
+
+    for (int work=work0;work < work1;work++) {
+      while (iTask + 1 < numTask && gpu_ldGlobal(glTask[iTask + 1].workStart) <= work) iTask++;
+      const GroupedTask<Index>& task = glTask[iTask];
+
+      const int unit = work - task.workStart;
+      const Index posMbar = unit/task.numTile;
+      const int tile = unit - (int)posMbar*task.numTile;
+      const int bx = (tile % task.numMm)*TILEDIM;
+      const int by = (tile / task.numMm)*TILEDIM;
+
+      // Compute global memory positions
+      Index posMajorIn = 0;
+      Index posMajorOut = 0;
+      for (int i=0;i < task.sizeMbar;i++) {
+        const TensorConvInOutT<Index> Mbar = gpu_ldGlobal(glMbar[task.offsetMbar + i]);
+        posMajorIn += ((posMbar/Mbar.c_in) % Mbar.d_in)*Mbar.ct_in;
+        posMajorOut += ((posMbar/Mbar.c_out) % Mbar.d_out)*Mbar.ct_out;
+      }
+      const T* dataIn = (const T *)task.dataIn;
+      T* dataOut = (T *)task.dataOut;
+
+      if (task.copy) {
+        // Rows are contiguous in both input and output
+        const int x = bx + threadIdx_x;
+#pragma unroll
+        for (int j=0; j < TILEDIM; j += TILEROWS) {
+          const int y = by + threadIdx_y + j;
+          if (x < task.volX && y < task.volY) {
+            gpu_stGlobal(dataOut[posMajorOut + x + y*task.cuDimMm], gpu_ldGlobal(dataIn[posMajorIn + x + y*task.cuDimMk]));
+          }
+        }
+      } else {
+        const int xin = bx + threadIdx_x;
+        const int yin = by + threadIdx_y;
+        const int xout = bx + threadIdx_y;
+        const int yout = by + threadIdx_x;
+
+        // Previous tile must be written out before the shared memory tile is reused
+        GROUPED_SYNC();
+#pragma unroll
+        for (int j=0; j < TILEDIM; j += TILEROWS) {
+          if (xin < task.volX && yin + j < task.volY) {
+            gpu_stShared(shTile[threadIdx_y + j][threadIdx_x], gpu_ldGlobal(dataIn[posMajorIn + xin + (yin + j)*task.cuDimMk]));
+          }
+        }
+        GROUPED_SYNC();
+#pragma unroll
+        for (int j=0; j < TILEDIM; j += TILEROWS) {
+          if (xout + j < task.volX && yout < task.volY) {
+            gpu_stGlobal(dataOut[posMajorOut + yout + (xout + j)*task.cuDimMm], gpu_ldShared(shTile[threadIdx_x][threadIdx_y + j]));
+          }
+        }
+      }
+    }
+  }
+
+  #undef GROUPED_SYNC
+}
+
 //######################################################################################
 //######################################################################################
 //######################################################################################
@@ -681,173 +1061,159 @@ __global__ void transposeTiledCopy(
 //
 // Sets shared memory bank configuration for all kernels. Needs to be called once per device.
 //
+//
+// The device kernels read the plan descriptors only
+//
+void librettKernelActivate(librettPlan_t&) {
+}
+
 void librettKernelSetSharedMemConfig() {
 #if LIBRETT_USES_CUDA // CUDA
-  #define CALL(NREG) cudaCheck(cudaFuncSetSharedMemConfig(transposePacked<float, NREG>, cudaSharedMemBankSizeFourByte ))
+  #define CALL(NREG) cudaCheck(cudaFuncSetSharedMemConfig(transposePacked<float, NREG, int>, cudaSharedMemBankSizeFourByte ))
   #include "calls.h"
   #undef CALL
 
-  #define CALL(NREG) cudaCheck(cudaFuncSetSharedMemConfig(transposePacked<double, NREG>, cudaSharedMemBankSizeEightByte ))
+  #define CALL(NREG) cudaCheck(cudaFuncSetSharedMemConfig(transposePacked<double, NREG, int>, cudaSharedMemBankSizeEightByte ))
   #include "calls.h"
   #undef CALL
 
-  #define CALL(NREG) cudaCheck(cudaFuncSetSharedMemConfig(transposePackedSplit<float, NREG>, cudaSharedMemBankSizeFourByte ))
+  #define CALL(NREG) cudaCheck(cudaFuncSetSharedMemConfig(transposePackedSplit<float, NREG, int>, cudaSharedMemBankSizeFourByte ))
   #include "calls.h"
   #undef CALL
 
-  #define CALL(NREG) cudaCheck(cudaFuncSetSharedMemConfig(transposePackedSplit<double, NREG>, cudaSharedMemBankSizeEightByte ))
+  #define CALL(NREG) cudaCheck(cudaFuncSetSharedMemConfig(transposePackedSplit<double, NREG, int>, cudaSharedMemBankSizeEightByte ))
   #include "calls.h"
   #undef CALL
 
-  cudaCheck(cudaFuncSetSharedMemConfig(transposeTiled<float>, cudaSharedMemBankSizeFourByte));
-  cudaCheck(cudaFuncSetSharedMemConfig(transposeTiledCopy<float>, cudaSharedMemBankSizeFourByte));
+  cudaCheck(cudaFuncSetSharedMemConfig(transposeTiled<float, int>, cudaSharedMemBankSizeFourByte));
+  cudaCheck(cudaFuncSetSharedMemConfig(transposeTiledCopy<float, int>, cudaSharedMemBankSizeFourByte));
 
-  cudaCheck(cudaFuncSetSharedMemConfig(transposeTiled<double>, cudaSharedMemBankSizeEightByte));
-  cudaCheck(cudaFuncSetSharedMemConfig(transposeTiledCopy<double>, cudaSharedMemBankSizeEightByte));
+  cudaCheck(cudaFuncSetSharedMemConfig(transposeTiled<double, int>, cudaSharedMemBankSizeEightByte));
+  cudaCheck(cudaFuncSetSharedMemConfig(transposeTiledCopy<double, int>, cudaSharedMemBankSizeEightByte));
 
 #endif // CUDA
 }
 
-// Caches for PackedSplit kernels. One cache for all devices
-// NOTE: Not thread safe
-const int CACHE_SIZE = 100000;
+#if HIP || LIBRETT_USES_CUDA
+template <typename Kernel>
+static void kernelAttributes(Kernel kernel, KernelResource& res) {
 #if HIP
-  const int MAX_NUMWARP = (1024/64);  // AMD change
-#elif SYCL
-  #if LIBRETT_SUBGROUP_SIZE16
-  const int MAX_NUMWARP = (1024/16);
-  #elif LIBRETT_SUBGROUP_SIZE32
-  const int MAX_NUMWARP = (1024/32);
-  #else
-  const int MAX_NUMWARP = (1024/32);
-  #endif
+  hipFuncAttributes attr;
+  hipCheck(hipFuncGetAttributes(&attr, reinterpret_cast<const void*>(kernel)));
 #else // CUDA
-  const int MAX_NUMWARP = (1024/32);
+  cudaFuncAttributes attr;
+  cudaCheck(cudaFuncGetAttributes(&attr, kernel));
 #endif
-const int MAX_NUMTYPE = 2;
-static int numDevices = -1;
-LRUCache<unsigned long long int, int> nabCache(CACHE_SIZE, -1);
+  res.numRegs = attr.numRegs;
+  res.sharedSizeBytes = attr.sharedSizeBytes;
+  res.maxThreadsPerBlock = attr.maxThreadsPerBlock;
+}
+#endif // HIP or CUDA
 
 //
-// Returns the maximum number of active blocks per SM
+// Resources of the int Index kernel of method, sizeofType and numRegStorage on the current
+// device, from the attributes the compiler gave it. Returns false if there is no such
+// kernel or the backend has no kernel attributes
 //
-int getNumActiveBlock(const int method, const int sizeofType, const LaunchConfig &lc,
-  const int deviceID, const gpuDeviceProp_t &prop)
-{
-  //int numActiveBlock = 1;
-  int numActiveBlock;
-  int numthread = lc.numthread_x * lc.numthread_y * lc.numthread_z;
+static bool kernelResource(const int method, const int sizeofType, const int numRegStorage,
+  KernelResource& res) {
+  res = {method, sizeofType, numRegStorage, 0, 0, 0};
+#if HIP || LIBRETT_USES_CUDA
   switch(method) {
-    case Trivial:
-    {
-      // This value does not matter, but should be > 0
-      numActiveBlock = 1;
-    }
-    break;
-
     case Packed:
     {
-    #ifndef SYCL
-      #define CALL0(TYPE, NREG) \
-        gpuOccupancyMaxActiveBlocksPerMultiprocessor(&numActiveBlock, \
-          transposePacked<TYPE, NREG>, numthread, lc.shmemsize)
-      switch(lc.numRegStorage) {
-        #define CALL(ICASE) case ICASE: if (sizeofType == 4) CALL0(float,  ICASE); \
-	                                if (sizeofType == 8) CALL0(double, ICASE); \
+      #define CALL0(TYPE, NREG) kernelAttributes(transposePacked<TYPE, NREG, int>, res)
+      switch(numRegStorage) {
+        #define CALL(ICASE) case ICASE: if (sizeofType == 1) CALL0(uint8_t,  ICASE); \
+                                        if (sizeofType == 2) CALL0(uint16_t, ICASE); \
+                                        if (sizeofType == 4) CALL0(float,  ICASE); \
+                                        if (sizeofType == 8) CALL0(double, ICASE); \
                                         if (sizeofType == 16) CALL0(librett_complex, ICASE); break;
         #include "calls.h"
       }
       #undef CALL
       #undef CALL0
-    #endif // CUDA or HIP
     }
     break;
 
     case PackedSplit:
     {
-      // Allocate cache structure if needed
-      if (numDevices == -1) {
-        #if SYCL
-          Librett::syclGetDeviceCount(&numDevices);
-        #elif HIP
-          hipCheck(hipGetDeviceCount(&numDevices));
-        #else // CUDA
-          cudaCheck(cudaGetDeviceCount(&numDevices));
-        #endif
-      }
-      // Build unique key for cache
-      int key_warp = (numthread/gpuWarpSize - 1);
-      if (key_warp >= MAX_NUMWARP) {
-        printf("getNumActiveBlock maximum number of warps exceeded\n");
-        exit(1);
-      }
-      int key_reg = (lc.numRegStorage - 1);
-      int key_type = (sizeofType == 4);
-      unsigned long long int key =
-      (unsigned long long int)(lc.shmemsize/sizeofType)*MAX_NUMWARP*MAX_REG_STORAGE*MAX_NUMTYPE*numDevices +
-      (unsigned long long int)deviceID*MAX_NUMWARP*MAX_REG_STORAGE*MAX_NUMTYPE +
-      (unsigned long long int)key_type*MAX_NUMWARP*MAX_REG_STORAGE +
-      (unsigned long long int)key_reg*MAX_NUMWARP +
-      (unsigned long long int)key_warp;
-
-      numActiveBlock = nabCache.get(key);
-      if (numActiveBlock == -1) {
-        // key not found in cache, determine value and add it to cache
-        #ifndef SYCL
-          #define CALL0(TYPE, NREG) \
-            gpuOccupancyMaxActiveBlocksPerMultiprocessor(&numActiveBlock, \
-              transposePackedSplit<TYPE, NREG>, numthread, lc.shmemsize)
-          switch(lc.numRegStorage) {
-            #define CALL(ICASE) case ICASE: if (sizeofType == 4) CALL0(float,  ICASE); \
-		                            if (sizeofType == 8) CALL0(double, ICASE); \
-                                            if (sizeofType == 16) CALL0(librett_complex,ICASE); break;
-            #include "calls.h"
-          }
-          #undef CALL
-          #undef CALL0
-        #endif // CUDA or HIP
-        nabCache.set(key, numActiveBlock);
+      #define CALL0(TYPE, NREG) kernelAttributes(transposePackedSplit<TYPE, NREG, int>, res)
+      switch(numRegStorage) {
+        #define CALL(ICASE) case ICASE: if (sizeofType == 1) CALL0(uint8_t,  ICASE); \
+                                        if (sizeofType == 2) CALL0(uint16_t, ICASE); \
+                                        if (sizeofType == 4) CALL0(float,  ICASE); \
+                                        if (sizeofType == 8) CALL0(double, ICASE); \
+                                        if (sizeofType == 16) CALL0(librett_complex, ICASE); break;
+        #include "calls.h"
       }
+      #undef CALL
+      #undef CALL0
     }
     break;
 
     case Tiled:
     {
-    #ifndef SYCL
-      if (sizeofType == 4) {
-        gpuOccupancyMaxActiveBlocksPerMultiprocessor(&numActiveBlock,
-          transposeTiled<float>, numthread, lc.shmemsize);
-      } else if (sizeofType == 8) {
-        gpuOccupancyMaxActiveBlocksPerMultiprocessor(&numActiveBlock,
-          transposeTiled<double>, numthread, lc.shmemsize);
-      }
-      else if (sizeofType == 16) {
-        gpuOccupancyMaxActiveBlocksPerMultiprocessor(&numActiveBlock,
-          transposeTiled<librett_complex>, numthread, lc.shmemsize);
-      }
-    #endif // CUDA or HIP
+      if (sizeofType == 1) kernelAttributes(transposeTiled<uint8_t, int>, res);
+      if (sizeofType == 2) kernelAttributes(transposeTiled<uint16_t, int>, res);
+      if (sizeofType == 4) kernelAttributes(transposeTiled<float, int>, res);
+      if (sizeofType == 8) kernelAttributes(transposeTiled<double, int>, res);
+      if (sizeofType == 16) kernelAttributes(transposeTiled<librett_complex, int>, res);
     }
     break;
 
     case TiledCopy:
     {
-    #ifndef SYCL
-      if (sizeofType == 4) {
-        gpuOccupancyMaxActiveBlocksPerMultiprocessor(&numActiveBlock,
-          transposeTiledCopy<float>, numthread, lc.shmemsize);
-      } else if (sizeofType == 8) {
-        gpuOccupancyMaxActiveBlocksPerMultiprocessor(&numActiveBlock,
-          transposeTiledCopy<double>, numthread, lc.shmemsize);
-      } else if (sizeofType == 16) {
-        gpuOccupancyMaxActiveBlocksPerMultiprocessor(&numActiveBlock,
-          transposeTiledCopy<librett_complex>, numthread, lc.shmemsize);
-      }
-    #endif // CUDA or HIP
+      if (sizeofType == 1) kernelAttributes(transposeTiledCopy<uint8_t, int>, res);
+      if (sizeofType == 2) kernelAttributes(transposeTiledCopy<uint16_t, int>, res);
+      if (sizeofType == 4) kernelAttributes(transposeTiledCopy<float, int>, res);
+      if (sizeofType == 8) kernelAttributes(transposeTiledCopy<double, int>, res);
+      if (sizeofType == 16) kernelAttributes(transposeTiledCopy<librett_complex, int>, res);
     }
     break;
   }
+#endif // HIP or CUDA
+  return (res.maxThreadsPerBlock > 0);
+}
 
-  return numActiveBlock;
+//
+// Returns the maximum number of active blocks per SM, computed on the host from the profile
+// of the device and the resources of the kernel, see occupancyActiveBlocks(). Resources are
+// read from the kernel attributes once per device and kernel; backends without attributes
+// and the profiles of librettPlanOffline() that lack a kernel are limited by threads and
+// shared memory only. Occupancy of the int Index kernels is used for index64 plans as well
+//
+int getNumActiveBlock(const int method, const int sizeofType, const LaunchConfig &lc,
+  const int deviceID, const gpuDeviceProp_t &prop)
+{
+  // This value does not matter, but should be > 0
+  if (method == Trivial) return 1;
+
+  const DeviceProfile* profile = deviceProfileFor(deviceID, prop);
+  if (profile == nullptr) return 0;
+  const int numRegStorage = (method == Packed || method == PackedSplit) ? lc.numRegStorage : 0;
+  KernelResource res;
+  if (!deviceProfileKernel(deviceID, method, sizeofType, numRegStorage, res)) {
+    if (deviceID < 0 || !kernelResource(method, sizeofType, numRegStorage, res)) {
+      res = {method, sizeofType, numRegStorage, 0, 0, profile->maxThreadsPerBlock};
+    }
+    if (deviceID >= 0) deviceProfileAddKernel(deviceID, res);
+  }
+  const int numthread = lc.numthread_x*lc.numthread_y*lc.numthread_z;
+  return occupancyActiveBlocks(*profile, res, numthread, lc.shmemsize);
+}
+
+void librettKernelResources(std::vector<KernelResource>& kernels) {
+  const int sizeofTypes[5] = {1, 2, 4, 8, 16};
+  for (int sizeofType : sizeofTypes) {
+    KernelResource res;
+    for (int numRegStorage=1;numRegStorage <= MAX_REG_STORAGE;numRegStorage++) {
+      if (kernelResource(Packed, sizeofType, numRegStorage, res)) kernels.push_back(res);
+      if (kernelResource(PackedSplit, sizeofType, numRegStorage, res)) kernels.push_back(res);
+    }
+    if (kernelResource(Tiled, sizeofType, 0, res)) kernels.push_back(res);
+    if (kernelResource(TiledCopy, sizeofType, 0, res)) kernels.push_back(res);
+  }
 }
 
 //
@@ -915,8 +1281,7 @@ int librettKernelLaunchConfiguration(const int sizeofType, const TensorSplit &ts
 
       lc.numthread_y = 1;
       lc.numthread_z = 1;
-      lc.numblock_x = max(1, ts.volMbar);
-      lc.numblock_x = std::min<unsigned int>(gpuMultiProcessorCount * 18, lc.numblock_x);
+      lc.numblock_x = std::min<long long int>(gpuMultiProcessorCount * 18, std::max(1LL, ts.volMbar));
       lc.numblock_y = 1;
       lc.numblock_z = 1;
 
@@ -975,7 +1340,7 @@ int librettKernelLaunchConfiguration(const int sizeofType, const TensorSplit &ts
       lc.numthread_y = 1;
       lc.numthread_z = 1;
       lc.numblock_x = ts.numSplit;
-      lc.numblock_y = std::max<unsigned int>(1, std::min<unsigned int>((gpuMultiProcessorCount*18)/lc.numblock_x,
+      lc.numblock_y = std::max<long long int>(1, std::min<long long int>((gpuMultiProcessorCount*18)/lc.numblock_x,
 			                                                ts.volMbar));
       lc.numblock_z = 1;
 
@@ -1007,7 +1372,7 @@ int librettKernelLaunchConfiguration(const int sizeofType, const TensorSplit &ts
       lc.numthread_z = 1;
       lc.numblock_x = ((ts.volMm - 1)/TILEDIM + 1)*((ts.volMk - 1)/TILEDIM + 1);
       lc.numblock_y = 1;
-      lc.numblock_z = std::max<unsigned int>(1, std::min<unsigned int>((gpuMultiProcessorCount*8) /
+      lc.numblock_z = std::max<long long int>(1, std::min<long long int>((gpuMultiProcessorCount*8) /
 			                    (lc.numblock_x*lc.numblock_y), ts.volMbar));
       lc.shmemsize = 0;
       lc.numRegStorage = 0;
@@ -1021,9 +1386,8 @@ int librettKernelLaunchConfiguration(const int sizeofType, const TensorSplit &ts
       lc.numthread_z = 1;
       lc.numblock_x = ((ts.volMm - 1)/TILEDIM + 1)*((ts.volMkBar - 1)/TILEDIM + 1);
       lc.numblock_y = 1;
-      lc.numblock_z = ts.volMbar;
-      lc.numblock_z = min((gpuMultiProcessorCount*8)/(lc.numblock_x*lc.numblock_y), lc.numblock_z);
-      lc.numblock_z = std::max<unsigned int>(1, lc.numblock_z);
+      lc.numblock_z = std::max<long long int>(1, std::min<long long int>((gpuMultiProcessorCount*8) /
+			                    (lc.numblock_x*lc.numblock_y), ts.volMbar));
       lc.shmemsize = 0;
       lc.numRegStorage = 0;
     }
@@ -1043,23 +1407,222 @@ int librettKernelLaunchConfiguration(const int sizeofType, const TensorSplit &ts
   return numActiveBlockReturn;
 }
 
-bool librettKernel(librettPlan_t &plan, void *dataIn, void *dataOut)
+//
+// Sets the kernel argument of a descriptor: the host copy by value when the descriptor
+// has no device buffer gl, see librettPlan_t::activate()
+//
+template <typename Conv, int N>
+static void setDescArg(DescArg<Conv, N>& arg, const std::vector<Conv>& host, const Conv* gl) {
+  arg.gl = gl;
+  if (gl == nullptr) std::copy(host.begin(), host.begin() + std::min<size_t>(host.size(), N), arg.inl);
+}
+
+//
+// Device descriptors of the plan are freed on plan.descriptorStream. A launch on another
+// stream makes descriptorStream wait for the launch, so that the descriptors are not
+// reused while the launch reads them.
+//
+// The wait takes the state of the event when it is queued, so one event per device and
+// thread is recorded over and over. The events are never destroyed, the device runtime
+// may have shut down when the thread exits
+//
+static void orderDescriptorFree(const librettPlan_t& plan, gpuStream_t stream) {
+#if HIP || LIBRETT_USES_CUDA
+  if (stream == plan.descriptorStream) return;
+  if (plan.Mbar == nullptr && plan.Mbar64 == nullptr && plan.Mmk == nullptr && plan.Mmk64 == nullptr &&
+    plan.Msh == nullptr) return;
+  int deviceID;
+#endif
+#if HIP
+  static thread_local std::map<int, hipEvent_t> events;
+  hipCheck(hipGetDevice(&deviceID));
+  auto it = events.find(deviceID);
+  if (it == events.end()) {
+    hipEvent_t event;
+    hipCheck(hipEventCreateWithFlags(&event, hipEventDisableTiming));
+    it = events.insert(std::make_pair(deviceID, event)).first;
+  }
+  hipCheck(hipEventRecord(it->second, stream));
+  hipCheck(hipStreamWaitEvent(plan.descriptorStream, it->second, 0));
+#elif LIBRETT_USES_CUDA
+  static thread_local std::map<int, cudaEvent_t> events;
+  cudaCheck(cudaGetDevice(&deviceID));
+  auto it = events.find(deviceID);
+  if (it == events.end()) {
+    cudaEvent_t event;
+    cudaCheck(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+    it = events.insert(std::make_pair(deviceID, event)).first;
+  }
+  cudaCheck(cudaEventRecord(it->second, stream));
+  cudaCheck(cudaStreamWaitEvent(plan.descriptorStream, it->second, 0));
+#else
+  // SYCL and host launches have completed when librettKernel() returns
+  (void)plan;
+  (void)stream;
+#endif
+}
+
+//
+// Packed word accesses of the Tiled, Packed and PackedSplit kernels on side i = 0 (input)
+// or 1 (output), see loadWord(). Every tensor of the launch must start at a word boundary,
+// Mbar must move whole words and the contiguous runs must consist of whole words
+//
+template <typename Conv>
+static bool wordAligned(const librettPlan_t& plan, const std::vector<Conv>& Mbar, const std::vector<Conv>& Mmk,
+  const int i, const void* data, const bool batched) {
+
+  const int V = 4/(int)plan.sizeofType;
+  if (batched && plan.batchPointers) {
+    for (long long int b=0;b < plan.batchCount;b++) {
+      if ((uintptr_t)plan.hostBatchData[i*plan.batchCount + b] % 4 != 0) return false;
+    }
+  } else if ((uintptr_t)data % 4 != 0) {
+    return false;
+  }
+  for (const Conv& conv : Mbar) {
+    if (((i == 0) ? conv.ct_in : conv.ct_out) % V != 0) return false;
+  }
+
+  const TensorSplit& ts = plan.tensorSplit;
+  if (ts.method == Tiled) return ((i == 0) ? plan.cuDimMk : plan.cuDimMm) % V == 0;
+  // Words run along the leading rank of Mmk, in both descriptor sets of PackedSplit
+  for (int j=0;j < (int)Mmk.size();j += ts.sizeMmk) {
+    if (i == 0 && (Mmk[j].ct_in != 1 || Mmk[j].d_in % V != 0)) return false;
+    if (i == 1 && (Mmk[j].ct_out != 1 || Mmk[j].d_out % V != 0)) return false;
+  }
+  // Start of the split
+  if (ts.method == PackedSplit) return ((i == 0) ? plan.cuDimMm : plan.cuDimMk) % V == 0;
+  return true;
+}
+
+bool librettKernel(librettPlan_t &plan, gpuStream_t stream, void *dataIn, void *dataOut, const double alpha,
+  const double beta, const bool batched)
 {
-  LaunchConfig& lc = plan.launchConfig;
-  TensorSplit& ts = plan.tensorSplit;
+  // Batched execution appends the batch rank to Mbar, see librettPlan_t::setupBatch()
+  LaunchConfig& lc = batched ? plan.batchLaunchConfig : plan.launchConfig;
+  TensorSplit ts = plan.tensorSplit;
+  if (batched) {
+    ts.sizeMbar++;
+    ts.volMbar *= plan.batchCount;
+  }
+
+  MbarArg<int> Mbar;
+  MbarArg<long long int> Mbar64;
+  MmkArg<int> Mmk;
+  MmkArg<long long int> Mmk64;
+  MshArg Msh;
+  if (ts.method != Trivial) {
+    if (plan.index64) {
+      if (batched) setDescArg(Mbar64, plan.hostMbarBatch64, plan.MbarBatch64);
+      else setDescArg(Mbar64, plan.hostMbar64, plan.Mbar64);
+    } else {
+      if (batched) setDescArg(Mbar, plan.hostMbarBatch, plan.MbarBatch);
+      else setDescArg(Mbar, plan.hostMbar, plan.Mbar);
+    }
+  }
+  // Batches of pointers, see librettPlan_t::setupBatchPointers()
+  BatchArg<int> batch = {nullptr, 0, 1};
+  BatchArg<long long int> batch64 = {nullptr, 0, 1};
+  if (batched && plan.batchPointers) {
+    batch = {plan.batchData, (int)plan.batchCount, (int)plan.tensorSplit.volMbar};
+    batch64 = {plan.batchData, plan.batchCount, plan.tensorSplit.volMbar};
+  }
+  if (ts.method == Packed || ts.method == PackedSplit) {
+    if (plan.index64) setDescArg(Mmk64, plan.hostMmk64, plan.Mmk64);
+    else setDescArg(Mmk, plan.hostMmk, plan.Mmk);
+    setDescArg(Msh, plan.hostMsh, plan.Msh);
+  }
+
+  // Store stage, see Store.h. Elements of 1 and 2 bytes are only copied
+  const int mode = (plan.typeIn != -1) ? StoreModeConvert :
+    ((plan.sizeofType < 4) ? StoreModeCopy : storeMode(alpha, beta));
+
+  // Packed word accesses of 1 and 2 byte elements, stores only for copies
+  bool wordIn = false;
+  bool wordOut = false;
+  if (plan.sizeofType < 4 && (ts.method == Tiled || ts.method == Packed || ts.method == PackedSplit)) {
+    if (plan.index64) {
+      const std::vector<TensorConvInOut64>& hostMbar = batched ? plan.hostMbarBatch64 : plan.hostMbar64;
+      wordIn = wordAligned(plan, hostMbar, plan.hostMmk64, 0, dataIn, batched);
+      wordOut = (mode == StoreModeCopy) && wordAligned(plan, hostMbar, plan.hostMmk64, 1, dataOut, batched);
+    } else {
+      const std::vector<TensorConvInOut>& hostMbar = batched ? plan.hostMbarBatch : plan.hostMbar;
+      wordIn = wordAligned(plan, hostMbar, plan.hostMmk, 0, dataIn, batched);
+      wordOut = (mode == StoreModeCopy) && wordAligned(plan, hostMbar, plan.hostMmk, 1, dataOut, batched);
+    }
+  }
+
+  // Converting plans: calls CALLC(ARG, TYPE, STORE) with the input element type and the
+  // converting store
+  #define CONVERT(CALLC, ARG) \
+    if (plan.typeIn == LIBRETT_FLOAT64) { CALLC(ARG, double, StoreConvert<float>); } \
+    if (plan.typeIn == LIBRETT_FLOAT16) { CALLC(ARG, Half, StoreConvert<float>); } \
+    if (plan.typeIn == LIBRETT_BFLOAT16) { CALLC(ARG, BFloat16, StoreConvert<float>); } \
+    if (plan.typeIn == LIBRETT_FLOAT32) { \
+      if (plan.typeOut == LIBRETT_FLOAT64) { CALLC(ARG, float, StoreConvert<double>); } \
+      if (plan.typeOut == LIBRETT_FLOAT16) { CALLC(ARG, float, StoreConvert<Half>); } \
+      if (plan.typeOut == LIBRETT_BFLOAT16) { CALLC(ARG, float, StoreConvert<BFloat16>); } \
+    }
 
   switch(ts.method) {
     case Trivial:
+    if (mode == StoreModeCopy)
     {
 #if SYCL
-      plan.stream->memcpy(dataOut, dataIn, ts.volMmk * ts.volMbar * plan.sizeofType);
+      stream->memcpy(dataOut, dataIn, ts.volMmk * ts.volMbar * plan.sizeofType);
 #elif HIP
       hipCheck(hipMemcpyAsync(dataOut, dataIn, ts.volMmk*ts.volMbar*plan.sizeofType,
-        hipMemcpyDefault, plan.stream));
+        hipMemcpyDefault, stream));
+#elif LIBRETT_USES_CPU
+      memcpy(dataOut, dataIn, (size_t)ts.volMmk*ts.volMbar*plan.sizeofType);
 #else // CUDA
       cudaCheck(cudaMemcpyAsync(dataOut, dataIn, ts.volMmk*ts.volMbar*plan.sizeofType,
-        cudaMemcpyDefault, plan.stream));
+        cudaMemcpyDefault, stream));
 #endif
+    } else {
+      const long long int vol = ts.volMmk*ts.volMbar;
+      const int nblock = (int)std::min<long long int>(TRIVIAL_MAXBLOCK, (vol - 1)/TRIVIAL_NUMTHREAD + 1);
+      #if SYCL
+        #define CALL1(TYPE, INDEX, STORE)                                         \
+        stream->submit([&](sycl::handler &cgh) {                             \
+          auto vol_ct0 = (INDEX)vol;                                              \
+          auto dataIn_ct1 = (TYPE *)dataIn;                                       \
+          auto dataOut_ct2 = (STORE::OutType *)dataOut;                                     \
+          auto store_ct3 = STORE(alpha, beta);                                    \
+                                                                                  \
+          cgh.parallel_for(                                                       \
+              sycl::nd_range<3>(sycl::range<3>(1, 1, nblock*TRIVIAL_NUMTHREAD),   \
+                                sycl::range<3>(1, 1, TRIVIAL_NUMTHREAD)),         \
+              [=](sycl::nd_item<3> item) { \
+                transposeTrivial<TYPE, INDEX, STORE>(                             \
+                    vol_ct0, dataIn_ct1, dataOut_ct2, store_ct3, item);           \
+              });                                                                 \
+        }); stream->wait();
+      #elif LIBRETT_USES_CPU
+        #define CALL1(TYPE, INDEX, STORE)                                                                      \
+        Librett::simt::launch(dim3(nblock), dim3(TRIVIAL_NUMTHREAD), 0, transposeTrivial<TYPE, INDEX, STORE>,  \
+            (INDEX)vol, (TYPE *)dataIn, (STORE::OutType *)dataOut, STORE(alpha, beta))
+      #else // CUDA or HIP
+        #define CALL1(TYPE, INDEX, STORE)                                                                      \
+        transposeTrivial<TYPE, INDEX, STORE> <<< nblock, TRIVIAL_NUMTHREAD, 0, stream >>>                 \
+            ((INDEX)vol, (TYPE *)dataIn, (STORE::OutType *)dataOut, STORE(alpha, beta))
+      #endif
+      #define CALL0(TYPE, STORE) \
+        if (plan.index64) { CALL1(TYPE, long long int, STORE); } else { CALL1(TYPE, int, STORE); }
+      #define CALL(TYPE) \
+        if (mode == StoreModeScale) { CALL0(TYPE, StoreScale<TYPE>); } else { CALL0(TYPE, StoreAxpby<TYPE>); }
+      #define CALLC(UNUSED, TYPE, STORE) CALL0(TYPE, STORE)
+      if (mode == StoreModeConvert) {
+        CONVERT(CALLC, 0)
+      } else {
+        if (plan.sizeofType == 4) { CALL(float); }
+        if (plan.sizeofType == 8) { CALL(double); }
+        if (plan.sizeofType == 16) { CALL(librett_complex); }
+      }
+      #undef CALLC
+      #undef CALL
+      #undef CALL0
+      #undef CALL1
     }
     break;
 
@@ -1067,48 +1630,71 @@ bool librettKernel(librettPlan_t &plan, void *dataIn, void *dataOut)
     {
       switch(lc.numRegStorage) {
         #if SYCL
-        #define CALL0(TYPE, NREG)                                       \
-        {auto event = plan.stream->submit([&](sycl::handler &cgh) {     \
+        #define CALL1(TYPE, NREG, INDEX, MMK, MBAR, BATCH, STORE)             \
+        {auto event = stream->submit([&](sycl::handler &cgh) {     \
           sycl::local_accessor<uint8_t, 1>                              \
             dpct_local_acc_ct1(sycl::range<1>(lc.shmemsize), cgh);      \
                                                                         \
-          auto ts_volMmk_ct0 = ts.volMmk;                               \
-          auto ts_volMbar_ct1 = ts.volMbar;                             \
+          auto ts_volMmk_ct0 = (int)ts.volMmk;                          \
+          auto ts_volMbar_ct1 = (INDEX)ts.volMbar;                      \
           auto ts_sizeMmk_ct2 = ts.sizeMmk;                             \
           auto ts_sizeMbar_ct3 = ts.sizeMbar;                           \
-          auto plan_Mmk_ct4 = plan.Mmk;                                 \
-          auto plan_Mbar_ct5 = plan.Mbar;                               \
-          auto plan_Msh_ct6 = plan.Msh;                                 \
+          auto plan_Mmk_ct4 = MMK;                                      \
+          auto plan_Mbar_ct5 = MBAR;                                    \
+          auto plan_Msh_ct6 = Msh;                                 \
+          auto batch_ct = BATCH;                                        \
           auto dataIn_ct7 = (TYPE *)dataIn;                             \
-          auto dataOut_ct8 = (TYPE *)dataOut;                           \
+          auto dataOut_ct8 = (STORE::OutType *)dataOut;                           \
+          auto store_ct9 = STORE(alpha, beta);                          \
                                                                         \
           cgh.parallel_for(                                             \
             sycl::nd_range<3>(lc.numblock * lc.numthread, lc.numthread), \
             [=](sycl::nd_item<3> item) { \
-              transposePacked<TYPE, NREG>(                              \
+              transposePacked<TYPE, NREG, INDEX, STORE>(                \
                 ts_volMmk_ct0, ts_volMbar_ct1, ts_sizeMmk_ct2, ts_sizeMbar_ct3, \
-                plan_Mmk_ct4, plan_Mbar_ct5, plan_Msh_ct6, dataIn_ct7,  \
-                dataOut_ct8, item, dpct_local_acc_ct1.get_pointer());   \
+                plan_Mmk_ct4, plan_Mbar_ct5, plan_Msh_ct6, batch_ct, wordIn, wordOut, dataIn_ct7, \
+                dataOut_ct8, store_ct9, item, dpct_local_acc_ct1.get_pointer()); \
             });                                                         \
         });                                                             \
           event.wait();                                                 \
         }
+        #elif LIBRETT_USES_CPU
+          #define CALL1(TYPE, NREG, INDEX, MMK, MBAR, BATCH, STORE)                                            \
+          Librett::simt::launch(lc.numblock, lc.numthread, lc.shmemsize,                               \
+              transposePacked<TYPE, NREG, INDEX, STORE>,                                               \
+              (int)ts.volMmk, (INDEX)ts.volMbar, ts.sizeMmk, ts.sizeMbar,                                  \
+              MMK, MBAR, Msh, BATCH, wordIn, wordOut, (TYPE *)dataIn, (STORE::OutType *)dataOut, STORE(alpha, beta))
         #else // CUDA or HIP
-          #define CALL0(TYPE, NREG)                                                                \
-          transposePacked<TYPE, NREG> <<< lc.numblock, lc.numthread, lc.shmemsize, plan.stream >>> \
-              (ts.volMmk, ts.volMbar, ts.sizeMmk, ts.sizeMbar,                                     \
-              plan.Mmk, plan.Mbar, plan.Msh, (TYPE *)dataIn, (TYPE *)dataOut)
+          #define CALL1(TYPE, NREG, INDEX, MMK, MBAR, BATCH, STORE)                                              \
+          transposePacked<TYPE, NREG, INDEX, STORE>                                                        \
+              <<< lc.numblock, lc.numthread, lc.shmemsize, stream >>>                                 \
+              ((int)ts.volMmk, (INDEX)ts.volMbar, ts.sizeMmk, ts.sizeMbar,                                 \
+              MMK, MBAR, Msh, BATCH, wordIn, wordOut, (TYPE *)dataIn, (STORE::OutType *)dataOut, STORE(alpha, beta))
         #endif // SYCL
-
-        #define CALL(ICASE) case ICASE: if (plan.sizeofType == 4) CALL0(float,  ICASE); \
-	                                if (plan.sizeofType == 8) CALL0(double, ICASE); \
-                                        if (plan.sizeofType == 16) CALL0(librett_complex,ICASE); break;
+        #define CALL0(TYPE, NREG, STORE)                                                     \
+          if (plan.index64) { CALL1(TYPE, NREG, long long int, Mmk64, Mbar64, batch64, STORE); } \
+          else { CALL1(TYPE, NREG, int, Mmk, Mbar, batch, STORE); }
+        #define CALLS(TYPE, NREG)                                                                  \
+          if (mode == StoreModeCopy) { CALL0(TYPE, NREG, StoreCopy<TYPE>); }                       \
+          else if (mode == StoreModeScale) { CALL0(TYPE, NREG, StoreScale<TYPE>); }                \
+          else { CALL0(TYPE, NREG, StoreAxpby<TYPE>); }
+
+        #define CALLC(NREG, TYPE, STORE) CALL0(TYPE, NREG, STORE)
+        #define CALL(ICASE) case ICASE: if (mode == StoreModeConvert) { CONVERT(CALLC, ICASE) break; } \
+                                        if (plan.sizeofType == 1) { CALL0(uint8_t,  ICASE, StoreCopy<uint8_t>); } \
+                                        if (plan.sizeofType == 2) { CALL0(uint16_t, ICASE, StoreCopy<uint16_t>); } \
+                                        if (plan.sizeofType == 4) { CALLS(float,  ICASE); } \
+	                                if (plan.sizeofType == 8) { CALLS(double, ICASE); } \
+                                        if (plan.sizeofType == 16) { CALLS(librett_complex,ICASE); } break;
         #include "calls.h"
         default:
         printf("librettKernel no template implemented for numRegStorage %d\n", lc.numRegStorage);
         return false;
         #undef CALL
+        #undef CALLC
+        #undef CALLS
         #undef CALL0
+        #undef CALL1
       }
 
     }
@@ -1118,50 +1704,75 @@ bool librettKernel(librettPlan_t &plan, void *dataIn, void *dataOut)
     {
       switch(lc.numRegStorage) {
         #if SYCL
-          #define CALL0(TYPE, NREG)                                                 \
-          plan.stream->submit([&](sycl::handler &cgh) {                             \
+          #define CALL1(TYPE, NREG, INDEX, MMK, MBAR, BATCH, STORE)                       \
+          stream->submit([&](sycl::handler &cgh) {                             \
             sycl::local_accessor<uint8_t, 1>                                        \
                 dpct_local_acc_ct1(sycl::range<1>(lc.shmemsize), cgh);              \
                                                                                     \
             auto ts_splitDim_ct0 = ts.splitDim;                                     \
             auto ts_volMmkUnsplit_ct1 = ts.volMmkUnsplit;                           \
-            auto ts_volMbar_ct2 = ts.volMbar;                                       \
+            auto ts_volMbar_ct2 = (INDEX)ts.volMbar;                                \
             auto ts_sizeMmk_ct3 = ts.sizeMmk;                                       \
             auto ts_sizeMbar_ct4 = ts.sizeMbar;                                     \
-            auto plan_cuDimMm_ct5 = plan.cuDimMm;                                   \
-            auto plan_cuDimMk_ct6 = plan.cuDimMk;                                   \
-            auto plan_Mmk_ct7 = plan.Mmk;                                           \
-            auto plan_Mbar_ct8 = plan.Mbar;                                         \
-            auto plan_Msh_ct9 = plan.Msh;                                           \
+            auto plan_cuDimMm_ct5 = (INDEX)plan.cuDimMm;                            \
+            auto plan_cuDimMk_ct6 = (INDEX)plan.cuDimMk;                            \
+            auto plan_Mmk_ct7 = MMK;                                                \
+            auto plan_Mbar_ct8 = MBAR;                                              \
+            auto plan_Msh_ct9 = Msh;                                           \
+            auto batch_ct = BATCH;                                                  \
             auto dataIn_ct10 = (TYPE *)dataIn;                                      \
-            auto dataOut_ct11 = (TYPE *)dataOut;                                    \
+            auto dataOut_ct11 = (STORE::OutType *)dataOut;                                    \
+            auto store_ct12 = STORE(alpha, beta);                                   \
                                                                                     \
             cgh.parallel_for(                                                       \
                 sycl::nd_range<3>(lc.numblock * lc.numthread, lc.numthread),        \
                 [=](sycl::nd_item<3> item) { \
-                  transposePackedSplit<TYPE, NREG>(                                 \
+                  transposePackedSplit<TYPE, NREG, INDEX, STORE>(                   \
                       ts_splitDim_ct0, ts_volMmkUnsplit_ct1, ts_volMbar_ct2,        \
                       ts_sizeMmk_ct3, ts_sizeMbar_ct4, plan_cuDimMm_ct5,            \
                       plan_cuDimMk_ct6, plan_Mmk_ct7, plan_Mbar_ct8, plan_Msh_ct9,  \
-                      dataIn_ct10, dataOut_ct11, item,                          \
+                      batch_ct, wordIn, wordOut, dataIn_ct10, dataOut_ct11, store_ct12, item, \
                       dpct_local_acc_ct1.get_pointer());                            \
                 });                                                                 \
-          }); plan.stream->wait();
+          }); stream->wait();
+        #elif LIBRETT_USES_CPU
+          #define CALL1(TYPE, NREG, INDEX, MMK, MBAR, BATCH, STORE)                                                 \
+          Librett::simt::launch(lc.numblock, lc.numthread, lc.shmemsize,                                    \
+              transposePackedSplit<TYPE, NREG, INDEX, STORE>,                                               \
+              ts.splitDim, ts.volMmkUnsplit, (INDEX)ts.volMbar, ts.sizeMmk, ts.sizeMbar,                      \
+              (INDEX)plan.cuDimMm, (INDEX)plan.cuDimMk, MMK, MBAR, Msh, BATCH, wordIn, wordOut, (TYPE *)dataIn, (STORE::OutType *)dataOut, \
+              STORE(alpha, beta))
         #else // CUDA or HIP
-          #define CALL0(TYPE, NREG)                                                                     \
-          transposePackedSplit<TYPE, NREG> <<< lc.numblock, lc.numthread, lc.shmemsize, plan.stream >>> \
-              (ts.splitDim, ts.volMmkUnsplit, ts. volMbar, ts.sizeMmk, ts.sizeMbar,                     \
-              plan.cuDimMm, plan.cuDimMk, plan.Mmk, plan.Mbar, plan.Msh, (TYPE *)dataIn, (TYPE *)dataOut)
+          #define CALL1(TYPE, NREG, INDEX, MMK, MBAR, BATCH, STORE)                                                   \
+          transposePackedSplit<TYPE, NREG, INDEX, STORE>                                                        \
+              <<< lc.numblock, lc.numthread, lc.shmemsize, stream >>>                                      \
+              (ts.splitDim, ts.volMmkUnsplit, (INDEX)ts.volMbar, ts.sizeMmk, ts.sizeMbar,                      \
+              (INDEX)plan.cuDimMm, (INDEX)plan.cuDimMk, MMK, MBAR, Msh, BATCH, wordIn, wordOut, (TYPE *)dataIn, (STORE::OutType *)dataOut, \
+              STORE(alpha, beta))
         #endif
-        #define CALL(ICASE) case ICASE: if (plan.sizeofType == 4) CALL0(float,  ICASE); \
-	                                if (plan.sizeofType == 8) CALL0(double, ICASE); \
-                                        if (plan.sizeofType == 16) CALL0(librett_complex, ICASE); break;
+        #define CALL0(TYPE, NREG, STORE)                                                     \
+          if (plan.index64) { CALL1(TYPE, NREG, long long int, Mmk64, Mbar64, batch64, STORE); } \
+          else { CALL1(TYPE, NREG, int, Mmk, Mbar, batch, STORE); }
+        #define CALLS(TYPE, NREG)                                                                  \
+          if (mode == StoreModeCopy) { CALL0(TYPE, NREG, StoreCopy<TYPE>); }                       \
+          else if (mode == StoreModeScale) { CALL0(TYPE, NREG, StoreScale<TYPE>); }                \
+          else { CALL0(TYPE, NREG, StoreAxpby<TYPE>); }
+        #define CALLC(NREG, TYPE, STORE) CALL0(TYPE, NREG, STORE)
+        #define CALL(ICASE) case ICASE: if (mode == StoreModeConvert) { CONVERT(CALLC, ICASE) break; } \
+                                        if (plan.sizeofType == 1) { CALL0(uint8_t,  ICASE, StoreCopy<uint8_t>); } \
+                                        if (plan.sizeofType == 2) { CALL0(uint16_t, ICASE, StoreCopy<uint16_t>); } \
+                                        if (plan.sizeofType == 4) { CALLS(float,  ICASE); } \
+	                                if (plan.sizeofType == 8) { CALLS(double, ICASE); } \
+                                        if (plan.sizeofType == 16) { CALLS(librett_complex, ICASE); } break;
         #include "calls.h"
         default:
         printf("librettKernel no template implemented for numRegStorage %d\n", lc.numRegStorage);
         return false;
         #undef CALL
+        #undef CALLC
+        #undef CALLS
         #undef CALL0
+        #undef CALL1
       }
 
     }
@@ -1170,84 +1781,329 @@ bool librettKernel(librettPlan_t &plan, void *dataIn, void *dataOut)
     case Tiled:
     {
       #if SYCL
-        #define CALL(TYPE)                                                        \
-        plan.stream->submit([&](sycl::handler &cgh) {                             \
+        #define CALL1(TYPE, INDEX, MBAR, BATCH, STORE)                                  \
+        stream->submit([&](sycl::handler &cgh) {                             \
                                                                                   \
           auto ts_volMm_TILEDIM_ct0 = ((ts.volMm - 1) / TILEDIM + 1);             \
-          auto ts_volMbar_ct1 = ts.volMbar;                                       \
+          auto ts_volMbar_ct1 = (INDEX)ts.volMbar;                                \
           auto ts_sizeMbar_ct2 = ts.sizeMbar;                                     \
           auto plan_tiledVol_ct3 = plan.tiledVol;                                 \
-          auto plan_cuDimMk_ct4 = plan.cuDimMk;                                   \
-          auto plan_cuDimMm_ct5 = plan.cuDimMm;                                   \
-          auto plan_Mbar_ct6 = plan.Mbar;                                         \
+          auto plan_cuDimMk_ct4 = (INDEX)plan.cuDimMk;                            \
+          auto plan_cuDimMm_ct5 = (INDEX)plan.cuDimMm;                            \
+          auto plan_Mbar_ct6 = MBAR;                                              \
+          auto batch_ct = BATCH;                                                  \
           auto dataIn_ct7 = (TYPE *)dataIn;                                       \
-          auto dataOut_ct8 = (TYPE *)dataOut;                                     \
+          auto dataOut_ct8 = (STORE::OutType *)dataOut;                                     \
+          auto store_ct9 = STORE(alpha, beta);                                    \
                                                                                   \
           cgh.parallel_for(                                                       \
               sycl::nd_range<3>(lc.numblock * lc.numthread, lc.numthread),        \
               [=](sycl::nd_item<3> item) { \
-                transposeTiled<TYPE>(                                             \
+                transposeTiled<TYPE, INDEX, STORE>(                               \
                     ts_volMm_TILEDIM_ct0, ts_volMbar_ct1, ts_sizeMbar_ct2,        \
                     plan_tiledVol_ct3, plan_cuDimMk_ct4, plan_cuDimMm_ct5, \
-                    plan_Mbar_ct6, dataIn_ct7, dataOut_ct8, item);      \
+                    plan_Mbar_ct6, batch_ct, wordIn, wordOut, dataIn_ct7, dataOut_ct8, store_ct9, item); \
               });                                                       \
-        }); plan.stream->wait();
+        }); stream->wait();
+      #elif LIBRETT_USES_CPU
+        #define CALL1(TYPE, INDEX, MBAR, BATCH, STORE)                                                               \
+        Librett::simt::launch(lc.numblock, lc.numthread, 0, transposeTiled<TYPE, INDEX, STORE>,                \
+            ((ts.volMm - 1)/TILEDIM + 1), (INDEX)ts.volMbar, ts.sizeMbar, plan.tiledVol,                       \
+            (INDEX)plan.cuDimMk, (INDEX)plan.cuDimMm, MBAR, BATCH, wordIn, wordOut, (TYPE *)dataIn, (STORE::OutType *)dataOut, STORE(alpha, beta))
       #else // CUDA or HIP
-        #define CALL(TYPE)                                                                                     \
-        transposeTiled<TYPE> <<< lc.numblock, lc.numthread, 0, plan.stream >>>                                 \
-            (((ts.volMm - 1)/TILEDIM + 1), ts.volMbar, ts.sizeMbar, plan.tiledVol, plan.cuDimMk, plan.cuDimMm, \
-            plan.Mbar, (TYPE *)dataIn, (TYPE *)dataOut)
+        #define CALL1(TYPE, INDEX, MBAR, BATCH, STORE)                                                               \
+        transposeTiled<TYPE, INDEX, STORE> <<< lc.numblock, lc.numthread, 0, stream >>>                   \
+            (((ts.volMm - 1)/TILEDIM + 1), (INDEX)ts.volMbar, ts.sizeMbar, plan.tiledVol,                      \
+            (INDEX)plan.cuDimMk, (INDEX)plan.cuDimMm, MBAR, BATCH, wordIn, wordOut, (TYPE *)dataIn, (STORE::OutType *)dataOut, STORE(alpha, beta))
       #endif
-      if (plan.sizeofType == 4) CALL(float);
-      if (plan.sizeofType == 8) CALL(double);
-      if (plan.sizeofType == 16) CALL(librett_complex);
+      #define CALL0(TYPE, STORE) \
+        if (plan.index64) { CALL1(TYPE, long long int, Mbar64, batch64, STORE); } else { CALL1(TYPE, int, Mbar, batch, STORE); }
+      #define CALL(TYPE) \
+        if (mode == StoreModeCopy) { CALL0(TYPE, StoreCopy<TYPE>); } \
+        else if (mode == StoreModeScale) { CALL0(TYPE, StoreScale<TYPE>); } \
+        else { CALL0(TYPE, StoreAxpby<TYPE>); }
+      #define CALLC(UNUSED, TYPE, STORE) CALL0(TYPE, STORE)
+      if (mode == StoreModeConvert) {
+        CONVERT(CALLC, 0)
+      } else {
+        if (plan.sizeofType == 1) { CALL0(uint8_t, StoreCopy<uint8_t>); }
+        if (plan.sizeofType == 2) { CALL0(uint16_t, StoreCopy<uint16_t>); }
+        if (plan.sizeofType == 4) { CALL(float); }
+        if (plan.sizeofType == 8) { CALL(double); }
+        if (plan.sizeofType == 16) { CALL(librett_complex); }
+      }
+      #undef CALLC
       #undef CALL
+      #undef CALL0
+      #undef CALL1
     }
     break;
 
     case TiledCopy:
     {
       #if SYCL
-        #define CALL(TYPE)                                                           \
-        plan.stream->submit([&](sycl::handler &cgh) {                                \
+        #define CALL1(TYPE, INDEX, MBAR, BATCH, STORE)                                     \
+        stream->submit([&](sycl::handler &cgh) {                                \
           auto ts_volMm_TILEDIM_ct0 = ((ts.volMm - 1) / TILEDIM + 1);                \
-          auto ts_volMbar_ct1 = ts.volMbar;                                          \
+          auto ts_volMbar_ct1 = (INDEX)ts.volMbar;                                   \
           auto ts_sizeMbar_ct2 = ts.sizeMbar;                                        \
-          auto plan_cuDimMk_ct3 = plan.cuDimMk;                                      \
-          auto plan_cuDimMm_ct4 = plan.cuDimMm;                                      \
+          auto plan_cuDimMk_ct3 = (INDEX)plan.cuDimMk;                               \
+          auto plan_cuDimMm_ct4 = (INDEX)plan.cuDimMm;                               \
           auto plan_tiledVol_ct5 = plan.tiledVol;                                    \
-          auto plan_Mbar_ct6 = plan.Mbar;                                            \
+          auto plan_Mbar_ct6 = MBAR;                                                 \
+          auto batch_ct = BATCH;                                                     \
           auto dataIn_ct7 = (TYPE *)dataIn;                                          \
-          auto dataOut_ct8 = (TYPE *)dataOut;                                        \
+          auto dataOut_ct8 = (STORE::OutType *)dataOut;                                        \
+          auto store_ct9 = STORE(alpha, beta);                                       \
                                                                                      \
           cgh.parallel_for(                                                          \
               sycl::nd_range<3>(lc.numblock * lc.numthread, lc.numthread),           \
               [=](sycl::nd_item<3> item) {    \
-                transposeTiledCopy<TYPE>(                                            \
+                transposeTiledCopy<TYPE, INDEX, STORE>(                              \
                     ts_volMm_TILEDIM_ct0, ts_volMbar_ct1, ts_sizeMbar_ct2,           \
                     plan_cuDimMk_ct3, plan_cuDimMm_ct4, plan_tiledVol_ct5,           \
-                    plan_Mbar_ct6, dataIn_ct7, dataOut_ct8, item);               \
+                    plan_Mbar_ct6, batch_ct, dataIn_ct7, dataOut_ct8, store_ct9, item);    \
               });                                                                    \
-        }); plan.stream->wait();
+        }); stream->wait();
+      #elif LIBRETT_USES_CPU
+        #define CALL1(TYPE, INDEX, MBAR, BATCH, STORE)                                                               \
+        Librett::simt::launch(lc.numblock, lc.numthread, 0, transposeTiledCopy<TYPE, INDEX, STORE>,            \
+            ((ts.volMm - 1)/TILEDIM + 1), (INDEX)ts.volMbar, ts.sizeMbar,                                      \
+            (INDEX)plan.cuDimMk, (INDEX)plan.cuDimMm, plan.tiledVol, MBAR, BATCH, (TYPE *)dataIn, (STORE::OutType *)dataOut,    \
+            STORE(alpha, beta))
       #else // CUDA or HIP
-        #define CALL(TYPE)                                                                                     \
-        transposeTiledCopy<TYPE> <<< lc.numblock, lc.numthread, 0, plan.stream >>>                             \
-            (((ts.volMm - 1)/TILEDIM + 1), ts.volMbar, ts.sizeMbar, plan.cuDimMk, plan.cuDimMm, plan.tiledVol, \
-            plan.Mbar, (TYPE *)dataIn, (TYPE *)dataOut)
+        #define CALL1(TYPE, INDEX, MBAR, BATCH, STORE)                                                               \
+        transposeTiledCopy<TYPE, INDEX, STORE> <<< lc.numblock, lc.numthread, 0, stream >>>               \
+            (((ts.volMm - 1)/TILEDIM + 1), (INDEX)ts.volMbar, ts.sizeMbar,                                     \
+            (INDEX)plan.cuDimMk, (INDEX)plan.cuDimMm, plan.tiledVol, MBAR, BATCH, (TYPE *)dataIn, (STORE::OutType *)dataOut,    \
+            STORE(alpha, beta))
       #endif
-      if (plan.sizeofType == 4) CALL(float);
-      if (plan.sizeofType == 8) CALL(double);
-      if (plan.sizeofType == 16) CALL(librett_complex);
+      #define CALL0(TYPE, STORE) \
+        if (plan.index64) { CALL1(TYPE, long long int, Mbar64, batch64, STORE); } else { CALL1(TYPE, int, Mbar, batch, STORE); }
+      #define CALL(TYPE) \
+        if (mode == StoreModeCopy) { CALL0(TYPE, StoreCopy<TYPE>); } \
+        else if (mode == StoreModeScale) { CALL0(TYPE, StoreScale<TYPE>); } \
+        else { CALL0(TYPE, StoreAxpby<TYPE>); }
+      #define CALLC(UNUSED, TYPE, STORE) CALL0(TYPE, STORE)
+      if (mode == StoreModeConvert) {
+        CONVERT(CALLC, 0)
+      } else {
+        if (plan.sizeofType == 1) { CALL0(uint8_t, StoreCopy<uint8_t>); }
+        if (plan.sizeofType == 2) { CALL0(uint16_t, StoreCopy<uint16_t>); }
+        if (plan.sizeofType == 4) { CALL(float); }
+        if (plan.sizeofType == 8) { CALL(double); }
+        if (plan.sizeofType == 16) { CALL(librett_complex); }
+      }
+      #undef CALLC
       #undef CALL
+      #undef CALL0
+      #undef CALL1
     }
     break;
 
   }
 
+  #undef CONVERT
+
 #if LIBRETT_USES_CUDA
   cudaCheck(cudaGetLastError());
 #elif HIP
   hipCheck(hipGetLastError());
 #endif
+  if (!batched) orderDescriptorFree(plan, stream);
+  return true;
+}
+
+//
+// Descriptor table and queue counter of grouped launches on one device, kept and grown
+// between calls. Grouped launches are serialised by the plan setup lock of librett.cpp,
+// a table that is reused on another stream waits for the launch on the previous stream
+//
+struct GroupedState {
+  std::vector<char> hostTable;
+  char* table = nullptr;
+  size_t tableSize = 0;
+  int* queue = nullptr;
+  gpuStream_t stream;
+};
+static std::map<int, GroupedState> groupedStates;
+
+//
+// Builds the packed descriptor table of a grouped launch: count GroupedTask<Index> entries
+// followed by the Mbar descriptors of all tensors. Returns the byte offset of the Mbar part
+//
+template <typename Index>
+static size_t buildGroupedTable(const int count, librettPlan_t* const* plans, void* const* dataIn,
+  void* const* dataOut, const int* workStart, std::vector<char>& table) {
+
+  size_t sizeMbar = 0;
+  for (int i=0;i < count;i++) sizeMbar += plans[i]->hostMbarGrouped.size();
+  const size_t offsetMbar = ((count*sizeof(GroupedTask<Index>) - 1)/16 + 1)*16;
+  table.resize(offsetMbar + sizeMbar*sizeof(TensorConvInOutT<Index>));
+  GroupedTask<Index>* task = (GroupedTask<Index> *)table.data();
+  TensorConvInOutT<Index>* Mbar = (TensorConvInOutT<Index> *)(table.data() + offsetMbar);
+
+  int iMbar = 0;
+  for (int i=0;i < count;i++) {
+    const librettPlan_t& plan = *plans[i];
+    task[i].dataIn = dataIn[i];
+    task[i].dataOut = dataOut[i];
+    task[i].volMbar = (Index)plan.groupedVolMbar;
+    task[i].cuDimMk = (Index)plan.groupedCuDimMk;
+    task[i].cuDimMm = (Index)plan.groupedCuDimMm;
+    task[i].workStart = workStart[i];
+    task[i].numMm = (plan.groupedVolX - 1)/TILEDIM + 1;
+    task[i].numTile = task[i].numMm*((plan.groupedVolY - 1)/TILEDIM + 1);
+    task[i].volX = plan.groupedVolX;
+    task[i].volY = plan.groupedVolY;
+    task[i].sizeMbar = plan.hostMbarGrouped.size();
+    task[i].offsetMbar = iMbar;
+    task[i].copy = (plan.groupedMethod == TiledCopy);
+    for (const TensorConvInOut64& conv : plan.hostMbarGrouped) {
+      Mbar[iMbar].c_in   = (Index)conv.c_in;
+      Mbar[iMbar].d_in   = (Index)conv.d_in;
+      Mbar[iMbar].ct_in  = (Index)conv.ct_in;
+      Mbar[iMbar].c_out  = (Index)conv.c_out;
+      Mbar[iMbar].d_out  = (Index)conv.d_out;
+      Mbar[iMbar].ct_out = (Index)conv.ct_out;
+      iMbar++;
+    }
+  }
+
+  return offsetMbar;
+}
+
+//
+// Launches transposeGrouped() on count tensors whose work units start at workStart[]
+//
+static bool launchGrouped(const int count, librettPlan_t* const* plans, void* const* dataIn,
+  void* const* dataOut, const int* workStart, const int numWork, const gpuDeviceProp_t& prop) {
+
+  // All plans are on the device of the first plan, see librettExecuteGrouped()
+  GroupedState& state = groupedStates[plans[0]->deviceID];
+  gpuStream_t stream = plans[0]->stream;
+  const size_t sizeofType = plans[0]->sizeofType;
+  bool index64 = false;
+  for (int i=0;i < count;i++) index64 = index64 || plans[i]->index64;
+
+  const size_t offsetMbar = index64 ?
+    buildGroupedTable<long long int>(count, plans, dataIn, dataOut, workStart, state.hostTable) :
+    buildGroupedTable<int>(count, plans, dataIn, dataOut, workStart, state.hostTable);
+
+  if (state.queue != nullptr && state.stream != stream) {
+#if SYCL
+    state.stream->wait();
+#elif HIP
+    hipCheck(hipStreamSynchronize(state.stream));
+#elif LIBRETT_USES_CUDA
+    cudaCheck(cudaStreamSynchronize(state.stream));
+#endif
+  }
+  if (state.hostTable.size() > state.tableSize) {
+    if (state.table != nullptr) deallocate_device<char>(&state.table, state.stream);
+    allocate_device<char>(&state.table, state.hostTable.size(), stream);
+    state.tableSize = state.hostTable.size();
+  }
+  if (state.queue == nullptr) allocate_device<int>(&state.queue, 1, stream);
+  state.stream = stream;
+
+  copy_HtoD<char>(state.hostTable.data(), state.table, state.hostTable.size(), stream);
+  set_device_array<int>(state.queue, 0, 1, stream);
+
+  LaunchConfig lc;
+  lc.numthread_x = TILEDIM;
+  lc.numthread_y = TILEROWS;
+  lc.numthread_z = 1;
+  lc.numblock_x = std::min(gpuMultiProcessorCount*8, (numWork - 1)/GROUPED_CHUNK + 1);
+  lc.numblock_y = 1;
+  lc.numblock_z = 1;
+
+  #if SYCL
+    #define CALL1(TYPE, INDEX)                                                    \
+    stream->submit([&](sycl::handler &cgh) {                                      \
+      auto count_ct0 = count;                                                     \
+      auto numWork_ct1 = numWork;                                                 \
+      auto task_ct2 = (GroupedTask<INDEX> *)state.table;                          \
+      auto Mbar_ct3 = (TensorConvInOutT<INDEX> *)(state.table + offsetMbar);      \
+      auto queue_ct4 = state.queue;                                               \
+                                                                                  \
+      cgh.parallel_for(                                                           \
+          sycl::nd_range<3>(lc.numblock * lc.numthread, lc.numthread),            \
+          [=](sycl::nd_item<3> item) {                                            \
+            transposeGrouped<TYPE, INDEX>(count_ct0, numWork_ct1, task_ct2,       \
+                Mbar_ct3, queue_ct4, item);                                       \
+          });                                                                     \
+    }); stream->wait();
+  #elif LIBRETT_USES_CPU
+    #define CALL1(TYPE, INDEX)                                                                      \
+    Librett::simt::launch(lc.numblock, lc.numthread, 0, transposeGrouped<TYPE, INDEX>,              \
+        count, numWork, (GroupedTask<INDEX> *)state.table,                                          \
+        (TensorConvInOutT<INDEX> *)(state.table + offsetMbar), state.queue)
+  #else // CUDA or HIP
+    #define CALL1(TYPE, INDEX)                                                                      \
+    transposeGrouped<TYPE, INDEX> <<< lc.numblock, lc.numthread, 0, stream >>>                      \
+        (count, numWork, (GroupedTask<INDEX> *)state.table,                                         \
+        (TensorConvInOutT<INDEX> *)(state.table + offsetMbar), state.queue)
+  #endif
+  #define CALL(TYPE) \
+    if (index64) { CALL1(TYPE, long long int); } else { CALL1(TYPE, int); }
+  if (sizeofType == 1) CALL(uint8_t);
+  if (sizeofType == 2) CALL(uint16_t);
+  if (sizeofType == 4) CALL(float);
+  if (sizeofType == 8) CALL(double);
+  if (sizeofType == 16) CALL(librett_complex);
+  #undef CALL
+  #undef CALL1
+
+#if LIBRETT_USES_CUDA
+  cudaCheck(cudaGetLastError());
+#elif HIP
+  hipCheck(hipGetLastError());
+#endif
+  return true;
+}
+
+bool librettKernelGrouped(const int count, librettPlan_t* const* plans, void* const* dataIn,
+  void* const* dataOut, const gpuDeviceProp_t& prop)
+{
+  // Tensors are added to the launch until the work units would overflow an int.
+  // A tensor with more than INT_MAX work units runs on its own
+  std::vector<librettPlan_t*> launchPlans;
+  std::vector<void*> launchIn;
+  std::vector<void*> launchOut;
+  std::vector<int> workStart;
+  long long int numWork = 0;
+  for (int i=0;i <= count;i++) {
+    long long int work = 0;
+    if (i < count) {
+      const librettPlan_t& plan = *plans[i];
+      work = (long long int)((plan.groupedVolX - 1)/TILEDIM + 1)*((plan.groupedVolY - 1)/TILEDIM + 1)*
+        plan.groupedVolMbar;
+      if (work > INT_MAX) {
+        if (!librettKernel(*plans[i], plans[i]->stream, dataIn[i], dataOut[i])) return false;
+        continue;
+      }
+    }
+    if (i == count || numWork + work > INT_MAX) {
+      if (launchPlans.size() == 1) {
+        if (!librettKernel(*launchPlans[0], launchPlans[0]->stream, launchIn[0], launchOut[0])) return false;
+      } else if (launchPlans.size() > 1) {
+        if (!launchGrouped(launchPlans.size(), launchPlans.data(), launchIn.data(), launchOut.data(),
+          workStart.data(), (int)numWork, prop)) return false;
+      }
+      launchPlans.clear();
+      launchIn.clear();
+      launchOut.clear();
+      workStart.clear();
+      numWork = 0;
+    }
+    if (i < count) {
+      launchPlans.push_back(plans[i]);
+      launchIn.push_back(dataIn[i]);
+      launchOut.push_back(dataOut[i]);
+      workStart.push_back((int)numWork);
+      numWork += work;
+    }
+  }
   return true;
 }
@@ -28,6 +28,8 @@ SOFTWARE.
 #ifdef SYCL
   #include <sycl/sycl.hpp>
 #endif
+#include <vector>
+#include "DeviceProfile.h"
 #include "plan.h"
 #include "uniapi.h"
 
@@ -36,6 +38,25 @@ void librettKernelSetSharedMemConfig();
 int librettKernelLaunchConfiguration(const int sizeofType, const TensorSplit &ts,
              const int deviceID, const gpuDeviceProp_t &prop, LaunchConfig &lc);
 
-bool librettKernel(librettPlan_t& plan, void* dataIn, void* dataOut);
+// Appends the resources of the kernel instances that getNumActiveBlock() asks about, on the
+// current device. Backends that cannot query them append nothing
+void librettKernelResources(std::vector<KernelResource>& kernels);
+
+// Builds the host data of the kernels of plan, called when the plan is activated.
+// Backends without such data do nothing
+void librettKernelActivate(librettPlan_t& plan);
+
+// Runs the plan on stream: dataOut = alpha*permute(dataIn) + beta*dataOut.
+// beta = 0 does not read dataOut, alpha = 1 and beta = 0 is a plain transpose.
+// batched = true runs the batch set up by librettPlan_t::setupBatch() in one launch,
+// on the stream of the plan
+bool librettKernel(librettPlan_t& plan, gpuStream_t stream, void* dataIn, void* dataOut,
+  const double alpha=1.0, const double beta=0.0, const bool batched=false);
+
+// Runs dataOut[i] = permute(dataIn[i]) with plans[i], i = 0 ... count - 1, in one launch
+// on the stream of plans[0]. The plans have the same sizeofType and a grouped form, see
+// librettPlan_t::setupGrouped()
+bool librettKernelGrouped(const int count, librettPlan_t* const* plans, void* const* dataIn,
+  void* const* dataOut, const gpuDeviceProp_t& prop);
 
 #endif // LIBRETTKERNEL_H
@@ -27,13 +27,35 @@ SOFTWARE.
 #include <unordered_map>
 #include "GpuUtils.h"
 #include "GpuMem.hpp"
+#include "AdaptivePlan.h"
+#include "DescriptorArena.h"
+#include "DeviceProfile.h"
 #include "plan.h"
+#include "PlanTable.h"
 #include "kernel.h"
+#include "InPlace.h"
+#include "LRUCache.h"
+#include "GpuMemcpy.h"
+#include "GpuModel.h"
+#include "ModelProfile.h"
+#include "ThreadPool.h"
 #include "Timer.h"
+#include "Wisdom.h"
 #include "librett.h"
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
 #include <mutex>
+#include <thread>
 #include <cstdlib>
+#include <cstdint>
+#include <climits>
+#include <algorithm>
+#include <memory>
+#include <string>
 // #include <chrono>
 
 // global Umpire allocator
@@ -41,26 +63,60 @@ SOFTWARE.
 umpire::Allocator librett_umpire_allocator;
 #endif
 
-// Hash table to store the plans
-static std::unordered_map<librettHandle, librettPlan_t* > planStorage;
-static std::mutex planStorageMutex;
+// Plans of the handles. Never destroyed, plans may be destroyed after static destructors
+// have run
+static PlanTable& planTable = *new PlanTable();
 
-// Current handle
-static std::atomic<librettHandle> curHandle(0);
+// Grouped execution sets up the grouped table of its plans. Batched execution holds the
+// batchMutex of its plan, the execution of a plan alone needs no lock
+static std::mutex planSetupMutex;
+
+// Plan cache: activated plans of librettPlanModel() keyed by planCacheKey(). The cache is
+// never destroyed, so that cached device descriptors are not freed after the device
+// runtime has shut down at exit. librettFinalize() empties it
+const int PLAN_CACHE_CAPACITY = 256;
+static LRUCache<std::string, std::shared_ptr<librettPlan_t> >& planCache =
+  *new LRUCache<std::string, std::shared_ptr<librettPlan_t> >(PLAN_CACHE_CAPACITY, nullptr);
+static std::atomic<int> planCacheCapacity(PLAN_CACHE_CAPACITY);
+static std::atomic<long long int> planCacheHits(0);
+static std::atomic<long long int> planCacheMisses(0);
+
+// Pool that runs the performance model of plan candidates, nullptr uses ThreadPool::instance()
+static std::shared_ptr<ThreadPool> planPool;
+static std::mutex planPoolMutex;
 
 // Table of devices that have been initialized
 static std::unordered_map<int, gpuDeviceProp_t> deviceProps;
 static std::mutex devicePropsMutex;
 
+// Plans of librettPlanAsync() that are still being created, with the result of the planning
+static std::unordered_map<librettHandle, std::shared_future<librettResult> > pendingPlans;
+static std::mutex pendingPlansMutex;
+
+// Background thread that creates the plans of librettPlanAsync() one after another. Started
+// by the first librettPlanAsync(), drained and stopped by librettFinalize(). Never
+// destroyed, so that a running thread is not destructed at exit
+struct PlanWorker {
+  std::thread thread;
+  std::deque<std::packaged_task<librettResult()> > jobs;
+  std::mutex mutex;
+  std::condition_variable cond;
+  bool stop = false;
+};
+static PlanWorker& planWorker = *new PlanWorker();
+
 // Checks prepares device if it's not ready yet and returns device properties
 // Also sets shared memory configuration
 void getDeviceProp(int& deviceID, gpuStream_t& stream, gpuDeviceProp_t &prop) {
   // need to lock this function
   std::lock_guard<std::mutex> lock(devicePropsMutex);
 
-  #if HIP
+  // Device IDs are not negative, those are the device profiles of librettPlanOffline()
+  #if SYCL || LIBRETT_USES_CPU
+    deviceID = 0;
+  #elif HIP
     hipCheck(hipGetDevice(&deviceID));
-  #elif CUDA
+  #else // CUDA
     cudaCheck(cudaGetDevice(&deviceID));
   #endif
 
@@ -69,6 +125,8 @@ void getDeviceProp(int& deviceID, gpuStream_t& stream, gpuDeviceProp_t &prop) {
     // Get device properties and store it for later use
     #if SYCL
       Librett::syclGetDeviceProperties(&prop, stream);
+    #elif LIBRETT_USES_CPU
+      Librett::cpuGetDeviceProperties(&prop);
     #elif HIP
       hipCheck(hipGetDeviceProperties(&prop, deviceID));
       librettKernelSetSharedMemConfig();
@@ -84,7 +142,8 @@ void getDeviceProp(int& deviceID, gpuStream_t& stream, gpuDeviceProp_t &prop) {
 
 librettResult librettPlanCheckInput(int rank, int* dim, int* permutation, size_t sizeofType) {
   // Check sizeofType
-  if (sizeofType != 4 && sizeofType != 8 && sizeofType != 16) return LIBRETT_INVALID_PARAMETER;
+  if (sizeofType != 1 && sizeofType != 2 && sizeofType != 4 && sizeofType != 8 && sizeofType != 16)
+    return LIBRETT_INVALID_PARAMETER;
   // Check rank
   if (rank < 1) return LIBRETT_INVALID_PARAMETER;
   // Check dim[]
@@ -107,8 +166,76 @@ librettResult librettPlanCheckInput(int rank, int* dim, int* permutation, size_t
   return LIBRETT_SUCCESS;
 }
 
-librettResult librettPlan(librettHandle *handle, int rank, int *dim, int *permutation, size_t sizeofType,
-  gpuStream_t& stream) {
+// Returns the size of librettDataType elements in bytes
+static size_t sizeofDataType(const int type) {
+  switch(type) {
+    case LIBRETT_FLOAT64: return 8;
+    case LIBRETT_FLOAT32: return 4;
+    case LIBRETT_FLOAT16: return 2;
+    case LIBRETT_BFLOAT16: return 2;
+  }
+  return 0;
+}
+
+//
+// Returns the plan cache key: the reduced dimensions, permutation and strides, the element
+// size and types, the device and the accumulate flag. The plan chosen by the model only
+// depends on these, tensors that reduce to the same ranks share a plan
+//
+static std::string planCacheKey(const std::vector<int>& redDim, const std::vector<int>& redPermutation,
+  const std::vector<long long int>& redInStride, const std::vector<long long int>& redOutStride,
+  const size_t sizeofType, const int deviceID, const bool readOut, const int typeIn, const int typeOut) {
+  std::vector<long long int> key = {(long long int)redDim.size(), (long long int)sizeofType, deviceID,
+    readOut, typeIn, typeOut, (long long int)redInStride.size()};
+  key.insert(key.end(), redDim.begin(), redDim.end());
+  key.insert(key.end(), redPermutation.begin(), redPermutation.end());
+  key.insert(key.end(), redInStride.begin(), redInStride.end());
+  key.insert(key.end(), redOutStride.begin(), redOutStride.end());
+  return std::string((const char *)key.data(), key.size()*sizeof(long long int));
+}
+
+//
+// Returns a new plan for a handle that shares the device descriptors of a cached plan
+//
+static librettPlan_t* sharePlan(const std::shared_ptr<librettPlan_t>& cached, gpuStream_t& stream) {
+  librettPlan_t* plan = new librettPlan_t();
+  *plan = *cached;
+  plan->descriptorOwner = cached;
+  plan->setStream(stream);
+  return plan;
+}
+
+//
+// Runs the performance model of the plan candidates on the planning pool.
+// Candidates are independent, each one only writes its own counters
+//
+static bool countCandidates(const std::vector<librettPlan_t*>& candidates, const gpuDeviceProp_t& prop,
+  const bool readOut) {
+  std::shared_ptr<ThreadPool> pool;
+  {
+    std::lock_guard<std::mutex> lock(planPoolMutex);
+    pool = planPool;
+  }
+  std::atomic<bool> countOk(true);
+  auto countFunc = [&](int i) {
+    if (!candidates[i]->countCycles(prop, 10, readOut)) countOk = false;
+  };
+  if (pool != nullptr) {
+    pool->parallelFor((int)candidates.size(), countFunc);
+  } else {
+    ThreadPool::instance().parallelFor((int)candidates.size(), countFunc);
+  }
+  return countOk;
+}
+
+//
+// Creates a plan using the performance model. readOut = true models accumulating execution,
+// typeIn and typeOut are the librettDataType of converting plans and -1 otherwise.
+// inStride and outStride are the strides of strided plans and nullptr for dense tensors
+//
+static librettResult librettPlanModel(librettHandle *handle, int rank, int *dim, int *permutation,
+  size_t sizeofType, gpuStream_t& stream, const bool readOut, const int typeIn=-1, const int typeOut=-1,
+  const long long int* inStride=nullptr, const long long int* outStride=nullptr) {
 
 #if SYCL
   if(stream == nullptr) {
@@ -124,16 +251,6 @@ librettResult librettPlan(librettHandle *handle, int rank, int *dim, int *permut
   librettResult inpCheck = librettPlanCheckInput(rank, dim, permutation, sizeofType);
   if (inpCheck != LIBRETT_SUCCESS) return inpCheck;
 
-  // Create new handle
-  *handle = curHandle;
-  curHandle++;
-
-  // Check that the current handle is available (it better be!)
-  {
-    std::lock_guard<std::mutex> lock(planStorageMutex);
-    if (planStorage.count(*handle) != 0) return LIBRETT_INTERNAL_ERROR;
-  }
-
   // // Prepare device
   int deviceID;
   gpuDeviceProp_t prop;
@@ -142,7 +259,34 @@ librettResult librettPlan(librettHandle *handle, int rank, int *dim, int *permut
   // Reduce ranks
   std::vector<int> redDim;
   std::vector<int> redPermutation;
-  reduceRanks(rank, dim, permutation, redDim, redPermutation);
+  std::vector<long long int> redInStride;
+  std::vector<long long int> redOutStride;
+  if (inStride != nullptr) {
+    reduceRanks(rank, dim, permutation, inStride, outStride, redDim, redPermutation, redInStride, redOutStride);
+  } else {
+    reduceRanks(rank, dim, permutation, redDim, redPermutation);
+  }
+
+  // Repeated plans come from the plan cache
+  const std::string cacheKey = planCacheKey(redDim, redPermutation, redInStride, redOutStride, sizeofType,
+    deviceID, readOut, typeIn, typeOut);
+  const bool useCache = (planCacheCapacity > 0);
+  if (useCache) {
+    std::shared_ptr<librettPlan_t> cached = planCache.get(cacheKey);
+    if (cached != nullptr) {
+      planCacheHits++;
+      librettPlan_t* plan = sharePlan(cached, stream);
+      if (!planTable.insert(plan, *handle)) {
+        delete plan;
+        return LIBRETT_INTERNAL_ERROR;
+      }
+#ifdef ENABLE_NVTOOLS
+      gpuRangeStop();
+#endif
+      return LIBRETT_SUCCESS;
+    }
+    planCacheMisses++;
+  }
 
   // Create plans from reduced ranks
   std::list<librettPlan_t> plans;
@@ -166,7 +310,9 @@ librettResult librettPlan(librettHandle *handle, int rank, int *dim, int *permut
   // plan_start = std::chrono::high_resolution_clock::now();
 
   if (!librettPlan_t::createPlans(rank, dim, permutation, redDim.size(), redDim.data(), redPermutation.data(),
-    sizeofType, deviceID, prop, plans)) return LIBRETT_INTERNAL_ERROR;
+    sizeofType, deviceID, prop, plans, inStride, outStride,
+    (inStride != nullptr) ? redInStride.data() : nullptr,
+    (inStride != nullptr) ? redOutStride.data() : nullptr)) return LIBRETT_INTERNAL_ERROR;
 
   // std::chrono::high_resolution_clock::time_point plan_end;
   // plan_end = std::chrono::high_resolution_clock::now();
@@ -178,9 +324,29 @@ librettResult librettPlan(librettHandle *handle, int rank, int *dim, int *permut
   gpuRangeStart("countCycles");
 #endif
 
-  // Count cycles
-  for (auto it=plans.begin();it != plans.end();it++) {
-    if (!it->countCycles(prop, 10)) return LIBRETT_INTERNAL_ERROR;
+  // Plans measured by librettPlanMeasure() come from wisdom
+  std::list<librettPlan_t>::iterator bestPlan = plans.end();
+  if (typeIn == -1 && inStride == nullptr && !readOut) {
+    bestPlan = wisdomFind(wisdomKey(prop, redDim, redPermutation, sizeofType), plans);
+  }
+
+  if (bestPlan == plans.end()) {
+    // Count cycles. Candidates are independent and are counted concurrently,
+    // choosePlanHeuristic() scans them in list order so the choice does not depend on the threads
+    std::vector<librettPlan_t*> candidates;
+    for (auto it=plans.begin();it != plans.end();it++) {
+      if (typeIn != -1) {
+        it->typeIn = typeIn;
+        it->typeOut = typeOut;
+        it->sizeofTypeOut = sizeofDataType(typeOut);
+      }
+      candidates.push_back(&(*it));
+    }
+    if (!countCandidates(candidates, prop, readOut)) return LIBRETT_INTERNAL_ERROR;
+
+    // Choose the plan
+    bestPlan = choosePlanHeuristic(plans);
+    if (bestPlan == plans.end()) return LIBRETT_INTERNAL_ERROR;
   }
 
 #ifdef ENABLE_NVTOOLS
@@ -188,10 +354,6 @@ librettResult librettPlan(librettHandle *handle, int rank, int *dim, int *permut
   gpuRangeStart("rest");
 #endif
 
-  // Choose the plan
-  std::list<librettPlan_t>::iterator bestPlan = choosePlanHeuristic(plans);
-  if (bestPlan == plans.end()) return LIBRETT_INTERNAL_ERROR;
-
   // bestPlan->print();
 
   // Create copy of the plan outside the list
@@ -201,6 +363,8 @@ librettResult librettPlan(librettHandle *handle, int rank, int *dim, int *permut
   // Set device pointers to NULL in the old copy of the plan so
   // that they won't be deallocated later when the object is destroyed
   bestPlan->nullDevicePointers();
+  plan->redDim = redDim;
+  plan->redPermutation = redPermutation;
 
   // Set stream
   plan->setStream(stream);
@@ -208,10 +372,24 @@ librettResult librettPlan(librettHandle *handle, int rank, int *dim, int *permut
   // Activate plan
   plan->activate();
 
+  if (useCache) {
+    // Descriptors must be on the device before plans on other streams use them
+#if SYCL
+    stream->wait();
+#elif HIP
+    hipCheck(hipStreamSynchronize(stream));
+#elif LIBRETT_USES_CUDA
+    cudaCheck(cudaStreamSynchronize(stream));
+#endif
+    std::shared_ptr<librettPlan_t> cached(plan);
+    planCache.set(cacheKey, cached);
+    plan = sharePlan(cached, stream);
+  }
+
   // Insert plan into storage
-  {
-    std::lock_guard<std::mutex> lock(planStorageMutex);
-    planStorage.insert( {*handle, plan} );
+  if (!planTable.insert(plan, *handle)) {
+    delete plan;
+    return LIBRETT_INTERNAL_ERROR;
   }
 
 #ifdef ENABLE_NVTOOLS
@@ -221,8 +399,138 @@ librettResult librettPlan(librettHandle *handle, int rank, int *dim, int *permut
   return LIBRETT_SUCCESS;
 }
 
-librettResult librettPlanMeasure(librettHandle *handle, int rank, int *dim, int *permutation, size_t sizeofType,
-  gpuStream_t& stream, void* idata, void* odata)
+librettResult librettPlan(librettHandle *handle, int rank, int *dim, int *permutation, size_t sizeofType,
+  gpuStream_t& stream) {
+  return librettPlanModel(handle, rank, dim, permutation, sizeofType, stream, false);
+}
+
+librettResult librettPlanAccumulate(librettHandle *handle, int rank, int *dim, int *permutation, size_t sizeofType,
+  gpuStream_t& stream) {
+  return librettPlanModel(handle, rank, dim, permutation, sizeofType, stream, true);
+}
+
+librettResult librettPlanConvert(librettHandle *handle, int rank, int *dim, int *permutation,
+  librettDataType typeIn, librettDataType typeOut, gpuStream_t& stream) {
+  // Conversions go through float, one side must be FLOAT32
+  if (sizeofDataType(typeIn) == 0 || sizeofDataType(typeOut) == 0 || typeIn == typeOut ||
+    (typeIn != LIBRETT_FLOAT32 && typeOut != LIBRETT_FLOAT32)) return LIBRETT_INVALID_PARAMETER;
+  return librettPlanModel(handle, rank, dim, permutation, sizeofDataType(typeIn), stream, false, typeIn, typeOut);
+}
+
+librettResult librettPlanStrided(librettHandle *handle, int rank, int *dim, long long int *inStride,
+  long long int *outStride, int *permutation, size_t sizeofType, gpuStream_t& stream) {
+  librettResult inpCheck = librettPlanCheckInput(rank, dim, permutation, sizeofType);
+  if (inpCheck != LIBRETT_SUCCESS) return inpCheck;
+  // Leading dimensions are contiguous and ranks do not overlap
+  if (inStride[0] != 1 || outStride[0] != 1) return LIBRETT_INVALID_PARAMETER;
+  for (int i=1;i < rank;i++) {
+    if (inStride[i] < inStride[i-1]*dim[i-1] ||
+      outStride[i] < outStride[i-1]*dim[permutation[i-1]]) return LIBRETT_INVALID_PARAMETER;
+  }
+  return librettPlanModel(handle, rank, dim, permutation, sizeofType, stream, false, -1, -1, inStride, outStride);
+}
+
+librettResult librettPlanMany(int count, librettHandle *handles, int *rank, int **dim, int **permutation,
+  size_t *sizeofType, gpuStream_t& stream)
+{
+#if SYCL
+  if(stream == nullptr) {
+    throw std::runtime_error("[SYCL] pass a valid/non-nullptr SYCL queue to the plan constructor!");
+  }
+#endif
+
+  if (count < 0) return LIBRETT_INVALID_PARAMETER;
+  for (int i=0;i < count;i++) {
+    librettResult inpCheck = librettPlanCheckInput(rank[i], dim[i], permutation[i], sizeofType[i]);
+    if (inpCheck != LIBRETT_SUCCESS) return inpCheck;
+  }
+
+  int deviceID;
+  gpuDeviceProp_t prop;
+  getDeviceProp(deviceID, stream, prop);
+
+  // Requests that reduce to the same ranks are planned once
+  std::unordered_map<std::string, int> problemIndex;
+  std::vector<int> problem(count);
+  std::vector<int> firstRequest;
+  std::vector< std::vector<int> > redDim;
+  std::vector< std::vector<int> > redPermutation;
+  for (int i=0;i < count;i++) {
+    std::vector<int> rd;
+    std::vector<int> rp;
+    reduceRanks(rank[i], dim[i], permutation[i], rd, rp);
+    auto res = problemIndex.insert( {planCacheKey(rd, rp, std::vector<long long int>(), std::vector<long long int>(),
+      sizeofType[i], deviceID, false, -1, -1), (int)firstRequest.size()} );
+    if (res.second) {
+      firstRequest.push_back(i);
+      redDim.push_back(rd);
+      redPermutation.push_back(rp);
+    }
+    problem[i] = res.first->second;
+  }
+  const int numProblem = firstRequest.size();
+
+  // Candidates of all problems are modeled together
+  std::vector< std::list<librettPlan_t> > plans(numProblem);
+  std::vector< std::list<librettPlan_t>::iterator > bestPlan(numProblem);
+  std::vector<librettPlan_t*> candidates;
+  for (int p=0;p < numProblem;p++) {
+    const int i = firstRequest[p];
+    if (!librettPlan_t::createPlans(rank[i], dim[i], permutation[i], redDim[p].size(), redDim[p].data(),
+      redPermutation[p].data(), sizeofType[i], deviceID, prop, plans[p])) return LIBRETT_INTERNAL_ERROR;
+    bestPlan[p] = wisdomFind(wisdomKey(prop, redDim[p], redPermutation[p], sizeofType[i]), plans[p]);
+    if (bestPlan[p] != plans[p].end()) continue;
+    for (auto it=plans[p].begin();it != plans[p].end();it++) candidates.push_back(&(*it));
+  }
+  if (!countCandidates(candidates, prop, false)) return LIBRETT_INTERNAL_ERROR;
+  for (int p=0;p < numProblem;p++) {
+    if (bestPlan[p] == plans[p].end()) bestPlan[p] = choosePlanHeuristic(plans[p]);
+    if (bestPlan[p] == plans[p].end()) return LIBRETT_INTERNAL_ERROR;
+  }
+
+  // The descriptors of all problems go into one device allocation that is freed with the last plan
+  std::vector<size_t> offset(numProblem + 1, 0);
+  for (int p=0;p < numProblem;p++) offset[p + 1] = offset[p] + bestPlan[p]->descriptorSize();
+  std::shared_ptr<void> descriptors;
+  char* buf = nullptr;
+  if (offset[numProblem] > 0) {
+    allocate_descriptor<char>(&buf, offset[numProblem], deviceID, stream);
+    descriptors = std::shared_ptr<void>(buf, [deviceID, stream](void* ptr) {
+      char* p = (char *)ptr;
+      deallocate_descriptor<char>(&p, deviceID, stream);
+    });
+  }
+  std::vector<char> hostBuf(offset[numProblem]);
+  for (int p=0;p < numProblem;p++) {
+    bestPlan[p]->activateShared(buf + offset[p], hostBuf.data() + offset[p]);
+    bestPlan[p]->descriptorOwner = descriptors;
+    bestPlan[p]->redDim = redDim[p];
+    bestPlan[p]->redPermutation = redPermutation[p];
+    bestPlan[p]->setStream(stream);
+    bestPlan[p]->descriptorStream = stream;
+  }
+  if (buf != nullptr) copy_HtoD_sync<char>(hostBuf.data(), buf, offset[numProblem], stream);
+
+  for (int i=0;i < count;i++) {
+    librettPlan_t* plan = new librettPlan_t();
+    *plan = *bestPlan[problem[i]];
+    if (!planTable.insert(plan, handles[i])) {
+      delete plan;
+      for (int j=0;j < i;j++) delete planTable.remove(handles[j]);
+      return LIBRETT_INTERNAL_ERROR;
+    }
+  }
+
+  return LIBRETT_SUCCESS;
+}
+
+//
+// Creates a plan by measuring candidates. topK = 0 runs every candidate once, otherwise the
+// topK best candidates of the performance model are run once to warm up and numRep times,
+// and their median times are compared
+//
+static librettResult librettPlanMeasureCandidates(librettHandle *handle, int rank, int *dim, int *permutation,
+  size_t sizeofType, gpuStream_t& stream, void* idata, void* odata, const int topK, const int numRep)
 {
 #if SYCL
   if(stream == nullptr) {
@@ -236,16 +544,6 @@ librettResult librettPlanMeasure(librettHandle *handle, int rank, int *dim, int
 
   if (idata == odata) return LIBRETT_INVALID_PARAMETER;
 
-  // Create new handle
-  *handle = curHandle;
-  curHandle++;
-
-  // Check that the current handle is available (it better be!)
-  {
-    std::lock_guard<std::mutex> lock(planStorageMutex);
-    if (planStorage.count(*handle) != 0) return LIBRETT_INTERNAL_ERROR;
-  }
-
   // // Prepare device
   int deviceID;
   gpuDeviceProp_t prop;
@@ -279,31 +577,57 @@ librettResult librettPlanMeasure(librettHandle *handle, int rank, int *dim, int
   size_t numBytes = sizeofType;
   for (int i=0;i < rank;i++) numBytes *= dim[i];
 
+  // Tensors measured before take the plan from wisdom
+  const std::string key = wisdomKey(prop, redDim, redPermutation, sizeofType);
+  auto bestPlan = wisdomFind(key, plans);
+  const bool measure = (bestPlan == plans.end());
+
+  // Candidates to measure, all of them or the topK best of the model
+  std::vector< std::list<librettPlan_t>::iterator > measured;
+  if (measure && topK == 0) {
+    for (auto it=plans.begin();it != plans.end();it++) measured.push_back(it);
+  } else if (measure) {
+    std::vector<librettPlan_t*> candidates;
+    for (auto it=plans.begin();it != plans.end();it++) candidates.push_back(&(*it));
+    if (!countCandidates(candidates, prop, false)) return LIBRETT_INTERNAL_ERROR;
+    measured = chooseTopPlans(plans, topK);
+  }
+
   // Choose the plan
   double bestTime = 1.0e40;
-  auto bestPlan = plans.end();
   Timer timer;
   std::vector<double> times;
-  for (auto it=plans.begin();it != plans.end();it++) {
+  for (auto it : measured) {
     // Activate plan
+    it->setStream(stream);
     it->activate();
 
     // Clear output data to invalidate caches
     set_device_array<char>((char *)odata, -1, numBytes, stream);
 
+    // Warm-up run
+    if (topK > 0 && !librettKernel(*it, it->stream, idata, odata)) return LIBRETT_INTERNAL_ERROR;
+
 #if SYCL
     stream->wait_and_throw();
+#elif LIBRETT_USES_CPU
+    // Host execution is synchronous
 #elif HIP
     hipCheck(hipStreamSynchronize(stream));
 #else // CUDA
     cudaCheck(cudaStreamSynchronize(stream));
 #endif
 
-    timer.start();
-    // Execute plan
-    if (!librettKernel(*it, idata, odata)) return LIBRETT_INTERNAL_ERROR;
-    timer.stop();
-    double curTime = timer.seconds();
+    // Execute plan, the median of numRep runs
+    std::vector<double> repTimes(numRep);
+    for (int rep=0;rep < numRep;rep++) {
+      timer.start();
+      if (!librettKernel(*it, it->stream, idata, odata)) return LIBRETT_INTERNAL_ERROR;
+      timer.stop();
+      repTimes[rep] = timer.seconds();
+    }
+    std::nth_element(repTimes.begin(), repTimes.begin() + numRep/2, repTimes.end());
+    double curTime = repTimes[numRep/2];
     // it->print();
     // printf("curTime %1.2lf\n", curTime*1000.0);
     times.push_back(curTime);
@@ -314,6 +638,13 @@ librettResult librettPlanMeasure(librettHandle *handle, int rank, int *dim, int
   }
   if (bestPlan == plans.end()) return LIBRETT_INTERNAL_ERROR;
 
+  if (measure) {
+    wisdomRecord(key, *bestPlan);
+    // librettPlan() picks up the new choice instead of a cached model plan
+    planCache.erase(planCacheKey(redDim, redPermutation, std::vector<long long int>(),
+      std::vector<long long int>(), sizeofType, deviceID, false, -1, -1));
+  }
+
   // bestPlan = plans.begin();
 
   // printMatlab(prop, plans, times);
@@ -326,6 +657,8 @@ librettResult librettPlanMeasure(librettHandle *handle, int rank, int *dim, int
   // Set device pointers to NULL in the old copy of the plan so
   // that they won't be deallocated later when the object is destroyed
   bestPlan->nullDevicePointers();
+  plan->redDim = redDim;
+  plan->redPermutation = redPermutation;
 
   // Set stream
   plan->setStream(stream);
@@ -334,14 +667,243 @@ librettResult librettPlanMeasure(librettHandle *handle, int rank, int *dim, int
   plan->activate();
 
   // Insert plan into storage
+  if (!planTable.insert(plan, *handle)) {
+    delete plan;
+    return LIBRETT_INTERNAL_ERROR;
+  }
+
+  return LIBRETT_SUCCESS;
+}
+
+librettResult librettPlanMeasure(librettHandle *handle, int rank, int *dim, int *permutation, size_t sizeofType,
+  gpuStream_t& stream, void* idata, void* odata)
+{
+  return librettPlanMeasureCandidates(handle, rank, dim, permutation, sizeofType, stream, idata, odata, 0, 1);
+}
+
+librettResult librettPlanMeasureTopK(librettHandle *handle, int rank, int *dim, int *permutation, size_t sizeofType,
+  gpuStream_t& stream, void* idata, void* odata, int topK, int numRep)
+{
+  if (topK < 1 || numRep < 1) return LIBRETT_INVALID_PARAMETER;
+  return librettPlanMeasureCandidates(handle, rank, dim, permutation, sizeofType, stream, idata, odata, topK,
+    numRep);
+}
+
+librettResult librettPlanAdaptive(librettHandle *handle, int rank, int *dim, int *permutation, size_t sizeofType,
+  gpuStream_t& stream, int numCandidate, int numExplore)
+{
+#if SYCL
+  if(stream == nullptr) {
+    throw std::runtime_error("[SYCL] pass a valid/non-nullptr SYCL queue to the plan constructor!");
+  }
+#endif
+
+  // Check that input parameters are valid
+  librettResult inpCheck = librettPlanCheckInput(rank, dim, permutation, sizeofType);
+  if (inpCheck != LIBRETT_SUCCESS) return inpCheck;
+
+  if (numCandidate < 1 || numExplore < 1) return LIBRETT_INVALID_PARAMETER;
+
+  // // Prepare device
+  int deviceID;
+  gpuDeviceProp_t prop;
+  getDeviceProp(deviceID, stream, prop);
+
+  // Reduce ranks
+  std::vector<int> redDim;
+  std::vector<int> redPermutation;
+  reduceRanks(rank, dim, permutation, redDim, redPermutation);
+
+  std::list<librettPlan_t> plans;
+  if (!librettPlan_t::createPlans(rank, dim, permutation, redDim.size(), redDim.data(), redPermutation.data(),
+    sizeofType, deviceID, prop, plans)) return LIBRETT_INTERNAL_ERROR;
+
+  // Tensors with wisdom take the plan of wisdom and do not explore
+  const std::string key = wisdomKey(prop, redDim, redPermutation, sizeofType);
+  std::vector< std::list<librettPlan_t>::iterator > chosen;
+  auto wisdomPlan = wisdomFind(key, plans);
+  if (wisdomPlan != plans.end()) {
+    chosen.push_back(wisdomPlan);
+  } else {
+    std::vector<librettPlan_t*> candidates;
+    for (auto it=plans.begin();it != plans.end();it++) candidates.push_back(&(*it));
+    if (!countCandidates(candidates, prop, false)) return LIBRETT_INTERNAL_ERROR;
+    chosen = chooseTopPlans(plans, numCandidate);
+    if (chosen.empty()) return LIBRETT_INTERNAL_ERROR;
+  }
+
+  // Create copies of the candidates outside the list
+  std::vector<librettPlan_t*> candidates;
+  for (auto it : chosen) {
+    librettPlan_t* candidate = new librettPlan_t();
+    *candidate = *it;
+    it->nullDevicePointers();
+    candidate->redDim = redDim;
+    candidate->redPermutation = redPermutation;
+    candidate->setStream(stream);
+    candidates.push_back(candidate);
+  }
+
+  librettPlan_t* plan;
+  if (candidates.size() == 1) {
+    plan = candidates[0];
+    plan->activate();
+  } else {
+    // The plan of the handle is an inactive copy of the best candidate of the model that
+    // runs the candidates
+    plan = new librettPlan_t();
+    *plan = *candidates[0];
+    for (librettPlan_t* candidate : candidates) candidate->activate();
+    plan->adaptive = std::make_shared<AdaptivePlan>(candidates, numExplore, key);
+  }
+
+  // Insert plan into storage
+  if (!planTable.insert(plan, *handle)) {
+    delete plan;
+    return LIBRETT_INTERNAL_ERROR;
+  }
+
+  return LIBRETT_SUCCESS;
+}
+
+static void planWorkerLoop() {
+  while (true) {
+    std::packaged_task<librettResult()> job;
+    {
+      std::unique_lock<std::mutex> lock(planWorker.mutex);
+      planWorker.cond.wait(lock, []() { return planWorker.stop || !planWorker.jobs.empty(); });
+      // Stopping drains the queued jobs first
+      if (planWorker.jobs.empty()) return;
+      job = std::move(planWorker.jobs.front());
+      planWorker.jobs.pop_front();
+    }
+    job();
+  }
+}
+
+//
+// Queues func on the plan worker and returns its result
+//
+static std::shared_future<librettResult> planWorkerSubmit(std::function<librettResult()> func) {
+  std::packaged_task<librettResult()> job(std::move(func));
+  std::shared_future<librettResult> result = job.get_future().share();
+  std::lock_guard<std::mutex> lock(planWorker.mutex);
+  if (!planWorker.thread.joinable()) {
+    planWorker.stop = false;
+    planWorker.thread = std::thread(planWorkerLoop);
+  }
+  planWorker.jobs.push_back(std::move(job));
+  planWorker.cond.notify_one();
+  return result;
+}
+
+//
+// Runs the queued jobs and stops the plan worker. Must not race with librettPlanAsync()
+//
+static void planWorkerStop() {
+  std::thread thread;
+  {
+    std::lock_guard<std::mutex> lock(planWorker.mutex);
+    planWorker.stop = true;
+    planWorker.cond.notify_one();
+    thread = std::move(planWorker.thread);
+  }
+  if (thread.joinable()) thread.join();
+}
+
+//
+// Waits until a plan of librettPlanAsync() has been created. Returns the result of the
+// planning, LIBRETT_SUCCESS for handles that are not pending
+//
+static librettResult waitPlan(const librettHandle handle) {
+  std::shared_future<librettResult> result;
   {
-    std::lock_guard<std::mutex> lock(planStorageMutex);
-    planStorage.insert( {*handle, plan} );
+    std::lock_guard<std::mutex> lock(pendingPlansMutex);
+    auto it = pendingPlans.find(handle);
+    if (it == pendingPlans.end()) return LIBRETT_SUCCESS;
+    result = it->second;
   }
+  librettResult res = result.get();
+  std::lock_guard<std::mutex> lock(pendingPlansMutex);
+  pendingPlans.erase(handle);
+  return res;
+}
+
+//
+// Reference to the plan of handle for an execute call, waits for plans of
+// librettPlanAsync() that are still being created
+//
+static librettResult findPlan(const librettHandle handle, PlanTable::Ref& plan) {
+  plan = planTable.find(handle);
+  if (plan) return LIBRETT_SUCCESS;
+  librettResult res = waitPlan(handle);
+  if (res != LIBRETT_SUCCESS) return res;
+  plan = planTable.find(handle);
+  return plan ? LIBRETT_SUCCESS : LIBRETT_INVALID_PLAN;
+}
 
+librettResult librettPlanAsync(librettHandle *handle, int rank, int *dim, int *permutation, size_t sizeofType,
+  gpuStream_t& stream)
+{
+  librettResult inpCheck = librettPlanCheckInput(rank, dim, permutation, sizeofType);
+  if (inpCheck != LIBRETT_SUCCESS) return inpCheck;
+
+  // The worker plans for the current device
+#if HIP
+  int deviceID;
+  hipCheck(hipGetDevice(&deviceID));
+#elif LIBRETT_USES_CUDA
+  int deviceID;
+  cudaCheck(cudaGetDevice(&deviceID));
+#endif
+
+  if (!planTable.reserve(*handle)) return LIBRETT_INTERNAL_ERROR;
+  const librettHandle asyncHandle = *handle;
+  std::vector<int> dimCopy(dim, dim + rank);
+  std::vector<int> permutationCopy(permutation, permutation + rank);
+  gpuStream_t streamCopy = stream;
+
+  std::lock_guard<std::mutex> lock(pendingPlansMutex);
+  pendingPlans[asyncHandle] = planWorkerSubmit([=]() mutable {
+#if HIP
+    hipCheck(hipSetDevice(deviceID));
+#elif LIBRETT_USES_CUDA
+    cudaCheck(cudaSetDevice(deviceID));
+#endif
+    // Plan under a handle of its own and move the plan to the handle returned to the caller
+    librettHandle planHandle;
+    librettResult res = librettPlanModel(&planHandle, rank, dimCopy.data(), permutationCopy.data(),
+      sizeofType, streamCopy, false);
+    if (res != LIBRETT_SUCCESS) {
+      planTable.remove(asyncHandle);
+      return res;
+    }
+    planTable.publish(asyncHandle, planTable.remove(planHandle));
+    return LIBRETT_SUCCESS;
+  });
   return LIBRETT_SUCCESS;
 }
 
+librettResult librettPlanQuery(librettHandle handle)
+{
+  {
+    std::lock_guard<std::mutex> lock(pendingPlansMutex);
+    auto it = pendingPlans.find(handle);
+    if (it != pendingPlans.end() &&
+      it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return LIBRETT_PLAN_PENDING;
+  }
+  librettResult res = waitPlan(handle);
+  if (res != LIBRETT_SUCCESS) return res;
+  return planTable.find(handle) ? LIBRETT_SUCCESS : LIBRETT_INVALID_PLAN;
+}
+
+librettResult librettPlanWait(librettHandle handle)
+{
+  librettResult res = waitPlan(handle);
+  if (res != LIBRETT_SUCCESS) return res;
+  return planTable.find(handle) ? LIBRETT_SUCCESS : LIBRETT_INVALID_PLAN;
+}
+
 void librettDestroy_callback(gpuStream_t stream, gpuError_t status,
   void *userData) {
   librettPlan_t* plan = (librettPlan_t*) userData;
@@ -349,42 +911,547 @@ void librettDestroy_callback(gpuStream_t stream, gpuError_t status,
 }
 
 librettResult librettDestroy(librettHandle handle) {
-  std::lock_guard<std::mutex> lock(planStorageMutex);
-  auto it = planStorage.find(handle);
-  if (it == planStorage.end()) return LIBRETT_INVALID_PLAN;
+  librettResult planResult = waitPlan(handle);
+  if (planResult != LIBRETT_SUCCESS) return planResult;
+  // Delete entry from plan storage, executions of the plan on other threads finish first
+  librettPlan_t* plan = planTable.remove(handle);
+  if (plan == nullptr) return LIBRETT_INVALID_PLAN;
 #ifdef LIBRETT_HAS_UMPIRE
-  // get the pointer librettPlan_t
-  librettPlan_t* plan = it->second;
   cudaStream_t stream = plan->stream;
-  // Delete entry from plan storage
-  planStorage.erase(it);
   // register callback to deallocate plan
   cudaStreamAddCallback(stream, librettDestroy_callback, plan, 0);
 #else
   // Delete instance of librettPlan_t
-  delete it->second;
-  // Delete entry from plan storage
-  planStorage.erase(it);
+  delete plan;
 #endif
   return LIBRETT_SUCCESS;
 }
 
+//
+// Runs plan on stream. Plans of librettPlanAdaptive() run one of their candidates, the
+// execution that makes the choice also drops the cached plan of the tensor so that
+// librettPlan() takes the choice from wisdom
+//
+static bool runPlan(librettPlan_t& plan, gpuStream_t stream, void* idata, void* odata,
+  const double alpha=1.0, const double beta=0.0) {
+  if (plan.adaptive == nullptr) return librettKernel(plan, stream, idata, odata, alpha, beta);
+  bool chosen;
+  if (!plan.adaptive->execute(stream, idata, odata, alpha, beta, chosen)) return false;
+  if (chosen) {
+    planCache.erase(planCacheKey(plan.redDim, plan.redPermutation, std::vector<long long int>(),
+      std::vector<long long int>(), plan.sizeofType, plan.deviceID, false, -1, -1));
+  }
+  return true;
+}
+
+//
+// Plan for batched and grouped execution of plan: the plan itself, or the current
+// candidate of a plan of librettPlanAdaptive(), kept alive by held
+//
+static librettPlan_t& executedPlan(librettPlan_t& plan, std::shared_ptr<librettPlan_t>& held) {
+  if (plan.adaptive == nullptr) return plan;
+  held = plan.adaptive->current();
+  return *held;
+}
+
 librettResult librettExecute(librettHandle handle, void *idata, void *odata)
 {
-  // prevent modification when find
-  std::lock_guard<std::mutex> lock(planStorageMutex);
-  auto it = planStorage.find(handle);
-  if (it == planStorage.end()) return LIBRETT_INVALID_PLAN;
+  // Keeps the plan from being destroyed during the call
+  PlanTable::Ref ref;
+  librettResult planResult = findPlan(handle, ref);
+  if (planResult != LIBRETT_SUCCESS) return planResult;
+
+  if (idata == odata) return LIBRETT_INVALID_PARAMETER;
+
+  librettPlan_t& plan = *ref;
+
+  if (!runPlan(plan, plan.stream, idata, odata)) return LIBRETT_INTERNAL_ERROR;
+  return LIBRETT_SUCCESS;
+}
+
+librettResult librettExecuteOnStream(librettHandle handle, gpuStream_t stream, void *idata, void *odata)
+{
+  // Keeps the plan from being destroyed during the call
+  PlanTable::Ref ref;
+  librettResult planResult = findPlan(handle, ref);
+  if (planResult != LIBRETT_SUCCESS) return planResult;
+
+  if (idata == odata) return LIBRETT_INVALID_PARAMETER;
+
+  librettPlan_t& plan = *ref;
+
+  if (!runPlan(plan, stream, idata, odata)) return LIBRETT_INTERNAL_ERROR;
+  return LIBRETT_SUCCESS;
+}
+
+librettResult librettExecuteAccumulate(librettHandle handle, void *idata, void *odata, double alpha, double beta)
+{
+  // Keeps the plan from being destroyed during the call
+  PlanTable::Ref ref;
+  librettResult planResult = findPlan(handle, ref);
+  if (planResult != LIBRETT_SUCCESS) return planResult;
 
   if (idata == odata) return LIBRETT_INVALID_PARAMETER;
 
-  librettPlan_t& plan = *(it->second);
+  librettPlan_t& plan = *ref;
+
+  // Scaling needs arithmetic on the elements, 1 and 2 byte elements can only be copied.
+  // Converting plans do not scale
+  if ((plan.sizeofType < 4 || plan.typeIn != -1) && (alpha != 1.0 || beta != 0.0))
+    return LIBRETT_INVALID_PARAMETER;
 
-  if (!librettKernel(plan, idata, odata)) return LIBRETT_INTERNAL_ERROR;
+  if (!runPlan(plan, plan.stream, idata, odata, alpha, beta)) return LIBRETT_INTERNAL_ERROR;
+  return LIBRETT_SUCCESS;
+}
+
+librettResult librettExecuteScaled(librettHandle handle, void *idata, void *odata, double alpha)
+{
+  return librettExecuteAccumulate(handle, idata, odata, alpha, 0.0);
+}
+
+//
+// Runs count tensors at idata + i*strideIn and odata + i*strideOut, strides in elements.
+// The batch is launched in chunks whose positions fit the index type of the plan.
+// Plans that cannot be batched run one tensor at a time.
+//
+static librettResult librettExecuteBatch(librettPlan_t& plan, const long long int count,
+  char* idata, const long long int strideIn, char* odata, const long long int strideOut) {
+
+  std::lock_guard<std::mutex> lock(plan.batchMutex);
+
+  int deviceID;
+  gpuDeviceProp_t prop;
+  getDeviceProp(deviceID, plan.stream, prop);
+
+  const long long int strideInBytes = strideIn*plan.sizeofType;
+  const long long int strideOutBytes = strideOut*plan.sizeofTypeOut;
+
+  long long int chunk = count;
+  if (!plan.index64) {
+    chunk = std::min<long long int>(chunk, INT_MAX/std::max(1LL, plan.tensorSplit.volMbar));
+    if (strideIn != 0) chunk = std::min<long long int>(chunk, (INT_MAX - plan.extentIn)/std::llabs(strideIn) + 1);
+    if (strideOut != 0) chunk = std::min<long long int>(chunk, (INT_MAX - plan.extentOut)/std::llabs(strideOut) + 1);
+  }
+
+  for (long long int i=0;i < count;i += chunk) {
+    const long long int n = std::min(chunk, count - i);
+    char* in = idata + i*strideInBytes;
+    char* out = odata + i*strideOutBytes;
+    if (n > 1 && plan.setupBatch(n, strideIn, strideOut, deviceID, prop)) {
+      if (!librettKernel(plan, plan.stream, in, out, 1.0, 0.0, true)) return LIBRETT_INTERNAL_ERROR;
+    } else {
+      for (long long int j=0;j < n;j++) {
+        if (!librettKernel(plan, plan.stream, in + j*strideInBytes, out + j*strideOutBytes)) return LIBRETT_INTERNAL_ERROR;
+      }
+    }
+  }
+
+  return LIBRETT_SUCCESS;
+}
+
+//
+// Runs count tensors at idata[i] and odata[i] in one launch per chunk, the kernels pick
+// each tensor from a device table of the pointers, see librettPlan_t::setupBatchPointers().
+// Plans that cannot be batched run one tensor at a time.
+//
+static librettResult librettExecuteBatchPointers(librettPlan_t& plan, const long long int count,
+  void** idata, void** odata) {
+
+  std::lock_guard<std::mutex> lock(plan.batchMutex);
+
+  int deviceID;
+  gpuDeviceProp_t prop;
+  getDeviceProp(deviceID, plan.stream, prop);
+
+  // Positions within a tensor fit the plan, only the batch rank can overflow
+  long long int chunk = count;
+  if (!plan.index64) chunk = std::min<long long int>(chunk, INT_MAX/std::max(1LL, plan.tensorSplit.volMbar));
+
+  for (long long int i=0;i < count;i += chunk) {
+    const long long int n = std::min(chunk, count - i);
+    if (n > 1 && plan.setupBatchPointers(n, idata + i, odata + i, deviceID, prop)) {
+      if (!librettKernel(plan, plan.stream, idata[i], odata[i], 1.0, 0.0, true)) return LIBRETT_INTERNAL_ERROR;
+    } else {
+      for (long long int j=i;j < i + n;j++) {
+        if (!librettKernel(plan, plan.stream, idata[j], odata[j])) return LIBRETT_INTERNAL_ERROR;
+      }
+    }
+  }
+
+  return LIBRETT_SUCCESS;
+}
+
+librettResult librettExecuteBatched(librettHandle handle, int count, void** idata, void** odata)
+{
+  // Keeps the plan from being destroyed during the call
+  PlanTable::Ref ref;
+  librettResult planResult = findPlan(handle, ref);
+  if (planResult != LIBRETT_SUCCESS) return planResult;
+
+  if (count < 0) return LIBRETT_INVALID_PARAMETER;
+  for (int i=0;i < count;i++) {
+    if (idata[i] == odata[i]) return LIBRETT_INVALID_PARAMETER;
+  }
+  if (count == 0) return LIBRETT_SUCCESS;
+
+  std::shared_ptr<librettPlan_t> held;
+  librettPlan_t& plan = executedPlan(*ref, held);
+
+  // Evenly spaced tensors are a strided batch
+  bool even = true;
+  long long int strideIn = 0;
+  long long int strideOut = 0;
+  if (count > 1) {
+    const long long int dIn = (long long int)((uintptr_t)idata[1] - (uintptr_t)idata[0]);
+    const long long int dOut = (long long int)((uintptr_t)odata[1] - (uintptr_t)odata[0]);
+    even = (dIn % (long long int)plan.sizeofType == 0) && (dOut % (long long int)plan.sizeofTypeOut == 0);
+    for (int i=2;i < count && even;i++) {
+      even = ((char *)idata[i] == (char *)idata[0] + i*dIn) && ((char *)odata[i] == (char *)odata[0] + i*dOut);
+    }
+    strideIn = dIn/(long long int)plan.sizeofType;
+    strideOut = dOut/(long long int)plan.sizeofTypeOut;
+  }
+  if (even) return librettExecuteBatch(plan, count, (char *)idata[0], strideIn, (char *)odata[0], strideOut);
+  return librettExecuteBatchPointers(plan, count, idata, odata);
+}
+
+librettResult librettExecuteBatchedStrided(librettHandle handle, int count, void* idata, long long int strideIn,
+  void* odata, long long int strideOut)
+{
+  // Keeps the plan from being destroyed during the call
+  PlanTable::Ref ref;
+  librettResult planResult = findPlan(handle, ref);
+  if (planResult != LIBRETT_SUCCESS) return planResult;
+
+  if (count < 0 || (idata == odata && strideIn == strideOut)) return LIBRETT_INVALID_PARAMETER;
+  if (count == 0) return LIBRETT_SUCCESS;
+
+  std::shared_ptr<librettPlan_t> held;
+  librettPlan_t& plan = executedPlan(*ref, held);
+  return librettExecuteBatch(plan, count, (char *)idata, strideIn, (char *)odata, strideOut);
+}
+
+librettResult librettExecuteGrouped(int count, librettHandle* handles, void** idata, void** odata)
+{
+  if (count < 0) return LIBRETT_INVALID_PARAMETER;
+
+  std::vector<PlanTable::Ref> refs(count);
+  std::vector< std::shared_ptr<librettPlan_t> > held(count);
+  std::vector<librettPlan_t*> plans(count);
+  for (int i=0;i < count;i++) {
+    librettResult planResult = findPlan(handles[i], refs[i]);
+    if (planResult != LIBRETT_SUCCESS) return planResult;
+    if (idata[i] == odata[i]) return LIBRETT_INVALID_PARAMETER;
+    plans[i] = &executedPlan(*refs[i], held[i]);
+  }
+  // A grouped launch runs on the device of its first plan
+  for (int i=1;i < count;i++) {
+    if (plans[i]->deviceID != plans[0]->deviceID) return LIBRETT_INVALID_PARAMETER;
+  }
+
+  std::lock_guard<std::mutex> lock(planSetupMutex);
+
+  // Plans without a grouped form run on their own, the rest in one launch per element size
+  std::vector<size_t> sizes;
+  for (int i=0;i < count;i++) {
+    if (!plans[i]->setupGrouped()) {
+      if (!librettKernel(*plans[i], plans[i]->stream, idata[i], odata[i])) return LIBRETT_INTERNAL_ERROR;
+    } else if (std::find(sizes.begin(), sizes.end(), plans[i]->sizeofType) == sizes.end()) {
+      sizes.push_back(plans[i]->sizeofType);
+    }
+  }
+
+  for (size_t sizeofType : sizes) {
+    std::vector<librettPlan_t*> groupPlans;
+    std::vector<void*> groupIn;
+    std::vector<void*> groupOut;
+    for (int i=0;i < count;i++) {
+      if (plans[i]->groupedMethod != Unknown && plans[i]->sizeofType == sizeofType) {
+        groupPlans.push_back(plans[i]);
+        groupIn.push_back(idata[i]);
+        groupOut.push_back(odata[i]);
+      }
+    }
+    int deviceID;
+    gpuDeviceProp_t prop;
+    getDeviceProp(deviceID, groupPlans[0]->stream, prop);
+    if (!librettKernelGrouped(groupPlans.size(), groupPlans.data(), groupIn.data(), groupOut.data(), prop))
+      return LIBRETT_INTERNAL_ERROR;
+  }
+
+  return LIBRETT_SUCCESS;
+}
+
+librettResult librettExecuteInPlace(librettHandle handle, void *data)
+{
+  // Keeps the plan from being destroyed during the call
+  PlanTable::Ref ref;
+  librettResult planResult = findPlan(handle, ref);
+  if (planResult != LIBRETT_SUCCESS) return planResult;
+
+  librettPlan_t& plan = *ref;
+
+  // Input and output elements must have the same type and dense layout
+  if (plan.typeIn != -1 || plan.strided) return LIBRETT_INVALID_PARAMETER;
+
+#if LIBRETT_USES_CPU
+  const int redRank = plan.redDim.size();
+  if (!inPlaceTranspose(redRank, plan.redDim.data(), plan.redPermutation.data(), plan.sizeofType, data))
+    return LIBRETT_INTERNAL_ERROR;
+  return LIBRETT_SUCCESS;
+#else
+  // Cycle following has no device implementation
+  (void)data;
+  return LIBRETT_INVALID_PARAMETER;
+#endif
+}
+
+librettResult librettPlanCacheSetCapacity(int capacity)
+{
+  if (capacity < 0) return LIBRETT_INVALID_PARAMETER;
+  planCacheCapacity = capacity;
+  planCache.setCapacity(capacity);
+  return LIBRETT_SUCCESS;
+}
+
+librettResult librettPlanCacheGetStats(long long int* hits, long long int* misses, int* size)
+{
+  if (hits != nullptr) *hits = planCacheHits;
+  if (misses != nullptr) *misses = planCacheMisses;
+  if (size != nullptr) *size = (int)planCache.size();
+  return LIBRETT_SUCCESS;
+}
+
+librettResult librettPlanCacheClear()
+{
+  planCache.clear();
+  planCacheHits = 0;
+  planCacheMisses = 0;
+  return LIBRETT_SUCCESS;
+}
+
+librettResult librettDescriptorArenaGetStats(size_t* reserved, size_t* inUse, size_t* peak)
+{
+  DescriptorArena::Stats stats = DescriptorArena::getTotalStats();
+  if (reserved != NULL) *reserved = stats.reserved;
+  if (inUse != NULL) *inUse = stats.inUse;
+  if (peak != NULL) *peak = stats.peak;
+  return LIBRETT_SUCCESS;
+}
+
+librettResult librettSetPlanThreads(int numThread)
+{
+  if (numThread < 0) return LIBRETT_INVALID_PARAMETER;
+  std::shared_ptr<ThreadPool> pool;
+  if (numThread > 0) pool = std::make_shared<ThreadPool>(numThread);
+  std::lock_guard<std::mutex> lock(planPoolMutex);
+  planPool = pool;
+  return LIBRETT_SUCCESS;
+}
+
+librettResult librettExportWisdom(const char* path)
+{
+  if (path == nullptr || !wisdomExport(path)) return LIBRETT_INVALID_PARAMETER;
+  return LIBRETT_SUCCESS;
+}
+
+librettResult librettImportWisdom(const char* path)
+{
+  if (path == nullptr || !wisdomImport(path)) return LIBRETT_INVALID_PARAMETER;
+  // Cached plans were chosen without the new entries
+  planCache.clear();
+  return LIBRETT_SUCCESS;
+}
+
+//
+// Tensors timed by librettCalibrateModel(). Their candidates cover the Tiled, TiledCopy,
+// Packed and PackedSplit kernels with a range of transactions per request
+//
+static const int NUM_CALIBRATION_TENSOR = 10;
+static const std::vector<int> calibrationDim[NUM_CALIBRATION_TENSOR] = {
+  {512, 512}, {2048, 96}, {64, 64, 64}, {64, 64, 64}, {64, 64, 64}, {1000, 7, 37},
+  {5, 300, 171}, {32, 32, 32, 32}, {12, 12, 12, 12, 12}, {3, 3, 3, 3, 3, 2000}};
+static const std::vector<int> calibrationPermutation[NUM_CALIBRATION_TENSOR] = {
+  {1, 0}, {1, 0}, {2, 1, 0}, {1, 0, 2}, {0, 2, 1}, {2, 0, 1},
+  {1, 2, 0}, {3, 2, 1, 0}, {4, 1, 3, 0, 2}, {5, 1, 3, 0, 4, 2}};
+
+librettResult librettCalibrateModel(gpuStream_t& stream, void* idata, void* odata, size_t size,
+  const char* samplePath)
+{
+#if SYCL
+  if(stream == nullptr) {
+    throw std::runtime_error("[SYCL] pass a valid/non-nullptr SYCL queue to the plan constructor!");
+  }
+#endif
+
+  if (idata == odata) return LIBRETT_INVALID_PARAMETER;
+
+  int deviceID;
+  gpuDeviceProp_t prop;
+  getDeviceProp(deviceID, stream, prop);
+
+  GpuModelProp gpuModelProp(gpuMajor);
+  Timer timer;
+
+  // Memory bandwidth from the copy kernel of GpuMemcpy.cpp, the best of a few runs
+  const int numCopy = (int)std::min<size_t>(size/sizeof(long long int), INT_MAX);
+  if (numCopy == 0) return LIBRETT_INVALID_PARAMETER;
+  vectorCopy<long long int>(numCopy, (long long int *)idata, (long long int *)odata, stream);
+  for (int rep=0;rep < 3;rep++) {
+    timer.start();
+    vectorCopy<long long int>(numCopy, (long long int *)idata, (long long int *)odata, stream);
+    timer.stop();
+    const double bandwidth = 2.0*(double)numCopy*sizeof(long long int)/timer.seconds()/1.0e9;
+    gpuModelProp.mem_BW = std::max(gpuModelProp.mem_BW, bandwidth);
+  }
+  const GpuModelDevice device = gpuModelDevice(prop, gpuModelProp);
+
+  // Time every candidate of the tensors that fit in size bytes
+  std::vector<GpuModelSample> samples;
+  const size_t sizeofTypes[2] = {4, 8};
+  for (int t=0;t < NUM_CALIBRATION_TENSOR;t++) {
+    std::vector<int> dim = calibrationDim[t];
+    std::vector<int> permutation = calibrationPermutation[t];
+    const int rank = (int)dim.size();
+    for (size_t sizeofType : sizeofTypes) {
+      size_t numBytes = sizeofType;
+      for (int i=0;i < rank;i++) numBytes *= dim[i];
+      if (numBytes > size) continue;
+
+      std::vector<int> redDim;
+      std::vector<int> redPermutation;
+      reduceRanks(rank, dim.data(), permutation.data(), redDim, redPermutation);
+      std::list<librettPlan_t> plans;
+      if (!librettPlan_t::createPlans(rank, dim.data(), permutation.data(), redDim.size(), redDim.data(),
+        redPermutation.data(), sizeofType, deviceID, prop, plans)) return LIBRETT_INTERNAL_ERROR;
+      std::vector<librettPlan_t*> candidates;
+      for (auto it=plans.begin();it != plans.end();it++) candidates.push_back(&(*it));
+      if (!countCandidates(candidates, prop, false)) return LIBRETT_INTERNAL_ERROR;
+
+      for (auto it=plans.begin();it != plans.end();it++) {
+        if (it->tensorSplit.method == Trivial) continue;
+        it->setStream(stream);
+        it->activate();
+        // Warm-up run, then the median of three
+        if (!librettKernel(*it, stream, idata, odata)) return LIBRETT_INTERNAL_ERROR;
+        double times[3];
+        for (int rep=0;rep < 3;rep++) {
+          timer.start();
+          if (!librettKernel(*it, stream, idata, odata)) return LIBRETT_INTERNAL_ERROR;
+          timer.stop();
+          times[rep] = timer.seconds();
+        }
+        std::sort(times, times + 3);
+        GpuModelSample sample;
+        sample.counters = gpuModelCounters(*it);
+        sample.seconds = times[1];
+        samples.push_back(sample);
+      }
+    }
+  }
+
+  if ((int)samples.size() < MODEL_FIT_MIN_SAMPLE) return LIBRETT_INVALID_PARAMETER;
+  if (!modelFit(device, samples, gpuModelProp)) return LIBRETT_INTERNAL_ERROR;
+  if (samplePath != nullptr && !modelSamplesWrite(samplePath, deviceName(prop), gpuMajor, device, samples))
+    return LIBRETT_INVALID_PARAMETER;
+  modelProfileRecord(deviceName(prop), gpuModelProp);
+  // Cached plans were chosen with the old parameters
+  planCache.clear();
+  return LIBRETT_SUCCESS;
+}
+
+librettResult librettFitModel(const char* samplePath)
+{
+  std::string name;
+  int major;
+  GpuModelDevice device;
+  std::vector<GpuModelSample> samples;
+  if (samplePath == nullptr || !modelSamplesRead(samplePath, name, major, device, samples))
+    return LIBRETT_INVALID_PARAMETER;
+  GpuModelProp gpuModelProp(major);
+  gpuModelProp.mem_BW = device.mem_BW;
+  if (!modelFit(device, samples, gpuModelProp)) return LIBRETT_INVALID_PARAMETER;
+  modelProfileRecord(name, gpuModelProp);
+  planCache.clear();
+  return LIBRETT_SUCCESS;
+}
+
+librettResult librettExportModelProfile(const char* path)
+{
+  if (path == nullptr || !modelProfileExport(path)) return LIBRETT_INVALID_PARAMETER;
+  return LIBRETT_SUCCESS;
+}
+
+librettResult librettImportModelProfile(const char* path)
+{
+  if (path == nullptr || !modelProfileImport(path)) return LIBRETT_INVALID_PARAMETER;
+  // Cached plans were chosen with the old parameters
+  planCache.clear();
+  return LIBRETT_SUCCESS;
+}
+
+librettResult librettExportDeviceProfile(gpuStream_t& stream, const char* path)
+{
+#if SYCL
+  if(stream == nullptr) {
+    throw std::runtime_error("[SYCL] pass a valid/non-nullptr SYCL queue to the plan constructor!");
+  }
+#endif
+
+  if (path == nullptr) return LIBRETT_INVALID_PARAMETER;
+
+  int deviceID;
+  gpuDeviceProp_t prop;
+  getDeviceProp(deviceID, stream, prop);
+  DeviceProfile profile = deviceProfileOf(prop);
+  librettKernelResources(profile.kernels);
+  if (!deviceProfileWrite(path, profile)) return LIBRETT_INVALID_PARAMETER;
+  return LIBRETT_SUCCESS;
+}
+
+librettResult librettPlanOffline(const char* deviceProfilePath, int rank, int* dim, int* permutation,
+  size_t sizeofType)
+{
+  librettResult inpCheck = librettPlanCheckInput(rank, dim, permutation, sizeofType);
+  if (inpCheck != LIBRETT_SUCCESS) return inpCheck;
+
+  // The profile stands in for the device, its plans have a negative deviceID
+  int deviceID;
+  if (deviceProfilePath == nullptr || !deviceProfileLoad(deviceProfilePath, deviceID))
+    return LIBRETT_INVALID_PARAMETER;
+  const DeviceProfile* profile = deviceProfileGet(deviceID);
+  // Candidates and their model depend on the kernels of the backend
+  if (profile->backend != deviceProfileBackend()) return LIBRETT_INVALID_PARAMETER;
+  gpuDeviceProp_t prop;
+  deviceProfileProp(*profile, prop);
+
+  std::vector<int> redDim;
+  std::vector<int> redPermutation;
+  reduceRanks(rank, dim, permutation, redDim, redPermutation);
+  std::list<librettPlan_t> plans;
+  if (!librettPlan_t::createPlans(rank, dim, permutation, redDim.size(), redDim.data(), redPermutation.data(),
+    sizeofType, deviceID, prop, plans)) return LIBRETT_INTERNAL_ERROR;
+  std::vector<librettPlan_t*> candidates;
+  for (auto it=plans.begin();it != plans.end();it++) candidates.push_back(&(*it));
+  if (!countCandidates(candidates, prop, false)) return LIBRETT_INTERNAL_ERROR;
+  auto bestPlan = choosePlanHeuristic(plans);
+  if (bestPlan == plans.end()) return LIBRETT_INTERNAL_ERROR;
+
+  wisdomRecord(wisdomKey(prop, redDim, redPermutation, sizeofType), *bestPlan);
+  // Cached plans of the device of the profile were chosen without the entry
+  planCache.clear();
   return LIBRETT_SUCCESS;
 }
 
 void librettInitialize() {
+  const char* wisdomPath = std::getenv("LIBRETT_WISDOM");
+  if (wisdomPath != nullptr && !wisdomImport(wisdomPath)) {
+    printf("librettInitialize: cannot read wisdom file %s\n", wisdomPath);
+  }
+  const char* profilePath = std::getenv("LIBRETT_MODEL_PROFILE");
+  if (profilePath != nullptr && !modelProfileImport(profilePath)) {
+    printf("librettInitialize: cannot read model profile file %s\n", profilePath);
+  }
 #ifdef LIBRETT_HAS_UMPIRE
   const char* alloc_env_var = std::getenv("LIBRETT_USES_THIS_UMPIRE_ALLOCATOR");
 #define __LIBRETT_STRINGIZE(x) #x
@@ -395,6 +1462,14 @@ void librettInitialize() {
 }
 
 void librettFinalize() {
+  planWorkerStop();
+  std::vector<librettHandle> pending;
+  {
+    std::lock_guard<std::mutex> lock(pendingPlansMutex);
+    for (auto it=pendingPlans.begin();it != pendingPlans.end();it++) pending.push_back(it->first);
+  }
+  for (librettHandle handle : pending) waitPlan(handle);
+  planCache.clear();
 }
 
 #if SYCL
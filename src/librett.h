@@ -28,6 +28,8 @@ SOFTWARE.
 #ifdef SYCL
   #include <sycl/sycl.hpp>
   using librett_gpuStream_t     = sycl::queue*;
+#elif LIBRETT_USES_CPU
+  using librett_gpuStream_t     = void*;
 #elif HIP
   #include <hip/hip_runtime.h>
   using librett_gpuStream_t     = hipStream_t;
@@ -36,7 +38,9 @@ SOFTWARE.
   using librett_gpuStream_t     = cudaStream_t;
 #endif
 
-// Handle type that is used to store and access librett plans
+// Handle type that is used to store and access librett plans. The handle of a destroyed
+// plan is invalid; it is given to a new plan only after 1024 more plans have been
+// destroyed in its place
 typedef unsigned int librettHandle;
 
 // Return value
@@ -47,18 +51,30 @@ typedef enum librettResult_t {
   LIBRETT_INVALID_DEVICE,     // Execution tried on device different than where plan was created
   LIBRETT_INTERNAL_ERROR,     // Internal error
   LIBRETT_UNDEFINED_ERROR,    // Undefined error
+  LIBRETT_PLAN_PENDING,       // Plan of librettPlanAsync() is not ready yet
 } librettResult;
 
+// Element types of converting plans, see librettPlanConvert()
+typedef enum librettDataType_t {
+  LIBRETT_FLOAT64,            // double
+  LIBRETT_FLOAT32,            // float
+  LIBRETT_FLOAT16,            // IEEE half precision (binary16)
+  LIBRETT_BFLOAT16,           // bfloat16
+} librettDataType;
+
 // Initializes LIBRETT
 //
-// This is only needed for the Umpire allocator's lifetime management:
 // - if LIBRETT_HAS_UMPIRE is defined, will grab Umpire's allocator;
-// - otherwise this is a no-op
+// - if the LIBRETT_WISDOM environment variable is set, imports the wisdom file it names,
+//   see librettImportWisdom()
+// - if the LIBRETT_MODEL_PROFILE environment variable is set, imports the model profile
+//   file it names, see librettImportModelProfile()
 void librettInitialize();
 
 // Finalizes LIBRETT
 //
-// This is currently a no-op
+// Waits for the plans of librettPlanAsync(), stops their worker thread and empties the
+// plan cache, see librettPlanCacheSetCapacity()
 void librettFinalize();
 
 //
@@ -69,7 +85,7 @@ void librettFinalize();
 // rank              = Rank of the tensor
 // dim[rank]         = Dimensions of the tensor
 // permutation[rank] = Transpose permutation
-// sizeofType        = Size of the elements of the tensor in bytes (=4 or 8)
+// sizeofType        = Size of the elements of the tensor in bytes (=1, 2, 4, 8 or 16)
 // stream            = CUDA stream (0 if no stream is used)
 //
 // Returns
@@ -77,15 +93,160 @@ void librettFinalize();
 //
 librettResult librettPlan(librettHandle* handle, int rank, int* dim, int* permutation, size_t sizeofType, librett_gpuStream_t& stream);
 
+//
+// Create plan on a background thread
+//
+// Same as librettPlan() except that the handle is returned right away and the performance
+// model runs on a background worker thread, overlapping with the caller and with earlier
+// transposes. The worker creates the pending plans one after another.
+// Functions that take the handle wait for the plan and return the error of the planning,
+// if any. Wait for or destroy pending plans before the program exits, librettFinalize()
+// waits for all of them.
+//
+// Parameters
+// handle            = Returned handle to LIBRETT plan
+// rank              = Rank of the tensor
+// dim[rank]         = Dimensions of the tensor
+// permutation[rank] = Transpose permutation
+// sizeofType        = Size of the elements of the tensor in bytes (=1, 2, 4, 8 or 16)
+// stream            = CUDA stream (0 if no stream is used)
+//
+// Returns
+// Success/unsuccess code of the input check
+//
+librettResult librettPlanAsync(librettHandle* handle, int rank, int* dim, int* permutation, size_t sizeofType,
+                               librett_gpuStream_t& stream);
+
+//
+// Poll a plan of librettPlanAsync()
+//
+// Parameters
+// handle            = Handle to the LIBRETT plan
+//
+// Returns
+// LIBRETT_PLAN_PENDING while the plan is being created, LIBRETT_SUCCESS when it is ready,
+// otherwise the error of the planning
+//
+librettResult librettPlanQuery(librettHandle handle);
+
+//
+// Wait for a plan of librettPlanAsync()
+//
+// Parameters
+// handle            = Handle to the LIBRETT plan
+//
+// Returns
+// LIBRETT_SUCCESS when the plan is ready, otherwise the error of the planning
+//
+librettResult librettPlanWait(librettHandle handle);
+
+//
+// Create plan for accumulating execution, librettExecuteAccumulate() with beta != 0
+//
+// Same as librettPlan() except that the performance model counts the reads of odata,
+// which can change the chosen implementation. Any plan can be executed in any mode.
+//
+// Parameters
+// handle            = Returned handle to LIBRETT plan
+// rank              = Rank of the tensor
+// dim[rank]         = Dimensions of the tensor
+// permutation[rank] = Transpose permutation
+// sizeofType        = Size of the elements of the tensor in bytes (=1, 2, 4, 8 or 16)
+// stream            = CUDA stream (0 if no stream is used)
+//
+// Returns
+// Success/unsuccess code
+//
+librettResult librettPlanAccumulate(librettHandle* handle, int rank, int* dim, int* permutation, size_t sizeofType,
+                                    librett_gpuStream_t& stream);
+
+//
+// Create plan that converts the elements during the transpose
+//
+// The elements are converted in the store stage of the transpose, so one pass replaces a
+// transpose followed by a conversion kernel. Supported conversions are
+// FLOAT64 <-> FLOAT32, FLOAT32 <-> FLOAT16 and FLOAT32 <-> BFLOAT16. Narrowing conversions
+// round to nearest even. The plan is executed with librettExecute(), idata holds typeIn
+// and odata typeOut elements. Scaling and in-place execution are not supported.
+//
+// Parameters
+// handle            = Returned handle to LIBRETT plan
+// rank              = Rank of the tensor
+// dim[rank]         = Dimensions of the tensor
+// permutation[rank] = Transpose permutation
+// typeIn            = Type of the input elements
+// typeOut           = Type of the output elements
+// stream            = CUDA stream (0 if no stream is used)
+//
+// Returns
+// Success/unsuccess code
+//
+librettResult librettPlanConvert(librettHandle* handle, int rank, int* dim, int* permutation,
+                                 librettDataType typeIn, librettDataType typeOut, librett_gpuStream_t& stream);
+
+//
+// Create plan for strided input and output tensors
+//
+// Transposes a sub-tensor view or writes into an output with padded leading dimensions
+// without a packing copy. Strides are in elements. The leading strides must be 1 and
+// every stride must be at least the extent of the previous rank, i.e.
+// inStride[i] >= inStride[i-1]*dim[i-1]. Elements between the strided positions are
+// not touched. Strided plans do not support in-place execution.
+//
+// Parameters
+// handle            = Returned handle to LIBRETT plan
+// rank              = Rank of the tensor
+// dim[rank]         = Dimensions of the tensor
+// inStride[rank]    = Strides of the input tensor, in input order
+// outStride[rank]   = Strides of the output tensor, in output order: outStride[i] is the
+//                     stride of dimension dim[permutation[i]]
+// permutation[rank] = Transpose permutation
+// sizeofType        = Size of the elements of the tensor in bytes (=1, 2, 4, 8 or 16)
+// stream            = CUDA stream (0 if no stream is used)
+//
+// Returns
+// Success/unsuccess code
+//
+librettResult librettPlanStrided(librettHandle* handle, int rank, int* dim, long long int* inStride,
+                                 long long int* outStride, int* permutation, size_t sizeofType,
+                                 librett_gpuStream_t& stream);
+
+//
+// Create plans for count tensors in one call
+//
+// Same as calling librettPlan() for every tensor, with the planning work shared: the device
+// is queried once, tensors that reduce to the same ranks and element size are planned once,
+// the candidates of all tensors are modeled in parallel and the descriptors of all plans
+// are uploaded into one device allocation. The plans do not go through the plan cache.
+//
+// Parameters
+// count             = Number of tensors
+// handles[count]    = Returned handles to LIBRETT plans
+// rank[count]       = Ranks of the tensors
+// dim[count]        = Dimensions of the tensors, dim[i][rank[i]]
+// permutation[count]= Transpose permutations, permutation[i][rank[i]]
+// sizeofType[count] = Size of the elements of the tensors in bytes (=1, 2, 4, 8 or 16)
+// stream            = CUDA stream (0 if no stream is used)
+//
+// Returns
+// Success/unsuccess code
+//
+librettResult librettPlanMany(int count, librettHandle* handles, int* rank, int** dim, int** permutation,
+                              size_t* sizeofType, librett_gpuStream_t& stream);
+
 //
 // Create plan and choose implementation by measuring performance
 //
+// The choice is kept as wisdom for the device, dimensions, permutation and element size.
+// Later calls of librettPlan() and librettPlanMeasure() for the same tensor take the plan
+// from wisdom without measuring, see librettExportWisdom()
+//
 // Parameters
 // handle            = Returned handle to LIBRETT plan
 // rank              = Rank of the tensor
 // dim[rank]         = Dimensions of the tensor
 // permutation[rank] = Transpose permutation
-// sizeofType        = Size of the elements of the tensor in bytes (=4 or 8)
+// sizeofType        = Size of the elements of the tensor in bytes (=1, 2, 4, 8 or 16)
 // stream            = CUDA stream (0 if no stream is used)
 // idata             = Input data size product(dim)
 // odata             = Output data size product(dim)
@@ -96,6 +257,64 @@ librettResult librettPlan(librettHandle* handle, int rank, int* dim, int* permut
 librettResult librettPlanMeasure(librettHandle* handle, int rank, int* dim, int* permutation, size_t sizeofType,
                                  librett_gpuStream_t& stream, void* idata, void* odata);
 
+//
+// Create plan by measuring the best candidates of the performance model
+//
+// The candidates are ranked by the model of librettPlan() and only the topK best are
+// measured. Each of them runs once to warm up and numRep more times, and the candidate with
+// the lowest median time is chosen. Planning costs about topK*(numRep + 1) executions, where
+// librettPlanMeasure() runs every candidate once. The choice is kept as wisdom like the
+// choice of librettPlanMeasure()
+//
+// Parameters
+// handle            = Returned handle to LIBRETT plan
+// rank              = Rank of the tensor
+// dim[rank]         = Dimensions of the tensor
+// permutation[rank] = Transpose permutation
+// sizeofType        = Size of the elements of the tensor in bytes (=1, 2, 4, 8 or 16)
+// stream            = CUDA stream (0 if no stream is used)
+// idata             = Input data size product(dim)
+// odata             = Output data size product(dim)
+// topK              = Number of candidates to measure, 1 measures the plan of librettPlan() only
+// numRep            = Number of timed runs of each candidate
+//
+// Returns
+// Success/unsuccess code
+//
+librettResult librettPlanMeasureTopK(librettHandle* handle, int rank, int* dim, int* permutation, size_t sizeofType,
+                                     librett_gpuStream_t& stream, void* idata, void* odata, int topK, int numRep);
+
+//
+// Create plan that chooses its implementation from its own executions
+//
+// The numCandidate best candidates of the performance model are activated, and the first
+// numExplore executions of the plan run them in turn and time them. Candidates that are
+// clearly slower than the best one are dropped early. The next execution chooses the
+// candidate with the lowest median time and frees the others. The choice is kept as wisdom
+// like the choice of librettPlanMeasure(), so later plans of the tensor start with it.
+// Tensors that already have wisdom get the plan of wisdom and do not explore.
+//
+// Executions of librettExecute(), librettExecuteOnStream(), librettExecuteAccumulate() and
+// librettExecuteScaled() are timed. Batched and grouped executions run the best candidate
+// of the model until the choice is made. Exploring executions of a plan are serialized;
+// on SYCL and CPU builds each of them waits for its transpose to finish.
+//
+// Parameters
+// handle            = Returned handle to LIBRETT plan
+// rank              = Rank of the tensor
+// dim[rank]         = Dimensions of the tensor
+// permutation[rank] = Transpose permutation
+// sizeofType        = Size of the elements of the tensor in bytes (=1, 2, 4, 8 or 16)
+// stream            = CUDA stream (0 if no stream is used)
+// numCandidate      = Number of candidates to explore, 1 gives the plan of librettPlan()
+// numExplore        = Number of timed executions
+//
+// Returns
+// Success/unsuccess code
+//
+librettResult librettPlanAdaptive(librettHandle* handle, int rank, int* dim, int* permutation, size_t sizeofType,
+                                  librett_gpuStream_t& stream, int numCandidate, int numExplore);
+
 //
 // Destroy plan
 //
@@ -107,6 +326,219 @@ librettResult librettPlanMeasure(librettHandle* handle, int rank, int* dim, int*
 //
 librettResult librettDestroy(librettHandle handle);
 
+//
+// Set the capacity of the plan cache
+//
+// librettPlan(), librettPlanAccumulate(), librettPlanConvert() and librettPlanStrided()
+// keep the plans they create in a process-wide cache, keyed on the reduced dimensions,
+// permutation and strides, element size and types and device. Repeated calls return a new
+// handle that shares the device descriptors of the cached plan, without running the
+// performance model again. Shared descriptors are reference counted, librettDestroy() is
+// safe in any order. Least recently used plans are dropped when the cache is full.
+// The default capacity is 256 plans, capacity 0 disables the cache.
+//
+// Parameters
+// capacity          = Maximum number of cached plans
+//
+// Returns
+// Success/unsuccess code
+//
+librettResult librettPlanCacheSetCapacity(int capacity);
+
+//
+// Get plan cache statistics
+//
+// Parameters
+// hits              = Number of plans returned from the cache (can be NULL)
+// misses            = Number of plans created and added to the cache (can be NULL)
+// size              = Number of plans in the cache (can be NULL)
+//
+// Returns
+// Success/unsuccess code
+//
+librettResult librettPlanCacheGetStats(long long int* hits, long long int* misses, int* size);
+
+//
+// Empty the plan cache and reset its statistics. Existing handles stay valid.
+//
+// Returns
+// Success/unsuccess code
+//
+librettResult librettPlanCacheClear();
+
+//
+// Get statistics of the descriptor arena
+//
+// Plan descriptors too long to be passed to the kernels as arguments are sub-allocated
+// from device memory chunks that librett keeps for reuse, so creating and destroying plans
+// does not allocate or free device memory one descriptor at a time. The statistics are
+// summed over all devices.
+//
+// Parameters
+// reserved          = Bytes of device memory held by the arena (can be NULL)
+// inUse             = Bytes of descriptors of live plans (can be NULL)
+// peak              = Largest inUse so far (can be NULL)
+//
+// Returns
+// Success/unsuccess code
+//
+librettResult librettDescriptorArenaGetStats(size_t* reserved, size_t* inUse, size_t* peak);
+
+//
+// Set the number of host threads that run the performance model in librettPlan(),
+// librettPlanAccumulate(), librettPlanConvert() and librettPlanStrided()
+//
+// The plan candidates are modeled concurrently. The chosen plan is the same for any
+// number of threads.
+//
+// Parameters
+// numThread         = Number of threads, 1 models the candidates serially and 0 (default)
+//                     uses the library thread pool of LIBRETT_NUM_THREADS or all hardware threads
+//
+// Returns
+// Success/unsuccess code
+//
+librettResult librettSetPlanThreads(int numThread);
+
+//
+// Write wisdom to a file
+//
+// Wisdom holds the plans chosen by librettPlanMeasure(): the tensor split and launch
+// configuration per device name, dimensions, permutation and element size. The file is
+// text and can hold entries of several devices.
+//
+// Parameters
+// path              = Name of the file
+//
+// Returns
+// Success/unsuccess code, LIBRETT_INVALID_PARAMETER if the file cannot be written
+//
+librettResult librettExportWisdom(const char* path);
+
+//
+// Read wisdom from a file written by librettExportWisdom()
+//
+// Entries are added to the wisdom in memory, replacing entries of the same tensor and device.
+// The plan cache is emptied so that later librettPlan() calls use the new entries. Entries
+// that do not match a plan of this library version are ignored.
+//
+// Parameters
+// path              = Name of the file
+//
+// Returns
+// Success/unsuccess code, LIBRETT_INVALID_PARAMETER if the file cannot be read
+//
+librettResult librettImportWisdom(const char* path);
+
+//
+// Calibrate the performance model of librettPlan() for the device of stream
+//
+// Measures the memory bandwidth with a copy kernel and times every candidate plan of a set
+// of tensors, those that fit in size bytes. The parameters of the model are fitted to the
+// timings by least squares and kept as the model profile of the device, which replaces the
+// defaults of its architecture in later plans, see librettExportModelProfile(). CPU builds
+// plan with a host model that does not use the profile.
+//
+// Parameters
+// stream            = CUDA stream (0 if no stream is used)
+// idata             = Input data of size bytes
+// odata             = Output data of size bytes
+// size              = Size of idata and odata in bytes. 8 MB covers all tensors, the
+//                     bandwidth is measured by copying all of it
+// samplePath        = File the timings are written to for librettFitModel(), or NULL
+//
+// Returns
+// Success/unsuccess code, LIBRETT_INVALID_PARAMETER if too few tensors fit in size or the
+// sample file cannot be written
+//
+librettResult librettCalibrateModel(librett_gpuStream_t& stream, void* idata, void* odata, size_t size,
+                                    const char* samplePath);
+
+//
+// Fit the model profile of a device to timings written by librettCalibrateModel()
+//
+// Needs no device, the file holds the device constants and the counters of the timed
+// kernels. The profile is kept under the name of the device of the file.
+//
+// Parameters
+// samplePath        = Name of the file
+//
+// Returns
+// Success/unsuccess code, LIBRETT_INVALID_PARAMETER if the file cannot be read or has too
+// few timings
+//
+librettResult librettFitModel(const char* samplePath);
+
+//
+// Write the model profiles to a file
+//
+// The file is text, one line per device with the parameters of the model and the name of
+// the device.
+//
+// Parameters
+// path              = Name of the file
+//
+// Returns
+// Success/unsuccess code, LIBRETT_INVALID_PARAMETER if the file cannot be written
+//
+librettResult librettExportModelProfile(const char* path);
+
+//
+// Read model profiles from a file written by librettExportModelProfile()
+//
+// Profiles replace the profiles of the same devices. The plan cache is emptied so that
+// later librettPlan() calls use them.
+//
+// Parameters
+// path              = Name of the file
+//
+// Returns
+// Success/unsuccess code, LIBRETT_INVALID_PARAMETER if the file cannot be read
+//
+librettResult librettImportModelProfile(const char* path);
+
+//
+// Write the device profile of the device of stream to a file
+//
+// The profile holds the properties that planning depends on: warp size, multiprocessors,
+// thread, block, register and shared memory limits, clocks and memory bus, and the
+// registers and shared memory of the kernels. It lets librettPlanOffline() plan for the
+// device on a node without it.
+//
+// Parameters
+// stream            = CUDA stream (0 if no stream is used)
+// path              = Name of the file
+//
+// Returns
+// Success/unsuccess code, LIBRETT_INVALID_PARAMETER if the file cannot be written
+//
+librettResult librettExportDeviceProfile(librett_gpuStream_t& stream, const char* path);
+
+//
+// Plan a tensor for the device of a profile written by librettExportDeviceProfile()
+//
+// Runs the performance model of librettPlan() with the properties of the profile and
+// computes the occupancy of the kernels from it, without a device. The choice is kept as
+// wisdom of the device of the profile, export it with librettExportWisdom() and import it
+// on the device with librettImportWisdom(). The model profile of the device is used if
+// one has been imported, see librettImportModelProfile(). The profile must come from a
+// build of the same backend, e.g. CUDA builds plan for NVIDIA devices, and is read once
+// per path.
+//
+// Parameters
+// deviceProfilePath = Name of the device profile file
+// rank              = Rank of the tensor
+// dim[rank]         = Dimensions of the tensor
+// permutation[rank] = Transpose permutation
+// sizeofType        = Size of the elements of the tensor in bytes (=1, 2, 4, 8 or 16)
+//
+// Returns
+// Success/unsuccess code, LIBRETT_INVALID_PARAMETER if the profile cannot be read or is of
+// another backend
+//
+librettResult librettPlanOffline(const char* deviceProfilePath, int rank, int* dim, int* permutation,
+                                 size_t sizeofType);
+
 //
 // Execute plan out-of-place
 //
@@ -120,4 +552,143 @@ librettResult librettDestroy(librettHandle handle);
 //
 librettResult librettExecute(librettHandle handle, void* idata, void* odata);
 
+//
+// Execute plan out-of-place on a stream other than the one it was created with
+//
+// A plan is not changed by its execution, so librettExecute() and librettExecuteOnStream()
+// of one plan may be called concurrently from any number of host threads and on any
+// number of streams. Batched and grouped execution of the same plan are serialized.
+// The plan must not be destroyed while calls that use it are in progress; work queued on
+// stream by earlier calls may still be running.
+//
+// Parameters
+// handle            = Returned handle to LIBRETT plan
+// stream            = Stream (SYCL queue) of the launch, on the device of the plan
+// idata             = Input data size product(dim)
+// odata             = Output data size product(dim)
+//
+// Returns
+// Success/unsuccess code
+//
+librettResult librettExecuteOnStream(librettHandle handle, librett_gpuStream_t stream, void* idata, void* odata);
+
+//
+// Execute plan out-of-place with scaling: odata = alpha*permute(idata)
+//
+// Scaling is fused into the store stage of the transpose. Elements are taken to be
+// float (sizeofType = 4), double (8) or double complex (16), a complex element is
+// scaled component-wise. Elements of 1 and 2 bytes only allow alpha = 1.
+//
+// Parameters
+// handle            = Returned handle to LIBRETT plan
+// idata             = Input data size product(dim)
+// odata             = Output data size product(dim)
+// alpha             = Scaling factor of idata
+//
+// Returns
+// Success/unsuccess code
+//
+librettResult librettExecuteScaled(librettHandle handle, void* idata, void* odata, double alpha);
+
+//
+// Execute plan out-of-place with accumulation: odata = alpha*permute(idata) + beta*odata
+//
+// Element types are as in librettExecuteScaled(). odata is only read when beta != 0,
+// plans made with librettPlanAccumulate() take this read traffic into account.
+//
+// Parameters
+// handle            = Returned handle to LIBRETT plan
+// idata             = Input data size product(dim)
+// odata             = Output data size product(dim)
+// alpha             = Scaling factor of idata
+// beta              = Scaling factor of odata
+//
+// Returns
+// Success/unsuccess code
+//
+librettResult librettExecuteAccumulate(librettHandle handle, void* idata, void* odata, double alpha, double beta);
+
+//
+// Execute plan in-place
+//
+// The tensor is permuted within its own buffer by cycle following, which halves the
+// peak memory footprint compared to librettExecute(). The extra memory is one bit per
+// moved run of elements plus a few MB of scratch. Expect a fraction of the out-of-place
+// bandwidth. Only the CPU backend runs in-place, CUDA, HIP and SYCL builds return
+// LIBRETT_INVALID_PARAMETER.
+//
+// Parameters
+// handle            = Returned handle to LIBRETT plan
+// data              = Input and output data size product(dim)
+//
+// Returns
+// Success/unsuccess code
+//
+librettResult librettExecuteInPlace(librettHandle handle, void* data);
+
+//
+// Execute plan on a batch of tensors
+//
+// Runs librettExecute() on idata[i] -> odata[i] for i = 0 ... count-1. The whole batch runs
+// in one kernel launch: evenly spaced tensors as in librettExecuteBatchedStrided(), other
+// tensors through a device copy of the pointer arrays. Trivial plans, and plans whose
+// kernels have no room for the extra rank, run one tensor at a time. Output tensors must
+// not overlap.
+//
+// Parameters
+// handle            = Returned handle to LIBRETT plan
+// count             = Number of tensors in the batch
+// idata[count]      = Input data of the tensors, host array of device pointers
+// odata[count]      = Output data of the tensors, host array of device pointers
+//
+// Returns
+// Success/unsuccess code
+//
+librettResult librettExecuteBatched(librettHandle handle, int count, void** idata, void** odata);
+
+//
+// Execute plan on a strided batch of tensors
+//
+// Tensor i is at idata + i*strideIn and odata + i*strideOut, strides are in elements.
+// The batch index is the slowest rank of the transpose, so the batch runs in one kernel
+// launch. Trivial plans, and plans whose kernels have no room for the extra rank, run one
+// tensor at a time. Output tensors must not overlap.
+//
+// Parameters
+// handle            = Returned handle to LIBRETT plan
+// count             = Number of tensors in the batch
+// idata             = Input data of the first tensor
+// strideIn          = Distance between the input tensors in elements
+// odata             = Output data of the first tensor
+// strideOut         = Distance between the output tensors in elements
+//
+// Returns
+// Success/unsuccess code
+//
+librettResult librettExecuteBatchedStrided(librettHandle handle, int count, void* idata, long long int strideIn,
+                                           void* odata, long long int strideOut);
+
+//
+// Execute a group of plans
+//
+// Runs librettExecute() with handles[i] on idata[i] -> odata[i] for i = 0 ... count-1.
+// The plans can have different shapes and permutations. Plans with the same element size
+// are run in one launch: their descriptors are packed into one device table and persistent
+// thread blocks take tiles of all tensors from a device-side work queue, so many small
+// tensors are not bound by launch latency. Converting plans, and strided plans whose
+// method is not Tiled or TiledCopy, run one at a time on their own stream. A grouped launch
+// uses the stream of its first plan. All plans must be on the same device, otherwise
+// LIBRETT_INVALID_PARAMETER is returned. Output tensors must not overlap.
+//
+// Parameters
+// count             = Number of tensors in the group
+// handles[count]    = Returned handles to LIBRETT plans
+// idata[count]      = Input data of the tensors, host array of device pointers
+// odata[count]      = Output data of the tensors, host array of device pointers
+//
+// Returns
+// Success/unsuccess code
+//
+librettResult librettExecuteGrouped(int count, librettHandle* handles, void** idata, void** odata);
+
 #endif // LIBRETT_H
@@ -27,8 +27,12 @@ SOFTWARE.
 #include <unordered_set>
 #include <cmath>
 #include <random>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
 #include "GpuUtils.h"
 #include "GpuMem.hpp"
+#include "DescriptorArena.h"
 #include "plan.h"
 #include "kernel.h"
 #include "GpuModel.h"
@@ -64,12 +68,38 @@ void printMethod(int method) {
 void reduceRanks(const int rank, const int* dim, const int* permutation,
   std::vector<int>& redDim, std::vector<int>& redPermutation) {
 
+  // Dense strides always allow combining
+  std::vector<long long int> inStride(rank);
+  std::vector<long long int> outStride(rank);
+  inStride[0] = 1;
+  outStride[0] = 1;
+  for (int i=1;i < rank;i++) {
+    inStride[i] = inStride[i-1]*dim[i-1];
+    outStride[i] = outStride[i-1]*dim[permutation[i-1]];
+  }
+  std::vector<long long int> redInStride;
+  std::vector<long long int> redOutStride;
+  reduceRanks(rank, dim, permutation, inStride.data(), outStride.data(),
+    redDim, redPermutation, redInStride, redOutStride);
+}
+
+//
+// Reduce ranks of a strided tensor. Ranks are combined only when they are contiguous
+// in both the input and the output. inStride is in input order, outStride in output order
+//
+void reduceRanks(const int rank, const int* dim, const int* permutation,
+  const long long int* inStride, const long long int* outStride,
+  std::vector<int>& redDim, std::vector<int>& redPermutation,
+  std::vector<long long int>& redInStride, std::vector<long long int>& redOutStride) {
+
   // Previous permutation value,
   // start with impossible value so that we always first do push_back(permutation[0])
   int prev = -2;
   for (int i=0;i < rank;i++) {
     int cur = permutation[i];
-    if (cur == prev + 1)
+    // Combined dimensions must stay in int range
+    if (cur == prev + 1 && (long long int)redDim.back()*dim[cur] <= INT_MAX &&
+      inStride[cur] == inStride[prev]*dim[prev] && outStride[i] == outStride[i-1]*dim[prev])
     {
       // Skip over ranks that are in consequtive order and
       // combine dimensions
@@ -77,8 +107,10 @@ void reduceRanks(const int rank, const int* dim, const int* permutation,
     } else {
       // Include ranks that start the consequtive sequence
       redPermutation.push_back(cur);
-      // NOTE: redDim will be in permuted order, re-order after dust settles
+      // NOTE: redDim and redInStride will be in permuted order, re-order after dust settles
       redDim.push_back(dim[cur]);
+      redInStride.push_back(inStride[cur]);
+      redOutStride.push_back(outStride[i]);
     }
     prev = cur;
   }
@@ -98,13 +130,18 @@ void reduceRanks(const int rank, const int* dim, const int* permutation,
     redPermutation[tmp[i]] = i;
   }
 
-  // Re-order redDim
+  // Re-order redDim and redInStride
   for (int i=0;i < redDim.size();i++) {
     tmp[redPermutation[i]] = redDim[i];
   }
   for (int i=0;i < redDim.size();i++) {
     redDim[i] = tmp[i];
   }
+  std::vector<long long int> tmpStride(redInStride.size());
+  for (int i=0;i < redInStride.size();i++) {
+    tmpStride[redPermutation[i]] = redInStride[i];
+  }
+  redInStride = tmpStride;
 
   // for (int i=0;i < rank;i++) {
   //   printf("%d ", dim[i]);
@@ -132,12 +169,14 @@ void reduceRanks(const int rank, const int* dim, const int* permutation,
 class TensorC {
 private:
   const int rank;
-  int* c;
+  long long int* c;
   // map[i] tells where to find rank i in c[]
   int* map;
 public:
   // rankInd[0 ... n - 1] = ranks that are included
-  TensorC(const int rank, const int n, const int* rankInd, const int* dim) : rank(rank) {
+  // stride[0 ... n - 1] = strides of the included ranks, dense strides from dim[] when nullptr
+  TensorC(const int rank, const int n, const int* rankInd, const int* dim,
+    const long long int* stride=nullptr) : rank(rank) {
     if (rank < 1 || n < 1 || n > rank) {
       printf("TensorC::TensorC, Invalid rank or n\n");
       exit(1);
@@ -147,11 +186,14 @@ public:
     for (int i=0;i < n;i++) {
       map[rankInd[i]] = i;
     }
-    c = new int[n];
+    c = new long long int[n];
     c[0] = 1;
     for (int i=1;i < n;i++) {
       c[i] = c[i-1]*dim[rankInd[i-1]];
     }
+    if (stride != nullptr) {
+      for (int i=0;i < n;i++) c[i] = stride[i];
+    }
   }
 
   ~TensorC() {
@@ -159,7 +201,7 @@ public:
     delete [] map;
   }
 
-  int get(const int i) {
+  long long int get(const int i) {
     int mapi;
     if (i < 0 || i >= rank || (mapi = map[i]) == -1) {
       printf("TensorC::get(), index out of range\n");
@@ -193,55 +235,62 @@ TensorSplit::TensorSplit() {
 void TensorSplit::print() {
   printf("sizeMm %d sizeMk %d sizeMmk %d sizeMbar %d sizeMkBar %d\n",
     sizeMm, sizeMk, sizeMmk, sizeMbar, sizeMkBar);
-  printf("volMm %d volMk %d volMmk %d volMbar %d volMkBar %d\n",
+  printf("volMm %d volMk %d volMmk %lld volMbar %lld volMkBar %d\n",
     volMm, volMk, volMmk, volMbar, volMkBar);
   printf("volMmkInCont %d volMmkOutCont %d\n", volMmkInCont, volMmkOutCont);
   if (method == PackedSplit) printf("numSplit %d splitRank %d\n", numSplit, splitRank);
 }
 
-void TensorSplit::update(const int sizeMm_in, const int sizeMk_in, const int rank,
+bool TensorSplit::update(const int sizeMm_in, const int sizeMk_in, const int rank,
   const int* dim, const int* permutation) {
 
   sizeMm = sizeMm_in;
   sizeMk = sizeMk_in;
 
+  // Volumes are accumulated in 64 bits and checked before they are stored
   // First sizeMm are in Mm
-  volMm = 1;
+  long long int volMm64 = 1;
   for (int i=0;i < sizeMm;i++) {
-    volMm *= dim[i];
+    volMm64 *= dim[i];
   }
   // First sizeMk in permuted order are in Mk
-  volMk = 1;
+  long long int volMk64 = 1;
   for (int i=0;i < sizeMk;i++) {
-    volMk *= dim[permutation[i]];
+    volMk64 *= dim[permutation[i]];
   }
 
-  int vol = 1;
-  volMmk = 1;
+  long long int vol = 1;
+  long long int volMmk64 = 1;
   sizeMmk = 0;
-  volMkBar = 1;
+  long long int volMkBar64 = 1;
   sizeMkBar = 0;
   for (int i=0;i < rank;i++) {
     int pi = permutation[i];
     if (i < sizeMm) {
-      volMmk *= dim[i];
+      volMmk64 *= dim[i];
       sizeMmk++;
     }
     if (i < sizeMk && pi >= sizeMm) {
-      volMmk *= dim[pi];
+      volMmk64 *= dim[pi];
       sizeMmk++;
-      volMkBar *= dim[pi];
+      volMkBar64 *= dim[pi];
       sizeMkBar++;
     }
     vol *= dim[i];
   }
 
+  if (volMm64 > INT_MAX || volMk64 > INT_MAX || volMkBar64 > INT_MAX) return false;
+  volMm = (int)volMm64;
+  volMk = (int)volMk64;
+  volMmk = volMmk64;
+  volMkBar = (int)volMkBar64;
+
   sizeMbar = rank - sizeMmk;
   volMbar = vol/volMmk;
 
   if (splitRank >= 0) {
     splitDim = dim[splitRank];
-    volMmkUnsplit = volMmk / splitDim;
+    volMmkUnsplit = (int)std::min<long long int>(INT_MAX, volMmk / splitDim);
   }
 
   std::vector<bool> isMmk(rank, false);
@@ -278,6 +327,7 @@ void TensorSplit::update(const int sizeMm_in, const int sizeMk_in, const int ran
     }
   }
 
+  return true;
 }
 
 bool operator==(const TensorSplit& lhs, const TensorSplit& rhs) {
@@ -464,7 +514,7 @@ size_t TensorSplit::shmemAlloc(int sizeofType) const {
 #ifdef HIP
       vol = TILEDIM*TILEDIM*sizeofType;
 #else // CUDA and SYCL
-      vol = (TILEDIM+1)*TILEDIM*sizeofType;
+      vol = (TILEDIM+tilePad(sizeofType))*TILEDIM*sizeofType;
 #endif
     }
     break;
@@ -491,9 +541,22 @@ bool planExists(TensorSplit& ts, std::list<librettPlan_t>& plans) {
 }
 
 bool librettPlan_t::createTrivialPlans(const int rank, const int *dim, const int *permutation,
-  const size_t sizeofType, const int deviceID, const gpuDeviceProp_t &prop, std::list<librettPlan_t> &plans) {
-
-  if (rank == 1) {
+  const size_t sizeofType, const int deviceID, const gpuDeviceProp_t &prop, std::list<librettPlan_t> &plans,
+  const long long int* inStride, const long long int* outStride) {
+
+  // Identity permutations of rank > 1 remain when reduceRanks() could not combine
+  // dimensions without overflowing an int, or when strided tensors are not contiguous.
+  // Trivial copies the whole volume and needs dense tensors
+  bool identity = true;
+  for (int i=0;i < rank;i++) identity = identity && (permutation[i] == i);
+  if (inStride != nullptr) {
+    long long int vol = 1;
+    for (int i=0;i < rank;i++) {
+      identity = identity && (inStride[i] == vol) && (outStride[i] == vol);
+      vol *= dim[i];
+    }
+  }
+  if (identity) {
     TensorSplit ts;
     ts.method = Trivial;
     ts.update(1, 1, rank, dim, permutation);
@@ -501,7 +564,7 @@ bool librettPlan_t::createTrivialPlans(const int rank, const int *dim, const int
     int numActiveBlock = librettKernelLaunchConfiguration(sizeofType, ts, deviceID, prop, lc);
     if (numActiveBlock > 0 && !planExists(ts, plans)) {
       librettPlan_t plan;
-      if (!plan.setup(rank, dim, permutation, sizeofType, ts, lc, numActiveBlock)) return false;
+      if (!plan.setup(rank, dim, permutation, sizeofType, ts, lc, numActiveBlock, inStride, outStride)) return false;
       plans.push_back(plan);
     }
   }
@@ -510,17 +573,18 @@ bool librettPlan_t::createTrivialPlans(const int rank, const int *dim, const int
 }
 
 bool librettPlan_t::createTiledPlans(const int rank, const int *dim, const int *permutation,
-  const size_t sizeofType, const int deviceID, const gpuDeviceProp_t &prop, std::list<librettPlan_t> &plans) {
+  const size_t sizeofType, const int deviceID, const gpuDeviceProp_t &prop, std::list<librettPlan_t> &plans,
+  const long long int* inStride, const long long int* outStride) {
 
   if (permutation[0] != 0 && rank > 1) {
     TensorSplit ts;
     ts.method = Tiled;
-    ts.update(1, 1, rank, dim, permutation);
+    if (!ts.update(1, 1, rank, dim, permutation)) return true;
     LaunchConfig lc;
     int numActiveBlock = librettKernelLaunchConfiguration(sizeofType, ts, deviceID, prop, lc);
     if (numActiveBlock > 0 && !planExists(ts, plans)) {
       librettPlan_t plan;
-      if (!plan.setup(rank, dim, permutation, sizeofType, ts, lc, numActiveBlock)) return false;
+      if (!plan.setup(rank, dim, permutation, sizeofType, ts, lc, numActiveBlock, inStride, outStride)) return false;
       plans.push_back(plan);
     }
   }
@@ -529,7 +593,8 @@ bool librettPlan_t::createTiledPlans(const int rank, const int *dim, const int *
 }
 
 bool librettPlan_t::createTiledCopyPlans(const int rank, const int *dim, const int *permutation,
-  const size_t sizeofType, const int deviceID, const gpuDeviceProp_t &prop, std::list<librettPlan_t> &plans) {
+  const size_t sizeofType, const int deviceID, const gpuDeviceProp_t &prop, std::list<librettPlan_t> &plans,
+  const long long int* inStride, const long long int* outStride) {
 
   // Count number of Mm and Mk which are the same
   int numMmMkSame = 0;
@@ -541,15 +606,15 @@ bool librettPlan_t::createTiledCopyPlans(const int rank, const int *dim, const i
     TensorSplit ts;
     ts.method = TiledCopy;
     if (numMmMkSame < rank) {
-      ts.update(numMmMkSame, numMmMkSame + 1, rank, dim, permutation);
+      if (!ts.update(numMmMkSame, numMmMkSame + 1, rank, dim, permutation)) return true;
     } else {
-      ts.update(numMmMkSame - 1, numMmMkSame, rank, dim, permutation);
+      if (!ts.update(numMmMkSame - 1, numMmMkSame, rank, dim, permutation)) return true;
     }
     LaunchConfig lc;
     int numActiveBlock = librettKernelLaunchConfiguration(sizeofType, ts, deviceID, prop, lc);
     if (numActiveBlock > 0 && !planExists(ts, plans)) {
       librettPlan_t plan;
-      if (!plan.setup(rank, dim, permutation, sizeofType, ts, lc, numActiveBlock)) return false;
+      if (!plan.setup(rank, dim, permutation, sizeofType, ts, lc, numActiveBlock, inStride, outStride)) return false;
       plans.push_back(plan);
     }
   }
@@ -558,20 +623,22 @@ bool librettPlan_t::createTiledCopyPlans(const int rank, const int *dim, const i
 }
 
 bool librettPlan_t::createPackedPlans(const int rank, const int *dim, const int *permutation,
-  const size_t sizeofType, const int deviceID, const gpuDeviceProp_t &prop, std::list<librettPlan_t> &plans) {
+  const size_t sizeofType, const int deviceID, const gpuDeviceProp_t &prop, std::list<librettPlan_t> &plans,
+  const long long int* inStride, const long long int* outStride) {
 
   LaunchConfig lc;
   for (int numMm=1;numMm < rank;numMm++) {
     for (int numMk=1;numMk < rank;numMk++) {
       TensorSplit ts;
       ts.method = Packed;
-      ts.update(numMm, numMk, rank, dim, permutation);
+      // Too large for shared memory, break out of inner loop
+      if (!ts.update(numMm, numMk, rank, dim, permutation)) break;
       int numActiveBlock = librettKernelLaunchConfiguration(sizeofType, ts, deviceID, prop, lc);
       // Does not fit on the device, break out of inner loop
       if (numActiveBlock == 0) break;
       if (!planExists(ts, plans)) {
         librettPlan_t plan;
-        if (!plan.setup(rank, dim, permutation, sizeofType, ts, lc, numActiveBlock)) return false;
+        if (!plan.setup(rank, dim, permutation, sizeofType, ts, lc, numActiveBlock, inStride, outStride)) return false;
         plans.push_back(plan);
       }
     }
@@ -581,14 +648,15 @@ bool librettPlan_t::createPackedPlans(const int rank, const int *dim, const int
 }
 
 bool librettPlan_t::createPackedSplitPlans(const int rank, const int *dim, const int *permutation,
-  const size_t sizeofType, const int deviceID, const gpuDeviceProp_t &prop, std::list<librettPlan_t> &plans) {
+  const size_t sizeofType, const int deviceID, const gpuDeviceProp_t &prop, std::list<librettPlan_t> &plans,
+  const long long int* inStride, const long long int* outStride) {
 
   LaunchConfig lc;
   for (int numMm=1;numMm < rank;numMm++) {
     for (int numMk=1;numMk < rank;numMk++) {
       TensorSplit ts;
       ts.method = Packed;
-      ts.update(numMm, numMk, rank, dim, permutation);
+      if (!ts.update(numMm, numMk, rank, dim, permutation) || ts.volMmk > INT_MAX) break;
       // Amount of shared memory required
       size_t shmemsize = ts.shmemAlloc(sizeofType);
       /* DPCT1019:0: local_mem_size in SYCL is not a complete equivalent of sharedMemPerBlock in CUDA. */
@@ -616,7 +684,8 @@ bool librettPlan_t::createPackedSplitPlans(const int rank, const int *dim, const
         //
         ts.update(numMm, numMk, rank, dim, permutation);
         /* DPCT1019:1: local_mem_size in SYCL is not a complete equivalent of sharedMemPerBlock in CUDA. */
-	int minNumSplit = (ts.splitDim*ts.volMmkUnsplit*sizeofType - 1)/gpuSharedMemPerBlock + 1;
+	int minNumSplit = (int)std::min<long long int>(INT_MAX,
+          ((long long int)ts.splitDim*ts.volMmkUnsplit*sizeofType - 1)/gpuSharedMemPerBlock + 1);
         int maxNumSplit = std::max(minNumSplit, std::min(ts.splitDim/splitDimMin, minNumSplit + 60));
 
         // Sanity check: do not split too much
@@ -661,32 +730,33 @@ bool librettPlan_t::createPackedSplitPlans(const int rank, const int *dim, const
         if (numActiveBlock == 0) break;
         ts.numSplit = bestNumSplit0;
         ts.update(numMm, numMk, rank, dim, permutation);
-        // Make sure splitDim*numSplit fits into an integer
+        // The int kernels compute splitDim*numSplit in int, keep their plans only when it fits.
+        // The index64 kernels compute it in long long int
         const unsigned long long int dim_cutoff = ((unsigned long long int)1 << 31);
         unsigned long long int dim0 = (unsigned long long int)ts.splitDim*(unsigned long long int)(ts.numSplit + 1);
-        if (!planExists(ts, plans) && dim0 < dim_cutoff) {
+        if (!planExists(ts, plans)) {
           librettPlan_t plan;
-          if (!plan.setup(rank, dim, permutation, sizeofType, ts, lc0, numActiveBlock0)) return false;
-          plans.push_back(plan);
+          if (!plan.setup(rank, dim, permutation, sizeofType, ts, lc0, numActiveBlock0, inStride, outStride)) return false;
+          if (plan.index64 || dim0 < dim_cutoff) plans.push_back(plan);
         }
         if (bestNumSplit1 != bestNumSplit0) {
           ts.numSplit = bestNumSplit1;
           ts.update(numMm, numMk, rank, dim, permutation);
           unsigned long long int dim1 = (unsigned long long int)ts.splitDim*(unsigned long long int)(ts.numSplit + 1);
-          if (!planExists(ts, plans) && dim1 < dim_cutoff) {
+          if (!planExists(ts, plans)) {
             librettPlan_t plan;
-            if (!plan.setup(rank, dim, permutation, sizeofType, ts, lc1, numActiveBlock1)) return false;
-            plans.push_back(plan);
+            if (!plan.setup(rank, dim, permutation, sizeofType, ts, lc1, numActiveBlock1, inStride, outStride)) return false;
+            if (plan.index64 || dim1 < dim_cutoff) plans.push_back(plan);
           }
         }
         if (bestNumSplit2 != bestNumSplit0 && bestNumSplit2 != bestNumSplit1) {
           ts.numSplit = bestNumSplit2;
           ts.update(numMm, numMk, rank, dim, permutation);
           unsigned long long int dim2 = (unsigned long long int)ts.splitDim*(unsigned long long int)(ts.numSplit + 1);
-          if (!planExists(ts, plans) && dim2 < dim_cutoff) {
+          if (!planExists(ts, plans)) {
             librettPlan_t plan;
-            if (!plan.setup(rank, dim, permutation, sizeofType, ts, lc2, numActiveBlock2)) return false;
-            plans.push_back(plan);
+            if (!plan.setup(rank, dim, permutation, sizeofType, ts, lc2, numActiveBlock2, inStride, outStride)) return false;
+            if (plan.index64 || dim2 < dim_cutoff) plans.push_back(plan);
           }
         }
       }
@@ -699,22 +769,36 @@ bool librettPlan_t::createPackedSplitPlans(const int rank, const int *dim, const
 //
 // Create all possible plans
 //
+// Strided tensors pass their strides for both the full and the reduced ranks,
+// nullptr strides are dense
+//
 bool librettPlan_t::createPlans(const int rank, const int *dim, const int *permutation,
   const int rankRed, const int *dimRed, const int *permutationRed,
-  const size_t sizeofType, const int deviceID, const gpuDeviceProp_t &prop, std::list<librettPlan_t> &plans) {
+  const size_t sizeofType, const int deviceID, const gpuDeviceProp_t &prop, std::list<librettPlan_t> &plans,
+  const long long int* inStride, const long long int* outStride,
+  const long long int* redInStride, const long long int* redOutStride) {
 
   size_t size0 = plans.size();
   /* if (!createTiledCopyPlans(rank, dim, permutation, sizeofType, deviceID, prop, plans)) return false;*/
-  if (!createTrivialPlans(rankRed, dimRed, permutationRed, sizeofType, deviceID, prop, plans)) return false;
+  if (!createTrivialPlans(rankRed, dimRed, permutationRed, sizeofType, deviceID, prop, plans,
+    redInStride, redOutStride)) return false;
   // If Trivial plan was created, that's the only one we need
-  if (size0 != plans.size()) return true;
-  if (!createTiledCopyPlans(rankRed, dimRed, permutationRed, sizeofType, deviceID, prop, plans)) return false;
-  if (!createTiledPlans(rankRed, dimRed, permutationRed, sizeofType, deviceID, prop, plans)) return false;
-  if (!createPackedPlans(rank, dim, permutation, sizeofType, deviceID, prop, plans)) return false;
-  if (!createPackedSplitPlans(rank, dim, permutation, sizeofType, deviceID, prop, plans)) return false;
-  if (rank != rankRed) {
-    if (!createPackedSplitPlans(rankRed, dimRed, permutationRed, sizeofType, deviceID, prop, plans)) return false;
+  if (size0 == plans.size()) {
+    if (!createTiledCopyPlans(rankRed, dimRed, permutationRed, sizeofType, deviceID, prop, plans,
+      redInStride, redOutStride)) return false;
+    if (!createTiledPlans(rankRed, dimRed, permutationRed, sizeofType, deviceID, prop, plans,
+      redInStride, redOutStride)) return false;
+    if (!createPackedPlans(rank, dim, permutation, sizeofType, deviceID, prop, plans,
+      inStride, outStride)) return false;
+    if (!createPackedSplitPlans(rank, dim, permutation, sizeofType, deviceID, prop, plans,
+      inStride, outStride)) return false;
+    if (rank != rankRed) {
+      if (!createPackedSplitPlans(rankRed, dimRed, permutationRed, sizeofType, deviceID, prop, plans,
+        redInStride, redOutStride)) return false;
+    }
   }
+  // activate() allocates the descriptors on this device
+  for (auto& plan : plans) plan.deviceID = deviceID;
   return true;
 }
 
@@ -788,6 +872,29 @@ std::list<librettPlan_t>::iterator choosePlanHeuristic(std::list<librettPlan_t>&
   return bestIt;
 }
 
+//
+// Returns the count best plans according to heuristic criteria, best first. The first one
+// is the plan of choosePlanHeuristic()
+//
+std::vector< std::list<librettPlan_t>::iterator > chooseTopPlans(std::list<librettPlan_t>& plans,
+  const int count) {
+
+  std::vector< std::list<librettPlan_t>::iterator > chosen;
+  while ((int)chosen.size() < count) {
+    auto bestIt = plans.end();
+    for (auto it=plans.begin();it != plans.end();it++) {
+      if (std::find(chosen.begin(), chosen.end(), it) != chosen.end()) continue;
+      if (bestIt == plans.end() || *bestIt < *it) {
+        bestIt = it;
+      }
+    }
+    if (bestIt == plans.end()) break;
+    chosen.push_back(bestIt);
+  }
+
+  return chosen;
+}
+
 void printMatlab( const gpuDeviceProp_t &prop, std::list<librettPlan_t> &plans, std::vector<double> &times) {
   static int count = 0;
   count++;
@@ -801,7 +908,7 @@ void printMatlab( const gpuDeviceProp_t &prop, std::list<librettPlan_t> &plans,
         ts.method == Tiled  || ts.method == TiledCopy)
     {
       int numthread = lc.numthread_x*lc.numthread_y*lc.numthread_z;
-      printf("MATLAB %d %d %d %d %1.3f %d %d %d %d %d %d %d %d %d %d %d %d %d %e %e\n", count, ts.method,
+      printf("MATLAB %d %d %lld %d %1.3f %d %lld %lld %lld %lld %lld %lld %lld %lld %lld %lld %lld %lld %e %e\n", count, ts.method,
         it->num_iter, numthread, it->mlp, it->numActiveBlock,
         it->gld_req, it->gst_req, it->gld_tran, it->gst_tran,
         it->sld_req, it->sst_req, it->sld_tran, it->sst_tran,
@@ -829,6 +936,45 @@ void librettPlan_t::print() {
 }
 
 
+//
+// LIBRETT_FORCE_INDEX64=1 selects the 64-bit index kernels for all tensors.
+// Used for testing the 64-bit path on tensors that fit into memory.
+//
+static bool forceIndex64() {
+  const char* env = std::getenv("LIBRETT_FORCE_INDEX64");
+  return (env != nullptr && std::atoi(env) != 0);
+}
+
+//
+// Copies 64-bit descriptors into int descriptors, values must fit
+//
+static void narrowConv(const std::vector<TensorConvInOut64>& src, std::vector<TensorConvInOut>& dst) {
+  dst.resize(src.size());
+  for (size_t i=0;i < src.size();i++) {
+    dst[i].c_in   = (int)src[i].c_in;
+    dst[i].d_in   = (int)src[i].d_in;
+    dst[i].ct_in  = (int)src[i].ct_in;
+    dst[i].c_out  = (int)src[i].c_out;
+    dst[i].d_out  = (int)src[i].d_out;
+    dst[i].ct_out = (int)src[i].ct_out;
+  }
+}
+
+//
+// Copies int descriptors into 64-bit descriptors
+//
+static void widenConv(const std::vector<TensorConvInOut>& src, std::vector<TensorConvInOut64>& dst) {
+  dst.resize(src.size());
+  for (size_t i=0;i < src.size();i++) {
+    dst[i].c_in   = src[i].c_in;
+    dst[i].d_in   = src[i].d_in;
+    dst[i].ct_in  = src[i].ct_in;
+    dst[i].c_out  = src[i].c_out;
+    dst[i].d_out  = src[i].d_out;
+    dst[i].ct_out = src[i].ct_out;
+  }
+}
+
 //
 // Setup plan
 // NOTE: Expects that librettKernelLaunchConfiguration() has been called to setup
@@ -836,15 +982,37 @@ void librettPlan_t::print() {
 //
 bool librettPlan_t::setup(const int rank_in, const int* dim, const int* permutation,
   const size_t sizeofType_in, const TensorSplit& tensorSplit_in,
-  const LaunchConfig& launchConfig_in, const int numActiveBlock_in) {
+  const LaunchConfig& launchConfig_in, const int numActiveBlock_in,
+  const long long int* inStride, const long long int* outStride) {
 
   rank = rank_in;
   sizeofType = sizeofType_in;
+  sizeofTypeOut = sizeofType_in;
+  typeIn = -1;
+  typeOut = -1;
   tensorSplit = tensorSplit_in;
   numActiveBlock = numActiveBlock_in;
   launchConfig = launchConfig_in;
+  strided = (inStride != nullptr);
   if (numActiveBlock == 0) return false;
 
+  // Positions of tensors with more than INT_MAX elements need 64-bit indexing
+  extentIn = tensorSplit.volMmk*tensorSplit.volMbar;
+  extentOut = extentIn;
+  if (strided) {
+    // Strided positions reach further than the volume
+    extentIn = 1;
+    extentOut = 1;
+    for (int i=0;i < rank;i++) {
+      extentIn += (dim[i] - 1)*inStride[i];
+      extentOut += (dim[permutation[i]] - 1)*outStride[i];
+    }
+  }
+  index64 = (extentIn > INT_MAX) || (extentOut > INT_MAX) || forceIndex64();
+  // Descriptors are built in 64 bits and narrowed to int for the 32-bit kernels
+  std::vector<TensorConvInOut64> convMbar;
+  std::vector<TensorConvInOut64> convMmk;
+
   std::vector<bool> isMm(rank, false);
   std::vector<bool> isMk(rank, false);
   for (int i=0;i < tensorSplit.sizeMm;i++) {
@@ -862,11 +1030,11 @@ bool librettPlan_t::setup(const int rank_in, const int* dim, const int* permutat
   for (int i=0;i < rank;i++) {
     I[i] = i;
   }
-  TensorC cI(rank, rank, I, dim);
+  TensorC cI(rank, rank, I, dim, inStride);
   delete [] I;
 
   // Build cO
-  TensorC cO(rank, rank, permutation, dim);
+  TensorC cO(rank, rank, permutation, dim, outStride);
 
   if (tensorSplit.method == Tiled) {
     cuDimMk = cI.get(permutation[0]);
@@ -916,16 +1084,16 @@ bool librettPlan_t::setup(const int rank_in, const int* dim, const int* permutat
       }
     }
 
-    hostMbar.resize(tensorSplit.sizeMbar);
+    convMbar.resize(tensorSplit.sizeMbar);
     for (int i=0;i < tensorSplit.sizeMbar;i++) {
       int si = MbarI[i];
-      hostMbar[i].c_in  = cMbarI.get(si);
-      hostMbar[i].d_in  = dim[si];
-      hostMbar[i].ct_in = cI.get(si);
+      convMbar[i].c_in  = cMbarI.get(si);
+      convMbar[i].d_in  = dim[si];
+      convMbar[i].ct_in = cI.get(si);
       int sli = MbarO[i];
-      hostMbar[i].c_out  = cMbarI.get(sli);
-      hostMbar[i].d_out  = dim[sli];
-      hostMbar[i].ct_out = cO.get(sli);
+      convMbar[i].c_out  = cMbarI.get(sli);
+      convMbar[i].d_out  = dim[sli];
+      convMbar[i].ct_out = cO.get(sli);
     }
 
     delete [] MbarI;
@@ -982,24 +1150,24 @@ bool librettPlan_t::setup(const int rank_in, const int* dim, const int* permutat
     TensorC cMmkOSplit(rank, tensorSplit.sizeMmk, MmkO.data(), dimSplit.data());
     TensorC cMmkOSplitPlusOne(rank, tensorSplit.sizeMmk, MmkO.data(), dimSplitPlusOne.data());
 
-    hostMmk.resize(tensorSplit.sizeMmk*2);
+    convMmk.resize(tensorSplit.sizeMmk*2);
     for (int i=0;i < tensorSplit.sizeMmk;i++) {
       // Minor reading position
       int qi = MmkI[i];
-      hostMmk[i].c_in                        = cMmkISplit.get(qi);
-      hostMmk[i].d_in                        = dimSplit[qi];
-      hostMmk[i].ct_in                       = cI.get(qi);
-      hostMmk[i + tensorSplit.sizeMmk].c_in  = cMmkISplitPlusOne.get(qi);
-      hostMmk[i + tensorSplit.sizeMmk].d_in  = dimSplitPlusOne[qi];
-      hostMmk[i + tensorSplit.sizeMmk].ct_in = cI.get(qi);
+      convMmk[i].c_in                        = cMmkISplit.get(qi);
+      convMmk[i].d_in                        = dimSplit[qi];
+      convMmk[i].ct_in                       = cI.get(qi);
+      convMmk[i + tensorSplit.sizeMmk].c_in  = cMmkISplitPlusOne.get(qi);
+      convMmk[i + tensorSplit.sizeMmk].d_in  = dimSplitPlusOne[qi];
+      convMmk[i + tensorSplit.sizeMmk].ct_in = cI.get(qi);
       // Minor writing position
       int qti = MmkO[i];
-      hostMmk[i].c_out                        = cMmkOSplit.get(qti);
-      hostMmk[i].d_out                        = dimSplit[qti];
-      hostMmk[i].ct_out                       = cO.get(qti);
-      hostMmk[i + tensorSplit.sizeMmk].c_out  = cMmkOSplitPlusOne.get(qti);
-      hostMmk[i + tensorSplit.sizeMmk].d_out  = dimSplitPlusOne[qti];
-      hostMmk[i + tensorSplit.sizeMmk].ct_out = cO.get(qti);
+      convMmk[i].c_out                        = cMmkOSplit.get(qti);
+      convMmk[i].d_out                        = dimSplit[qti];
+      convMmk[i].ct_out                       = cO.get(qti);
+      convMmk[i + tensorSplit.sizeMmk].c_out  = cMmkOSplitPlusOne.get(qti);
+      convMmk[i + tensorSplit.sizeMmk].d_out  = dimSplitPlusOne[qti];
+      convMmk[i + tensorSplit.sizeMmk].ct_out = cO.get(qti);
     }
 
     hostMsh.resize(tensorSplit.sizeMmk*2);
@@ -1038,18 +1206,18 @@ bool librettPlan_t::setup(const int rank_in, const int* dim, const int* permutat
     }
     TensorC cMmkO(rank, tensorSplit.sizeMmk, MmkO.data(), dim);
 
-    hostMmk.resize(tensorSplit.sizeMmk);
+    convMmk.resize(tensorSplit.sizeMmk);
     for (int i=0;i < tensorSplit.sizeMmk;i++) {
       // Minor reading position
       int qi = MmkI[i];
-      hostMmk[i].c_in  = cMmkI.get(qi);
-      hostMmk[i].d_in  = dim[qi];
-      hostMmk[i].ct_in = cI.get(qi);
+      convMmk[i].c_in  = cMmkI.get(qi);
+      convMmk[i].d_in  = dim[qi];
+      convMmk[i].ct_in = cI.get(qi);
       // Minor writing position
       int qti = MmkO[i];
-      hostMmk[i].c_out  = cMmkO.get(qti);
-      hostMmk[i].d_out  = dim[qti];
-      hostMmk[i].ct_out = cO.get(qti);
+      convMmk[i].c_out  = cMmkO.get(qti);
+      convMmk[i].d_out  = dim[qti];
+      convMmk[i].ct_out = cO.get(qti);
     }
 
     hostMsh.resize(tensorSplit.sizeMmk);
@@ -1062,42 +1230,64 @@ bool librettPlan_t::setup(const int rank_in, const int* dim, const int* permutat
     }
   }
 
+  if (index64) {
+    hostMbar64 = convMbar;
+    hostMmk64 = convMmk;
+  } else {
+    narrowConv(convMbar, hostMbar);
+    narrowConv(convMmk, hostMmk);
+  }
+
   return true;
 }
 
 // #define COUNTCYCLE_CHECK
 
 //
-// Count the number of cycles using the MWP-CWP model
+// Counts global and shared memory transactions. Global memory widths are for elements of
+// sizeofTypeGl bytes, shared memory holds elements of sizeofType bytes
 //
-bool librettPlan_t::countCycles( const gpuDeviceProp_t &prop, const int numPosMbarSample) {
-
+bool librettPlan_t::countTransactions(const gpuDeviceProp_t &prop, const int numPosMbarSample,
+  const size_t sizeofTypeGl) {
+
+#if LIBRETT_USES_CPU
+  // On the host both transactions and cache lines are 64 byte lines
+  const int accWidth = 64/sizeofTypeGl;
+  const int cacheWidth = 64/sizeofTypeGl;
+#else
   // Number of elements that are loaded per memory transaction:
   // 128 bytes per transaction
-  const int accWidth = 128/sizeofType;
+  const int accWidth = 128/sizeofTypeGl;
   // L2 cache line width is 32 bytes
 #if HIP
-  const int cacheWidth = 64/sizeofType;  // AMD change
+  const int cacheWidth = 64/sizeofTypeGl;  // AMD change
 #elif SYCL
   #if LIBRETT_SUBGROUP_SIZE16
-  const int cacheWidth = 16/sizeofType;
+  const int cacheWidth = 16/sizeofTypeGl;
   #elif LIBRETT_SUBGROUP_SIZE32
-  const int cacheWidth = 32/sizeofType;
+  const int cacheWidth = 32/sizeofTypeGl;
   #else
-  const int cacheWidth = 32/sizeofType;
+  const int cacheWidth = 32/sizeofTypeGl;
   #endif
 #else // CUDA
-  const int cacheWidth = 32/sizeofType;
+  const int cacheWidth = 32/sizeofTypeGl;
 #endif
+#endif // LIBRETT_USES_CPU
 
   if (tensorSplit.method == Tiled) {
     // Global memory
 #ifdef ENABLE_NVTOOLS
     gpuRangeStart("countTiledGlTransactions");
 #endif
-    countTiledGlTransactions(false, numPosMbarSample, tensorSplit.volMm, tensorSplit.volMk, tensorSplit.volMbar,
-      cuDimMk, cuDimMm, accWidth, cacheWidth, hostMbar, tensorSplit.sizeMbar,
-      num_iter, mlp, gld_tran, gst_tran, gld_req, gst_req, cl_full_l2, cl_part_l2);
+    if (index64) {
+      countTiledGlTransactions(false, numPosMbarSample, tensorSplit.volMm, tensorSplit.volMk, tensorSplit.volMbar,
+        modelPos(cuDimMk), modelPos(cuDimMm), accWidth, cacheWidth, hostMbar64, tensorSplit.sizeMbar,
+        num_iter, mlp, gld_tran, gst_tran, gld_req, gst_req, cl_full_l2, cl_part_l2);
+    } else {
+      countTiledGlTransactions(false, numPosMbarSample, tensorSplit.volMm, tensorSplit.volMk, tensorSplit.volMbar,
+        (int)cuDimMk, (int)cuDimMm, accWidth, cacheWidth, hostMbar, tensorSplit.sizeMbar,
+        num_iter, mlp, gld_tran, gst_tran, gld_req, gst_req, cl_full_l2, cl_part_l2);
+    }
 #ifdef ENABLE_NVTOOLS
     gpuRangeStop();
 #endif
@@ -1111,9 +1301,15 @@ bool librettPlan_t::countCycles( const gpuDeviceProp_t &prop, const int numPosMb
 #ifdef ENABLE_NVTOOLS
     gpuRangeStart("countTiledGlTransactions (copy)");
 #endif
-    countTiledGlTransactions(true, numPosMbarSample, tensorSplit.volMm, tensorSplit.volMkBar, tensorSplit.volMbar,
-      cuDimMk, cuDimMm, accWidth, cacheWidth, hostMbar, tensorSplit.sizeMbar,
-      num_iter, mlp, gld_tran, gst_tran, gld_req, gst_req, cl_full_l2, cl_part_l2);
+    if (index64) {
+      countTiledGlTransactions(true, numPosMbarSample, tensorSplit.volMm, tensorSplit.volMkBar, tensorSplit.volMbar,
+        modelPos(cuDimMk), modelPos(cuDimMm), accWidth, cacheWidth, hostMbar64, tensorSplit.sizeMbar,
+        num_iter, mlp, gld_tran, gst_tran, gld_req, gst_req, cl_full_l2, cl_part_l2);
+    } else {
+      countTiledGlTransactions(true, numPosMbarSample, tensorSplit.volMm, tensorSplit.volMkBar, tensorSplit.volMbar,
+        (int)cuDimMk, (int)cuDimMm, accWidth, cacheWidth, hostMbar, tensorSplit.sizeMbar,
+        num_iter, mlp, gld_tran, gst_tran, gld_req, gst_req, cl_full_l2, cl_part_l2);
+    }
 #ifdef ENABLE_NVTOOLS
     gpuRangeStop();
 #endif
@@ -1148,14 +1344,18 @@ bool librettPlan_t::countCycles( const gpuDeviceProp_t &prop, const int numPosMb
     cl_part_l1 = 0;
     // Random number generator
     std::default_random_engine generator;
-    std::uniform_int_distribution<int> distribution(0, tensorSplit.volMbar*tensorSplit.numSplit - 1);
+    std::uniform_int_distribution<long long int> distribution(0, tensorSplit.volMbar*tensorSplit.numSplit - 1);
     // Pre-compute posMmkIn and posMmkOut
     std::vector<int> posMmkIn0(volMmk0);
     std::vector<int> posMmkOut0(volMmk0);
 #ifdef ENABLE_NVTOOLS
     gpuRangeStart("computePos");
 #endif
-    computePos0(volMmk0, hostMmk.data(), tensorSplit.sizeMmk, posMmkIn0.data(), posMmkOut0.data());
+    if (index64) {
+      computePos(0, volMmk0 - 1, hostMmk64.data(), tensorSplit.sizeMmk, posMmkIn0.data(), posMmkOut0.data());
+    } else {
+      computePos0(volMmk0, hostMmk.data(), tensorSplit.sizeMmk, posMmkIn0.data(), posMmkOut0.data());
+    }
     // computePos(0, volMmk0 - 1, hostMmkFast.data(), tensorSplit.sizeMmk, posMmkIn0.data(), posMmkOut0.data());
 #ifdef COUNTCYCLE_CHECK
     std::vector<int> posMmkIn0Ref(volMmk0);
@@ -1183,7 +1383,12 @@ bool librettPlan_t::countCycles( const gpuDeviceProp_t &prop, const int numPosMb
 #ifdef ENABLE_NVTOOLS
       gpuRangeStart("computePos");
 #endif
-      computePos0(volMmk1, hostMmk.data() + tensorSplit.sizeMmk, tensorSplit.sizeMmk, posMmkIn1.data(), posMmkOut1.data());
+      if (index64) {
+        computePos(0, volMmk1 - 1, hostMmk64.data() + tensorSplit.sizeMmk, tensorSplit.sizeMmk,
+          posMmkIn1.data(), posMmkOut1.data());
+      } else {
+        computePos0(volMmk1, hostMmk.data() + tensorSplit.sizeMmk, tensorSplit.sizeMmk, posMmkIn1.data(), posMmkOut1.data());
+      }
       // computePos(0, volMmk1 - 1, hostMmkFast.data() + tensorSplit.sizeMmk, tensorSplit.sizeMmk,
       //   posMmkIn1.data(), posMmkOut1.data());
 #ifdef COUNTCYCLE_CHECK
@@ -1208,21 +1413,21 @@ bool librettPlan_t::countCycles( const gpuDeviceProp_t &prop, const int numPosMb
 #endif
     }
 
-    int num_ipos = (numPosMbarSample == 0) ? tensorSplit.volMbar*tensorSplit.numSplit : numPosMbarSample;
+    int num_ipos = (numPosMbarSample == 0) ? (int)(tensorSplit.volMbar*tensorSplit.numSplit) : numPosMbarSample;
 
 #ifdef ENABLE_NVTOOLS
     gpuRangeStop();
     gpuRangeStart("PackedSplit: loop");
 #endif
 
-    std::vector<int> posTmp(num_ipos);
+    std::vector<long long int> posTmp(num_ipos);
     int numRoundUp = 0;
     for (int ipos=0;ipos < num_ipos;ipos++) {
       posTmp[ipos] = (numPosMbarSample == 0) ? ipos : distribution(generator);
       int isplit = posTmp[ipos] % tensorSplit.numSplit;
       if (isplit < num1) numRoundUp++;
     }
-    std::vector<int> pos(num_ipos);
+    std::vector<long long int> pos(num_ipos);
     int indRoundUp = 0;
     int indRoundDown = numRoundUp;
     for (int ipos=0;ipos < num_ipos;ipos++) {
@@ -1246,24 +1451,30 @@ bool librettPlan_t::countCycles( const gpuDeviceProp_t &prop, const int numPosMb
       int posMbarIn[INT_VECTOR_LEN];
       int posMbarOut[INT_VECTOR_LEN];
       for (int i=0;i < numPos;i++) {
-        int posMbar = pos[ipos + i] / tensorSplit.numSplit;
+        long long int posMbar = pos[ipos + i] / tensorSplit.numSplit;
         int isplit  = pos[ipos + i] % tensorSplit.numSplit;
-        int p0 = isplit*tensorSplit.splitDim/tensorSplit.numSplit;
-        computePos(posMbar, posMbar, hostMbar.data(), tensorSplit.sizeMbar, &posMbarIn[i], &posMbarOut[i]);
-        posMbarIn[i] += p0*cuDimMm;
-        posMbarOut[i] += p0*cuDimMk;
+        long long int p0 = (long long int)isplit*tensorSplit.splitDim/tensorSplit.numSplit;
+        if (index64) {
+          computePos(posMbar, posMbar, hostMbar64.data(), tensorSplit.sizeMbar, &posMbarIn[i], &posMbarOut[i]);
+          posMbarIn[i] = modelPos(posMbarIn[i] + p0*cuDimMm);
+          posMbarOut[i] = modelPos(posMbarOut[i] + p0*cuDimMk);
+        } else {
+          computePos((int)posMbar, (int)posMbar, hostMbar.data(), tensorSplit.sizeMbar, &posMbarIn[i], &posMbarOut[i]);
+          posMbarIn[i] += p0*cuDimMm;
+          posMbarOut[i] += p0*cuDimMk;
+        }
       }
       for (int i=numPos;i < INT_VECTOR_LEN;i++) {
         posMbarIn[i]  = posMbarIn[numPos - 1];
         posMbarOut[i] = posMbarOut[numPos - 1];
       }
 
-      int gld_tran_tmp = 0;
-      int gst_tran_tmp = 0;
-      int gld_req_tmp = 0;
-      int gst_req_tmp = 0;
-      int cl_full_l2_tmp = 0;
-      int cl_part_l2_tmp = 0;
+      long long int gld_tran_tmp = 0;
+      long long int gst_tran_tmp = 0;
+      long long int gld_req_tmp = 0;
+      long long int gst_req_tmp = 0;
+      long long int cl_full_l2_tmp = 0;
+      long long int cl_part_l2_tmp = 0;
       countPackedGlTransactions0(
         gpuWarpSize, accWidth, cacheWidth, launchConfig.numthread_x,
 	numPos, posMbarIn, posMbarOut, volMmk1,
@@ -1277,12 +1488,12 @@ bool librettPlan_t::countCycles( const gpuDeviceProp_t &prop, const int numPosMb
       cl_part_l2 += cl_part_l2_tmp;
 
 #ifdef COUNTCYCLE_CHECK
-      int gld_tran_ref = 0;
-      int gst_tran_ref = 0;
-      int gld_req_ref = 0;
-      int gst_req_ref = 0;
-      int cl_full_l2_ref = 0;
-      int cl_part_l2_ref = 0;
+      long long int gld_tran_ref = 0;
+      long long int gst_tran_ref = 0;
+      long long int gld_req_ref = 0;
+      long long int gst_req_ref = 0;
+      long long int cl_full_l2_ref = 0;
+      long long int cl_part_l2_ref = 0;
       for (int i=0;i < numPos;i++) {
         countPackedGlTransactions(gpuWarpSize, accWidth, cacheWidth, launchConfig.numthread_x,
           posMbarIn[i], posMbarOut[i], volMmk1, posMmkIn1, posMmkOut1,
@@ -1292,14 +1503,14 @@ bool librettPlan_t::countCycles( const gpuDeviceProp_t &prop, const int numPosMb
       if (gld_tran_tmp != gld_tran_ref || gst_tran_tmp != gst_tran_ref ||
         gld_req_tmp != gld_req_ref || gst_req_tmp != gst_req_ref) {
         printf("PackedSplit:countPackedGlTransactions0 ERROR\n");
-        printf("tmp %d %d %d %d\n", gld_tran_tmp, gst_tran_tmp, gld_req_tmp, gst_req_tmp);
-        printf("ref %d %d %d %d\n", gld_tran_ref, gst_tran_ref, gld_req_ref, gst_req_ref);
+        printf("tmp %lld %lld %lld %lld\n", gld_tran_tmp, gst_tran_tmp, gld_req_tmp, gst_req_tmp);
+        printf("ref %lld %lld %lld %lld\n", gld_tran_ref, gst_tran_ref, gld_req_ref, gst_req_ref);
         return false;
       }
       if (cl_full_l2_tmp != cl_full_l2_ref || cl_part_l2_tmp != cl_part_l2_ref) {
         printf("PackedSplit:countPackedGlTransactions0 ERROR\n");
-        printf("tmp %d %d\n", cl_full_l2_tmp, cl_part_l2_tmp);
-        printf("ref %d %d\n",  cl_full_l2_ref, cl_part_l2_ref);
+        printf("tmp %lld %lld\n", cl_full_l2_tmp, cl_part_l2_tmp);
+        printf("ref %lld %lld\n",  cl_full_l2_ref, cl_part_l2_ref);
         return false;
       }
 #endif
@@ -1311,24 +1522,30 @@ bool librettPlan_t::countCycles( const gpuDeviceProp_t &prop, const int numPosMb
       int posMbarIn[INT_VECTOR_LEN];
       int posMbarOut[INT_VECTOR_LEN];
       for (int i=0;i < numPos;i++) {
-        int posMbar = pos[ipos + i] / tensorSplit.numSplit;
+        long long int posMbar = pos[ipos + i] / tensorSplit.numSplit;
         int isplit  = pos[ipos + i] % tensorSplit.numSplit;
-        int p0 = isplit*tensorSplit.splitDim/tensorSplit.numSplit;
-        computePos(posMbar, posMbar, hostMbar.data(), tensorSplit.sizeMbar, &posMbarIn[i], &posMbarOut[i]);
-        posMbarIn[i] += p0*cuDimMm;
-        posMbarOut[i] += p0*cuDimMk;
+        long long int p0 = (long long int)isplit*tensorSplit.splitDim/tensorSplit.numSplit;
+        if (index64) {
+          computePos(posMbar, posMbar, hostMbar64.data(), tensorSplit.sizeMbar, &posMbarIn[i], &posMbarOut[i]);
+          posMbarIn[i] = modelPos(posMbarIn[i] + p0*cuDimMm);
+          posMbarOut[i] = modelPos(posMbarOut[i] + p0*cuDimMk);
+        } else {
+          computePos((int)posMbar, (int)posMbar, hostMbar.data(), tensorSplit.sizeMbar, &posMbarIn[i], &posMbarOut[i]);
+          posMbarIn[i] += p0*cuDimMm;
+          posMbarOut[i] += p0*cuDimMk;
+        }
       }
       for (int i=numPos;i < INT_VECTOR_LEN;i++) {
         posMbarIn[i]  = posMbarIn[numPos - 1];
         posMbarOut[i] = posMbarOut[numPos - 1];
       }
 
-      int gld_tran_tmp = 0;
-      int gst_tran_tmp = 0;
-      int gld_req_tmp = 0;
-      int gst_req_tmp = 0;
-      int cl_full_l2_tmp = 0;
-      int cl_part_l2_tmp = 0;
+      long long int gld_tran_tmp = 0;
+      long long int gst_tran_tmp = 0;
+      long long int gld_req_tmp = 0;
+      long long int gst_req_tmp = 0;
+      long long int cl_full_l2_tmp = 0;
+      long long int cl_part_l2_tmp = 0;
       countPackedGlTransactions0( gpuWarpSize, accWidth, cacheWidth, launchConfig.numthread_x,
         numPos, posMbarIn, posMbarOut, volMmk0,
         posMmkIn0.data(), posMmkOut0.data(), gld_tran_tmp, gst_tran_tmp,
@@ -1341,12 +1558,12 @@ bool librettPlan_t::countCycles( const gpuDeviceProp_t &prop, const int numPosMb
       cl_part_l2 += cl_part_l2_tmp;
 
 #ifdef COUNTCYCLE_CHECK
-      int gld_tran_ref = 0;
-      int gst_tran_ref = 0;
-      int gld_req_ref = 0;
-      int gst_req_ref = 0;
-      int cl_full_l2_ref = 0;
-      int cl_part_l2_ref = 0;
+      long long int gld_tran_ref = 0;
+      long long int gst_tran_ref = 0;
+      long long int gld_req_ref = 0;
+      long long int gst_req_ref = 0;
+      long long int cl_full_l2_ref = 0;
+      long long int cl_part_l2_ref = 0;
       for (int i=0;i < numPos;i++) {
         countPackedGlTransactions(gpuWarpSize, accWidth, cacheWidth, launchConfig.numthread_x,
           posMbarIn[i], posMbarOut[i], volMmk0, posMmkIn0, posMmkOut0,
@@ -1356,14 +1573,14 @@ bool librettPlan_t::countCycles( const gpuDeviceProp_t &prop, const int numPosMb
       if (gld_tran_tmp != gld_tran_ref || gst_tran_tmp != gst_tran_ref ||
         gld_req_tmp != gld_req_ref || gst_req_tmp != gst_req_ref) {
         printf("PackedSplit:countPackedGlTransactions0 ERROR\n");
-        printf("tmp %d %d %d %d\n", gld_tran_tmp, gst_tran_tmp, gld_req_tmp, gst_req_tmp);
-        printf("ref %d %d %d %d\n", gld_tran_ref, gst_tran_ref, gld_req_ref, gst_req_ref);
+        printf("tmp %lld %lld %lld %lld\n", gld_tran_tmp, gst_tran_tmp, gld_req_tmp, gst_req_tmp);
+        printf("ref %lld %lld %lld %lld\n", gld_tran_ref, gst_tran_ref, gld_req_ref, gst_req_ref);
         return false;
       }
       if (cl_full_l2_tmp != cl_full_l2_ref || cl_part_l2_tmp != cl_part_l2_ref) {
         printf("PackedSplit:countPackedGlTransactions0 ERROR\n");
-        printf("tmp %d %d\n", cl_full_l2_tmp, cl_part_l2_tmp);
-        printf("ref %d %d\n",  cl_full_l2_ref, cl_part_l2_ref);
+        printf("tmp %lld %lld\n", cl_full_l2_tmp, cl_part_l2_tmp);
+        printf("ref %lld %lld\n",  cl_full_l2_ref, cl_part_l2_ref);
         return false;
       }
 #endif
@@ -1380,22 +1597,22 @@ bool librettPlan_t::countCycles( const gpuDeviceProp_t &prop, const int numPosMb
     sld_req = 0;
     sst_req = 0;
     // Round down splits
-    countPackedShTransactions0(gpuWarpSize, gpuWarpSize, launchConfig.numthread_x,
+    countPackedShTransactions0(gpuWarpSize, gpuWarpSize, shWordShift(sizeofType), launchConfig.numthread_x,
       volMmk0, hostMsh.data(), tensorSplit.sizeMmk, sld_tran, sst_tran, sld_req, sst_req);
 #ifdef COUNTCYCLE_CHECK
     {
-      int sld_tran_ref = 0;
-      int sst_tran_ref = 0;
-      int sld_req_ref = 0;
-      int sst_req_ref = 0;
-      countPackedShTransactionsRef(gpuWarpSize, gpuWarpSize, launchConfig.numthread_x,
+      long long int sld_tran_ref = 0;
+      long long int sst_tran_ref = 0;
+      long long int sld_req_ref = 0;
+      long long int sst_req_ref = 0;
+      countPackedShTransactionsRef(gpuWarpSize, gpuWarpSize, shWordShift(sizeofType), launchConfig.numthread_x,
         volMmk0, hostMsh.data(), tensorSplit.sizeMmk,
         sld_tran_ref, sst_tran_ref, sld_req_ref, sst_req_ref);
       if (sld_tran != sld_tran_ref || sst_tran != sst_tran_ref ||
         sld_req != sld_req_ref || sst_req != sst_req_ref) {
         printf("PackedSplit:countPackedShTransactions0 fails\n");
-        printf("    %d %d %d %d\n", sld_tran, sst_tran, sld_req, sst_req);
-        printf("ref %d %d %d %d\n", sld_tran_ref, sst_tran_ref, sld_req_ref, sst_req_ref);
+        printf("    %lld %lld %lld %lld\n", sld_tran, sst_tran, sld_req, sst_req);
+        printf("ref %lld %lld %lld %lld\n", sld_tran_ref, sst_tran_ref, sld_req_ref, sst_req_ref);
         return false;
       }
     }
@@ -1407,27 +1624,27 @@ bool librettPlan_t::countCycles( const gpuDeviceProp_t &prop, const int numPosMb
 
     // Round up splits
     if (num1 > 0) {
-      int sld_tran_tmp = 0;
-      int sst_tran_tmp = 0;
-      int sld_req_tmp = 0;
-      int sst_req_tmp = 0;
-      countPackedShTransactions0(gpuWarpSize, gpuWarpSize, launchConfig.numthread_x,
+      long long int sld_tran_tmp = 0;
+      long long int sst_tran_tmp = 0;
+      long long int sld_req_tmp = 0;
+      long long int sst_req_tmp = 0;
+      countPackedShTransactions0(gpuWarpSize, gpuWarpSize, shWordShift(sizeofType), launchConfig.numthread_x,
 	volMmk1, hostMsh.data() + tensorSplit.sizeMmk, tensorSplit.sizeMmk,
         sld_tran_tmp, sst_tran_tmp, sld_req_tmp, sst_req_tmp);
 #ifdef COUNTCYCLE_CHECK
       {
-        int sld_tran_ref = 0;
-        int sst_tran_ref = 0;
-        int sld_req_ref = 0;
-        int sst_req_ref = 0;
-        countPackedShTransactionsRef(gpuWarpSize, gpuWarpSize, launchConfig.numthread_x,
+        long long int sld_tran_ref = 0;
+        long long int sst_tran_ref = 0;
+        long long int sld_req_ref = 0;
+        long long int sst_req_ref = 0;
+        countPackedShTransactionsRef(gpuWarpSize, gpuWarpSize, shWordShift(sizeofType), launchConfig.numthread_x,
           volMmk1, hostMsh.data() + tensorSplit.sizeMmk, tensorSplit.sizeMmk,
           sld_tran_ref, sst_tran_ref, sld_req_ref, sst_req_ref);
         if (sld_tran_tmp != sld_tran_ref || sst_tran_tmp != sst_tran_ref ||
           sld_req_tmp != sld_req_ref || sst_req_tmp != sst_req_ref) {
           printf("PackedSplit:countPackedShTransactions0 fails\n");
-          printf("    %d %d %d %d\n", sld_tran, sst_tran, sld_req, sst_req);
-          printf("ref %d %d %d %d\n", sld_tran_ref, sst_tran_ref, sld_req_ref, sst_req_ref);
+          printf("    %lld %lld %lld %lld\n", sld_tran, sst_tran, sld_req, sst_req);
+          printf("ref %lld %lld %lld %lld\n", sld_tran_ref, sst_tran_ref, sld_req_ref, sst_req_ref);
           return false;
         }
       }
@@ -1459,13 +1676,18 @@ bool librettPlan_t::countCycles( const gpuDeviceProp_t &prop, const int numPosMb
     cl_part_l1 = 0;
     // Random number generator
     std::default_random_engine generator;
-    std::uniform_int_distribution<int> distribution(0, tensorSplit.volMbar - 1);
+    std::uniform_int_distribution<long long int> distribution(0, tensorSplit.volMbar - 1);
     // Pre-compute posMmkIn and posMmkOut
     std::vector<int> posMmkIn(tensorSplit.volMmk);
     std::vector<int> posMmkOut(tensorSplit.volMmk);
 
-    computePos0(tensorSplit.volMmk, hostMmk.data(), tensorSplit.sizeMmk,
-      posMmkIn.data(), posMmkOut.data());
+    if (index64) {
+      computePos(0, tensorSplit.volMmk - 1, hostMmk64.data(), tensorSplit.sizeMmk,
+        posMmkIn.data(), posMmkOut.data());
+    } else {
+      computePos0(tensorSplit.volMmk, hostMmk.data(), tensorSplit.sizeMmk,
+        posMmkIn.data(), posMmkOut.data());
+    }
     // computePos(0, tensorSplit.volMmk - 1, hostMmkFast.data(), tensorSplit.sizeMmk,
     //   posMmkIn.data(), posMmkOut.data());
 #ifdef COUNTCYCLE_CHECK
@@ -1482,7 +1704,7 @@ bool librettPlan_t::countCycles( const gpuDeviceProp_t &prop, const int numPosMb
     }
 #endif
 
-    int num_ipos = (numPosMbarSample == 0) ? tensorSplit.volMbar : numPosMbarSample;
+    int num_ipos = (numPosMbarSample == 0) ? (int)tensorSplit.volMbar : numPosMbarSample;
 
 #ifdef ENABLE_NVTOOLS
     gpuRangeStop();
@@ -1492,7 +1714,7 @@ bool librettPlan_t::countCycles( const gpuDeviceProp_t &prop, const int numPosMb
     for (int iposMbar=0;iposMbar < num_ipos;iposMbar+=INT_VECTOR_LEN) {
       // int posMbar = (numPosMbarSample == 0) ? iposMbar : distribution(generator);
       int numPos = std::min(num_ipos - iposMbar, INT_VECTOR_LEN);
-      int posMbar[INT_VECTOR_LEN];
+      long long int posMbar[INT_VECTOR_LEN];
       for (int i=0;i < numPos;i++) {
         posMbar[i] = (numPosMbarSample == 0) ? (iposMbar + i) : distribution(generator);
       }
@@ -1506,7 +1728,11 @@ bool librettPlan_t::countCycles( const gpuDeviceProp_t &prop, const int numPosMb
       gpuRangeStart("computePos");
 #endif
       for (int i=0;i < INT_VECTOR_LEN;i++) {
-        computePos(posMbar[i], posMbar[i], hostMbar.data(), tensorSplit.sizeMbar, &posMbarIn[i], &posMbarOut[i]);
+        if (index64) {
+          computePos(posMbar[i], posMbar[i], hostMbar64.data(), tensorSplit.sizeMbar, &posMbarIn[i], &posMbarOut[i]);
+        } else {
+          computePos((int)posMbar[i], (int)posMbar[i], hostMbar.data(), tensorSplit.sizeMbar, &posMbarIn[i], &posMbarOut[i]);
+        }
       }
       // computePosRef(posMbar, posMbar, hostMbar.begin(), hostMbar.begin() + tensorSplit.sizeMbar, posMbarInV, posMbarOutV);
       // int posMbarIn = posMbarInV[0];
@@ -1517,12 +1743,12 @@ bool librettPlan_t::countCycles( const gpuDeviceProp_t &prop, const int numPosMb
       gpuRangeStart("countPackedGlTransactions");
 #endif
 
-      int gld_tran_tmp = 0;
-      int gst_tran_tmp = 0;
-      int gld_req_tmp = 0;
-      int gst_req_tmp = 0;
-      int cl_full_l2_tmp = 0;
-      int cl_part_l2_tmp = 0;
+      long long int gld_tran_tmp = 0;
+      long long int gst_tran_tmp = 0;
+      long long int gld_req_tmp = 0;
+      long long int gst_req_tmp = 0;
+      long long int cl_full_l2_tmp = 0;
+      long long int cl_part_l2_tmp = 0;
       countPackedGlTransactions0(gpuWarpSize, accWidth, cacheWidth, launchConfig.numthread_x,
 	numPos, posMbarIn, posMbarOut, tensorSplit.volMmk, posMmkIn.data(), posMmkOut.data(),
 	gld_tran_tmp, gst_tran_tmp, gld_req_tmp, gst_req_tmp, cl_full_l2_tmp,
@@ -1535,12 +1761,12 @@ bool librettPlan_t::countCycles( const gpuDeviceProp_t &prop, const int numPosMb
       cl_part_l2 += cl_part_l2_tmp;
 
 #ifdef COUNTCYCLE_CHECK
-      int gld_tran_ref = 0;
-      int gst_tran_ref = 0;
-      int gld_req_ref = 0;
-      int gst_req_ref = 0;
-      int cl_full_l2_ref = 0;
-      int cl_part_l2_ref = 0;
+      long long int gld_tran_ref = 0;
+      long long int gst_tran_ref = 0;
+      long long int gld_req_ref = 0;
+      long long int gst_req_ref = 0;
+      long long int cl_full_l2_ref = 0;
+      long long int cl_part_l2_ref = 0;
       for (int i=0;i < numPos;i++) {
         countPackedGlTransactions(gpuWarpSize, accWidth, cacheWidth, launchConfig.numthread_x,
           posMbarIn[i], posMbarOut[i], tensorSplit.volMmk, posMmkIn, posMmkOut,
@@ -1550,14 +1776,14 @@ bool librettPlan_t::countCycles( const gpuDeviceProp_t &prop, const int numPosMb
       if (gld_tran_tmp != gld_tran_ref || gst_tran_tmp != gst_tran_ref ||
         gld_req_tmp != gld_req_ref || gst_req_tmp != gst_req_ref) {
         printf("countPackedGlTransactions0 ERROR\n");
-        printf("tmp %d %d %d %d\n", gld_tran_tmp, gst_tran_tmp, gld_req_tmp, gst_req_tmp);
-        printf("ref %d %d %d %d\n", gld_tran_ref, gst_tran_ref, gld_req_ref, gst_req_ref);
+        printf("tmp %lld %lld %lld %lld\n", gld_tran_tmp, gst_tran_tmp, gld_req_tmp, gst_req_tmp);
+        printf("ref %lld %lld %lld %lld\n", gld_tran_ref, gst_tran_ref, gld_req_ref, gst_req_ref);
         return false;
       }
       if (cl_full_l2_tmp != cl_full_l2_ref || cl_part_l2_tmp != cl_part_l2_ref) {
         printf("countPackedGlTransactions0 ERROR\n");
-        printf("tmp %d %d\n", cl_full_l2_tmp, cl_part_l2_tmp);
-        printf("ref %d %d\n",  cl_full_l2_ref, cl_part_l2_ref);
+        printf("tmp %lld %lld\n", cl_full_l2_tmp, cl_part_l2_tmp);
+        printf("ref %lld %lld\n",  cl_full_l2_ref, cl_part_l2_ref);
         return false;
       }
 #endif
@@ -1577,25 +1803,25 @@ bool librettPlan_t::countCycles( const gpuDeviceProp_t &prop, const int numPosMb
     sst_tran = 0;
     sld_req = 0;
     sst_req = 0;
-    countPackedShTransactions0(gpuWarpSize, gpuWarpSize, launchConfig.numthread_x,
+    countPackedShTransactions0(gpuWarpSize, gpuWarpSize, shWordShift(sizeofType), launchConfig.numthread_x,
       tensorSplit.volMmk, hostMsh.data(), tensorSplit.sizeMmk, sld_tran, sst_tran, sld_req, sst_req);
 #ifdef COUNTCYCLE_CHECK
-    int sld_tran_ref = 0;
-    int sst_tran_ref = 0;
-    int sld_req_ref = 0;
-    int sst_req_ref = 0;
-    countPackedShTransactionsRef(gpuWarpSize, gpuWarpSize, launchConfig.numthread_x,
+    long long int sld_tran_ref = 0;
+    long long int sst_tran_ref = 0;
+    long long int sld_req_ref = 0;
+    long long int sst_req_ref = 0;
+    countPackedShTransactionsRef(gpuWarpSize, gpuWarpSize, shWordShift(sizeofType), launchConfig.numthread_x,
       tensorSplit.volMmk, hostMsh.data(), tensorSplit.sizeMmk,
       sld_tran_ref, sst_tran_ref, sld_req_ref, sst_req_ref);
     if (sld_tran != sld_tran_ref || sst_tran != sst_tran_ref ||
       sld_req != sld_req_ref || sst_req != sst_req_ref) {
       printf("countPackedShTransactions0 fails\n");
-      printf("    %d %d %d %d\n", sld_tran, sst_tran, sld_req, sst_req);
-      printf("ref %d %d %d %d\n", sld_tran_ref, sst_tran_ref, sld_req_ref, sst_req_ref);
+      printf("    %lld %lld %lld %lld\n", sld_tran, sst_tran, sld_req, sst_req);
+      printf("ref %lld %lld %lld %lld\n", sld_tran_ref, sst_tran_ref, sld_req_ref, sst_req_ref);
       return false;
     }
 #endif
-    // countPackedShTransactions(gpuWarpSize, gpuWarpSize, launchConfig.numthread.x,
+    // countPackedShTransactions(gpuWarpSize, gpuWarpSize, shWordShift(sizeofType), launchConfig.numthread.x,
     //   tensorSplit.volMmk, hostMsh.data(), tensorSplit.sizeMmk,
     //   sld_tran, sst_tran, sld_req, sst_req);
 #ifdef ENABLE_NVTOOLS
@@ -1615,13 +1841,52 @@ bool librettPlan_t::countCycles( const gpuDeviceProp_t &prop, const int numPosMb
     sst_tran = 0;
     sld_req = 0;
     sst_req = 0;
-    // Cycles
-    cycles = 0.0;
-    return true;
   } else {
     return false;
   }
 
+  return true;
+}
+
+//
+// Count the number of cycles using the MWP-CWP model
+//
+bool librettPlan_t::countCycles( const gpuDeviceProp_t &prop, const int numPosMbarSample, const bool readOut) {
+
+  if (!countTransactions(prop, numPosMbarSample, sizeofType)) return false;
+  if (sizeofTypeOut != sizeofType) {
+    // Converting plans store narrower or wider elements than they load. Loads keep the
+    // input width, stores and written cache lines are counted again with the output width
+    long long int gld_tran_in = gld_tran;
+    long long int gld_req_in = gld_req;
+    if (!countTransactions(prop, numPosMbarSample, sizeofTypeOut)) return false;
+    gld_tran = gld_tran_in;
+    gld_req = gld_req_in;
+  }
+
+  if (tensorSplit.method == Trivial) {
+    cycles = 0.0;
+    return true;
+  }
+
+  // Accumulation reads odata with the same access pattern as it is written
+  if (readOut) {
+    gld_tran += gst_tran;
+    gld_req += gst_req;
+  }
+
+#if LIBRETT_USES_CPU
+  {
+    // Counts above cover num_ipos Mbar positions (or Mbar x split positions) out of numUnit
+    double numUnit = (double)((tensorSplit.method == PackedSplit) ? tensorSplit.volMbar*tensorSplit.numSplit : tensorSplit.volMbar);
+    double numSample = (numPosMbarSample == 0) ? numUnit : (double)numPosMbarSample;
+    cycles = cyclesHost(tensorSplit.method, sizeofType, prop, numUnit/numSample,
+      (double)tensorSplit.volMmk*(double)tensorSplit.volMbar, num_iter,
+      gld_tran, gst_tran, cl_full_l2, cl_part_l2);
+    return true;
+  }
+#endif
+
   int numthread = launchConfig.numthread_x*launchConfig.numthread_y*launchConfig.numthread_z;
   // double cl_val = (double)cl_part/(double)std::max(1, cl_full + cl_part);
 
@@ -1641,27 +1906,52 @@ bool librettPlan_t::countCycles( const gpuDeviceProp_t &prop, const int numPosMb
 }
 
 //
-// Activates the plan: Allocates device memory buffers and copies data to them
+// Descriptors that fit in the kernel arguments are passed by value and get no device
+// buffer, see DescArg in Types.h. Mbar has size entries, Mmk and Msh MmkSize entries
+//
+static bool mbarOnDevice(const int size) {
+  return size > DESC_INLINE;
+}
+
+static bool mmkOnDevice(const int MmkSize) {
+  return MmkSize > 2*DESC_INLINE;
+}
+
+//
+// Activates the plan: Allocates device memory buffers and copies data to them.
+// Short descriptors stay on the host, which makes activating most plans allocation free
 //
 void librettPlan_t::activate() {
 
   gpuStream_t queue = this->getStream();
-
-  if (tensorSplit.sizeMbar > 0) {
-    if (Mbar == nullptr) {
-      allocate_device<TensorConvInOut>(&Mbar, tensorSplit.sizeMbar, queue);
+  descriptorStream = queue;
+  librettKernelActivate(*this);
+
+  if (mbarOnDevice(tensorSplit.sizeMbar)) {
+    if (index64) {
+      if (Mbar64 == nullptr) {
+        allocate_descriptor<TensorConvInOut64>(&Mbar64, tensorSplit.sizeMbar, deviceID, queue);
+        copy_HtoD<TensorConvInOut64>(hostMbar64.data(), Mbar64, tensorSplit.sizeMbar, queue);
+      }
+    } else if (Mbar == nullptr) {
+      allocate_descriptor<TensorConvInOut>(&Mbar, tensorSplit.sizeMbar, deviceID, queue);
       copy_HtoD<TensorConvInOut>(hostMbar.data(), Mbar, tensorSplit.sizeMbar, queue);
     }
   }
 
-  if (tensorSplit.method == Packed || tensorSplit.method == PackedSplit) {
-    int MmkSize = (tensorSplit.method == Packed) ? tensorSplit.sizeMmk : tensorSplit.sizeMmk*2;
-    if (Mmk == nullptr) {
-      allocate_device<TensorConvInOut>(&Mmk, MmkSize, queue);
+  int MmkSize = (tensorSplit.method == Packed) ? tensorSplit.sizeMmk : tensorSplit.sizeMmk*2;
+  if ((tensorSplit.method == Packed || tensorSplit.method == PackedSplit) && mmkOnDevice(MmkSize)) {
+    if (index64) {
+      if (Mmk64 == nullptr) {
+        allocate_descriptor<TensorConvInOut64>(&Mmk64, MmkSize, deviceID, queue);
+        copy_HtoD<TensorConvInOut64>(hostMmk64.data(), Mmk64, MmkSize, queue);
+      }
+    } else if (Mmk == nullptr) {
+      allocate_descriptor<TensorConvInOut>(&Mmk, MmkSize, deviceID, queue);
       copy_HtoD<TensorConvInOut>(hostMmk.data(), Mmk, MmkSize, queue);
     }
     if (Msh == nullptr) {
-      allocate_device<TensorConv>(&Msh, MmkSize, queue);
+      allocate_descriptor<TensorConv>(&Msh, MmkSize, deviceID, queue);
       copy_HtoD<TensorConv>(hostMsh.data(), Msh, MmkSize, queue);
     }
   }
@@ -1673,6 +1963,224 @@ void librettPlan_t::activate() {
 
 }
 
+// Alignment of the descriptors in a shared allocation, see activateShared()
+const size_t DESCRIPTOR_ALIGN = 128;
+
+static size_t alignDescriptor(const size_t size) {
+  return (size + DESCRIPTOR_ALIGN - 1)/DESCRIPTOR_ALIGN*DESCRIPTOR_ALIGN;
+}
+
+//
+// Returns the number of bytes of device descriptors that activate() allocates,
+// with every descriptor aligned to DESCRIPTOR_ALIGN bytes
+//
+size_t librettPlan_t::descriptorSize() const {
+  size_t size = 0;
+  if (mbarOnDevice(tensorSplit.sizeMbar)) {
+    size += alignDescriptor(tensorSplit.sizeMbar*(index64 ? sizeof(TensorConvInOut64) : sizeof(TensorConvInOut)));
+  }
+  int MmkSize = (tensorSplit.method == Packed) ? tensorSplit.sizeMmk : tensorSplit.sizeMmk*2;
+  if ((tensorSplit.method == Packed || tensorSplit.method == PackedSplit) && mmkOnDevice(MmkSize)) {
+    size += alignDescriptor(MmkSize*(index64 ? sizeof(TensorConvInOut64) : sizeof(TensorConvInOut)));
+    size += alignDescriptor(MmkSize*sizeof(TensorConv));
+  }
+  return size;
+}
+
+//
+// Activates the plan with the descriptors in a device buffer shared with other plans:
+// the descriptors are placed at buf, descriptorSize() bytes, and their host copy at
+// hostBuf. The caller copies hostBuf to buf and owns buf, see descriptorOwner
+//
+void librettPlan_t::activateShared(char* buf, char* hostBuf) {
+  librettKernelActivate(*this);
+  size_t pos = 0;
+  auto place = [&](const void* hostData, const size_t size) {
+    memcpy(hostBuf + pos, hostData, size);
+    char* p = buf + pos;
+    pos += alignDescriptor(size);
+    return p;
+  };
+
+  if (mbarOnDevice(tensorSplit.sizeMbar)) {
+    if (index64) {
+      Mbar64 = (TensorConvInOut64 *)place(hostMbar64.data(), tensorSplit.sizeMbar*sizeof(TensorConvInOut64));
+    } else {
+      Mbar = (TensorConvInOut *)place(hostMbar.data(), tensorSplit.sizeMbar*sizeof(TensorConvInOut));
+    }
+  }
+
+  int MmkSize = (tensorSplit.method == Packed) ? tensorSplit.sizeMmk : tensorSplit.sizeMmk*2;
+  if ((tensorSplit.method == Packed || tensorSplit.method == PackedSplit) && mmkOnDevice(MmkSize)) {
+    if (index64) {
+      Mmk64 = (TensorConvInOut64 *)place(hostMmk64.data(), MmkSize*sizeof(TensorConvInOut64));
+    } else {
+      Mmk = (TensorConvInOut *)place(hostMmk.data(), MmkSize*sizeof(TensorConvInOut));
+    }
+    Msh = (TensorConv *)place(hostMsh.data(), MmkSize*sizeof(TensorConv));
+  }
+}
+
+//
+// Sets up batched execution of count tensors, tensor i is at idata + i*strideIn and
+// odata + i*strideOut. The batch index becomes the slowest Mbar rank, so the existing
+// kernels run the whole batch in one launch with volMbar*count positions.
+// The setup is kept for repeated calls with the same parameters.
+//
+// Returns false when the plan cannot be batched: Trivial plans have no Mbar and all
+// Mbar lanes of the warp are already in use
+//
+bool librettPlan_t::setupBatch(const long long int count, const long long int strideIn,
+  const long long int strideOut, const int deviceID, const gpuDeviceProp_t &prop) {
+
+  batchPointers = false;
+  if (batchCount > 0) {
+    if (count == batchCount && strideIn == batchStrideIn && strideOut == batchStrideOut) return true;
+  }
+
+  const int sizeMbar = tensorSplit.sizeMbar;
+  if (tensorSplit.method == Trivial || sizeMbar + 1 > gpuWarpSize) return false;
+
+  TensorSplit ts = tensorSplit;
+  ts.sizeMbar++;
+  ts.volMbar *= count;
+  // The previous setup stays intact when this one fails
+  LaunchConfig lc;
+  if (librettKernelLaunchConfiguration(sizeofType, ts, deviceID, prop, lc) == 0) return false;
+  batchLaunchConfig = lc;
+
+  TensorConvInOut64 batchConv;
+  batchConv.c_in   = tensorSplit.volMbar;
+  batchConv.d_in   = count;
+  batchConv.ct_in  = strideIn;
+  batchConv.c_out  = tensorSplit.volMbar;
+  batchConv.d_out  = count;
+  batchConv.ct_out = strideOut;
+
+  gpuStream_t queue = this->getStream();
+  if (index64) {
+    hostMbarBatch64 = hostMbar64;
+    hostMbarBatch64.push_back(batchConv);
+    if (mbarOnDevice(sizeMbar + 1)) {
+      if (MbarBatch64 == nullptr) allocate_descriptor<TensorConvInOut64>(&MbarBatch64, sizeMbar + 1, deviceID, queue);
+      copy_HtoD<TensorConvInOut64>(hostMbarBatch64.data(), MbarBatch64, sizeMbar + 1, queue);
+    }
+  } else {
+    std::vector<TensorConvInOut64> conv(1, batchConv);
+    narrowConv(conv, hostMbarBatch);
+    hostMbarBatch.insert(hostMbarBatch.begin(), hostMbar.begin(), hostMbar.end());
+    if (mbarOnDevice(sizeMbar + 1)) {
+      if (MbarBatch == nullptr) allocate_descriptor<TensorConvInOut>(&MbarBatch, sizeMbar + 1, deviceID, queue);
+      copy_HtoD<TensorConvInOut>(hostMbarBatch.data(), MbarBatch, sizeMbar + 1, queue);
+    }
+  }
+  batchCount = count;
+  batchStrideIn = strideIn;
+  batchStrideOut = strideOut;
+
+  return true;
+}
+
+//
+// Sets up batched execution of count tensors at arbitrary addresses, tensor i is at
+// idata[i] and odata[i]. The batch rank gets zero strides and the kernels pick the tensor
+// of each Mbar position from a device table of the pointers, so the whole batch still
+// runs in one launch. Returns false when setupBatch() does
+//
+bool librettPlan_t::setupBatchPointers(const long long int count, void* const* idata,
+  void* const* odata, const int deviceID, const gpuDeviceProp_t &prop) {
+
+  if (!setupBatch(count, 0, 0, deviceID, prop)) return false;
+
+  hostBatchData.assign(idata, idata + count);
+  hostBatchData.insert(hostBatchData.end(), odata, odata + count);
+
+  gpuStream_t queue = this->getStream();
+  const size_t size = hostBatchData.size();
+  if (batchData == nullptr || batchDataSize < size) {
+    if (batchData != nullptr) deallocate_descriptor<void*>(&batchData, deviceID, queue);
+    allocate_descriptor<void*>(&batchData, size, deviceID, queue);
+    batchDataSize = size;
+  }
+  copy_HtoD<void*>(hostBatchData.data(), batchData, size, queue);
+  batchPointers = true;
+
+  return true;
+}
+
+//
+// Sets up the grouped form of the plan used by librettKernelGrouped(): the tensor as a
+// Tiled or TiledCopy transpose with its own Mbar descriptors. Tiled and TiledCopy plans
+// are already in this form. Trivial plans become a single row, Packed and PackedSplit
+// plans get the Tiled (or TiledCopy) split of the reduced tensor.
+//
+// Returns false when the plan has no grouped form: converting plans, strided Packed plans
+// whose strides are not kept, and splits whose volumes do not fit into an int
+//
+bool librettPlan_t::setupGrouped() {
+
+  if (groupedMethod != -1) return (groupedMethod != Unknown);
+  groupedMethod = Unknown;
+
+  if (typeIn != -1) return false;
+
+  if (tensorSplit.method == Tiled || tensorSplit.method == TiledCopy) {
+    groupedMethod = tensorSplit.method;
+    groupedVolX = tiledVol_x;
+    groupedVolY = tiledVol_y;
+    groupedCuDimMk = cuDimMk;
+    groupedCuDimMm = cuDimMm;
+    groupedVolMbar = tensorSplit.volMbar;
+    if (index64) {
+      hostMbarGrouped = hostMbar64;
+    } else {
+      widenConv(hostMbar, hostMbarGrouped);
+    }
+    return true;
+  }
+
+  if (strided) return false;
+
+  if (tensorSplit.method == Trivial) {
+    const long long int vol = tensorSplit.volMmk*tensorSplit.volMbar;
+    if (vol > INT_MAX) return false;
+    groupedMethod = TiledCopy;
+    groupedVolX = (int)vol;
+    groupedVolY = 1;
+    groupedCuDimMk = vol;
+    groupedCuDimMm = vol;
+    groupedVolMbar = 1;
+    hostMbarGrouped.clear();
+    return true;
+  }
+
+  const int redRank = redDim.size();
+  TensorSplit ts;
+  if (redPermutation[0] != 0) {
+    ts.method = Tiled;
+    if (!ts.update(1, 1, redRank, redDim.data(), redPermutation.data())) return false;
+  } else {
+    ts.method = TiledCopy;
+    if (!ts.update(1, 2, redRank, redDim.data(), redPermutation.data())) return false;
+  }
+  librettPlan_t tiled;
+  if (!tiled.setup(redRank, redDim.data(), redPermutation.data(), sizeofType, ts, launchConfig, 1,
+    nullptr, nullptr)) return false;
+
+  groupedMethod = ts.method;
+  groupedVolX = tiled.tiledVol_x;
+  groupedVolY = tiled.tiledVol_y;
+  groupedCuDimMk = tiled.cuDimMk;
+  groupedCuDimMm = tiled.cuDimMm;
+  groupedVolMbar = ts.volMbar;
+  if (tiled.index64) {
+    hostMbarGrouped = tiled.hostMbar64;
+  } else {
+    widenConv(tiled.hostMbar, hostMbarGrouped);
+  }
+  return true;
+}
+
 //
 // Set device buffers to nullptr
 //
@@ -1682,22 +2190,45 @@ void librettPlan_t::nullDevicePointers() {
   Msh = nullptr;
   Mk = nullptr;
   Mm = nullptr;
+  Mbar64 = nullptr;
+  Mmk64 = nullptr;
+  MbarBatch = nullptr;
+  MbarBatch64 = nullptr;
+  batchData = nullptr;
 }
 
 librettPlan_t::librettPlan_t() {
   deviceID = 0;
   stream = nullptr;
+  descriptorStream = nullptr;
   numActiveBlock = 0;
+  index64 = false;
+  strided = false;
+  batchCount = 0;
+  batchStrideIn = 0;
+  batchStrideOut = 0;
+  batchPointers = false;
+  batchDataSize = 0;
+  typeIn = -1;
+  typeOut = -1;
+  groupedMethod = -1;
   nullDevicePointers();
 }
 
 librettPlan_t::~librettPlan_t() {
-  // Deallocate device buffers
-  if (Mbar != nullptr) deallocate_device<TensorConvInOut>(&Mbar, this->getStream());
-  if (Mmk != nullptr) deallocate_device<TensorConvInOut>(&Mmk, this->getStream());
-  if (Msh != nullptr) deallocate_device<TensorConv>(&Msh, this->getStream());
-  if (Mk != nullptr) deallocate_device<TensorConv>(&Mk, this->getStream());
-  if (Mm != nullptr) deallocate_device<TensorConv>(&Mm, this->getStream());
+  // Deallocate device buffers, shared descriptors belong to descriptorOwner
+  if (descriptorOwner == nullptr) {
+    if (Mbar != nullptr) deallocate_descriptor<TensorConvInOut>(&Mbar, deviceID, descriptorStream);
+    if (Mmk != nullptr) deallocate_descriptor<TensorConvInOut>(&Mmk, deviceID, descriptorStream);
+    if (Msh != nullptr) deallocate_descriptor<TensorConv>(&Msh, deviceID, descriptorStream);
+    if (Mk != nullptr) deallocate_descriptor<TensorConv>(&Mk, deviceID, descriptorStream);
+    if (Mm != nullptr) deallocate_descriptor<TensorConv>(&Mm, deviceID, descriptorStream);
+    if (Mbar64 != nullptr) deallocate_descriptor<TensorConvInOut64>(&Mbar64, deviceID, descriptorStream);
+    if (Mmk64 != nullptr) deallocate_descriptor<TensorConvInOut64>(&Mmk64, deviceID, descriptorStream);
+  }
+  if (MbarBatch != nullptr) deallocate_descriptor<TensorConvInOut>(&MbarBatch, deviceID, this->getStream());
+  if (MbarBatch64 != nullptr) deallocate_descriptor<TensorConvInOut64>(&MbarBatch64, deviceID, this->getStream());
+  if (batchData != nullptr) deallocate_descriptor<void*>(&batchData, deviceID, this->getStream());
 }
 
 void librettPlan_t::setStream(gpuStream_t& stream_in)
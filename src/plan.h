@@ -29,6 +29,8 @@ All rights reserved.
 #define LIBRETTPLAN_H
 
 #include <list>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include "Types.h"
 #include "uniapi.h"
@@ -48,6 +50,12 @@ All rights reserved.
 #endif
 const int TILEROWS = 8;
 
+// Row padding of the Tiled shared memory tile in elements. Rows of 1 and 2 byte elements
+// are padded by a whole 4 byte bank so that column accesses stay free of bank conflicts
+constexpr int tilePad(const size_t sizeofType) {
+  return (sizeofType < 4) ? (int)(4/sizeofType) : 1;
+}
+
 // Transposing methods
 enum {Unknown, Trivial, Packed, PackedSplit,
   Tiled, TiledCopy,
@@ -68,9 +76,9 @@ public:
   int sizeMk;
   int volMk;
 
-  // {Input} U {Output}
+  // {Input} U {Output}, fits into an int for the Packed methods
   int sizeMmk;
-  int volMmk;
+  long long int volMmk;
 
   // {Input} CUT {Output} = Mk which is not in Mm
   int sizeMkBar;
@@ -78,7 +86,7 @@ public:
 
   // Remaining volume
   int sizeMbar;
-  int volMbar;
+  long long int volMbar;
 
   // For Packed and PackedSplit methods:
   // Amount of contigious volume
@@ -100,7 +108,8 @@ public:
 
   void print();
 
-  void update(const int sizeMm_in, const int sizeMk_in, const int rank,
+  // Returns false if volMm, volMk or volMkBar does not fit into an int
+  bool update(const int sizeMm_in, const int sizeMk_in, const int rank,
     const int* dim, const int* permutation);
 
   // Number of elements in shared memory space
@@ -133,6 +142,16 @@ public:
   void print();
 };
 
+class AdaptivePlan;
+
+// Mutex that keeps librettPlan_t copyable, a copy of a plan gets a mutex of its own
+class PlanMutex : public std::mutex {
+public:
+  PlanMutex() {}
+  PlanMutex(const PlanMutex&) : std::mutex() {}
+  PlanMutex& operator=(const PlanMutex&) { return *this; }
+};
+
 // Class that stores the plan data
 class librettPlan_t {
 public:
@@ -148,27 +167,50 @@ public:
   // Rank of the tensor
   int rank;
 
-  // Size of the tensor elements in bytes
+  // Reduced dimensions and permutation of the tensor, used by in-place execution
+  std::vector<int> redDim;
+  std::vector<int> redPermutation;
+
+  // Size of the tensor elements in bytes. Converting plans hold the input element size
+  // here, it sets the shared memory and tile layout
   size_t sizeofType;
 
+  // Converting plans only: output element size and the librettDataType of the input and
+  // output elements. typeIn = typeOut = -1 and sizeofTypeOut = sizeofType otherwise
+  size_t sizeofTypeOut;
+  int typeIn;
+  int typeOut;
+
+  // True when the tensor has more than INT_MAX elements. Such plans use the 64-bit
+  // descriptors hostMbar64 and hostMmk64 and the 64-bit index kernels
+  bool index64;
+
+  // True for plans created by librettPlanStrided(). The strides are in the ct_in and
+  // ct_out descriptors and in cuDimMk, cuDimMm
+  bool strided;
+
+  // Number of elements spanned by the input and the output tensor
+  long long int extentIn;
+  long long int extentOut;
+
   TensorSplit tensorSplit;
 
   // Number of active thread blocks
   int numActiveBlock;
 
-  int cuDimMk;
-  int cuDimMm;
+  long long int cuDimMk;
+  long long int cuDimMm;
 
   int2_t tiledVol;
 
   // Number of iterations of the kernel
-  int num_iter;
+  long long int num_iter;
   // Average memory level parallelism = average unroll count
   float mlp;
-  int gld_req, gst_req, gld_tran, gst_tran;
-  int cl_full_l2, cl_part_l2;
-  int cl_full_l1, cl_part_l1;
-  int sld_req, sst_req, sld_tran, sst_tran;
+  long long int gld_req, gst_req, gld_tran, gst_tran;
+  long long int cl_full_l2, cl_part_l2;
+  long long int cl_full_l1, cl_part_l1;
+  long long int sld_req, sst_req, sld_tran, sst_tran;
   double cycles;
 
   //--------------
@@ -177,6 +219,9 @@ public:
   std::vector<TensorConvInOut> hostMbar;
   std::vector<TensorConvInOut> hostMmk;
   std::vector<TensorConv> hostMsh;
+  // index64 plans only
+  std::vector<TensorConvInOut64> hostMbar64;
+  std::vector<TensorConvInOut64> hostMmk64;
 
   //----------------
   // Device buffers
@@ -196,38 +241,112 @@ public:
   // For TiledSingleOutRank
   TensorConv* Mm;
 
+  // index64 plans only
+  TensorConvInOut64* Mbar64;
+  TensorConvInOut64* Mmk64;
+
+  // Stream on which Mbar ... Mmk64 were allocated and are freed. Launches on other streams
+  // are ordered before the free, see librettKernel()
+  gpuStream_t descriptorStream;
+
+  // Plans handed out by the plan cache share the descriptors Mbar ... Mmk64 above with the
+  // cached plan, plans of librettPlanMany() share one device allocation. When set, the
+  // owner (the cached plan or the allocation) is kept alive while any such plan exists and
+  // frees the descriptors
+  std::shared_ptr<void> descriptorOwner;
+
+  // Plans of librettPlanAdaptive() have no descriptors of their own, their executions run
+  // the candidates of adaptive
+  std::shared_ptr<AdaptivePlan> adaptive;
+
+  // Gather tables of the host Packed kernels, built by librettKernelActivate(). Set 1 is
+  // for the PackedSplit splits with one more element along the split rank
+  std::vector<int> hostPosIn[2];
+  std::vector<int> hostPosOut[2];
+  std::vector<long long int> hostPosIn64[2];
+  std::vector<long long int> hostPosOut64[2];
+
+  //------------------------------------------------------------------------
+  // Batched execution, Mbar with the batch rank appended, see setupBatch()
+  //------------------------------------------------------------------------
+  // Held by batched executions of the plan while they set up and use the members below
+  PlanMutex batchMutex;
+  long long int batchCount;
+  long long int batchStrideIn;
+  long long int batchStrideOut;
+  LaunchConfig batchLaunchConfig;
+  std::vector<TensorConvInOut> hostMbarBatch;
+  std::vector<TensorConvInOut64> hostMbarBatch64;
+  TensorConvInOut* MbarBatch;
+  TensorConvInOut64* MbarBatch64;
+  // Batches of tensors at arbitrary addresses, see setupBatchPointers(). The input
+  // pointers followed by the output pointers, batchData on the device
+  bool batchPointers;
+  std::vector<void*> hostBatchData;
+  void** batchData;
+  size_t batchDataSize;
+
+  //------------------------------------------------------------------------------
+  // Grouped execution, the plan in Tiled or TiledCopy form, see setupGrouped()
+  //------------------------------------------------------------------------------
+  // -1 before setupGrouped(), Unknown for plans without a grouped form
+  int groupedMethod;
+  int groupedVolX;
+  int groupedVolY;
+  long long int groupedCuDimMk;
+  long long int groupedCuDimMm;
+  long long int groupedVolMbar;
+  std::vector<TensorConvInOut64> hostMbarGrouped;
+
   librettPlan_t();
   ~librettPlan_t();
   void print();
   gpuStream_t getStream() { return stream; };
   void setStream(gpuStream_t& stream_in);
-  bool countCycles(const gpuDeviceProp_t &prop, const int numPosMbarSample=0);
+  // readOut = true counts the reads of odata done by accumulating execution (beta != 0)
+  bool countCycles(const gpuDeviceProp_t &prop, const int numPosMbarSample=0, const bool readOut=false);
+  bool countTransactions(const gpuDeviceProp_t &prop, const int numPosMbarSample, const size_t sizeofTypeGl);
   void activate();
+  size_t descriptorSize() const;
+  void activateShared(char* buf, char* hostBuf);
   void nullDevicePointers();
+  bool setupBatch(const long long int count, const long long int strideIn, const long long int strideOut,
+    const int deviceID, const gpuDeviceProp_t &prop);
+  bool setupBatchPointers(const long long int count, void* const* idata, void* const* odata,
+    const int deviceID, const gpuDeviceProp_t &prop);
+  bool setupGrouped();
 
   static bool createPlans(const int rank, const int* dim, const int* permutation,
     const int redRank, const int* redDim, const int* redPermutation, const size_t sizeofType,
-    const int deviceID, const gpuDeviceProp_t &prop, std::list<librettPlan_t>& plans);
+    const int deviceID, const gpuDeviceProp_t &prop, std::list<librettPlan_t>& plans,
+    const long long int* inStride=nullptr, const long long int* outStride=nullptr,
+    const long long int* redInStride=nullptr, const long long int* redOutStride=nullptr);
 
 private:
   static bool createTrivialPlans(const int rank, const int* dim, const int* permutation,
-    const size_t sizeofType, const int deviceID, const gpuDeviceProp_t &prop, std::list<librettPlan_t>& plans);
+    const size_t sizeofType, const int deviceID, const gpuDeviceProp_t &prop, std::list<librettPlan_t>& plans,
+    const long long int* inStride, const long long int* outStride);
 
   static bool createTiledPlans(const int rank, const int* dim, const int* permutation,
-    const size_t sizeofType, const int deviceID, const gpuDeviceProp_t &prop, std::list<librettPlan_t>& plans);
+    const size_t sizeofType, const int deviceID, const gpuDeviceProp_t &prop, std::list<librettPlan_t>& plans,
+    const long long int* inStride, const long long int* outStride);
 
   static bool createTiledCopyPlans(const int rank, const int* dim, const int* permutation,
-    const size_t sizeofType, const int deviceID, const gpuDeviceProp_t &prop, std::list<librettPlan_t>& plans);
+    const size_t sizeofType, const int deviceID, const gpuDeviceProp_t &prop, std::list<librettPlan_t>& plans,
+    const long long int* inStride, const long long int* outStride);
 
   static bool createPackedPlans(const int rank, const int* dim, const int* permutation,
-    const size_t sizeofType, const int deviceID, const gpuDeviceProp_t &prop, std::list<librettPlan_t>& plans);
+    const size_t sizeofType, const int deviceID, const gpuDeviceProp_t &prop, std::list<librettPlan_t>& plans,
+    const long long int* inStride, const long long int* outStride);
 
   static bool createPackedSplitPlans(const int rank, const int* dim, const int* permutation,
-    const size_t sizeofType, const int deviceID, const gpuDeviceProp_t &prop, std::list<librettPlan_t>& plans);
+    const size_t sizeofType, const int deviceID, const gpuDeviceProp_t &prop, std::list<librettPlan_t>& plans,
+    const long long int* inStride, const long long int* outStride);
 
   bool setup(const int rank_in, const int* dim, const int* permutation,
     const size_t sizeofType_in, const TensorSplit& tensorSplit_in,
-    const LaunchConfig& launchConfig_in, const int numActiveBlock_in);
+    const LaunchConfig& launchConfig_in, const int numActiveBlock_in,
+    const long long int* inStride, const long long int* outStride);
 
 };
 
@@ -236,6 +355,14 @@ void printMatlab(const gpuDeviceProp_t &prop, std::list<librettPlan_t>& plans, s
 void reduceRanks(const int rank, const int* dim, const int* permutation,
   std::vector<int>& redDim, std::vector<int>& redPermutation);
 
+void reduceRanks(const int rank, const int* dim, const int* permutation,
+  const long long int* inStride, const long long int* outStride,
+  std::vector<int>& redDim, std::vector<int>& redPermutation,
+  std::vector<long long int>& redInStride, std::vector<long long int>& redOutStride);
+
 std::list<librettPlan_t>::iterator choosePlanHeuristic(std::list<librettPlan_t>& plans);
 
+std::vector< std::list<librettPlan_t>::iterator > chooseTopPlans(std::list<librettPlan_t>& plans,
+  const int count);
+
 #endif // LIBRETTPLAN_H
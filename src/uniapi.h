@@ -30,6 +30,13 @@ SOFTWARE.
   #include "sycl_device.hpp"
   #include <complex>
   typedef std::complex<double> librett_complex;
+#elif LIBRETT_USES_CPU
+  #include "cpu_device.hpp"
+  #if LIBRETT_CPU_SIMT
+  #include "cpu_simt.hpp"
+  #endif
+  #include <complex>
+  typedef std::complex<double> librett_complex;
 #elif HIP
   #include <hip/hip_runtime.h>
   #include <hip/hip_complex.h>
@@ -41,7 +48,7 @@ SOFTWARE.
   typedef cuDoubleComplex librett_complex;
 #endif
 
-#if !defined(SYCL) && !defined(HIP)
+#if !defined(SYCL) && !defined(HIP) && !defined(LIBRETT_USES_CPU)
   #define LIBRETT_USES_CUDA 1
 #endif
 
@@ -84,6 +91,43 @@ extern SYCL_EXTERNAL sycl::detail::ConvertToOpenCLType_t<sycl::vec<unsigned, 4>>
 
 extern SYCL_EXTERNAL sycl::vec<unsigned, 4> ballot(sycl::sub_group, bool);
 
+#elif LIBRETT_USES_CPU
+#if LIBRETT_CPU_SIMT
+  #define threadIdx_x   (Librett::simt::current.threadIdx.x)
+  #define blockIdx_x    (Librett::simt::current.blockIdx.x)
+  #define blockDim_x    (Librett::simt::current.blockDim.x)
+  #define gridDim_x     (Librett::simt::current.gridDim.x)
+  #define threadIdx_y   (Librett::simt::current.threadIdx.y)
+  #define blockIdx_y    (Librett::simt::current.blockIdx.y)
+  #define blockDim_y    (Librett::simt::current.blockDim.y)
+  #define gridDim_y     (Librett::simt::current.gridDim.y)
+  #define threadIdx_z   (Librett::simt::current.threadIdx.z)
+  #define blockIdx_z    (Librett::simt::current.blockIdx.z)
+  #define blockDim_z    (Librett::simt::current.blockDim.z)
+  #define gridDim_z     (Librett::simt::current.gridDim.z)
+  #define syncthreads() Librett::simt::syncthreads()
+  // Static shared memory belongs to the OS thread that runs the block
+  #define __shared__    static thread_local
+  #define __launch_bounds__(...)
+#endif
+  #define numthread_x   numthread.x
+  #define numthread_y   numthread.y
+  #define numthread_z   numthread.z
+  #define numblock_x    numblock.x
+  #define numblock_y    numblock.y
+  #define numblock_z    numblock.z
+  #define gpuMaxThreadsPerBlock    (prop.maxThreadsPerBlock)
+  #define gpuMultiProcessorCount   (prop.multiProcessorCount)
+  #define gpuWarpSize              (prop.warpSize)
+  #define gpuClockRate             (prop.clockRate / 1000.0)
+  #define gpuMajor                 (prop.major)
+  #define gpuSharedMemPerBlock     (prop.sharedMemPerBlock)
+  #define tiledVol_x    tiledVol.x
+  #define tiledVol_y    tiledVol.y
+  #define __gpu_inline__     inline
+  #define __global__
+  #define __device__
+
 #else // CUDA & HIP
   #define threadIdx_x   threadIdx.x
   #define blockIdx_x    blockIdx.x
@@ -123,6 +167,14 @@ extern SYCL_EXTERNAL sycl::vec<unsigned, 4> ballot(sycl::sub_group, bool);
   using gpuStream_t     = sycl::queue*;
   using gpuDeviceProp_t = Librett::DeviceProp_t;
   using gpuError_t      = int;
+#elif LIBRETT_USES_CPU
+  using dim3            = Librett::dim3;
+  using int2_t          = Librett::int2;
+  using int4_t          = Librett::int4;
+  using float4_t        = Librett::float4;
+  using gpuStream_t     = Librett::cpuStream_t;
+  using gpuDeviceProp_t = Librett::cpuDeviceProp;
+  using gpuError_t      = int;
 #elif HIP
   using int2_t          = int2;
   using int4_t          = int4;
@@ -150,13 +202,30 @@ extern SYCL_EXTERNAL sycl::vec<unsigned, 4> ballot(sycl::sub_group, bool);
   #define gpu_shuffle(a,b)    __shfl(a,b)
   #define gpu_shfl_down(a,b)  __shfl_down(a,b)
   #define gpu_atomicAdd(a,b)  atomicAdd(&(a), b)
-  #define gpuOccupancyMaxActiveBlocksPerMultiprocessor hipOccupancyMaxActiveBlocksPerMultiprocessor
+#elif LIBRETT_USES_CPU
+  #define gpu_shfl_xor(a,b)   __shfl_xor_sync(0xffffffff,a,b)
+  #define gpu_shuffle(a,b)    __shfl_sync(0xffffffff,a,b)
+  #define gpu_shfl_down(a,b)  __shfl_down_sync(0xffffffff,a,b)
+  #define gpu_atomicAdd(a,b)  atomicAdd(&(a), b)
 #else // CUDA
   #define gpu_shfl_xor(a,b)   __shfl_xor_sync(0xffffffff,a,b)
   #define gpu_shuffle(a,b)    __shfl_sync(0xffffffff,a,b)
   #define gpu_shfl_down(a,b)  __shfl_down_sync(0xffffffff,a,b)
   #define gpu_atomicAdd(a,b)  atomicAdd(&(a), b)
-  #define gpuOccupancyMaxActiveBlocksPerMultiprocessor cudaOccupancyMaxActiveBlocksPerMultiprocessor
+#endif
+
+// Global and shared memory accesses of the transpose kernels. The SIMT emulation counts
+// them per block, see Librett::simt::Stats, on the devices they are plain loads and stores
+#if LIBRETT_CPU_SIMT
+  #define gpu_ldGlobal(x)     Librett::simt::load<Librett::simt::GlobalLoad>(x)
+  #define gpu_stGlobal(x, v)  Librett::simt::store<Librett::simt::GlobalStore>(x, v)
+  #define gpu_ldShared(x)     Librett::simt::load<Librett::simt::SharedLoad>(x)
+  #define gpu_stShared(x, v)  Librett::simt::store<Librett::simt::SharedStore>(x, v)
+#else
+  #define gpu_ldGlobal(x)     (x)
+  #define gpu_stGlobal(x, v)  ((x) = (v))
+  #define gpu_ldShared(x)     (x)
+  #define gpu_stShared(x, v)  ((x) = (v))
 #endif
 
 #endif // UNIAPI_H
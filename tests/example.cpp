@@ -52,6 +52,8 @@ void CreateGpuStream(gpuStream_t& master_gpustream) {
   master_gpustream = new sycl::queue(ctxt, dev, Librett::sycl_asynchandler, sycl::property_list{sycl::property::queue::in_order{}});
   #elif HIP
   hipCheck(hipStreamCreate(&master_gpustream));
+  #elif LIBRETT_USES_CPU
+  master_gpustream = nullptr;
   #elif CUDA
   cudaCheck(cudaStreamCreate(&master_gpustream));
   #endif
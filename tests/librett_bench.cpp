@@ -30,6 +30,8 @@ SOFTWARE.
 #include <cmath>
 #include <cctype>
 #include <random>
+#include <thread>
+#include <atomic>
 #include "librett.h"
 #include "GpuUtils.h"
 #include "GpuMem.hpp"
@@ -37,6 +39,9 @@ SOFTWARE.
 #include "Timer.h"
 #include "GpuMemcpy.h"
 #include "int_vector.h"
+#if LIBRETT_USES_CPU
+#include "CpuTile.h"
+#endif
 
 #define MILLION 1000000
 #define BILLION 1000000000
@@ -48,6 +53,7 @@ TensorTester* tester = NULL;
 
 librettTimer* timer;
 bool use_librettPlanMeasure;
+int measureTopK;
 bool use_plantimer;
 
 std::default_random_engine generator;
@@ -58,6 +64,11 @@ bool bench3(int numElem, gpuStream_t& gpuStream);
 template <typename T> bool bench5(int numElem, int ratio, gpuStream_t& gpuStream);
 bool bench6(gpuStream_t& gpuStream);
 template <typename T> bool bench7(gpuStream_t& gpuStream);
+#if LIBRETT_USES_CPU
+bool bench8();
+#endif
+bool bench9(gpuStream_t& gpuStream);
+bool bench10();
 template <typename T> bool bench_input(std::vector<int>& dim, std::vector<int>& permutation, gpuStream_t& gpuStream);
 template <typename T> bool bench_memcpy(int numElem, gpuStream_t& gpuStream);
 
@@ -76,6 +87,7 @@ int main(int argc, char *argv[])
   bool passed = false;
   int benchID = 0;
   use_librettPlanMeasure = false;
+  measureTopK = 0;
   use_plantimer = false;
   int elemsize = 8;
   std::vector<int> dimIn;
@@ -92,6 +104,9 @@ int main(int argc, char *argv[])
       } else if (strcmp(argv[i], "-measure") == 0) {
         use_librettPlanMeasure = true;
         i++;
+      } else if (strcmp(argv[i], "-topk") == 0) {
+        sscanf(argv[i+1], "%d", &measureTopK);
+        i += 2;
       } else if (strcmp(argv[i], "-seed") == 0) {
         sscanf(argv[i+1], "%u", &seed);
         i += 2;
@@ -133,12 +148,18 @@ int main(int argc, char *argv[])
     printf("Options:\n");
     printf("-device [int]    : GPU ID (default is 0)\n");
     printf("-measure         : use librettPlanMeasure (default is librettPlan)\n");
+    printf("-topk [int]      : use librettPlanMeasureTopK with this many candidates\n");
     printf("-plantimer       : planning is timed (default is no)\n");
     printf("-seed [int]      : seed value for random number generator (default is system timer)\n");
     printf("-elemsize [int]  : size of elements in bytes, 4 or 8. (default is 8)\n");
     printf("-dim ...         : space-separated list of dimensions\n");
     printf("-permutation ... : space-separated list of permutations\n");
     printf("-bench benchID   : benchmark to run\n");
+#if LIBRETT_USES_CPU
+    printf("                   8 = host tile engine vs scalar loop\n");
+#endif
+    printf("                   9 = librettPlan latency vs number of planning threads\n");
+    printf("                   10 = librettExecute calls per second vs number of calling threads\n");
     return 1;
   }
 
@@ -160,6 +181,8 @@ int main(int argc, char *argv[])
   } else {
     hipCheck(hipDeviceSetSharedMemConfig(hipSharedMemBankSizeEightByte));
   }
+#elif LIBRETT_USES_CPU
+  gpuStream = nullptr;
 #else // CUDA
   cudaStreamCreate(&gpustream);
   if (elemsize == 4) {
@@ -174,7 +197,12 @@ int main(int argc, char *argv[])
 
   timer = new librettTimer(elemsize);
 
+#if LIBRETT_USES_CPU
+  // Host memory, sized for the largest benchmark (200M elements)
+  dataSize = 200*MILLION;
+#else
   dataSize = (elemsize == 4) ? 420*MILLION : 530*MILLION;
+#endif
 #if HIP
 //  dataSize = (elemsize == 4) ? 420*MILLION : 370*MILLION;
 #else // CUDA or SYCL
@@ -354,6 +382,23 @@ int main(int argc, char *argv[])
     }
   }
 
+#if LIBRETT_USES_CPU
+  if (benchID == 8) {
+    if (bench8()) goto benchOK;
+    goto fail;
+  }
+#endif
+
+  if (benchID == 9) {
+    if (bench9(gpuStream)) goto benchOK;
+    goto fail;
+  }
+
+  if (benchID == 10) {
+    if (bench10()) goto benchOK;
+    goto fail;
+  }
+
   // Otherwise, do memcopy benchmark
   {
     bool ok = (elemsize == 4) ? bench_memcpy<int>(benchID, gpuStream) : bench_memcpy<long long int>(benchID, gpuStream);
@@ -384,6 +429,7 @@ end:
 #elif HIP
   hipCheck(hipDeviceSynchronize());
   hipCheck(hipDeviceReset());
+#elif LIBRETT_USES_CPU
 #else // CUDA
   cudaCheck(cudaDeviceSynchronize());
   cudaCheck(cudaDeviceReset());
@@ -826,6 +872,9 @@ bool bench_tensor(std::vector<int> &dim, std::vector<int> &permutation, gpuStrea
   }
   if (use_librettPlanMeasure) {
     librettCheck(librettPlanMeasure(&plan, rank, dim.data(), permutation.data(), sizeof(T), q, dataIn, dataOut));
+  } else if (measureTopK > 0) {
+    librettCheck(librettPlanMeasureTopK(&plan, rank, dim.data(), permutation.data(), sizeof(T), q, dataIn, dataOut,
+      measureTopK, 5));
   } else {
     librettCheck(librettPlan(&plan, rank, dim.data(), permutation.data(), sizeof(T), q));
   }
@@ -843,20 +892,241 @@ bool bench_tensor(std::vector<int> &dim, std::vector<int> &permutation, gpuStrea
     q->wait_and_throw();
 #elif HIP
     hipCheck(hipStreamSynchronize(q));
+#elif LIBRETT_USES_CPU
 #else // CUDA
     cudaCheck(cudaStreamSynchronize(q));
 #endif
 
+#if LIBRETT_CPU_SIMT
+    Librett::simt::resetStats();
+#endif
     timer->start(dim, permutation);
     librettCheck(librettExecute(plan, dataIn, dataOut));
     timer->stop();
 
     printf("wall time %lf ms %lf GB/s\n", timer->seconds()*1000.0, timer->GBs());
+#if LIBRETT_CPU_SIMT
+    // Emulated execution, counts are per warp and do not depend on the host
+    Librett::simt::Stats stats = Librett::simt::getStats();
+    printf("simt blocks %llu threads %llu syncthreads %llu shuffles %llu ballots %llu\n",
+      stats.blocks, stats.threads, stats.syncthreads, stats.shuffles, stats.ballots);
+    // Memory accesses per block, by all threads of the block
+    const double numBlock = (double)std::max(1ULL, stats.blocks);
+    printf("simt per block global loads %.1lf stores %.1lf shared loads %.1lf stores %.1lf\n",
+      stats.globalLoads/numBlock, stats.globalStores/numBlock, stats.sharedLoads/numBlock,
+      stats.sharedStores/numBlock);
+#endif
   }
 
   librettCheck(librettDestroy(plan));
   return tester->checkTranspose<T>(rank, dim.data(), permutation.data(), (T *)dataOut);
 }
+#if LIBRETT_USES_CPU
+//
+// Benchmark 8: single-threaded host tile engine against the scalar loop.
+// Transposes an n x n matrix in 32 x 32 blocks, like the Tiled method does,
+// with n chosen so that the last row and column of blocks exercise the masked edges.
+//
+bool bench8() {
+  const int n = 250;
+  const int tileDim = 32;
+  const int nrep = 50;
+  const CpuIsa hostIsa = cpuIsa();
+  printf("bench8: host instruction set %s\n", cpuIsaName(hostIsa));
+  printf("elemsize isa GB/s speedup\n");
+
+  auto transpose = [&](TileTransposeFunc tileTranspose, const int sizeofType) {
+    for (int bx=0;bx < n;bx += tileDim) {
+      for (int by=0;by < n;by += tileDim) {
+        tileTranspose(dataIn + (bx + (size_t)by*n)*sizeofType, n,
+          dataOut + (by + (size_t)bx*n)*sizeofType, n, std::min(tileDim, n - bx), std::min(tileDim, n - by));
+      }
+    }
+  };
+
+  for (int sizeofType : {4, 8, 16}) {
+    const size_t bytes = (size_t)n*n*sizeofType;
+    std::vector<char> ref(bytes);
+    std::vector<double> best(hostIsa + 1, 0.0);
+    for (int isa=IsaScalar;isa <= hostIsa;isa++) {
+      memset(dataOut, 0, bytes);
+      transpose(tileTransposeFunc(sizeofType, (CpuIsa)isa), sizeofType);
+      if (isa == IsaScalar) {
+        memcpy(ref.data(), dataOut, bytes);
+      } else if (memcmp(ref.data(), dataOut, bytes) != 0) {
+        printf("bench8: %s result differs from scalar loop for elemsize %d\n", cpuIsaName((CpuIsa)isa), sizeofType);
+        return false;
+      }
+    }
+    // Alternate between the versions so that they see the same machine state
+    for (int rep=0;rep < nrep;rep++) {
+      for (int isa=IsaScalar;isa <= hostIsa;isa++) {
+        Timer tm;
+        tm.start();
+        transpose(tileTransposeFunc(sizeofType, (CpuIsa)isa), sizeofType);
+        tm.stop();
+        if (rep == 0 || tm.seconds() < best[isa]) best[isa] = tm.seconds();
+      }
+    }
+    for (int isa=IsaScalar;isa <= hostIsa;isa++) {
+      printf("%2d %-8s %6.2lf %5.2lf\n", sizeofType, cpuIsaName((CpuIsa)isa), 2.0*bytes/best[isa]/1.0e9, best[IsaScalar]/best[isa]);
+    }
+  }
+
+  return true;
+}
+#endif
+
+//
+// Benchmark 9: librettPlan() latency against the number of threads that run the
+// performance model. High rank tensors have the most Packed and PackedSplit candidates.
+// The plan cache is disabled so that every call runs the model
+//
+bool bench9(gpuStream_t& gpuStream) {
+  const int nrep = 5;
+  const int maxThread = std::max(1, (int)std::thread::hardware_concurrency());
+  std::vector<int> numThreads;
+  for (int n=1;n < maxThread;n *= 2) numThreads.push_back(n);
+  numThreads.push_back(maxThread);
+
+  std::vector< std::vector<int> > dims;
+  std::vector< std::vector<int> > permutations;
+  for (int rank=5;rank <= 8;rank++) {
+    for (int sample=0;sample < 4;sample++) {
+      std::vector<int> dim(rank);
+      std::vector<int> permutation(rank);
+      getRandomDim(16.0*MILLION, dim);
+      for (int r=0;r < rank;r++) permutation[r] = r;
+      do {
+        std::shuffle(permutation.begin(), permutation.end(), generator);
+      } while (isTrivial(permutation));
+      dims.push_back(dim);
+      permutations.push_back(permutation);
+    }
+  }
+
+  librettCheck(librettPlanCacheSetCapacity(0));
+  printf("bench9: librettPlan latency in ms\n");
+  printf("rank");
+  for (int n : numThreads) printf(" %8d", n);
+  printf("\n");
+  for (int i=0;i < dims.size();i++) {
+    int rank = dims[i].size();
+    printf("%4d", rank);
+    for (int n : numThreads) {
+      librettCheck(librettSetPlanThreads(n));
+      double best = 0.0;
+      for (int rep=0;rep < nrep;rep++) {
+        librettHandle plan;
+        Timer tm;
+        tm.start();
+        librettCheck(librettPlan(&plan, rank, dims[i].data(), permutations[i].data(), sizeof(double), gpuStream));
+        tm.stop();
+        if (rep == 0 || tm.seconds() < best) best = tm.seconds();
+        librettCheck(librettDestroy(plan));
+      }
+      printf(" %8.3lf", best*1000.0);
+    }
+    printf("\n");
+  }
+
+  // Check the plans of the last number of threads
+  bool ok = true;
+  for (int i=0;ok && i < dims.size();i++) {
+    ok = bench_tensor<long long int>(dims[i], permutations[i], gpuStream);
+  }
+  librettCheck(librettSetPlanThreads(0));
+  librettCheck(librettPlanCacheSetCapacity(256));
+
+  return ok;
+}
+
+//
+// Benchmark 10: librettExecute() calls per second against the number of host threads that
+// call it. Each thread has a plan and a stream of its own and transposes a small matrix,
+// so that the time goes to the call rather than to the transpose
+//
+bool bench10() {
+  const int ncall = 20000;
+  const int maxThread = std::max(16, (int)std::thread::hardware_concurrency());
+  std::vector<int> numThreads;
+  for (int n=1;n <= maxThread;n *= 2) numThreads.push_back(n);
+
+  int dim[2] = {32, 32};
+  int permutation[2] = {1, 0};
+  const int vol = dim[0]*dim[1];
+  if ((size_t)maxThread*vol > dataSize) {
+    printf("bench10, data size exceeded\n");
+    return false;
+  }
+
+  std::vector<gpuStream_t> streams(maxThread);
+  for (int t=0;t < maxThread;t++) {
+#if SYCL
+    streams[t] = new sycl::queue(sycl::gpu_selector_v, Librett::sycl_asynchandler, sycl::property_list{sycl::property::queue::in_order{}});
+#elif HIP
+    hipCheck(hipStreamCreate(&streams[t]));
+#elif LIBRETT_USES_CPU
+    streams[t] = nullptr;
+#else // CUDA
+    cudaCheck(cudaStreamCreate(&streams[t]));
+#endif
+  }
+
+  printf("bench10: librettExecute calls per second\n");
+  printf("threads   calls/s   us/call/thread\n");
+  for (int n : numThreads) {
+    std::vector<librettHandle> plans(n);
+    for (int t=0;t < n;t++) {
+      librettCheck(librettPlan(&plans[t], 2, dim, permutation, sizeof(long long int), streams[t]));
+    }
+
+    // Threads start calling together
+    std::atomic<int> numReady(0);
+    std::atomic<bool> go(false);
+    std::vector<std::thread> threads;
+    for (int t=0;t < n;t++) {
+      threads.emplace_back([&, t]() {
+        long long int* odata = (long long int *)dataOut + (size_t)t*vol;
+        numReady++;
+        while (!go) std::this_thread::yield();
+        for (int i=0;i < ncall;i++) librettCheck(librettExecute(plans[t], dataIn, odata));
+      });
+    }
+    while (numReady < n) std::this_thread::yield();
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    go = true;
+    for (int t=0;t < n;t++) threads[t].join();
+    for (int t=0;t < n;t++) {
+#if SYCL
+      streams[t]->wait_and_throw();
+#elif HIP
+      hipCheck(hipStreamSynchronize(streams[t]));
+#elif LIBRETT_USES_CPU
+#else // CUDA
+      cudaCheck(cudaStreamSynchronize(streams[t]));
+#endif
+    }
+    std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration_cast< std::chrono::duration<double> >(end - start).count();
+    printf("%7d %9.0lf %16.3lf\n", n, (double)n*ncall/seconds, seconds*1.0e6/ncall);
+
+    for (int t=0;t < n;t++) librettCheck(librettDestroy(plans[t]));
+  }
+
+  for (int t=0;t < maxThread;t++) {
+#if SYCL
+    delete streams[t];
+#elif HIP
+    hipCheck(hipStreamDestroy(streams[t]));
+#elif LIBRETT_USES_CPU
+#else // CUDA
+    cudaCheck(cudaStreamDestroy(streams[t]));
+#endif
+  }
+
+  return tester->checkTranspose<long long int>(2, dim, permutation, (long long int *)dataOut);
+}
 
 void printVec(std::vector<int>& vec) {
   for (int i=0;i < vec.size();i++) {
@@ -882,6 +1152,7 @@ template <typename T> bool bench_memcpy(int numElem, gpuStream_t& gpuStr)
       gpuStr->wait_and_throw();
 #elif HIP
       hipCheck(hipStreamSynchronize(gpuStr));
+#elif LIBRETT_USES_CPU
 #else // CUDA
       cudaCheck(cudaStreamSynchronize(gpuStr));
 #endif
@@ -905,6 +1176,7 @@ template <typename T> bool bench_memcpy(int numElem, gpuStream_t& gpuStr)
       gpuStr->wait_and_throw();
 #elif HIP
       hipCheck(hipStreamSynchronize(gpuStr));
+#elif LIBRETT_USES_CPU
 #else // CUDA
       cudaCheck(cudaStreamSynchronize(gpuStr));
 #endif
@@ -929,6 +1201,7 @@ template <typename T> bool bench_memcpy(int numElem, gpuStream_t& gpuStr)
       gpuStr->wait_and_throw();
 #elif HIP
       hipCheck(hipStreamSynchronize(gpuStr));
+#elif LIBRETT_USES_CPU
 #else // CUDA
       cudaCheck(cudaStreamSynchronize(gpuStr));
 #endif
@@ -0,0 +1,128 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2026 Librett developers
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*******************************************************************************/
+#include <cstdio>
+#include <cstring>         // strcmp
+#include "librett.h"
+#include "GpuUtils.h"
+#include "GpuMem.hpp"
+
+//
+// Calibrates the performance model for a device and writes its model profile, see
+// librettCalibrateModel(). With -fit the profile is fitted to the timings of an earlier
+// run, without a device
+//
+int main(int argc, char *argv[])
+{
+  int gpuid = -1;
+  int sizeMB = 64;
+  const char* samplePath = NULL;
+  const char* profilePath = "librett_model_profile.txt";
+  const char* fitPath = NULL;
+  bool arg_ok = true;
+  int i = 1;
+  while (i < argc) {
+    if (strcmp(argv[i], "-device") == 0 && i + 1 < argc) {
+      sscanf(argv[i+1], "%d", &gpuid);
+      i += 2;
+    } else if (strcmp(argv[i], "-size") == 0 && i + 1 < argc) {
+      sscanf(argv[i+1], "%d", &sizeMB);
+      i += 2;
+    } else if (strcmp(argv[i], "-samples") == 0 && i + 1 < argc) {
+      samplePath = argv[i+1];
+      i += 2;
+    } else if (strcmp(argv[i], "-profile") == 0 && i + 1 < argc) {
+      profilePath = argv[i+1];
+      i += 2;
+    } else if (strcmp(argv[i], "-fit") == 0 && i + 1 < argc) {
+      fitPath = argv[i+1];
+      i += 2;
+    } else {
+      arg_ok = false;
+      break;
+    }
+  }
+  if (sizeMB < 1) arg_ok = false;
+
+  if (!arg_ok) {
+    printf("librett_calibrate [options]\n");
+    printf("Options:\n");
+    printf("-device [int]    : GPU ID (default is 0)\n");
+    printf("-size [int]      : size of the input and output buffers in MB (default is 64)\n");
+    printf("-samples [file]  : write the timings to file\n");
+    printf("-profile [file]  : write the model profile to file (default is librett_model_profile.txt)\n");
+    printf("-fit [file]      : fit the model to the timings in file instead of timing the device\n");
+    return 1;
+  }
+
+  if (fitPath != NULL) {
+    librettCheck(librettFitModel(fitPath));
+    librettCheck(librettExportModelProfile(profilePath));
+    printf("Model profile written to %s\n", profilePath);
+    return 0;
+  }
+
+#if HIP
+  if (gpuid >= 0) hipCheck(hipSetDevice(gpuid));
+#elif LIBRETT_USES_CUDA
+  if (gpuid >= 0) cudaCheck(cudaSetDevice(gpuid));
+#endif
+
+  DeviceReset();
+  gpuStream_t gpuStream;
+#if SYCL
+  sycl::device dev(sycl::gpu_selector_v);
+  sycl::context ctxt(dev, Librett::sycl_asynchandler, sycl::property_list{sycl::property::queue::in_order{}});
+  gpuStream = new sycl::queue(ctxt, dev, Librett::sycl_asynchandler, sycl::property_list{sycl::property::queue::in_order{}});
+#elif HIP
+  hipCheck(hipStreamCreate(&gpuStream));
+#elif LIBRETT_USES_CPU
+  gpuStream = nullptr;
+#else // CUDA
+  cudaCheck(cudaStreamCreate(&gpuStream));
+#endif
+
+  const size_t size = (size_t)sizeMB << 20;
+  char* dataIn = NULL;
+  char* dataOut = NULL;
+  allocate_device<char>(&dataIn, size, gpuStream);
+  allocate_device<char>(&dataOut, size, gpuStream);
+
+  librettCheck(librettCalibrateModel(gpuStream, dataIn, dataOut, size, samplePath));
+  librettCheck(librettExportModelProfile(profilePath));
+  printf("Model profile written to %s\n", profilePath);
+  if (samplePath != NULL) printf("Timings written to %s\n", samplePath);
+
+  deallocate_device<char>(&dataIn, gpuStream);
+  deallocate_device<char>(&dataOut, gpuStream);
+
+  DeviceReset();
+#if SYCL
+  delete gpuStream;
+#elif HIP
+  hipCheck(hipStreamDestroy(gpuStream));
+#elif LIBRETT_USES_CUDA
+  cudaCheck(cudaStreamDestroy(gpuStream));
+#endif
+  return 0;
+}
@@ -29,13 +29,19 @@ All rights reserved.
 #include <algorithm>
 #include <ctime>           // std::time
 #include <cstring>         // strcmp
+#include <cstdlib>         // setenv
 #include <cmath>
+#include <thread>
+#include <atomic>
 #include "librett.h"
 #include "GpuUtils.h"
 #include "GpuMem.hpp"
+#include "DescriptorArena.h"
 #include "TensorTester.h"
 #include "Timer.h"
 #include "GpuModel.h"      // testCounters
+#include "ModelProfile.h"   // modelFit
+#include "DeviceProfile.h"  // occupancyActiveBlocks
 #include "GpuUtils.h"
 
 #ifdef SYCL
@@ -56,7 +62,7 @@ librettTimer* timerDouble;
 
 long long int* dataIn  = NULL;
 long long int* dataOut = NULL;
-#if PERFTEST
+#if PERFTEST || LIBRETT_USES_CPU
   int dataSize  = 20000000;
 #else
   int dataSize  = 200000000;
@@ -68,7 +74,42 @@ bool test2(gpuStream_t&);
 bool test3(gpuStream_t&);
 bool test4();
 bool test5();
+bool test6(gpuStream_t&);
+bool test7(gpuStream_t&);
+bool test8(gpuStream_t&);
+bool test9(gpuStream_t&);
+bool test10(gpuStream_t&);
+bool test11(gpuStream_t&);
+bool test12(gpuStream_t&);
+bool test13(gpuStream_t&);
+bool test14(gpuStream_t&);
+bool test15(gpuStream_t&);
+bool test16(gpuStream_t&);
+bool test17(gpuStream_t&);
+bool test18(gpuStream_t&);
+bool test19(gpuStream_t&);
+bool test20(gpuStream_t&);
+bool test21(gpuStream_t&);
+bool test22(gpuStream_t&);
+bool test23(gpuStream_t&);
+bool test24(gpuStream_t&);
+bool test25(gpuStream_t&);
+bool test26(gpuStream_t&);
+bool test27(gpuStream_t&);
 template <typename T> bool test_tensor(std::vector<int>& dim, std::vector<int>& permutation, gpuStream_t& stream);
+template <typename T> bool test_tensor_inplace(std::vector<int>& dim, std::vector<int>& permutation, gpuStream_t& stream);
+template <typename T> bool test_tensor_small(std::vector<int>& dim, std::vector<int>& permutation, gpuStream_t& stream);
+template <typename S> bool test_tensor_scaled(std::vector<int>& dim, std::vector<int>& permutation, const int numComp,
+  const double alpha, const double beta, gpuStream_t& stream);
+bool test_tensor_convert(std::vector<int>& dim, std::vector<int>& permutation, const librettDataType typeIn,
+  const librettDataType typeOut, gpuStream_t& stream);
+template <typename T> bool test_tensor_strided(std::vector<int>& dim, std::vector<int>& permutation, const int inPad,
+  const int outPad, gpuStream_t& stream);
+template <typename T> bool test_tensor_batched(std::vector<int>& dim, std::vector<int>& permutation, const int count,
+  const int mode, gpuStream_t& stream);
+template <typename T> bool test_tensor_grouped(std::vector< std::vector<int> >& dims,
+  std::vector< std::vector<int> >& permutations, gpuStream_t& stream);
+void hostPermutePos(std::vector<int>& dim, std::vector<int>& permutation, std::vector<int>& posIn);
 void printVec(std::vector<int>& vec);
 
 void gpuDeviceSynchronize(gpuStream_t& master_gpustream) {
@@ -76,6 +117,7 @@ void gpuDeviceSynchronize(gpuStream_t& master_gpustream) {
   master_gpustream->wait_and_throw();
   #elif HIP
   hipCheck(hipDeviceSynchronize());
+  #elif LIBRETT_USES_CPU
   #elif CUDA
   cudaCheck(cudaDeviceSynchronize());
   #endif
@@ -88,6 +130,8 @@ void CreateGpuStream(gpuStream_t& master_gpustream) {
   master_gpustream = new sycl::queue(ctxt, dev, sycl_asynchandler, sycl::property_list{sycl::property::queue::in_order{}});
   #elif HIP
   hipCheck(hipStreamCreate(&master_gpustream));
+  #elif LIBRETT_USES_CPU
+  master_gpustream = nullptr;
   #elif CUDA
   cudaCheck(cudaStreamCreate(&master_gpustream));
   #endif
@@ -98,6 +142,7 @@ void DestroyGpuStream(gpuStream_t& master_gpustream) {
   delete master_gpustream;
   #elif HIP
   hipCheck(hipStreamDestroy(master_gpustream));
+  #elif LIBRETT_USES_CPU
   #elif CUDA
   cudaCheck(cudaStreamDestroy(master_gpustream));
   #endif
@@ -131,6 +176,28 @@ int main(int argc, char *argv[])
 #ifndef HIP
   if(passed){passed = test5(); if(!passed) printf("Test 5 failed\n");}
 #endif
+  if(passed){passed = test6(gpumasterstream); if(!passed) printf("Test 6 failed\n");}
+  if(passed){passed = test7(gpumasterstream); if(!passed) printf("Test 7 failed\n");}
+  if(passed){passed = test8(gpumasterstream); if(!passed) printf("Test 8 failed\n");}
+  if(passed){passed = test9(gpumasterstream); if(!passed) printf("Test 9 failed\n");}
+  if(passed){passed = test10(gpumasterstream); if(!passed) printf("Test 10 failed\n");}
+  if(passed){passed = test11(gpumasterstream); if(!passed) printf("Test 11 failed\n");}
+  if(passed){passed = test12(gpumasterstream); if(!passed) printf("Test 12 failed\n");}
+  if(passed){passed = test13(gpumasterstream); if(!passed) printf("Test 13 failed\n");}
+  if(passed){passed = test14(gpumasterstream); if(!passed) printf("Test 14 failed\n");}
+  if(passed){passed = test15(gpumasterstream); if(!passed) printf("Test 15 failed\n");}
+  if(passed){passed = test16(gpumasterstream); if(!passed) printf("Test 16 failed\n");}
+  if(passed){passed = test17(gpumasterstream); if(!passed) printf("Test 17 failed\n");}
+  if(passed){passed = test18(gpumasterstream); if(!passed) printf("Test 18 failed\n");}
+  if(passed){passed = test19(gpumasterstream); if(!passed) printf("Test 19 failed\n");}
+  if(passed){passed = test20(gpumasterstream); if(!passed) printf("Test 20 failed\n");}
+  if(passed){passed = test21(gpumasterstream); if(!passed) printf("Test 21 failed\n");}
+  if(passed){passed = test22(gpumasterstream); if(!passed) printf("Test 22 failed\n");}
+  if(passed){passed = test23(gpumasterstream); if(!passed) printf("Test 23 failed\n");}
+  if(passed){passed = test24(gpumasterstream); if(!passed) printf("Test 24 failed\n");}
+  if(passed){passed = test25(gpumasterstream); if(!passed) printf("Test 25 failed\n");}
+  if(passed){passed = test26(gpumasterstream); if(!passed) printf("Test 26 failed\n");}
+  if(passed){passed = test27(gpumasterstream); if(!passed) printf("Test 27 failed\n");}
 #endif
 
   if(passed){
@@ -295,7 +362,7 @@ bool test3(gpuStream_t& master_gpustream) {
     int rank = 3;
     std::vector<int> dim(rank);
     std::vector<int> permutation(rank);
-#if PERFTEST
+#if PERFTEST || LIBRETT_USES_CPU
     dim[0] = 651;
     dim[1] = 299;
     dim[2] = 44;
@@ -316,7 +383,7 @@ bool test3(gpuStream_t& master_gpustream) {
     std::vector<int> dim(rank);
     std::vector<int> permutation(rank);
     dim[0] = 24;
-#if PERFTEST
+#if PERFTEST || LIBRETT_USES_CPU
     dim[1] = 170;
     dim[2] = 32;
     dim[3] = 97;
@@ -373,7 +440,7 @@ bool test3(gpuStream_t& master_gpustream) {
     std::vector<int> dim(5);
     std::vector<int> permutation(5);
     dim[0] = 5;
-#if PERFTEST
+#if PERFTEST || LIBRETT_USES_CPU
     dim[1] = 32;
     dim[2] = 45;
     dim[3] = 63;
@@ -418,7 +485,11 @@ bool test3(gpuStream_t& master_gpustream) {
 //
 bool test4()
 {
+#if LIBRETT_USES_CPU
+  std::vector<int> dim = {12, 16, 8, 36, 21, 9};
+#else
   std::vector<int> dim = {24, 32, 16, 36, 43, 9};
+#endif
   std::vector<int> permutation = {5, 1, 4, 2, 3, 0};
 
   const int numStream = 10;
@@ -434,6 +505,10 @@ bool test4()
   for (int i=0;i < numStream;i++) {
     hipCheck(hipStreamCreate(&streams[i]));
   }
+#elif LIBRETT_USES_CPU
+  for (int i=0;i < numStream;i++) {
+    streams[i] = nullptr;
+  }
 #else // CUDA
   for (int i=0;i < numStream;i++) {
     cudaCheck(cudaStreamCreate(&streams[i]));
@@ -453,6 +528,7 @@ bool test4()
   }
 #elif HIP
   hipCheck(hipDeviceSynchronize());
+#elif LIBRETT_USES_CPU
 #else // CUDA
   cudaCheck(cudaDeviceSynchronize());
 #endif
@@ -465,6 +541,7 @@ bool test4()
   }
 #elif HIP
   hipCheck(hipDeviceSynchronize());
+#elif LIBRETT_USES_CPU
 #else // CUDA
   cudaCheck(cudaDeviceSynchronize());
 #endif
@@ -476,6 +553,7 @@ bool test4()
     delete streams[i];
 #elif HIP
     hipCheck(hipStreamDestroy(streams[i]));
+#elif LIBRETT_USES_CPU
 #else // CUDA
     cudaCheck(cudaStreamDestroy(streams[i]));
 #endif
@@ -510,6 +588,920 @@ bool test5() {
   return true;
 }
 
+//
+// Test 6: in-place execution
+//
+bool test6(gpuStream_t& master_gpustream) {
+  std::vector< std::vector<int> > dims = {
+    {43, 67}, {1000, 999}, {65536, 2}, {2, 65536},
+    {31, 40, 64}, {31, 40, 64}, {31, 40, 64},
+    {12, 16, 8, 36}, {12, 16, 8, 36},
+    {5, 7, 6, 9, 4, 11}};
+  std::vector< std::vector<int> > permutations = {
+    {1, 0}, {1, 0}, {1, 0}, {1, 0},
+    {2, 0, 1}, {1, 2, 0}, {0, 2, 1},
+    {3, 1, 0, 2}, {0, 3, 2, 1},
+    {4, 2, 5, 0, 3, 1}};
+
+  for (int i=0;i < dims.size();i++) {
+    if (!test_tensor_inplace<long long int>(dims[i], permutations[i], master_gpustream)) return false;
+    if (!test_tensor_inplace<int>(dims[i], permutations[i], master_gpustream)) return false;
+  }
+
+  return true;
+}
+
+//
+// Test 7: 64-bit index kernels, forced on with LIBRETT_FORCE_INDEX64
+//
+bool test7(gpuStream_t& master_gpustream) {
+  std::vector< std::vector<int> > dims = {
+    {1000, 999}, {31, 40, 64}, {31, 40, 64}, {64, 3, 70, 5},
+    {12, 16, 8, 36}, {5, 7, 6, 9, 4, 11}, {2, 3, 400000}};
+  std::vector< std::vector<int> > permutations = {
+    {1, 0}, {2, 0, 1}, {0, 2, 1}, {0, 3, 2, 1},
+    {3, 1, 0, 2}, {4, 2, 5, 0, 3, 1}, {2, 1, 0}};
+
+  setenv("LIBRETT_FORCE_INDEX64", "1", 1);
+  bool ok = true;
+  for (int i=0;i < dims.size() && ok;i++) {
+    ok = test_tensor<long long int>(dims[i], permutations[i], master_gpustream) &&
+      test_tensor<int>(dims[i], permutations[i], master_gpustream);
+  }
+  unsetenv("LIBRETT_FORCE_INDEX64");
+
+  return ok;
+}
+
+//
+// Test 8: 1 and 2 byte elements
+//
+bool test8(gpuStream_t& master_gpustream) {
+  std::vector< std::vector<int> > dims = {
+    {43, 67}, {1000, 999}, {31, 40, 64}, {31, 40, 64}, {64, 3, 70, 5},
+    {12, 16, 8, 36}, {5, 7, 6, 9, 4, 11}, {2, 3, 400000}};
+  std::vector< std::vector<int> > permutations = {
+    {1, 0}, {1, 0}, {2, 0, 1}, {0, 2, 1}, {0, 3, 2, 1},
+    {3, 1, 0, 2}, {4, 2, 5, 0, 3, 1}, {2, 1, 0}};
+
+  for (int i=0;i < dims.size();i++) {
+    if (!test_tensor_small<uint8_t>(dims[i], permutations[i], master_gpustream)) return false;
+    if (!test_tensor_small<uint16_t>(dims[i], permutations[i], master_gpustream)) return false;
+  }
+
+  return true;
+}
+
+//
+// Test 9: scaling and accumulation, odata = alpha*permute(idata) + beta*odata
+//
+bool test9(gpuStream_t& master_gpustream) {
+  std::vector< std::vector<int> > dims = {
+    {40, 50}, {43, 67}, {31, 40, 64}, {12, 16, 8, 36}, {2, 3, 400000}};
+  std::vector< std::vector<int> > permutations = {
+    {0, 1}, {1, 0}, {0, 2, 1}, {3, 1, 0, 2}, {2, 1, 0}};
+  std::vector< std::vector<double> > alphaBeta = {{2.0, 0.0}, {2.0, 0.5}, {1.0, 1.0}};
+
+  for (int i=0;i < dims.size();i++) {
+    for (int j=0;j < alphaBeta.size();j++) {
+      const double alpha = alphaBeta[j][0];
+      const double beta = alphaBeta[j][1];
+      if (!test_tensor_scaled<float>(dims[i], permutations[i], 1, alpha, beta, master_gpustream)) return false;
+      if (!test_tensor_scaled<double>(dims[i], permutations[i], 1, alpha, beta, master_gpustream)) return false;
+      if (!test_tensor_scaled<double>(dims[i], permutations[i], 2, alpha, beta, master_gpustream)) return false;
+    }
+  }
+
+  return true;
+}
+
+//
+// Test 10: precision conversion, odata = convert(permute(idata))
+//
+bool test10(gpuStream_t& master_gpustream) {
+  std::vector< std::vector<int> > dims = {
+    {40, 50}, {43, 67}, {31, 40, 64}, {31, 40, 64}, {12, 16, 8, 36}, {2, 3, 400000}};
+  std::vector< std::vector<int> > permutations = {
+    {0, 1}, {1, 0}, {2, 0, 1}, {0, 2, 1}, {3, 1, 0, 2}, {2, 1, 0}};
+  std::vector< std::vector<librettDataType> > types = {
+    {LIBRETT_FLOAT64, LIBRETT_FLOAT32}, {LIBRETT_FLOAT32, LIBRETT_FLOAT64},
+    {LIBRETT_FLOAT32, LIBRETT_FLOAT16}, {LIBRETT_FLOAT16, LIBRETT_FLOAT32},
+    {LIBRETT_FLOAT32, LIBRETT_BFLOAT16}, {LIBRETT_BFLOAT16, LIBRETT_FLOAT32}};
+
+  for (int i=0;i < dims.size();i++) {
+    for (int j=0;j < types.size();j++) {
+      if (!test_tensor_convert(dims[i], permutations[i], types[j][0], types[j][1], master_gpustream)) return false;
+    }
+  }
+
+  return true;
+}
+
+//
+// Test 11: strided input and output, every rank is padded by inPad and outPad elements
+//
+bool test11(gpuStream_t& master_gpustream) {
+  std::vector< std::vector<int> > dims = {
+    {100, 200}, {40, 50}, {43, 67}, {31, 40, 64}, {31, 40, 64}, {12, 16, 8, 36},
+    {5, 7, 6, 9, 4, 11}, {2, 3, 400000}};
+  std::vector< std::vector<int> > permutations = {
+    {0, 1}, {1, 0}, {0, 1}, {2, 0, 1}, {0, 2, 1}, {3, 1, 0, 2},
+    {4, 2, 5, 0, 3, 1}, {2, 1, 0}};
+  std::vector< std::vector<int> > pads = {{0, 0}, {3, 0}, {0, 5}, {1, 2}};
+
+  for (int i=0;i < dims.size();i++) {
+    for (int j=0;j < pads.size();j++) {
+      if (!test_tensor_strided<int>(dims[i], permutations[i], pads[j][0], pads[j][1], master_gpustream))
+        return false;
+      if (!test_tensor_strided<double>(dims[i], permutations[i], pads[j][0], pads[j][1], master_gpustream))
+        return false;
+    }
+  }
+
+  return true;
+}
+
+//
+// Test 12: batched execution, strided batch and evenly and unevenly spaced pointer arrays
+//
+bool test12(gpuStream_t& master_gpustream) {
+  std::vector< std::vector<int> > dims = {
+    {100, 200}, {16, 16}, {43, 67}, {31, 40, 64}, {31, 40, 64}, {12, 16, 8, 36},
+    {5, 7, 6, 9, 4, 11}, {2, 3, 4000}};
+  std::vector< std::vector<int> > permutations = {
+    {0, 1}, {1, 0}, {1, 0}, {2, 0, 1}, {0, 2, 1}, {3, 1, 0, 2},
+    {4, 2, 5, 0, 3, 1}, {2, 1, 0}};
+
+  for (int i=0;i < dims.size();i++) {
+    for (int mode=0;mode < 3;mode++) {
+      if (!test_tensor_batched<int>(dims[i], permutations[i], 7, mode, master_gpustream)) return false;
+      if (!test_tensor_batched<double>(dims[i], permutations[i], 3, mode, master_gpustream)) return false;
+    }
+  }
+
+  return true;
+}
+
+//
+// Test 13: grouped execution of tensors with different shapes and permutations
+//
+bool test13(gpuStream_t& master_gpustream) {
+  std::vector< std::vector<int> > dims = {
+    {100, 200}, {16, 16}, {1000}, {43, 67}, {31, 40, 64}, {31, 40, 64}, {12, 16, 8, 36},
+    {5, 7, 6, 9, 4, 11}, {2, 3, 4000}, {3, 5}};
+  std::vector< std::vector<int> > permutations = {
+    {1, 0}, {1, 0}, {0}, {0, 1}, {2, 0, 1}, {0, 2, 1}, {3, 1, 0, 2},
+    {4, 2, 5, 0, 3, 1}, {2, 1, 0}, {1, 0}};
+
+  if (!test_tensor_grouped<int>(dims, permutations, master_gpustream)) return false;
+  if (!test_tensor_grouped<double>(dims, permutations, master_gpustream)) return false;
+  if (!test_tensor_grouped<char>(dims, permutations, master_gpustream)) return false;
+
+  return true;
+}
+
+//
+// Test 14: plan cache, repeated plans and plans that reduce to the same ranks share a plan
+//
+bool test14(gpuStream_t& master_gpustream) {
+  std::vector<int> dim = {200, 30};
+  std::vector<int> permutation = {1, 0};
+  // Reduces to dim and permutation
+  std::vector<int> dimEq = {10, 20, 30};
+  std::vector<int> permutationEq = {2, 0, 1};
+
+  librettCheck(librettPlanCacheClear());
+  librettHandle plan0, plan1, plan2;
+  librettCheck(librettPlan(&plan0, 2, dim.data(), permutation.data(), sizeof(int), master_gpustream));
+  librettCheck(librettPlan(&plan1, 2, dim.data(), permutation.data(), sizeof(int), master_gpustream));
+  librettCheck(librettPlan(&plan2, 3, dimEq.data(), permutationEq.data(), sizeof(int), master_gpustream));
+  long long int hits, misses;
+  int size;
+  librettCheck(librettPlanCacheGetStats(&hits, &misses, &size));
+  if (hits != 2 || misses != 1 || size != 1) {
+    printf("test14 FAIL hits %lld misses %lld size %d\n", hits, misses, size);
+    return false;
+  }
+
+  // Shared descriptors outlive the plan that created them and the cache entry
+  librettCheck(librettDestroy(plan0));
+  librettCheck(librettPlanCacheClear());
+  librettCheck(librettExecute(plan2, dataIn, dataOut));
+  if (!tester->checkTranspose<int>(3, dimEq.data(), permutationEq.data(), (int *)dataOut)) return false;
+  librettCheck(librettDestroy(plan1));
+  librettCheck(librettDestroy(plan2));
+
+  // Disabled cache
+  librettCheck(librettPlanCacheSetCapacity(0));
+  if (!test_tensor<int>(dim, permutation, master_gpustream)) return false;
+  librettCheck(librettPlanCacheGetStats(&hits, &misses, &size));
+  librettCheck(librettPlanCacheSetCapacity(256));
+  if (hits != 0 || misses != 0 || size != 0) {
+    printf("test14 FAIL disabled cache hits %lld misses %lld size %d\n", hits, misses, size);
+    return false;
+  }
+
+  return true;
+}
+
+// Number of lines in the wisdom file
+static int countWisdom() {
+  const char* path = "librett_test_wisdom.txt";
+  if (librettExportWisdom(path) != LIBRETT_SUCCESS) return -1;
+  FILE* file = fopen(path, "r");
+  if (file == NULL) return -1;
+  char line[1024];
+  int numLine = 0;
+  while (fgets(line, sizeof(line), file) != NULL) numLine++;
+  fclose(file);
+  remove(path);
+  return numLine;
+}
+
+//
+// Test 15: wisdom, measured plans are reused by librettPlan() and survive export and import
+//
+bool test15(gpuStream_t& master_gpustream) {
+  std::vector<int> dim = {31, 45, 27};
+  std::vector<int> permutation = {2, 0, 1};
+  const char* path = "librett_test_wisdom.txt";
+  int vol = dim[0]*dim[1]*dim[2];
+
+  // A measured plan replaces the cached model plan of the same tensor
+  librettCheck(librettPlanCacheClear());
+  librettHandle plan;
+  librettCheck(librettPlan(&plan, 3, dim.data(), permutation.data(), sizeof(double), master_gpustream));
+  librettCheck(librettDestroy(plan));
+  librettCheck(librettPlanMeasure(&plan, 3, dim.data(), permutation.data(), sizeof(double), master_gpustream,
+    dataIn, dataOut));
+  librettCheck(librettDestroy(plan));
+  librettCheck(librettPlan(&plan, 3, dim.data(), permutation.data(), sizeof(double), master_gpustream));
+  long long int hits, misses;
+  librettCheck(librettPlanCacheGetStats(&hits, &misses, nullptr));
+  if (hits != 0 || misses != 2) {
+    printf("test15 FAIL hits %lld misses %lld\n", hits, misses);
+    return false;
+  }
+  set_device_array<double>((double *)dataOut, -1, vol, master_gpustream);
+  librettCheck(librettExecute(plan, dataIn, dataOut));
+  gpuDeviceSynchronize(master_gpustream);
+  if (!tester->checkTranspose<long long int>(3, dim.data(), permutation.data(), (long long int *)dataOut)) return false;
+  librettCheck(librettDestroy(plan));
+
+  // Export and import
+  librettCheck(librettExportWisdom(path));
+  FILE* file = fopen(path, "r");
+  if (file == NULL) return false;
+  char line[1024];
+  int numLine = 0;
+  while (fgets(line, sizeof(line), file) != NULL) numLine++;
+  fclose(file);
+  if (numLine < 2) {
+    printf("test15 FAIL wisdom file has %d lines\n", numLine);
+    return false;
+  }
+  librettCheck(librettImportWisdom(path));
+  remove(path);
+  if (librettImportWisdom(path) != LIBRETT_INVALID_PARAMETER) return false;
+
+  librettCheck(librettPlan(&plan, 3, dim.data(), permutation.data(), sizeof(double), master_gpustream));
+  set_device_array<double>((double *)dataOut, -1, vol, master_gpustream);
+  librettCheck(librettExecute(plan, dataIn, dataOut));
+  gpuDeviceSynchronize(master_gpustream);
+  if (!tester->checkTranspose<long long int>(3, dim.data(), permutation.data(), (long long int *)dataOut)) return false;
+  librettCheck(librettDestroy(plan));
+
+  // Tensors with the same reduced ranks, and so the same cached plan, share the entry
+  std::vector<int> dimUnit = {31, 45, 1, 27};
+  std::vector<int> permutationUnit = {3, 0, 1, 2};
+  const int numWisdom = countWisdom();
+  librettCheck(librettPlanMeasure(&plan, 4, dimUnit.data(), permutationUnit.data(), sizeof(double),
+    master_gpustream, dataIn, dataOut));
+  librettCheck(librettDestroy(plan));
+  if (countWisdom() != numWisdom) {
+    printf("test15 FAIL wisdom has %d lines, %d before\n", countWisdom(), numWisdom);
+    return false;
+  }
+
+  return true;
+}
+
+//
+// Test 16: candidates modeled serially and on several threads
+//
+bool test16(gpuStream_t& master_gpustream) {
+  std::vector< std::vector<int> > dims = {{5, 7, 6, 9, 4, 11}, {12, 16, 8, 36}, {31, 40, 64}};
+  std::vector< std::vector<int> > permutations = {{4, 2, 5, 0, 3, 1}, {3, 1, 0, 2}, {2, 0, 1}};
+
+  librettCheck(librettPlanCacheSetCapacity(0));
+  bool ok = true;
+  for (int numThread : {1, 3, 0}) {
+    librettCheck(librettSetPlanThreads(numThread));
+    for (int i=0;ok && i < dims.size();i++) {
+      ok = test_tensor<long long int>(dims[i], permutations[i], master_gpustream);
+    }
+  }
+  librettCheck(librettPlanCacheSetCapacity(256));
+  if (librettSetPlanThreads(-1) != LIBRETT_INVALID_PARAMETER) return false;
+
+  return ok;
+}
+
+//
+// Test 17: asynchronous plans, execution waits for pending plans
+//
+bool test17(gpuStream_t& master_gpustream) {
+  std::vector< std::vector<int> > dims = {{5, 7, 6, 9, 4, 11}, {12, 16, 8, 36}, {31, 40, 64}, {200, 30}};
+  std::vector< std::vector<int> > permutations = {{4, 2, 5, 0, 3, 1}, {3, 1, 0, 2}, {2, 0, 1}, {1, 0}};
+
+  librettCheck(librettPlanCacheSetCapacity(0));
+  std::vector<librettHandle> plans(dims.size());
+  for (int i=0;i < dims.size();i++) {
+    librettCheck(librettPlanAsync(&plans[i], dims[i].size(), dims[i].data(), permutations[i].data(),
+      sizeof(long long int), master_gpustream));
+  }
+
+  for (int i=0;i < dims.size();i++) {
+    int vol = 1;
+    for (int d : dims[i]) vol *= d;
+    set_device_array<long long int>((long long int *)dataOut, -1, vol, master_gpustream);
+    if (i == 1) librettCheck(librettPlanWait(plans[i]));
+    if (i == 2) {
+      librettResult res;
+      while ((res = librettPlanQuery(plans[i])) == LIBRETT_PLAN_PENDING);
+      librettCheck(res);
+    }
+    librettCheck(librettExecute(plans[i], dataIn, dataOut));
+    gpuDeviceSynchronize(master_gpustream);
+    if (!tester->checkTranspose<long long int>(dims[i].size(), dims[i].data(), permutations[i].data(),
+      (long long int *)dataOut)) return false;
+  }
+  for (int i=0;i < dims.size();i++) {
+    librettCheck(librettPlanQuery(plans[i]));
+    librettCheck(librettDestroy(plans[i]));
+  }
+  librettCheck(librettPlanCacheSetCapacity(256));
+
+  // Invalid input is reported right away, destroyed plans are no longer valid
+  std::vector<int> badPermutation = {0, 0};
+  librettHandle plan;
+  if (librettPlanAsync(&plan, 2, dims[3].data(), badPermutation.data(), sizeof(int), master_gpustream) !=
+    LIBRETT_INVALID_PARAMETER) return false;
+  if (librettPlanWait(plans[0]) != LIBRETT_INVALID_PLAN) return false;
+
+  return true;
+}
+
+//
+// Test 18: bulk planning, duplicate tensors and shared descriptors
+//
+bool test18(gpuStream_t& master_gpustream) {
+  // The second and the last tensor reduce to the first one
+  std::vector< std::vector<int> > dims = {{200, 30}, {10, 20, 30}, {5, 7, 6, 9, 4, 11}, {12, 16, 8, 36},
+    {31, 40, 64}, {1000}, {12, 16, 8, 36}, {200, 30}};
+  std::vector< std::vector<int> > permutations = {{1, 0}, {2, 0, 1}, {4, 2, 5, 0, 3, 1}, {3, 1, 0, 2},
+    {2, 0, 1}, {0}, {3, 1, 0, 2}, {1, 0}};
+  const int count = dims.size();
+  std::vector<librettHandle> plans(count);
+  std::vector<int> rank(count);
+  std::vector<int*> dim(count);
+  std::vector<int*> permutation(count);
+  std::vector<size_t> sizeofType(count, sizeof(long long int));
+  for (int i=0;i < count;i++) {
+    rank[i] = dims[i].size();
+    dim[i] = dims[i].data();
+    permutation[i] = permutations[i].data();
+  }
+  librettCheck(librettPlanMany(count, plans.data(), rank.data(), dim.data(), permutation.data(),
+    sizeofType.data(), master_gpustream));
+
+  // Destroy some plans first, the others keep the shared descriptors
+  librettCheck(librettDestroy(plans[0]));
+  librettCheck(librettDestroy(plans[3]));
+  for (int i=0;i < count;i++) {
+    if (i == 0 || i == 3) continue;
+    int vol = 1;
+    for (int d : dims[i]) vol *= d;
+    set_device_array<long long int>((long long int *)dataOut, -1, vol, master_gpustream);
+    librettCheck(librettExecute(plans[i], dataIn, dataOut));
+    gpuDeviceSynchronize(master_gpustream);
+    if (!tester->checkTranspose<long long int>(rank[i], dim[i], permutation[i], (long long int *)dataOut)) return false;
+    librettCheck(librettDestroy(plans[i]));
+  }
+
+  int badPermutation[2] = {1, 1};
+  permutation[0] = badPermutation;
+  if (librettPlanMany(count, plans.data(), rank.data(), dim.data(), permutation.data(),
+    sizeofType.data(), master_gpustream) != LIBRETT_INVALID_PARAMETER) return false;
+
+  return true;
+}
+
+//
+// Test 19: descriptors passed to the kernels by value and in device memory. Reversed ranks
+// of size 2 do not merge; the last tensor is PackedSplit with 17 Mmk ranks, so its Mmk and
+// Msh descriptors are too long for the kernel arguments
+//
+bool test19(gpuStream_t& master_gpustream) {
+  for (int rank : {6, 16}) {
+    std::vector<int> dim(rank, 2);
+    std::vector<int> permutation(rank);
+    for (int r=0;r < rank;r++) permutation[r] = rank - 1 - r;
+    if (!test_tensor<long long int>(dim, permutation, master_gpustream)) return false;
+    if (!test_tensor_batched<int>(dim, permutation, 3, 0, master_gpustream)) return false;
+  }
+
+  const int rank = 17;
+  std::vector<int> dim(rank, 2);
+  dim[rank - 1] = 300;
+  std::vector<int> permutation(rank);
+  for (int r=0;r < rank;r++) permutation[r] = (r*7) % rank;
+  if (!test_tensor<int>(dim, permutation, master_gpustream)) return false;
+
+  return true;
+}
+
+//
+// Test 20: descriptor arena, freed blocks are reused without new device memory and plans
+// return their descriptors on destroy
+//
+bool test20(gpuStream_t& master_gpustream) {
+  // Cached plans of the earlier tests hold descriptors
+  librettCheck(librettPlanCacheClear());
+  size_t reserved0, inUse0;
+  librettCheck(librettDescriptorArenaGetStats(&reserved0, &inUse0, NULL));
+
+  DescriptorArena& arena = DescriptorArena::instance(0);
+  const int numBlock = 200;
+  std::vector<void*> blocks(numBlock);
+  size_t size = 0;
+  for (int i=0;i < numBlock;i++) {
+    blocks[i] = arena.allocate(1 + i*97, master_gpustream);
+    size += 1 + i*97;
+  }
+  size_t reserved1, inUse1, peak1;
+  librettCheck(librettDescriptorArenaGetStats(&reserved1, &inUse1, &peak1));
+  if (inUse1 - inUse0 < size || reserved1 < inUse1 || peak1 < inUse1) return false;
+
+  for (int i=0;i < numBlock;i++) arena.deallocate(blocks[i], master_gpustream);
+  for (int i=numBlock - 1;i >= 0;i--) blocks[i] = arena.allocate(1 + i*97, master_gpustream);
+  size_t reserved2, inUse2;
+  librettCheck(librettDescriptorArenaGetStats(&reserved2, &inUse2, NULL));
+  if (reserved2 != reserved1 || inUse2 != inUse1) return false;
+  for (int i=0;i < numBlock;i++) arena.deallocate(blocks[i], master_gpustream);
+
+  // Blocks larger than the size classes are allocated and freed directly
+  void* large = arena.allocate(4*DescriptorArena::CHUNK_SIZE, master_gpustream);
+  librettCheck(librettDescriptorArenaGetStats(&reserved2, NULL, NULL));
+  if (reserved2 != reserved1 + 4*DescriptorArena::CHUNK_SIZE) return false;
+  arena.deallocate(large, master_gpustream);
+  librettCheck(librettDescriptorArenaGetStats(&reserved2, &inUse2, NULL));
+  if (reserved2 != reserved1 || inUse2 != inUse0) return false;
+
+  // Long descriptors of test 19
+  const int rank = 17;
+  std::vector<int> dim(rank, 2);
+  dim[rank - 1] = 300;
+  std::vector<int> permutation(rank);
+  for (int r=0;r < rank;r++) permutation[r] = (r*7) % rank;
+  librettHandle plan;
+  librettCheck(librettPlan(&plan, rank, dim.data(), permutation.data(), sizeof(int), master_gpustream));
+  librettCheck(librettDestroy(plan));
+  librettCheck(librettPlanCacheClear());
+  librettCheck(librettDescriptorArenaGetStats(NULL, &inUse2, NULL));
+  if (inUse2 != inUse0) return false;
+
+  return true;
+}
+
+//
+// Test 21: handles of destroyed plans stay invalid when their slot is reused, and a plan is
+// executed from several threads while another thread creates and destroys plans
+//
+bool test21(gpuStream_t& master_gpustream) {
+  std::vector<int> dim = {200, 30};
+  std::vector<int> permutation = {1, 0};
+  const int vol = dim[0]*dim[1];
+  librettHandle oldPlan, plan;
+  librettCheck(librettPlan(&oldPlan, 2, dim.data(), permutation.data(), sizeof(long long int), master_gpustream));
+  librettCheck(librettDestroy(oldPlan));
+  librettCheck(librettPlan(&plan, 2, dim.data(), permutation.data(), sizeof(long long int), master_gpustream));
+  if (plan == oldPlan) return false;
+  if (librettExecute(oldPlan, dataIn, dataOut) != LIBRETT_INVALID_PLAN) return false;
+  if (librettPlanQuery(oldPlan) != LIBRETT_INVALID_PLAN) return false;
+  if (librettDestroy(oldPlan) != LIBRETT_INVALID_PLAN) return false;
+
+  const int numThread = 4;
+  const int ncall = 50;
+  std::atomic<bool> ok(true);
+  std::vector<std::thread> threads;
+  for (int t=0;t < numThread;t++) {
+    threads.emplace_back([&, t]() {
+      for (int i=0;i < ncall;i++) {
+        if (librettExecute(plan, dataIn, dataOut + (size_t)t*vol) != LIBRETT_SUCCESS) ok = false;
+      }
+    });
+  }
+  threads.emplace_back([&]() {
+    std::vector<int> dimOther = {20, 30};
+    for (int i=0;i < ncall;i++) {
+      librettHandle other;
+      if (librettPlan(&other, 2, dimOther.data(), permutation.data(), sizeof(int), master_gpustream) != LIBRETT_SUCCESS ||
+        librettDestroy(other) != LIBRETT_SUCCESS) ok = false;
+    }
+  });
+  for (std::thread& thread : threads) thread.join();
+  gpuDeviceSynchronize(master_gpustream);
+  if (!ok) return false;
+  for (int t=0;t < numThread;t++) {
+    if (!tester->checkTranspose<long long int>(2, dim.data(), permutation.data(), dataOut + (size_t)t*vol)) return false;
+  }
+  librettCheck(librettDestroy(plan));
+
+  return true;
+}
+
+//
+// Test 22: one plan executed concurrently on several streams, and a plan with descriptors
+// in device memory destroyed right after a launch on another stream
+//
+bool test22(gpuStream_t& master_gpustream) {
+  const int numStream = 3;
+  std::vector<gpuStream_t> streams(numStream);
+  for (int t=0;t < numStream;t++) {
+#if SYCL
+    streams[t] = new sycl::queue(master_gpustream->get_context(), master_gpustream->get_device(),
+      sycl::property_list{sycl::property::queue::in_order{}});
+#else
+    CreateGpuStream(streams[t]);
+#endif
+  }
+
+  std::vector<int> dim = {31, 40, 64};
+  std::vector<int> permutation = {2, 0, 1};
+  const int vol = dim[0]*dim[1]*dim[2];
+  librettHandle plan;
+  librettCheck(librettPlan(&plan, 3, dim.data(), permutation.data(), sizeof(long long int), master_gpustream));
+  set_device_array<long long int>(dataOut, -1, numStream*vol, master_gpustream);
+  gpuDeviceSynchronize(master_gpustream);
+  std::atomic<bool> ok(true);
+  std::vector<std::thread> threads;
+  for (int t=0;t < numStream;t++) {
+    threads.emplace_back([&, t]() {
+      if (librettExecuteOnStream(plan, streams[t], dataIn, dataOut + (size_t)t*vol) != LIBRETT_SUCCESS) ok = false;
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+  for (int t=0;t < numStream;t++) gpuDeviceSynchronize(streams[t]);
+  if (!ok) return false;
+  for (int t=0;t < numStream;t++) {
+    if (!tester->checkTranspose<long long int>(3, dim.data(), permutation.data(), dataOut + (size_t)t*vol)) return false;
+  }
+  if (librettExecuteOnStream(plan, streams[0], dataIn, dataIn) != LIBRETT_INVALID_PARAMETER) return false;
+  librettCheck(librettDestroy(plan));
+  if (librettExecuteOnStream(plan, streams[0], dataIn, dataOut) != LIBRETT_INVALID_PLAN) return false;
+
+  // PackedSplit plan of test 19
+  const int rank = 17;
+  std::vector<int> dimLong(rank, 2);
+  dimLong[rank - 1] = 300;
+  std::vector<int> permutationLong(rank);
+  for (int r=0;r < rank;r++) permutationLong[r] = (r*7) % rank;
+  librettCheck(librettPlanCacheSetCapacity(0));
+  librettCheck(librettPlan(&plan, rank, dimLong.data(), permutationLong.data(), sizeof(int), master_gpustream));
+  librettCheck(librettPlanCacheSetCapacity(256));
+  librettCheck(librettExecuteOnStream(plan, streams[1], dataIn, dataOut));
+  librettCheck(librettDestroy(plan));
+  gpuDeviceSynchronize(streams[1]);
+  if (!tester->checkTranspose<int>(rank, dimLong.data(), permutationLong.data(), (int *)dataOut)) return false;
+
+  for (int t=0;t < numStream;t++) DestroyGpuStream(streams[t]);
+  return true;
+}
+
+//
+// Test 23: top-K measured planning
+//
+bool test23(gpuStream_t& master_gpustream) {
+  std::vector< std::vector<int> > dims = {{29, 43, 37}, {8, 13, 7, 33}, {120, 95}};
+  std::vector< std::vector<int> > permutations = {{1, 2, 0}, {3, 1, 0, 2}, {1, 0}};
+  std::vector<int> topKs = {3, 1, 4};
+  for (size_t i=0;i < dims.size();i++) {
+    const int rank = (int)dims[i].size();
+    int vol = 1;
+    for (int r=0;r < rank;r++) vol *= dims[i][r];
+    librettHandle plan;
+    librettCheck(librettPlanMeasureTopK(&plan, rank, dims[i].data(), permutations[i].data(), sizeof(long long int),
+      master_gpustream, dataIn, dataOut, topKs[i], 3));
+    set_device_array<long long int>(dataOut, -1, vol, master_gpustream);
+    librettCheck(librettExecute(plan, dataIn, dataOut));
+    gpuDeviceSynchronize(master_gpustream);
+    librettCheck(librettDestroy(plan));
+    if (!tester->checkTranspose<long long int>(rank, dims[i].data(), permutations[i].data(), dataOut)) return false;
+  }
+
+  librettHandle plan;
+  if (librettPlanMeasureTopK(&plan, 3, dims[0].data(), permutations[0].data(), sizeof(long long int),
+    master_gpustream, dataIn, dataOut, 0, 3) != LIBRETT_INVALID_PARAMETER) return false;
+  if (librettPlanMeasureTopK(&plan, 3, dims[0].data(), permutations[0].data(), sizeof(long long int),
+    master_gpustream, dataIn, dataOut, 3, 0) != LIBRETT_INVALID_PARAMETER) return false;
+  if (librettPlanMeasureTopK(&plan, 3, dims[0].data(), permutations[0].data(), sizeof(long long int),
+    master_gpustream, dataIn, dataIn, 3, 3) != LIBRETT_INVALID_PARAMETER) return false;
+
+  return true;
+}
+
+//
+// Test 24: adaptive plans explore their candidates, commit to one and record it in wisdom
+//
+bool test24(gpuStream_t& master_gpustream) {
+  std::vector<int> dim = {37, 29, 41};
+  std::vector<int> permutation = {2, 0, 1};
+  const int vol = dim[0]*dim[1]*dim[2];
+  const int numExplore = 6;
+
+  const int numWisdom = countWisdom();
+  librettHandle plan;
+  librettCheck(librettPlanAdaptive(&plan, 3, dim.data(), permutation.data(), sizeof(long long int),
+    master_gpustream, 3, numExplore));
+  // Exploring, choosing and chosen executions, with batched executions in between
+  for (int i=0;i < numExplore + 3;i++) {
+    set_device_array<long long int>(dataOut, -1, vol, master_gpustream);
+    if (i % 2 == 0) {
+      librettCheck(librettExecute(plan, dataIn, dataOut));
+    } else {
+      librettCheck(librettExecuteOnStream(plan, master_gpustream, dataIn, dataOut));
+    }
+    gpuDeviceSynchronize(master_gpustream);
+    if (!tester->checkTranspose<long long int>(3, dim.data(), permutation.data(), dataOut)) return false;
+    if (i == 2) {
+      set_device_array<long long int>(dataOut, -1, vol, master_gpustream);
+      librettCheck(librettExecuteBatchedStrided(plan, 1, dataIn, 0, dataOut, 0));
+      gpuDeviceSynchronize(master_gpustream);
+      if (!tester->checkTranspose<long long int>(3, dim.data(), permutation.data(), dataOut)) return false;
+    }
+  }
+  librettCheck(librettDestroy(plan));
+  if (countWisdom() != numWisdom + 1) {
+    printf("test24 FAIL wisdom has %d lines, %d before\n", countWisdom(), numWisdom);
+    return false;
+  }
+
+  // The choice comes from wisdom
+  librettCheck(librettPlan(&plan, 3, dim.data(), permutation.data(), sizeof(long long int), master_gpustream));
+  set_device_array<long long int>(dataOut, -1, vol, master_gpustream);
+  librettCheck(librettExecute(plan, dataIn, dataOut));
+  gpuDeviceSynchronize(master_gpustream);
+  librettCheck(librettDestroy(plan));
+  if (!tester->checkTranspose<long long int>(3, dim.data(), permutation.data(), dataOut)) return false;
+
+  if (librettPlanAdaptive(&plan, 3, dim.data(), permutation.data(), sizeof(long long int), master_gpustream,
+    0, numExplore) != LIBRETT_INVALID_PARAMETER) return false;
+  if (librettPlanAdaptive(&plan, 3, dim.data(), permutation.data(), sizeof(long long int), master_gpustream,
+    3, 0) != LIBRETT_INVALID_PARAMETER) return false;
+
+  return true;
+}
+
+//
+// Test 25: the model fit recovers the cycles of a model with known parameters from the
+// timings it predicts, and fitted profiles go through the sample and profile files
+//
+bool test25(gpuStream_t& master_gpustream) {
+  GpuModelDevice device;
+  device.numSM = 80.0;
+  device.freq = 1.4;
+  device.warpSize = 32;
+  device.mem_BW = 900.0;
+
+  GpuModelProp trueProp(7);
+  trueProp.base_dep_delay *= 1.4;
+  trueProp.base_mem_latency *= 0.8;
+  trueProp.sh_mem_latency *= 1.5;
+  trueProp.iter_cycles *= 1.2;
+  trueProp.fac *= 0.9;
+  trueProp.mem_BW = device.mem_BW;
+
+  // Counters of the four kernels over a range of block sizes, occupancies and transactions
+  const int methods[4] = {Packed, PackedSplit, Tiled, TiledCopy};
+  std::vector<GpuModelSample> samples;
+  for (int i=0;i < 32;i++) {
+    GpuModelSample sample;
+    GpuModelCounters& c = sample.counters;
+    c.method = methods[i % 4];
+    c.nthread = 128 << (i % 3);
+    c.numActiveBlock = 1 + (i*5) % 8;
+    c.mlp = (float)(1 + (i/4) % 4);
+    c.gld_req = 1000*(1 + i % 5);
+    c.gst_req = 1000*(1 + (i + 2) % 5);
+    c.gld_tran = c.gld_req*(1 + (i*3) % 4);
+    c.gst_tran = c.gst_req*(1 + (i*7) % 5);
+    c.sld_req = (c.method == TiledCopy) ? 0 : c.gld_req;
+    c.sst_req = (c.method == TiledCopy) ? 0 : c.gst_req;
+    c.sld_tran = c.sld_req*(1 + i % 2);
+    c.sst_tran = c.sst_req*(1 + (i/2) % 3);
+    c.num_iter = 100*(1 + (i*11) % 13);
+    c.cl_full = c.gst_tran - (c.gst_tran*(i % 4))/8;
+    c.cl_part = c.gst_tran - c.cl_full;
+    sample.seconds = gpuModelCycles(trueProp, device, c)/(device.freq*1.0e9*device.numSM);
+    samples.push_back(sample);
+  }
+
+  GpuModelProp fitProp(7);
+  fitProp.mem_BW = device.mem_BW;
+  if (!modelFit(device, samples, fitProp)) {
+    printf("test25 FAIL model fit failed\n");
+    return false;
+  }
+  for (const GpuModelSample& sample : samples) {
+    const double cyclesTrue = gpuModelCycles(trueProp, device, sample.counters);
+    const double cyclesFit = gpuModelCycles(fitProp, device, sample.counters);
+    if (std::abs(cyclesFit/cyclesTrue - 1.0) > 0.02) {
+      printf("test25 FAIL method %d cycles %e fitted %e\n", sample.counters.method, cyclesTrue, cyclesFit);
+      return false;
+    }
+  }
+  // Too few samples
+  std::vector<GpuModelSample> fewSamples(samples.begin(), samples.begin() + MODEL_FIT_MIN_SAMPLE - 1);
+  if (modelFit(device, fewSamples, fitProp)) return false;
+
+  // Offline fit of a sample file and export of the profile
+  const char* samplePath = "librett_test_samples.txt";
+  const char* profilePath = "librett_test_profile.txt";
+  const std::string name = "librett test device";
+  if (!modelSamplesWrite(samplePath, name, 7, device, samples)) return false;
+  librettCheck(librettFitModel(samplePath));
+  librettCheck(librettExportModelProfile(profilePath));
+  remove(samplePath);
+  FILE* file = fopen(profilePath, "r");
+  if (file == NULL) return false;
+  char line[1024];
+  bool found = false;
+  while (fgets(line, sizeof(line), file) != NULL) {
+    std::string str(line);
+    if (str.find(name) != std::string::npos) found = true;
+  }
+  fclose(file);
+  librettCheck(librettImportModelProfile(profilePath));
+  remove(profilePath);
+  if (!found) {
+    printf("test25 FAIL no profile for %s\n", name.c_str());
+    return false;
+  }
+
+  if (librettFitModel("librett_test_missing.txt") != LIBRETT_INVALID_PARAMETER) return false;
+  if (librettImportModelProfile("librett_test_missing.txt") != LIBRETT_INVALID_PARAMETER) return false;
+
+  return true;
+}
+
+// Copies the device profile of pathIn to pathOut with the lines of key replaced by line
+static bool editDeviceProfile(const char* pathIn, const char* pathOut, const char* key, const char* line) {
+  FILE* fileIn = fopen(pathIn, "r");
+  if (fileIn == NULL) return false;
+  FILE* fileOut = fopen(pathOut, "w");
+  if (fileOut == NULL) {
+    fclose(fileIn);
+    return false;
+  }
+  char buf[1024];
+  const size_t keyLen = strlen(key);
+  while (fgets(buf, sizeof(buf), fileIn) != NULL) {
+    if (strncmp(buf, key, keyLen) == 0 && buf[keyLen] == ' ') {
+      fprintf(fileOut, "%s\n", line);
+    } else {
+      fputs(buf, fileOut);
+    }
+  }
+  fclose(fileIn);
+  fclose(fileOut);
+  return true;
+}
+
+//
+// Test 26: plans of device profiles are made without the device and are kept as wisdom
+// of the device of the profile
+//
+bool test26(gpuStream_t& master_gpustream) {
+  // Occupancy of an SM with 2048 threads, 32 blocks, 64K registers and 164 KB of shared
+  // memory, as the occupancy calculator of CUDA has it
+  DeviceProfile sm;
+  sm.warpSize = 32;
+  sm.maxThreadsPerBlock = 1024;
+  sm.maxThreadsPerMultiProcessor = 2048;
+  sm.maxBlocksPerMultiProcessor = 32;
+  sm.sharedMemPerBlock = 48*1024;
+  sm.sharedMemPerMultiprocessor = 164*1024;
+  sm.reservedSharedMemPerBlock = 1024;
+  sm.sharedMemAllocUnit = 128;
+  sm.regsPerBlock = 65536;
+  sm.regsPerMultiprocessor = 65536;
+  sm.regAllocUnit = 256;
+  sm.regAllocPartitions = 4;
+  const int numCase = 6;
+  // numRegs sharedSizeBytes numthread dynamicSharedMem numActiveBlock
+  const int cases[numCase][5] = {{32, 0, 256, 0, 8}, {64, 0, 256, 0, 4}, {32, 0, 128, 48*1024, 3},
+    {72, 0, 1024, 0, 0}, {32, 0, 2048, 0, 0}, {40, 8*1024, 96, 0, 16}};
+  for (int i=0;i < numCase;i++) {
+    KernelResource res = {Packed, 8, 1, cases[i][0], (size_t)cases[i][1], 1024};
+    const int numActiveBlock = occupancyActiveBlocks(sm, res, cases[i][2], cases[i][3]);
+    if (numActiveBlock != cases[i][4]) {
+      printf("test26 FAIL occupancy case %d %d expected %d\n", i, numActiveBlock, cases[i][4]);
+      return false;
+    }
+  }
+
+  const char* profilePath = "librett_test_device.txt";
+  const char* targetPath = "librett_test_target.txt";
+  const char* otherPath = "librett_test_other.txt";
+  librettCheck(librettExportDeviceProfile(master_gpustream, profilePath));
+  DeviceProfile profile;
+  if (!deviceProfileRead(profilePath, profile)) return false;
+  // A device with more multiprocessors and another name
+  char line[256];
+  snprintf(line, sizeof(line), "multiProcessorCount %d", profile.multiProcessorCount + 7);
+  if (!editDeviceProfile(profilePath, "librett_test_target0.txt", "multiProcessorCount", line)) return false;
+  if (!editDeviceProfile("librett_test_target0.txt", targetPath, "name", "name librett test target")) return false;
+  remove("librett_test_target0.txt");
+  if (!editDeviceProfile(profilePath, otherPath, "backend", "backend other")) return false;
+
+  std::vector<int> dim = {31, 17, 23, 9};
+  std::vector<int> permutation = {3, 1, 0, 2};
+  const int vol = dim[0]*dim[1]*dim[2]*dim[3];
+  const int numWisdom = countWisdom();
+  librettCheck(librettPlanOffline(targetPath, 4, dim.data(), permutation.data(), sizeof(double)));
+  librettCheck(librettPlanOffline(targetPath, 4, dim.data(), permutation.data(), sizeof(double)));
+  librettCheck(librettPlanOffline(profilePath, 4, dim.data(), permutation.data(), sizeof(double)));
+  if (countWisdom() != numWisdom + 2) {
+    printf("test26 FAIL wisdom has %d lines, %d before\n", countWisdom(), numWisdom);
+    return false;
+  }
+
+  // The plan for this device comes from wisdom
+  librettHandle plan;
+  librettCheck(librettPlan(&plan, 4, dim.data(), permutation.data(), sizeof(double), master_gpustream));
+  set_device_array<double>((double *)dataOut, -1, vol, master_gpustream);
+  librettCheck(librettExecute(plan, dataIn, dataOut));
+  gpuDeviceSynchronize(master_gpustream);
+  librettCheck(librettDestroy(plan));
+  if (!tester->checkTranspose<long long int>(4, dim.data(), permutation.data(), dataOut)) return false;
+
+  bool ok = true;
+  if (librettPlanOffline(otherPath, 4, dim.data(), permutation.data(), sizeof(double)) != LIBRETT_INVALID_PARAMETER) ok = false;
+  if (librettPlanOffline("librett_test_missing.txt", 4, dim.data(), permutation.data(), sizeof(double)) !=
+    LIBRETT_INVALID_PARAMETER) ok = false;
+  std::vector<int> badPermutation = {3, 1, 1, 2};
+  if (librettPlanOffline(targetPath, 4, dim.data(), badPermutation.data(), sizeof(double)) !=
+    LIBRETT_INVALID_PARAMETER) ok = false;
+  remove(profilePath);
+  remove(targetPath);
+  remove(otherPath);
+  return ok;
+}
+
+//
+// Test 27: occupancy is computed on the host from the profile of the device
+//
+bool test27(gpuStream_t& master_gpustream) {
+  const char* profilePath = "librett_test_device.txt";
+  librettCheck(librettExportDeviceProfile(master_gpustream, profilePath));
+  DeviceProfile profile;
+  const bool read = deviceProfileRead(profilePath, profile);
+  remove(profilePath);
+  if (!read) return false;
+
+  // Kernels with the resources of the device, or limited by threads alone if it has none
+  std::vector<KernelResource> kernels = profile.kernels;
+  if (kernels.empty()) kernels.push_back({Packed, 8, 1, 0, 0, profile.maxThreadsPerBlock});
+  for (const KernelResource& res : kernels) {
+    int prevActiveBlock = profile.maxBlocksPerMultiProcessor;
+    for (int numthread=profile.warpSize;numthread <= res.maxThreadsPerBlock;numthread += profile.warpSize) {
+      const int numActiveBlock = occupancyActiveBlocks(profile, res, numthread, 0);
+      if (numActiveBlock < 1 || numActiveBlock > prevActiveBlock ||
+        numActiveBlock != occupancyActiveBlocks(profile, res, numthread, 0)) {
+        printf("test27 FAIL kernel %d %d %d numthread %d occupancy %d\n", res.method, res.sizeofType,
+          res.numRegStorage, numthread, numActiveBlock);
+        return false;
+      }
+#if LIBRETT_USES_CPU
+      // The SIMT pool runs 2048 threads and 32 blocks per SM
+      const int numWarp = (numthread + profile.warpSize - 1)/profile.warpSize;
+      if (numActiveBlock != std::min(32, 2048/(numWarp*profile.warpSize))) {
+        printf("test27 FAIL numthread %d occupancy %d\n", numthread, numActiveBlock);
+        return false;
+      }
+#endif
+      prevActiveBlock = numActiveBlock;
+    }
+    if (occupancyActiveBlocks(profile, res, res.maxThreadsPerBlock + profile.warpSize, 0) != 0 ||
+      occupancyActiveBlocks(profile, res, profile.warpSize, profile.sharedMemPerBlock + 1) != 0) {
+      printf("test27 FAIL kernel %d %d %d over limits\n", res.method, res.sizeofType, res.numRegStorage);
+      return false;
+    }
+  }
+  return true;
+}
+
 template <typename T>
 bool test_tensor(std::vector<int> &dim, std::vector<int> &permutation, gpuStream_t& gpustream)
 {
@@ -548,6 +1540,7 @@ bool test_tensor(std::vector<int> &dim, std::vector<int> &permutation, gpuStream
   gpustream->wait_and_throw();
 #elif HIP
   hipCheck(hipDeviceSynchronize());
+#elif LIBRETT_USES_CPU
 #else // CUDA
   cudaCheck(cudaDeviceSynchronize());
 #endif
@@ -562,9 +1555,511 @@ bool test_tensor(std::vector<int> &dim, std::vector<int> &permutation, gpuStream
   return tester->checkTranspose<T>(rank, dim.data(), permutation.data(), (T *)dataOut);
 }
 
+template <typename T>
+bool test_tensor_inplace(std::vector<int> &dim, std::vector<int> &permutation, gpuStream_t& gpustream)
+{
+  int rank = dim.size();
+
+  int vol = 1;
+  for (int r=0;r < rank;r++) {
+    vol *= dim[r];
+  }
+
+  printf("In-place\n");
+  printf("Dimensions\n");
+  printVec(dim);
+  printf("Permutation\n");
+  printVec(permutation);
+
+  // dataOut gets the same pattern as dataIn and is transposed in-place
+  tester->setTensorCheckPattern((unsigned int *)dataOut, vol*sizeof(T)/sizeof(unsigned int));
+
+  librettHandle plan;
+  librettCheck(librettPlan(&plan, rank, dim.data(), permutation.data(), sizeof(T), gpustream));
+#if LIBRETT_USES_CPU
+  librettCheck(librettExecuteInPlace(plan, dataOut));
+  librettCheck(librettDestroy(plan));
+
+  return tester->checkTranspose<T>(rank, dim.data(), permutation.data(), (T *)dataOut);
+#else
+  // Device builds have no in-place execution
+  const bool rejected = (librettExecuteInPlace(plan, dataOut) == LIBRETT_INVALID_PARAMETER);
+  librettCheck(librettDestroy(plan));
+  return rejected;
+#endif
+}
+
 void printVec(std::vector<int>& vec) {
   for (int i=0;i < vec.size();i++) {
     printf("%d ", vec[i]);
   }
   printf("\n");
 }
+
+//
+// TensorTester checks 4 and 8 byte elements. Smaller elements are checked against a
+// reference transpose on the host, input values are a hash of the element position.
+//
+template <typename T>
+bool test_tensor_small(std::vector<int> &dim, std::vector<int> &permutation, gpuStream_t& gpustream)
+{
+  int rank = dim.size();
+
+  int vol = 1;
+  for (int r=0;r < rank;r++) {
+    vol *= dim[r];
+  }
+
+  printf("%d byte elements\n", (int)sizeof(T));
+  printf("Dimensions\n");
+  printVec(dim);
+  printf("Permutation\n");
+  printVec(permutation);
+
+  std::vector<T> hostIn(vol);
+  for (int i=0;i < vol;i++) {
+    hostIn[i] = (T)(((unsigned int)i*2654435761u) >> (32 - 8*sizeof(T)));
+  }
+  copy_HtoD_sync<T>(hostIn.data(), (T *)dataIn, vol, gpustream);
+
+  librettHandle plan;
+  librettCheck(librettPlan(&plan, rank, dim.data(), permutation.data(), sizeof(T), gpustream));
+  librettCheck(librettExecute(plan, dataIn, dataOut));
+  librettCheck(librettDestroy(plan));
+
+  std::vector<T> hostOut(vol);
+  copy_DtoH_sync<T>((T *)dataOut, hostOut.data(), vol, gpustream);
+
+  std::vector<int> posIn;
+  hostPermutePos(dim, permutation, posIn);
+  for (int posOut=0;posOut < vol;posOut++) {
+    if (hostOut[posOut] != hostIn[posIn[posOut]]) {
+      printf("test_tensor_small FAIL at %d ref %d data %d\n", posOut, (int)hostIn[posIn[posOut]],
+        (int)hostOut[posOut]);
+      return false;
+    }
+  }
+
+  // Restore the check pattern for the tests that follow
+  tester->setTensorCheckPattern((unsigned int *)dataIn, dataSize*2);
+
+  return true;
+}
+
+//
+// Input position of every output position of the transpose
+//
+void hostPermutePos(std::vector<int>& dim, std::vector<int>& permutation, std::vector<int>& posIn) {
+  int rank = dim.size();
+  int vol = 1;
+  for (int r=0;r < rank;r++) vol *= dim[r];
+  posIn.resize(vol);
+
+  // Walk the output in order, pos follows the permuted input strides
+  std::vector<int> strideIn(rank);
+  strideIn[0] = 1;
+  for (int r=1;r < rank;r++) strideIn[r] = strideIn[r-1]*dim[r-1];
+  std::vector<int> p(rank, 0);
+  int pos = 0;
+  for (int posOut=0;posOut < vol;posOut++) {
+    posIn[posOut] = pos;
+    for (int r=0;r < rank;r++) {
+      pos += strideIn[permutation[r]];
+      if (++p[r] < dim[permutation[r]]) break;
+      pos -= p[r]*strideIn[permutation[r]];
+      p[r] = 0;
+    }
+  }
+}
+
+//
+// Checks librettExecuteScaled() and librettExecuteAccumulate() against a host reference.
+// Elements are numComp components of type S (numComp = 2 for complex). Values are small
+// integers so that the reference is exact.
+//
+template <typename S>
+bool test_tensor_scaled(std::vector<int> &dim, std::vector<int> &permutation, const int numComp,
+  const double alpha, const double beta, gpuStream_t& gpustream)
+{
+  int rank = dim.size();
+
+  int vol = 1;
+  for (int r=0;r < rank;r++) {
+    vol *= dim[r];
+  }
+
+  printf("%d byte elements alpha %lf beta %lf\n", (int)(numComp*sizeof(S)), alpha, beta);
+  printf("Dimensions\n");
+  printVec(dim);
+  printf("Permutation\n");
+  printVec(permutation);
+
+  std::vector<S> hostIn(vol*numComp);
+  std::vector<S> hostOut0(vol*numComp);
+  for (int i=0;i < vol*numComp;i++) {
+    hostIn[i] = (S)((((unsigned int)i*2654435761u) >> 20) % 1000);
+    hostOut0[i] = (S)(i % 777);
+  }
+  copy_HtoD_sync<S>(hostIn.data(), (S *)dataIn, vol*numComp, gpustream);
+  copy_HtoD_sync<S>(hostOut0.data(), (S *)dataOut, vol*numComp, gpustream);
+
+  librettHandle plan;
+  if (beta == 0.0) {
+    librettCheck(librettPlan(&plan, rank, dim.data(), permutation.data(), numComp*sizeof(S), gpustream));
+    librettCheck(librettExecuteScaled(plan, dataIn, dataOut, alpha));
+  } else {
+    librettCheck(librettPlanAccumulate(&plan, rank, dim.data(), permutation.data(), numComp*sizeof(S), gpustream));
+    librettCheck(librettExecuteAccumulate(plan, dataIn, dataOut, alpha, beta));
+  }
+  librettCheck(librettDestroy(plan));
+
+  std::vector<S> hostOut(vol*numComp);
+  copy_DtoH_sync<S>((S *)dataOut, hostOut.data(), vol*numComp, gpustream);
+
+  std::vector<int> posIn;
+  hostPermutePos(dim, permutation, posIn);
+  for (int posOut=0;posOut < vol;posOut++) {
+    for (int k=0;k < numComp;k++) {
+      S ref = (S)alpha*hostIn[posIn[posOut]*numComp + k] + (S)beta*hostOut0[posOut*numComp + k];
+      if (hostOut[posOut*numComp + k] != ref) {
+        printf("test_tensor_scaled FAIL at %d ref %lf data %lf\n", posOut, (double)ref,
+          (double)hostOut[posOut*numComp + k]);
+        return false;
+      }
+    }
+  }
+
+  // Restore the check pattern for the tests that follow
+  tester->setTensorCheckPattern((unsigned int *)dataIn, dataSize*2);
+
+  return true;
+}
+
+//
+// Size in bytes of the elements of type
+//
+static int hostSizeofType(const librettDataType type) {
+  return (type == LIBRETT_FLOAT64) ? 8 : ((type == LIBRETT_FLOAT32) ? 4 : 2);
+}
+
+//
+// Writes non-negative value x as element i of buf in the format of type. Half and
+// bfloat16 values must be exact, float values are rounded from double.
+//
+static void hostEncode(const double x, const librettDataType type, std::vector<char>& buf, const int i) {
+  if (type == LIBRETT_FLOAT64) {
+    memcpy(&buf[i*8], &x, 8);
+    return;
+  }
+  float f = (float)x;
+  unsigned int bits;
+  memcpy(&bits, &f, 4);
+  if (type == LIBRETT_FLOAT32) {
+    memcpy(&buf[i*4], &bits, 4);
+    return;
+  }
+  unsigned short h;
+  if (type == LIBRETT_BFLOAT16) {
+    h = (unsigned short)(bits >> 16);
+  } else {
+    // Normal half, exponent bias 15 and 10 mantissa bits
+    h = (f == 0.0f) ? 0 : (unsigned short)(((((bits >> 23) & 0xff) - 127 + 15) << 10) | ((bits >> 13) & 0x3ff));
+  }
+  memcpy(&buf[i*2], &h, 2);
+}
+
+//
+// Checks librettPlanConvert() against a host reference. Values are multiples of 1/4
+// below 64, which all formats hold exactly, except for double input where they are
+// divided by 3 to check the rounding to float.
+//
+bool test_tensor_convert(std::vector<int> &dim, std::vector<int> &permutation, const librettDataType typeIn,
+  const librettDataType typeOut, gpuStream_t& gpustream)
+{
+  int rank = dim.size();
+
+  int vol = 1;
+  for (int r=0;r < rank;r++) {
+    vol *= dim[r];
+  }
+
+  const int sizeIn = hostSizeofType(typeIn);
+  const int sizeOut = hostSizeofType(typeOut);
+  printf("%d byte to %d byte elements\n", sizeIn, sizeOut);
+  printf("Dimensions\n");
+  printVec(dim);
+  printf("Permutation\n");
+  printVec(permutation);
+
+  std::vector<double> val(vol);
+  std::vector<char> hostIn((size_t)vol*sizeIn);
+  for (int i=0;i < vol;i++) {
+    val[i] = (double)((((unsigned int)i*2654435761u) >> 20) % 256)/4.0;
+    if (typeIn == LIBRETT_FLOAT64) val[i] /= 3.0;
+    hostEncode(val[i], typeIn, hostIn, i);
+  }
+  copy_HtoD_sync<char>(hostIn.data(), (char *)dataIn, (size_t)vol*sizeIn, gpustream);
+
+  librettHandle plan;
+  librettCheck(librettPlanConvert(&plan, rank, dim.data(), permutation.data(), typeIn, typeOut, gpustream));
+  librettCheck(librettExecute(plan, dataIn, dataOut));
+  librettCheck(librettDestroy(plan));
+
+  std::vector<char> hostOut((size_t)vol*sizeOut);
+  copy_DtoH_sync<char>((char *)dataOut, hostOut.data(), (size_t)vol*sizeOut, gpustream);
+
+  std::vector<int> posIn;
+  hostPermutePos(dim, permutation, posIn);
+  std::vector<char> ref(sizeOut);
+  for (int posOut=0;posOut < vol;posOut++) {
+    hostEncode(val[posIn[posOut]], typeOut, ref, 0);
+    if (memcmp(ref.data(), &hostOut[(size_t)posOut*sizeOut], sizeOut) != 0) {
+      printf("test_tensor_convert FAIL at %d ref %lf\n", posOut, val[posIn[posOut]]);
+      return false;
+    }
+  }
+
+  // Restore the check pattern for the tests that follow
+  tester->setTensorCheckPattern((unsigned int *)dataIn, dataSize*2);
+
+  return true;
+}
+
+//
+// Position of element pos of a dense tensor with dimensions dim in a tensor with strides stride
+//
+static long long int hostStridedPos(std::vector<int>& dim, std::vector<long long int>& stride, int pos) {
+  long long int posStrided = 0;
+  for (int r=0;r < dim.size();r++) {
+    posStrided += (pos % dim[r])*stride[r];
+    pos /= dim[r];
+  }
+  return posStrided;
+}
+
+//
+// Checks librettPlanStrided() against a host reference. Elements of odata between the
+// strided positions must keep their initial value.
+//
+template <typename T>
+bool test_tensor_strided(std::vector<int> &dim, std::vector<int> &permutation, const int inPad,
+  const int outPad, gpuStream_t& gpustream)
+{
+  int rank = dim.size();
+
+  int vol = 1;
+  for (int r=0;r < rank;r++) {
+    vol *= dim[r];
+  }
+
+  printf("%d byte elements inPad %d outPad %d\n", (int)sizeof(T), inPad, outPad);
+  printf("Dimensions\n");
+  printVec(dim);
+  printf("Permutation\n");
+  printVec(permutation);
+
+  std::vector<int> dimOut(rank);
+  std::vector<long long int> inStride(rank);
+  std::vector<long long int> outStride(rank);
+  for (int r=0;r < rank;r++) {
+    dimOut[r] = dim[permutation[r]];
+    inStride[r] = (r == 0) ? 1 : inStride[r-1]*(dim[r-1] + inPad);
+    outStride[r] = (r == 0) ? 1 : outStride[r-1]*(dimOut[r-1] + outPad);
+  }
+  const long long int volIn = inStride[rank-1]*dim[rank-1];
+  const long long int volOut = outStride[rank-1]*dimOut[rank-1];
+
+  std::vector<T> hostIn(volIn);
+  for (long long int i=0;i < volIn;i++) {
+    hostIn[i] = (T)((((unsigned int)i*2654435761u) >> 8) & 0xffffff);
+  }
+  std::vector<T> hostOut0(volOut, (T)-1);
+  copy_HtoD_sync<T>(hostIn.data(), (T *)dataIn, volIn, gpustream);
+  copy_HtoD_sync<T>(hostOut0.data(), (T *)dataOut, volOut, gpustream);
+
+  librettHandle plan;
+  librettCheck(librettPlanStrided(&plan, rank, dim.data(), inStride.data(), outStride.data(), permutation.data(),
+    sizeof(T), gpustream));
+  librettCheck(librettExecute(plan, dataIn, dataOut));
+  librettCheck(librettDestroy(plan));
+
+  std::vector<T> hostOut(volOut);
+  copy_DtoH_sync<T>((T *)dataOut, hostOut.data(), volOut, gpustream);
+
+  std::vector<int> posIn;
+  hostPermutePos(dim, permutation, posIn);
+  for (int posOut=0;posOut < vol;posOut++) {
+    const long long int pIn = hostStridedPos(dim, inStride, posIn[posOut]);
+    const long long int pOut = hostStridedPos(dimOut, outStride, posOut);
+    if (hostOut[pOut] != hostIn[pIn]) {
+      printf("test_tensor_strided FAIL at %d ref %lf data %lf\n", posOut, (double)hostIn[pIn],
+        (double)hostOut[pOut]);
+      return false;
+    }
+    // Mark the strided positions
+    hostOut[pOut] = (T)-1;
+  }
+  for (long long int i=0;i < volOut;i++) {
+    if (hostOut[i] != (T)-1) {
+      printf("test_tensor_strided FAIL padding at %lld overwritten\n", i);
+      return false;
+    }
+  }
+
+  // Restore the check pattern for the tests that follow
+  tester->setTensorCheckPattern((unsigned int *)dataIn, dataSize*2);
+
+  return true;
+}
+
+//
+// Checks librettExecuteBatchedStrided() (mode = 0) and librettExecuteBatched() with evenly
+// (mode = 1) and unevenly (mode = 2) spaced tensors against a host reference
+//
+template <typename T>
+bool test_tensor_batched(std::vector<int> &dim, std::vector<int> &permutation, const int count,
+  const int mode, gpuStream_t& gpustream)
+{
+  int rank = dim.size();
+
+  int vol = 1;
+  for (int r=0;r < rank;r++) {
+    vol *= dim[r];
+  }
+
+  printf("%d byte elements batch %d mode %d\n", (int)sizeof(T), count, mode);
+  printf("Dimensions\n");
+  printVec(dim);
+  printf("Permutation\n");
+  printVec(permutation);
+
+  // Offsets of the tensors in elements
+  std::vector<int> offIn(count);
+  std::vector<int> offOut(count);
+  for (int i=0;i < count;i++) {
+    offIn[i]  = (mode == 0) ? i*(vol + 3) : ((mode == 1) ? i*vol : i*vol + i*i);
+    offOut[i] = (mode == 0) ? i*(vol + 5) : ((mode == 1) ? i*vol : i*vol + 2*i*i);
+  }
+  const int volIn = offIn[count-1] + vol;
+  const int volOut = offOut[count-1] + vol;
+
+  std::vector<T> hostIn(volIn);
+  for (int i=0;i < volIn;i++) {
+    hostIn[i] = (T)((((unsigned int)i*2654435761u) >> 8) & 0xffffff);
+  }
+  std::vector<T> hostOut0(volOut, (T)-1);
+  copy_HtoD_sync<T>(hostIn.data(), (T *)dataIn, volIn, gpustream);
+  copy_HtoD_sync<T>(hostOut0.data(), (T *)dataOut, volOut, gpustream);
+
+  librettHandle plan;
+  librettCheck(librettPlan(&plan, rank, dim.data(), permutation.data(), sizeof(T), gpustream));
+  if (mode == 0) {
+    librettCheck(librettExecuteBatchedStrided(plan, count, dataIn, vol + 3, dataOut, vol + 5));
+  } else {
+    std::vector<void*> idata(count);
+    std::vector<void*> odata(count);
+    for (int i=0;i < count;i++) {
+      idata[i] = (T *)dataIn + offIn[i];
+      odata[i] = (T *)dataOut + offOut[i];
+    }
+    librettCheck(librettExecuteBatched(plan, count, idata.data(), odata.data()));
+  }
+  librettCheck(librettDestroy(plan));
+
+  std::vector<T> hostOut(volOut);
+  copy_DtoH_sync<T>((T *)dataOut, hostOut.data(), volOut, gpustream);
+
+  std::vector<int> posIn;
+  hostPermutePos(dim, permutation, posIn);
+  for (int i=0;i < count;i++) {
+    for (int posOut=0;posOut < vol;posOut++) {
+      const T ref = hostIn[offIn[i] + posIn[posOut]];
+      if (hostOut[offOut[i] + posOut] != ref) {
+        printf("test_tensor_batched FAIL in tensor %d at %d ref %lf data %lf\n", i, posOut, (double)ref,
+          (double)hostOut[offOut[i] + posOut]);
+        return false;
+      }
+    }
+    // Gaps between the output tensors stay untouched
+    const int gapEnd = (i + 1 < count) ? offOut[i + 1] : volOut;
+    for (int pos=offOut[i] + vol;pos < gapEnd;pos++) {
+      if (hostOut[pos] != (T)-1) {
+        printf("test_tensor_batched FAIL gap after tensor %d written at %d\n", i, pos);
+        return false;
+      }
+    }
+  }
+
+  // Restore the check pattern for the tests that follow
+  tester->setTensorCheckPattern((unsigned int *)dataIn, dataSize*2);
+
+  return true;
+}
+
+//
+// Checks librettExecuteGrouped() on tensors placed one after another in dataIn and dataOut
+// against a host reference
+//
+template <typename T>
+bool test_tensor_grouped(std::vector< std::vector<int> > &dims, std::vector< std::vector<int> > &permutations,
+  gpuStream_t& gpustream)
+{
+  const int count = dims.size();
+
+  printf("%d byte elements group of %d tensors\n", (int)sizeof(T), count);
+
+  // Offsets of the tensors in elements
+  std::vector<int> vol(count, 1);
+  std::vector<int> off(count + 1, 0);
+  for (int i=0;i < count;i++) {
+    for (int r=0;r < dims[i].size();r++) vol[i] *= dims[i][r];
+    off[i + 1] = off[i] + vol[i];
+  }
+
+  std::vector<T> hostIn(off[count]);
+  for (int i=0;i < off[count];i++) {
+    hostIn[i] = (T)((((unsigned int)i*2654435761u) >> 8) & 0x7f);
+  }
+  std::vector<T> hostOut0(off[count], (T)-1);
+  copy_HtoD_sync<T>(hostIn.data(), (T *)dataIn, off[count], gpustream);
+  copy_HtoD_sync<T>(hostOut0.data(), (T *)dataOut, off[count], gpustream);
+
+  std::vector<librettHandle> plans(count);
+  std::vector<void*> idata(count);
+  std::vector<void*> odata(count);
+  for (int i=0;i < count;i++) {
+    librettCheck(librettPlan(&plans[i], dims[i].size(), dims[i].data(), permutations[i].data(), sizeof(T),
+      gpustream));
+    idata[i] = (T *)dataIn + off[i];
+    odata[i] = (T *)dataOut + off[i];
+  }
+  librettCheck(librettExecuteGrouped(count, plans.data(), idata.data(), odata.data()));
+  for (int i=0;i < count;i++) {
+    librettCheck(librettDestroy(plans[i]));
+  }
+
+  std::vector<T> hostOut(off[count]);
+  copy_DtoH_sync<T>((T *)dataOut, hostOut.data(), off[count], gpustream);
+
+  for (int i=0;i < count;i++) {
+    std::vector<int> posIn;
+    hostPermutePos(dims[i], permutations[i], posIn);
+    for (int posOut=0;posOut < vol[i];posOut++) {
+      const T ref = hostIn[off[i] + posIn[posOut]];
+      if (hostOut[off[i] + posOut] != ref) {
+        printf("test_tensor_grouped FAIL in tensor %d at %d ref %lf data %lf\n", i, posOut, (double)ref,
+          (double)hostOut[off[i] + posOut]);
+        printf("Dimensions\n");
+        printVec(dims[i]);
+        printf("Permutation\n");
+        printVec(permutations[i]);
+        return false;
+      }
+    }
+  }
+
+  // Restore the check pattern for the tests that follow
+  tester->setTensorCheckPattern((unsigned int *)dataIn, dataSize*2);
+
+  return true;
+}